@@ -0,0 +1,7 @@
+DELETE FROM `rbac_permissions` WHERE `id`=1008;
+INSERT INTO `rbac_permissions` (`id`,`name`) VALUES
+(1008, 'Command: debug aurapools');
+
+DELETE FROM `rbac_linked_permissions` WHERE `linkedId`=1008;
+INSERT INTO `rbac_linked_permissions` (`id`,`linkedId`) VALUES
+(196, 1008);
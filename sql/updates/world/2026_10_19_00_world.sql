@@ -0,0 +1,5 @@
+DELETE FROM `command` WHERE `name`='debug procstats';
+INSERT INTO `command` (`name`, `permission`, `help`) VALUES
+('debug procstats', 1007, 'Syntax: .debug procstats
+
+Shows the proc checks of the last update of your map and the proc aura index of the selected unit.');
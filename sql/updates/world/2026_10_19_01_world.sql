@@ -0,0 +1,5 @@
+DELETE FROM `command` WHERE `name`='debug aurapools';
+INSERT INTO `command` (`name`, `permission`, `help`) VALUES
+('debug aurapools', 1008, 'Syntax: .debug aurapools
+
+Shows allocation counters of the aura object pools.');
@@ -0,0 +1,5 @@
+DELETE FROM `command` WHERE `name`='mmap pathcache';
+INSERT INTO `command` (`name`, `permission`, `help`) VALUES
+('mmap pathcache', 1009, 'Syntax: .mmap pathcache
+
+Shows hit rate and size of the per map navmesh path caches.');
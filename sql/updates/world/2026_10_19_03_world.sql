@@ -0,0 +1,5 @@
+DELETE FROM `command` WHERE `name`='debug querycache';
+INSERT INTO `command` (`name`, `permission`, `help`) VALUES
+('debug querycache', 1010, 'Syntax: .debug querycache
+
+Shows hit rates of the per map caches for static height, area, liquid and line of sight queries.');
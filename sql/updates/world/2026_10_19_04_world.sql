@@ -0,0 +1,5 @@
+DELETE FROM `command` WHERE `name`='debug profiler';
+INSERT INTO `command` (`name`, `permission`, `help`) VALUES
+('debug profiler', 1011, 'Syntax: .debug profiler [on|off|reset|show [world|opcodes|maps] [#count]|dump $file]
+
+Controls the update profiler. show lists the world update phases and packet processing modes, or the #count (default 10) opcode handlers or maps that took the most time. dump writes all statistics with their latency histograms to $file in the logs directory.');
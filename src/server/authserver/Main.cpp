@@ -24,11 +24,14 @@
 * authentication server
 */
 
+#include "AuthComputePool.h"
 #include "AuthSocketMgr.h"
 #include "Common.h"
 #include "Config.h"
 #include "DatabaseEnv.h"
+#include "IpBanCache.h"
 #include "Log.h"
+#include "OpenSSLCrypto.h"
 #include "ProcessPriority.h"
 #include "RealmList.h"
 #include "SystemConfig.h"
@@ -49,11 +52,14 @@ bool StartDB();
 void StopDB();
 void SignalHandler(const boost::system::error_code& error, int signalNumber);
 void KeepDatabaseAliveHandler(const boost::system::error_code& error);
+void BanExpiryHandler(const boost::system::error_code& error);
 variables_map GetConsoleArguments(int argc, char** argv, std::string& configFile);
 
 boost::asio::io_service _ioService;
 boost::asio::deadline_timer _dbPingTimer(_ioService);
 uint32 _dbPingInterval;
+boost::asio::deadline_timer _banExpiryCheckTimer(_ioService);
+uint32 _banExpiryCheckInterval;
 LoginDatabaseWorkerPool LoginDatabase;
 
 int main(int argc, char** argv)
@@ -94,6 +100,21 @@ int main(int argc, char** argv)
     if (!StartDB())
         return 1;
 
+    // Load the banned ip addresses checked on logon
+    sIpBanCache->LoadFromDB();
+
+    // SRP6 calculations of logon attempts run on their own threads
+    OpenSSLCrypto::threadsSetup();
+
+    int32 computeThreads = sConfigMgr->GetIntDefault("LoginCompute.Threads", 2);
+    if (computeThreads < 0 || computeThreads > 32)
+    {
+        TC_LOG_ERROR("server.authserver", "Improper value specified for LoginCompute.Threads, defaulting to 2.");
+        computeThreads = 2;
+    }
+
+    sAuthComputePool->Start(uint32(computeThreads));
+
     // Get the list of realms for the server
     sRealmList->Initialize(_ioService, sConfigMgr->GetIntDefault("RealmsStateUpdateDelay", 20));
 
@@ -132,9 +153,20 @@ int main(int argc, char** argv)
     _dbPingTimer.expires_from_now(boost::posix_time::minutes(_dbPingInterval));
     _dbPingTimer.async_wait(KeepDatabaseAliveHandler);
 
+    // Enabled a timed callback for expiring bans and reloading the banned ip addresses
+    _banExpiryCheckInterval = sConfigMgr->GetIntDefault("BanExpiryCheckInterval", 60);
+    if (!_banExpiryCheckInterval)
+        _banExpiryCheckInterval = 1;
+
+    _banExpiryCheckTimer.expires_from_now(boost::posix_time::seconds(_banExpiryCheckInterval));
+    _banExpiryCheckTimer.async_wait(BanExpiryHandler);
+
     // Start the io service worker loop
     _ioService.run();
 
+    sAuthComputePool->Stop();
+    OpenSSLCrypto::threadsCleanup();
+
     // Close the Database Pool and library
     StopDB();
 
@@ -169,7 +201,8 @@ bool StartDB()
         synch_threads = 1;
     }
 
-    // NOTE: While authserver is singlethreaded you should keep synch_threads == 1. Increasing it is just silly since only 1 will be used ever.
+    // NOTE: Logon queries run on the worker threads, only the realm list and ban list reloads use the synch connection.
+    // Keep synch_threads == 1, raise worker_threads for more logons per second instead.
     if (!LoginDatabase.Open(dbstring, uint8(worker_threads), uint8(synch_threads)))
     {
         TC_LOG_ERROR("server.authserver", "Cannot connect to database");
@@ -206,6 +239,21 @@ void KeepDatabaseAliveHandler(const boost::system::error_code& error)
     }
 }
 
+void BanExpiryHandler(const boost::system::error_code& error)
+{
+    if (!error)
+    {
+        LoginDatabase.Execute(LoginDatabase.GetPreparedStatement(LOGIN_DEL_EXPIRED_IP_BANS));
+        LoginDatabase.Execute(LoginDatabase.GetPreparedStatement(LOGIN_UPD_EXPIRED_ACCOUNT_BANS));
+        LoginDatabase.Execute(LoginDatabase.GetPreparedStatement(LOGIN_UPD_EXPIRED_ACCOUNT_PREMIUM));
+
+        sIpBanCache->LoadFromDB();
+
+        _banExpiryCheckTimer.expires_from_now(boost::posix_time::seconds(_banExpiryCheckInterval));
+        _banExpiryCheckTimer.async_wait(BanExpiryHandler);
+    }
+}
+
 variables_map GetConsoleArguments(int argc, char** argv, std::string& configFile)
 {
     options_description all("Allowed options");
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2008-2015 TrinityCore <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AuthComputePool.h"
+#include "Log.h"
+
+void AuthComputePool::Start(uint32 threadCount)
+{
+    for (uint32 i = 0; i < threadCount; ++i)
+        _threads.push_back(std::thread(&AuthComputePool::WorkerThread, this));
+
+    TC_LOG_INFO("server.authserver", "Started %u SRP6 compute thread(s).", threadCount);
+}
+
+void AuthComputePool::Stop()
+{
+    if (_threads.empty())
+        return;
+
+    // pending calculations are dropped, their sessions are gone with the network
+    _queue.Cancel();
+
+    for (std::thread& thread : _threads)
+        thread.join();
+
+    _threads.clear();
+}
+
+void AuthComputePool::WorkerThread()
+{
+    for (;;)
+    {
+        std::function<void()>* task = nullptr;
+
+        _queue.WaitAndPop(task);
+
+        if (!task)
+            return;
+
+        (*task)();
+        delete task;
+    }
+}
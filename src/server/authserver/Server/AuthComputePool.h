@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2008-2015 TrinityCore <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef AuthComputePool_h__
+#define AuthComputePool_h__
+
+#include "Define.h"
+#include "ProducerConsumerQueue.h"
+#include <functional>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Runs the SRP6 modular exponentiations of logon attempts off the network thread.
+// Sessions poll the returned futures from their Update, like database query callbacks.
+class AuthComputePool
+{
+public:
+    static AuthComputePool* instance()
+    {
+        static AuthComputePool instance;
+        return &instance;
+    }
+
+    void Start(uint32 threadCount);
+    void Stop();
+
+    template<class Result>
+    std::future<Result> Enqueue(std::function<Result()>&& func)
+    {
+        std::shared_ptr<std::packaged_task<Result()>> task = std::make_shared<std::packaged_task<Result()>>(std::move(func));
+        std::future<Result> result = task->get_future();
+
+        // without worker threads calculate right away, the caller picks up the result on its next update
+        if (_threads.empty())
+            (*task)();
+        else
+            _queue.Push(new std::function<void()>([task]() { (*task)(); }));
+
+        return result;
+    }
+
+private:
+    AuthComputePool() { }
+    ~AuthComputePool() { Stop(); }
+
+    void WorkerThread();
+
+    ProducerConsumerQueue<std::function<void()>*> _queue;
+    std::vector<std::thread> _threads;
+};
+
+#define sAuthComputePool AuthComputePool::instance()
+
+#endif // AuthComputePool_h__
@@ -17,6 +17,7 @@
 */
 
 #include "AuthSession.h"
+#include "AuthComputePool.h"
 #include "Log.h"
 #include "AuthCodes.h"
 #include "Database/DatabaseEnv.h"
@@ -24,6 +25,7 @@
 #include "TOTP.h"
 #include "openssl/crypto.h"
 #include "Configuration/Config.h"
+#include "IpBanCache.h"
 #include "RealmList.h"
 #include <boost/lexical_cast.hpp>
 
@@ -139,8 +141,128 @@ std::unordered_map<uint8, AuthHandler> AuthSession::InitHandlers()
 
 std::unordered_map<uint8, AuthHandler> const Handlers = AuthSession::InitHandlers();
 
+// Make the SRP6 calculation from hash in dB
+static void CalculateVSFields(std::string const& rI, BigNumber& N, BigNumber& g, BigNumber& s, BigNumber& v)
+{
+    s.SetRand(int32(BufferSizes::SRP_6_S) * 8);
+
+    BigNumber I;
+    I.SetHexStr(rI.c_str());
+
+    // In case of leading zeros in the rI hash, restore them
+    uint8 mDigest[SHA_DIGEST_LENGTH];
+    memcpy(mDigest, I.AsByteArray(SHA_DIGEST_LENGTH).get(), SHA_DIGEST_LENGTH);
+
+    std::reverse(mDigest, mDigest + SHA_DIGEST_LENGTH);
+
+    SHA1Hash sha;
+    sha.UpdateData(s.AsByteArray(uint32(BufferSizes::SRP_6_S)).get(), (uint32(BufferSizes::SRP_6_S)));
+    sha.UpdateData(mDigest, SHA_DIGEST_LENGTH);
+    sha.Finalize();
+    BigNumber x;
+    x.SetBinary(sha.GetDigest(), sha.GetLength());
+    v = g.ModExp(x, N);
+}
+
+// Verify the client proof M1 and calculate the session key and server proof M2
+static SRP6ProofValues CalculateLogonProof(std::string const& login, BigNumber& A, BigNumber& N, BigNumber& g, BigNumber& s, BigNumber& v,
+    BigNumber& b, BigNumber& B, uint8 const* M1)
+{
+    SRP6ProofValues values;
+
+    SHA1Hash sha;
+    sha.UpdateBigNumbers(&A, &B, NULL);
+    sha.Finalize();
+    BigNumber u;
+    u.SetBinary(sha.GetDigest(), 20);
+    BigNumber S = (A * (v.ModExp(u, N))).ModExp(b, N);
+
+    uint8 t[32];
+    uint8 t1[16];
+    uint8 vK[40];
+    memcpy(t, S.AsByteArray(32).get(), 32);
+
+    for (int i = 0; i < 16; ++i)
+        t1[i] = t[i * 2];
+
+    sha.Initialize();
+    sha.UpdateData(t1, 16);
+    sha.Finalize();
+
+    for (int i = 0; i < 20; ++i)
+        vK[i * 2] = sha.GetDigest()[i];
+
+    for (int i = 0; i < 16; ++i)
+        t1[i] = t[i * 2 + 1];
+
+    sha.Initialize();
+    sha.UpdateData(t1, 16);
+    sha.Finalize();
+
+    for (int i = 0; i < 20; ++i)
+        vK[i * 2 + 1] = sha.GetDigest()[i];
+
+    values.K.SetBinary(vK, 40);
+
+    uint8 hash[20];
+
+    sha.Initialize();
+    sha.UpdateBigNumbers(&N, NULL);
+    sha.Finalize();
+    memcpy(hash, sha.GetDigest(), 20);
+    sha.Initialize();
+    sha.UpdateBigNumbers(&g, NULL);
+    sha.Finalize();
+
+    for (int i = 0; i < 20; ++i)
+        hash[i] ^= sha.GetDigest()[i];
+
+    BigNumber t3;
+    t3.SetBinary(hash, 20);
+
+    sha.Initialize();
+    sha.UpdateData(login);
+    sha.Finalize();
+    uint8 t4[SHA_DIGEST_LENGTH];
+    memcpy(t4, sha.GetDigest(), SHA_DIGEST_LENGTH);
+
+    sha.Initialize();
+    sha.UpdateBigNumbers(&t3, NULL);
+    sha.UpdateData(t4, SHA_DIGEST_LENGTH);
+    sha.UpdateBigNumbers(&s, &A, &B, &values.K, NULL);
+    sha.Finalize();
+    BigNumber M;
+    M.SetBinary(sha.GetDigest(), sha.GetLength());
+
+    // Check if SRP6 results match (password is correct)
+    values.Valid = !memcmp(M.AsByteArray(sha.GetLength()).get(), M1, 20);
+
+    // Finish SRP6 for the final result to the client
+    sha.Initialize();
+    sha.UpdateBigNumbers(&A, &M, &values.K, NULL);
+    sha.Finalize();
+    memcpy(values.M2, sha.GetDigest(), SHA_DIGEST_LENGTH);
+
+    return values;
+}
+
+template<class T>
+inline bool IsCallbackReady(std::future<T> const& callback)
+{
+    return callback.valid() && callback.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
 void AuthSession::ReadHandler()
 {
+    std::lock_guard<std::mutex> guard(_sessionLock);
+    ProcessReadBuffer();
+}
+
+void AuthSession::ProcessReadBuffer()
+{
+    if (!IsOpen())
+        return;
+
     MessageBuffer& packet = GetReadBuffer();
     while (packet.GetActiveSize())
     {
@@ -173,11 +295,53 @@ void AuthSession::ReadHandler()
         }
 
         packet.ReadCompleted(size);
+
+        // The handler started a query or SRP6 calculation, its callback continues with the rest of the buffer
+        if (IsWaitingForCallback())
+            return;
     }
 
     AsyncRead();
 }
 
+bool AuthSession::Update()
+{
+    if (!AuthSocket::Update())
+        return false;
+
+    ProcessQueryCallbacks();
+    return true;
+}
+
+void AuthSession::ProcessQueryCallbacks()
+{
+    // the read handler is busy with this session, try again on the next update
+    std::unique_lock<std::mutex> guard(_sessionLock, std::try_to_lock);
+    if (!guard)
+        return;
+
+    if (IsCallbackReady(_logonChallengeCallback))
+        LogonChallengeCallback(_logonChallengeCallback.get());
+    else if (IsCallbackReady(_logonCountryCallback))
+        LogonCountryCallback(_logonCountryCallback.get());
+    else if (IsCallbackReady(_logonChallengeCalculation))
+        LogonChallengeCalculated(_logonChallengeCalculation.get());
+    else if (IsCallbackReady(_logonProofCalculation))
+        LogonProofCalculated(_logonProofCalculation.get());
+    else if (IsCallbackReady(_failedLoginsCallback))
+        FailedLoginsCallback(_failedLoginsCallback.get());
+    else if (IsCallbackReady(_reconnectChallengeCallback))
+        ReconnectChallengeCallback(_reconnectChallengeCallback.get());
+    else if (IsCallbackReady(_realmListCallback))
+        RealmListCallback(_realmListCallback.get());
+}
+
+bool AuthSession::IsWaitingForCallback() const
+{
+    return _logonChallengeCallback.valid() || _logonCountryCallback.valid() || _logonChallengeCalculation.valid() ||
+        _logonProofCalculation.valid() || _failedLoginsCallback.valid() || _reconnectChallengeCallback.valid() || _realmListCallback.valid();
+}
+
 void AuthSession::SendPacket(ByteBuffer& packet)
 {
     if (!IsOpen())
@@ -194,6 +358,15 @@ void AuthSession::SendPacket(ByteBuffer& packet)
     }
 }
 
+void AuthSession::SendLogonChallengeError(AuthResult result)
+{
+    ByteBuffer pkt;
+    pkt << uint8(AUTH_LOGON_CHALLENGE);
+    pkt << uint8(0x00);
+    pkt << uint8(result);
+    SendPacket(pkt);
+}
+
 bool AuthSession::HandleLogonChallenge()
 {
     sAuthLogonChallenge_C* challenge = reinterpret_cast<sAuthLogonChallenge_C*>(GetReadBuffer().GetReadPointer());
@@ -201,8 +374,6 @@ bool AuthSession::HandleLogonChallenge()
     //TC_LOG_DEBUG("server.authserver", "[AuthChallenge] got full packet, %#04x bytes", challenge->size);
     TC_LOG_DEBUG("server.authserver", "[AuthChallenge] name(%d): '%s'", challenge->I_len, challenge->I);
 
-    ByteBuffer pkt;
-
     _login.assign((const char*)challenge->I, challenge->I_len);
     _build = challenge->build;
     _expversion = uint8(AuthHelper::IsPostBCAcceptedClientBuild(_build) ? POST_BC_EXP_FLAG : (AuthHelper::IsPreBCAcceptedClientBuild(_build) ? PRE_BC_EXP_FLAG : NO_VALID_EXP_FLAG));
@@ -214,202 +385,254 @@ bool AuthSession::HandleLogonChallenge()
     // Restore string order as its byte order is reversed
     std::reverse(_os.begin(), _os.end());
 
-    pkt << uint8(AUTH_LOGON_CHALLENGE);
-    pkt << uint8(0x00);
+    _localizationName.resize(4);
+    for (int i = 0; i < 4; ++i)
+        _localizationName[i] = challenge->country[4 - i - 1];
 
     // Verify that this IP is not in the ip_banned table
-    LoginDatabase.Execute(LoginDatabase.GetPreparedStatement(LOGIN_DEL_EXPIRED_IP_BANS));
+    if (sIpBanCache->IsBanned(GetRemoteIpAddress().to_string()))
+    {
+        SendLogonChallengeError(WOW_FAIL_BANNED);
+        TC_LOG_DEBUG("server.authserver", "'%s:%d' [AuthChallenge] Banned ip tries to login!", GetRemoteIpAddress().to_string().c_str(), GetRemotePort());
+        return true;
+    }
 
-    std::string ipAddress = GetRemoteIpAddress().to_string();
-    uint16 port = GetRemotePort();
+    // Get the account details from the account table
+    // No SQL injection (prepared statement)
+    PreparedStatement* stmt = LoginDatabase.GetPreparedStatement(LOGIN_SEL_LOGONCHALLENGE);
+    stmt->setString(0, _login);
+    _logonChallengeCallback = LoginDatabase.AsyncQuery(stmt);
+    return true;
+}
 
-    PreparedStatement* stmt = LoginDatabase.GetPreparedStatement(LOGIN_SEL_IP_BANNED);
-    stmt->setString(0, ipAddress);
-    PreparedQueryResult result = LoginDatabase.Query(stmt);
-    if (result)
+void AuthSession::LogonChallengeCallback(PreparedQueryResult result)
+{
+    if (!result)                                            //no account
     {
-        pkt << uint8(WOW_FAIL_BANNED);
-        TC_LOG_DEBUG("server.authserver", "'%s:%d' [AuthChallenge] Banned ip tries to login!", ipAddress.c_str(), port);
+        SendLogonChallengeError(WOW_FAIL_UNKNOWN_ACCOUNT);
+        ProcessReadBuffer();
+        return;
     }
+
+    std::string ipAddress = GetRemoteIpAddress().to_string();
+    Field* fields = result->Fetch();
+
+    _accountId = fields[1].GetUInt32();
+    _tokenKey = fields[8].GetString();
+
+    uint8 secLevel = fields[5].GetUInt8();
+    _accountSecurityLevel = secLevel <= SEC_ADMINISTRATOR ? AccountTypes(secLevel) : SEC_ADMINISTRATOR;
+
+    // Don't calculate (v, s) if there are already some in the database
+    std::string databaseV = fields[6].GetString();
+    std::string databaseS = fields[7].GetString();
+
+    TC_LOG_DEBUG("network", "database authentication values: v='%s' s='%s'", databaseV.c_str(), databaseS.c_str());
+
+    // multiply with 2 since bytes are stored as hexstring
+    if (databaseV.size() != size_t(BufferSizes::SRP_6_V) * 2 || databaseS.size() != size_t(BufferSizes::SRP_6_S) * 2)
+        _passwordHash = fields[0].GetString();
     else
     {
-        // Get the account details from the account table
-        // No SQL injection (prepared statement)
-        stmt = LoginDatabase.GetPreparedStatement(LOGIN_SEL_LOGONCHALLENGE);
-        stmt->setString(0, _login);
+        _passwordHash.clear();
+        s.SetHexStr(databaseS.c_str());
+        v.SetHexStr(databaseV.c_str());
+    }
+
+    bool ipLocked = fields[2].GetUInt8() == 1;
+    std::string lastIp = fields[4].GetString();
+    _accountCountry = fields[3].GetString();
+
+    // Active account bans are joined in, every ban adds a row
+    _accountBanResult = WOW_SUCCESS;
+    do
+    {
+        Field* banFields = result->Fetch();
+        if (banFields[9].IsNull())
+            continue;
+
+        if (banFields[9].GetUInt32() == banFields[10].GetUInt32())
+            _accountBanResult = WOW_FAIL_BANNED;
+        else if (_accountBanResult != WOW_FAIL_BANNED)
+            _accountBanResult = WOW_FAIL_SUSPENDED;
+    }
+    while (result->NextRow());
 
-        PreparedQueryResult res2 = LoginDatabase.Query(stmt);
-        if (res2)
+    // If the IP is 'locked', check that the player comes indeed from the correct IP address
+    if (ipLocked)
+    {
+        TC_LOG_DEBUG("server.authserver", "[AuthChallenge] Account '%s' is locked to IP - '%s'", _login.c_str(), lastIp.c_str());
+        TC_LOG_DEBUG("server.authserver", "[AuthChallenge] Player address is '%s'", ipAddress.c_str());
+
+        if (lastIp != ipAddress)
         {
-            Field* fields = res2->Fetch();
+            TC_LOG_DEBUG("server.authserver", "[AuthChallenge] Account IP differs");
+            SendLogonChallengeError(WOW_FAIL_LOCKED_ENFORCED);
+            ProcessReadBuffer();
+            return;
+        }
 
-            // If the IP is 'locked', check that the player comes indeed from the correct IP address
-            bool locked = false;
-            if (fields[2].GetUInt8() == 1)                  // if ip is locked
-            {
-                TC_LOG_DEBUG("server.authserver", "[AuthChallenge] Account '%s' is locked to IP - '%s'", _login.c_str(), fields[4].GetCString());
-                TC_LOG_DEBUG("server.authserver", "[AuthChallenge] Player address is '%s'", ipAddress.c_str());
-
-                if (strcmp(fields[4].GetCString(), ipAddress.c_str()) != 0)
-                {
-                    TC_LOG_DEBUG("server.authserver", "[AuthChallenge] Account IP differs");
-                    pkt << uint8(WOW_FAIL_LOCKED_ENFORCED);
-                    locked = true;
-                }
-                else
-                    TC_LOG_DEBUG("server.authserver", "[AuthChallenge] Account IP matches");
-            }
-            else
-            {
-                TC_LOG_DEBUG("server.authserver", "[AuthChallenge] Account '%s' is not locked to ip", _login.c_str());
-                std::string accountCountry = fields[3].GetString();
-                if (accountCountry.empty() || accountCountry == "00")
-                    TC_LOG_DEBUG("server.authserver", "[AuthChallenge] Account '%s' is not locked to country", _login.c_str());
-                else if (!accountCountry.empty())
-                {
-                    uint32 ip = inet_addr(ipAddress.c_str());
-                    EndianConvertReverse(ip);
-
-                    stmt = LoginDatabase.GetPreparedStatement(LOGIN_SEL_LOGON_COUNTRY);
-                    stmt->setUInt32(0, ip);
-                    if (PreparedQueryResult sessionCountryQuery = LoginDatabase.Query(stmt))
-                    {
-                        std::string loginCountry = (*sessionCountryQuery)[0].GetString();
-                        TC_LOG_DEBUG("server.authserver", "[AuthChallenge] Account '%s' is locked to country: '%s' Player country is '%s'", _login.c_str(),
-                            accountCountry.c_str(), loginCountry.c_str());
-
-                        if (loginCountry != accountCountry)
-                        {
-                            TC_LOG_DEBUG("server.authserver", "[AuthChallenge] Account country differs.");
-                            pkt << uint8(WOW_FAIL_UNLOCKABLE_LOCK);
-                            locked = true;
-                        }
-                        else
-                            TC_LOG_DEBUG("server.authserver", "[AuthChallenge] Account country matches");
-                    }
-                    else
-                        TC_LOG_DEBUG("server.authserver", "[AuthChallenge] IP2NATION Table empty");
-                }
-            }
+        TC_LOG_DEBUG("server.authserver", "[AuthChallenge] Account IP matches");
+    }
+    else
+    {
+        TC_LOG_DEBUG("server.authserver", "[AuthChallenge] Account '%s' is not locked to ip", _login.c_str());
+        if (_accountCountry.empty() || _accountCountry == "00")
+            TC_LOG_DEBUG("server.authserver", "[AuthChallenge] Account '%s' is not locked to country", _login.c_str());
+        else
+        {
+            uint32 ip = inet_addr(ipAddress.c_str());
+            EndianConvertReverse(ip);
 
-            if (!locked)
-            {
-                //set expired bans to inactive
-                LoginDatabase.DirectExecute(LoginDatabase.GetPreparedStatement(LOGIN_UPD_EXPIRED_ACCOUNT_BANS));
-
-                //set expired premium to inactive
-                LoginDatabase.DirectExecute(LoginDatabase.GetPreparedStatement(LOGIN_UPD_EXPIRED_ACCOUNT_PREMIUM));
-
-                // If the account is banned, reject the logon attempt
-                stmt = LoginDatabase.GetPreparedStatement(LOGIN_SEL_ACCOUNT_BANNED);
-                stmt->setUInt32(0, fields[1].GetUInt32());
-                PreparedQueryResult banresult = LoginDatabase.Query(stmt);
-                if (banresult)
-                {
-                    if ((*banresult)[0].GetUInt32() == (*banresult)[1].GetUInt32())
-                    {
-                        pkt << uint8(WOW_FAIL_BANNED);
-                        TC_LOG_DEBUG("server.authserver", "'%s:%d' [AuthChallenge] Banned account %s tried to login!", ipAddress.c_str(),
-                            port, _login.c_str());
-                    }
-                    else
-                    {
-                        pkt << uint8(WOW_FAIL_SUSPENDED);
-                        TC_LOG_DEBUG("server.authserver", "'%s:%d' [AuthChallenge] Temporarily banned account %s tried to login!",
-                            ipAddress.c_str(), port, _login.c_str());
-                    }
-                }
-                else
-                {
-                    // Get the password from the account table, upper it, and make the SRP6 calculation
-                    std::string rI = fields[0].GetString();
-
-                    // Don't calculate (v, s) if there are already some in the database
-                    std::string databaseV = fields[6].GetString();
-                    std::string databaseS = fields[7].GetString();
-
-                    TC_LOG_DEBUG("network", "database authentication values: v='%s' s='%s'", databaseV.c_str(), databaseS.c_str());
-
-                    // multiply with 2 since bytes are stored as hexstring
-                    if (databaseV.size() != size_t(BufferSizes::SRP_6_V) * 2 || databaseS.size() != size_t(BufferSizes::SRP_6_S) * 2)
-                        SetVSFields(rI);
-                    else
-                    {
-                        s.SetHexStr(databaseS.c_str());
-                        v.SetHexStr(databaseV.c_str());
-                    }
-
-                    b.SetRand(19 * 8);
-                    BigNumber gmod = g.ModExp(b, N);
-                    B = ((v * 3) + gmod) % N;
-
-                    ASSERT(gmod.GetNumBytes() <= 32);
-
-                    BigNumber unk3;
-                    unk3.SetRand(16 * 8);
-
-                    // Fill the response packet with the result
-                    if (AuthHelper::IsAcceptedClientBuild(_build))
-                        pkt << uint8(WOW_SUCCESS);
-                    else
-                        pkt << uint8(WOW_FAIL_VERSION_INVALID);
-
-                    // B may be calculated < 32B so we force minimal length to 32B
-                    pkt.append(B.AsByteArray(32).get(), 32);      // 32 bytes
-                    pkt << uint8(1);
-                    pkt.append(g.AsByteArray(1).get(), 1);
-                    pkt << uint8(32);
-                    pkt.append(N.AsByteArray(32).get(), 32);
-                    pkt.append(s.AsByteArray(int32(BufferSizes::SRP_6_S)).get(), size_t(BufferSizes::SRP_6_S));   // 32 bytes
-                    pkt.append(unk3.AsByteArray(16).get(), 16);
-                    uint8 securityFlags = 0;
-
-                    // Check if token is used
-                    _tokenKey = fields[8].GetString();
-                    if (!_tokenKey.empty())
-                        securityFlags = 4;
-
-                    pkt << uint8(securityFlags);            // security flags (0x0...0x04)
-
-                    if (securityFlags & 0x01)               // PIN input
-                    {
-                        pkt << uint32(0);
-                        pkt << uint64(0) << uint64(0);      // 16 bytes hash?
-                    }
-
-                    if (securityFlags & 0x02)               // Matrix input
-                    {
-                        pkt << uint8(0);
-                        pkt << uint8(0);
-                        pkt << uint8(0);
-                        pkt << uint8(0);
-                        pkt << uint64(0);
-                    }
-
-                    if (securityFlags & 0x04)               // Security token input
-                        pkt << uint8(1);
-
-                    uint8 secLevel = fields[5].GetUInt8();
-                    _accountSecurityLevel = secLevel <= SEC_ADMINISTRATOR ? AccountTypes(secLevel) : SEC_ADMINISTRATOR;
-
-                    _localizationName.resize(4);
-                    for (int i = 0; i < 4; ++i)
-                        _localizationName[i] = challenge->country[4 - i - 1];
-
-                    TC_LOG_DEBUG("server.authserver", "'%s:%d' [AuthChallenge] account %s is using '%c%c%c%c' locale (%u)",
-                        ipAddress.c_str(), port, _login.c_str(),
-                        challenge->country[3], challenge->country[2], challenge->country[1], challenge->country[0],
-                        GetLocaleByName(_localizationName)
-                        );
-                }
-            }
+            PreparedStatement* stmt = LoginDatabase.GetPreparedStatement(LOGIN_SEL_LOGON_COUNTRY);
+            stmt->setUInt32(0, ip);
+            _logonCountryCallback = LoginDatabase.AsyncQuery(stmt);
+            return;
         }
-        else                                                //no account
-            pkt << uint8(WOW_FAIL_UNKNOWN_ACCOUNT);
     }
 
+    ContinueLogonChallenge();
+}
+
+void AuthSession::LogonCountryCallback(PreparedQueryResult result)
+{
+    if (result)
+    {
+        std::string loginCountry = (*result)[0].GetString();
+        TC_LOG_DEBUG("server.authserver", "[AuthChallenge] Account '%s' is locked to country: '%s' Player country is '%s'", _login.c_str(),
+            _accountCountry.c_str(), loginCountry.c_str());
+
+        if (loginCountry != _accountCountry)
+        {
+            TC_LOG_DEBUG("server.authserver", "[AuthChallenge] Account country differs.");
+            SendLogonChallengeError(WOW_FAIL_UNLOCKABLE_LOCK);
+            ProcessReadBuffer();
+            return;
+        }
+
+        TC_LOG_DEBUG("server.authserver", "[AuthChallenge] Account country matches");
+    }
+    else
+        TC_LOG_DEBUG("server.authserver", "[AuthChallenge] IP2NATION Table empty");
+
+    ContinueLogonChallenge();
+}
+
+void AuthSession::ContinueLogonChallenge()
+{
+    // If the account is banned, reject the logon attempt
+    if (_accountBanResult != WOW_SUCCESS)
+    {
+        if (_accountBanResult == WOW_FAIL_BANNED)
+            TC_LOG_DEBUG("server.authserver", "'%s:%d' [AuthChallenge] Banned account %s tried to login!", GetRemoteIpAddress().to_string().c_str(),
+                GetRemotePort(), _login.c_str());
+        else
+            TC_LOG_DEBUG("server.authserver", "'%s:%d' [AuthChallenge] Temporarily banned account %s tried to login!",
+                GetRemoteIpAddress().to_string().c_str(), GetRemotePort(), _login.c_str());
+
+        SendLogonChallengeError(_accountBanResult);
+        ProcessReadBuffer();
+        return;
+    }
+
+    // Make the SRP6 calculation on the compute pool, with the password hash from the account table if v and s must be generated
+    BigNumber modulus(N), generator(g), salt(s), verifier(v);
+    std::string passwordHash = _passwordHash;
+    _logonChallengeCalculation = sAuthComputePool->Enqueue<SRP6ChallengeValues>([modulus, generator, salt, verifier, passwordHash]() mutable
+    {
+        SRP6ChallengeValues values;
+        values.UpdateVS = !passwordHash.empty();
+        if (values.UpdateVS)
+            CalculateVSFields(passwordHash, modulus, generator, salt, verifier);
+
+        values.s = salt;
+        values.v = verifier;
+        values.b.SetRand(19 * 8);
+        BigNumber gmod = generator.ModExp(values.b, modulus);
+        values.B = ((verifier * 3) + gmod) % modulus;
+
+        ASSERT(gmod.GetNumBytes() <= 32);
+        return values;
+    });
+}
+
+void AuthSession::LogonChallengeCalculated(SRP6ChallengeValues const& values)
+{
+    s = values.s;
+    v = values.v;
+    b = values.b;
+    B = values.B;
+
+    if (values.UpdateVS)
+    {
+        // No SQL injection (username escaped)
+        char *v_hex, *s_hex;
+        v_hex = v.AsHexStr();
+        s_hex = s.AsHexStr();
+
+        PreparedStatement* stmt = LoginDatabase.GetPreparedStatement(LOGIN_UPD_VS);
+        stmt->setString(0, v_hex);
+        stmt->setString(1, s_hex);
+        stmt->setString(2, _login);
+        LoginDatabase.Execute(stmt);
+
+        OPENSSL_free(v_hex);
+        OPENSSL_free(s_hex);
+    }
+
+    BigNumber unk3;
+    unk3.SetRand(16 * 8);
+
+    ByteBuffer pkt;
+    pkt << uint8(AUTH_LOGON_CHALLENGE);
+    pkt << uint8(0x00);
+
+    // Fill the response packet with the result
+    if (AuthHelper::IsAcceptedClientBuild(_build))
+        pkt << uint8(WOW_SUCCESS);
+    else
+        pkt << uint8(WOW_FAIL_VERSION_INVALID);
+
+    // B may be calculated < 32B so we force minimal length to 32B
+    pkt.append(B.AsByteArray(32).get(), 32);      // 32 bytes
+    pkt << uint8(1);
+    pkt.append(g.AsByteArray(1).get(), 1);
+    pkt << uint8(32);
+    pkt.append(N.AsByteArray(32).get(), 32);
+    pkt.append(s.AsByteArray(int32(BufferSizes::SRP_6_S)).get(), size_t(BufferSizes::SRP_6_S));   // 32 bytes
+    pkt.append(unk3.AsByteArray(16).get(), 16);
+    uint8 securityFlags = 0;
+
+    // Check if token is used
+    if (!_tokenKey.empty())
+        securityFlags = 4;
+
+    pkt << uint8(securityFlags);            // security flags (0x0...0x04)
+
+    if (securityFlags & 0x01)               // PIN input
+    {
+        pkt << uint32(0);
+        pkt << uint64(0) << uint64(0);      // 16 bytes hash?
+    }
+
+    if (securityFlags & 0x02)               // Matrix input
+    {
+        pkt << uint8(0);
+        pkt << uint8(0);
+        pkt << uint8(0);
+        pkt << uint8(0);
+        pkt << uint64(0);
+    }
+
+    if (securityFlags & 0x04)               // Security token input
+        pkt << uint8(1);
+
+    TC_LOG_DEBUG("server.authserver", "'%s:%d' [AuthChallenge] account %s is using '%s' locale (%u)",
+        GetRemoteIpAddress().to_string().c_str(), GetRemotePort(), _login.c_str(), _localizationName.c_str(),
+        GetLocaleByName(_localizationName));
+
     SendPacket(pkt);
-    return true;
+    ProcessReadBuffer();
 }
 
 // Logon Proof command handler
@@ -439,75 +662,40 @@ bool AuthSession::HandleLogonProof()
         return false;
     }
 
-    SHA1Hash sha;
-    sha.UpdateBigNumbers(&A, &B, NULL);
-    sha.Finalize();
-    BigNumber u;
-    u.SetBinary(sha.GetDigest(), 20);
-    BigNumber S = (A * (v.ModExp(u, N))).ModExp(b, N);
-
-    uint8 t[32];
-    uint8 t1[16];
-    uint8 vK[40];
-    memcpy(t, S.AsByteArray(32).get(), 32);
+    uint8 M1[20];
+    memcpy(M1, logonProof->M1, 20);
 
-    for (int i = 0; i < 16; ++i)
-        t1[i] = t[i * 2];
-
-    sha.Initialize();
-    sha.UpdateData(t1, 16);
-    sha.Finalize();
-
-    for (int i = 0; i < 20; ++i)
-        vK[i * 2] = sha.GetDigest()[i];
-
-    for (int i = 0; i < 16; ++i)
-        t1[i] = t[i * 2 + 1];
-
-    sha.Initialize();
-    sha.UpdateData(t1, 16);
-    sha.Finalize();
-
-    for (int i = 0; i < 20; ++i)
-        vK[i * 2 + 1] = sha.GetDigest()[i];
-
-    K.SetBinary(vK, 40);
-
-    uint8 hash[20];
-
-    sha.Initialize();
-    sha.UpdateBigNumbers(&N, NULL);
-    sha.Finalize();
-    memcpy(hash, sha.GetDigest(), 20);
-    sha.Initialize();
-    sha.UpdateBigNumbers(&g, NULL);
-    sha.Finalize();
-
-    for (int i = 0; i < 20; ++i)
-        hash[i] ^= sha.GetDigest()[i];
-
-    BigNumber t3;
-    t3.SetBinary(hash, 20);
+    // Check auth token, it follows the proof and is gone from the buffer once the calculation is done
+    _validToken = true;
+    if ((logonProof->securityFlags & 0x04) || !_tokenKey.empty())
+    {
+        uint8 size = *(GetReadBuffer().GetReadPointer() + sizeof(sAuthLogonProof_C));
+        std::string token(reinterpret_cast<char*>(GetReadBuffer().GetReadPointer() + sizeof(sAuthLogonProof_C) + sizeof(size)), size);
+        GetReadBuffer().ReadCompleted(sizeof(size) + size);
+        uint32 validToken = TOTP::GenerateToken(_tokenKey.c_str());
+        uint32 incomingToken = atoi(token.c_str());
+        _validToken = validToken == incomingToken;
+    }
 
-    sha.Initialize();
-    sha.UpdateData(_login);
-    sha.Finalize();
-    uint8 t4[SHA_DIGEST_LENGTH];
-    memcpy(t4, sha.GetDigest(), SHA_DIGEST_LENGTH);
+    BigNumber modulus(N), generator(g), salt(s), verifier(v), privateB(b), publicB(B);
+    std::string login = _login;
+    _logonProofCalculation = sAuthComputePool->Enqueue<SRP6ProofValues>([login, A, modulus, generator, salt, verifier, privateB, publicB, M1]() mutable
+    {
+        return CalculateLogonProof(login, A, modulus, generator, salt, verifier, privateB, publicB, M1);
+    });
 
-    sha.Initialize();
-    sha.UpdateBigNumbers(&t3, NULL);
-    sha.UpdateData(t4, SHA_DIGEST_LENGTH);
-    sha.UpdateBigNumbers(&s, &A, &B, &K, NULL);
-    sha.Finalize();
-    BigNumber M;
-    M.SetBinary(sha.GetDigest(), sha.GetLength());
+    return true;
+}
 
+void AuthSession::LogonProofCalculated(SRP6ProofValues const& values)
+{
     // Check if SRP6 results match (password is correct), else send an error
-    if (!memcmp(M.AsByteArray(sha.GetLength()).get(), logonProof->M1, 20))
+    if (values.Valid)
     {
         TC_LOG_DEBUG("server.authserver", "'%s:%d' User '%s' successfully authenticated", GetRemoteIpAddress().to_string().c_str(), GetRemotePort(), _login.c_str());
 
+        K = values.K;
+
         // Update the sessionkey, last_ip, last login time and reset number of failed logins in the account table for this account
         // No SQL injection (escaped user name) and IP address as received by socket
         const char *K_hex = K.AsHexStr();
@@ -518,40 +706,28 @@ bool AuthSession::HandleLogonProof()
         stmt->setUInt32(2, GetLocaleByName(_localizationName));
         stmt->setString(3, _os);
         stmt->setString(4, _login);
+        // the worldserver reads the session key as soon as the client connects, it must be written before the reply
         LoginDatabase.DirectExecute(stmt);
 
         OPENSSL_free((void*)K_hex);
 
-        // Finish SRP6 and send the final result to the client
-        sha.Initialize();
-        sha.UpdateBigNumbers(&A, &M, &K, NULL);
-        sha.Finalize();
-
-        // Check auth token
-        if ((logonProof->securityFlags & 0x04) || !_tokenKey.empty())
+        if (!_validToken)
         {
-            uint8 size = *(GetReadBuffer().GetReadPointer() + sizeof(sAuthLogonProof_C));
-            std::string token(reinterpret_cast<char*>(GetReadBuffer().GetReadPointer() + sizeof(sAuthLogonProof_C) + sizeof(size)), size);
-            GetReadBuffer().ReadCompleted(sizeof(size) + size);
-            uint32 validToken = TOTP::GenerateToken(_tokenKey.c_str());
-            uint32 incomingToken = atoi(token.c_str());
-            if (validToken != incomingToken)
-            {
-                ByteBuffer packet;
-                packet << uint8(AUTH_LOGON_PROOF);
-                packet << uint8(WOW_FAIL_UNKNOWN_ACCOUNT);
-                packet << uint8(3);
-                packet << uint8(0);
-                SendPacket(packet);
-                return false;
-            }
+            ByteBuffer packet;
+            packet << uint8(AUTH_LOGON_PROOF);
+            packet << uint8(WOW_FAIL_UNKNOWN_ACCOUNT);
+            packet << uint8(3);
+            packet << uint8(0);
+            SendPacket(packet);
+            CloseSocket();
+            return;
         }
 
         ByteBuffer packet;
         if (_expversion & POST_BC_EXP_FLAG)                 // 2.x and 3.x clients
         {
             sAuthLogonProof_S proof;
-            memcpy(proof.M2, sha.GetDigest(), 20);
+            memcpy(proof.M2, values.M2, 20);
             proof.cmd = AUTH_LOGON_PROOF;
             proof.error = 0;
             proof.AccountFlags = 0x00800000;    // 0x01 = GM, 0x08 = Trial, 0x00800000 = Pro pass (arena tournament)
@@ -564,7 +740,7 @@ bool AuthSession::HandleLogonProof()
         else
         {
             sAuthLogonProof_S_Old proof;
-            memcpy(proof.M2, sha.GetDigest(), 20);
+            memcpy(proof.M2, values.M2, 20);
             proof.cmd = AUTH_LOGON_PROOF;
             proof.error = 0;
             proof.unk2 = 0x00;
@@ -610,43 +786,54 @@ bool AuthSession::HandleLogonProof()
 
             stmt = LoginDatabase.GetPreparedStatement(LOGIN_SEL_FAILEDLOGINS);
             stmt->setString(0, _login);
+            _failedLoginsCallback = LoginDatabase.AsyncQuery(stmt);
+            return;
+        }
+    }
+
+    ProcessReadBuffer();
+}
+
+void AuthSession::FailedLoginsCallback(PreparedQueryResult result)
+{
+    if (result)
+    {
+        uint32 MaxWrongPassCount = sConfigMgr->GetIntDefault("WrongPass.MaxCount", 0);
+        uint32 failed_logins = (*result)[1].GetUInt32();
 
-            if (PreparedQueryResult loginfail = LoginDatabase.Query(stmt))
+        if (failed_logins >= MaxWrongPassCount)
+        {
+            uint32 WrongPassBanTime = sConfigMgr->GetIntDefault("WrongPass.BanTime", 600);
+            bool WrongPassBanType = sConfigMgr->GetBoolDefault("WrongPass.BanType", false);
+
+            if (WrongPassBanType)
             {
-                uint32 failed_logins = (*loginfail)[1].GetUInt32();
-
-                if (failed_logins >= MaxWrongPassCount)
-                {
-                    uint32 WrongPassBanTime = sConfigMgr->GetIntDefault("WrongPass.BanTime", 600);
-                    bool WrongPassBanType = sConfigMgr->GetBoolDefault("WrongPass.BanType", false);
-
-                    if (WrongPassBanType)
-                    {
-                        uint32 acc_id = (*loginfail)[0].GetUInt32();
-                        stmt = LoginDatabase.GetPreparedStatement(LOGIN_INS_ACCOUNT_AUTO_BANNED);
-                        stmt->setUInt32(0, acc_id);
-                        stmt->setUInt32(1, WrongPassBanTime);
-                        LoginDatabase.Execute(stmt);
-
-                        TC_LOG_DEBUG("server.authserver", "'%s:%d' [AuthChallenge] account %s got banned for '%u' seconds because it failed to authenticate '%u' times",
-                            GetRemoteIpAddress().to_string().c_str(), GetRemotePort(), _login.c_str(), WrongPassBanTime, failed_logins);
-                    }
-                    else
-                    {
-                        stmt = LoginDatabase.GetPreparedStatement(LOGIN_INS_IP_AUTO_BANNED);
-                        stmt->setString(0, GetRemoteIpAddress().to_string());
-                        stmt->setUInt32(1, WrongPassBanTime);
-                        LoginDatabase.Execute(stmt);
-
-                        TC_LOG_DEBUG("server.authserver", "'%s:%d' [AuthChallenge] IP got banned for '%u' seconds because account %s failed to authenticate '%u' times",
-                            GetRemoteIpAddress().to_string().c_str(), GetRemotePort(), WrongPassBanTime, _login.c_str(), failed_logins);
-                    }
-                }
+                uint32 acc_id = (*result)[0].GetUInt32();
+                PreparedStatement* stmt = LoginDatabase.GetPreparedStatement(LOGIN_INS_ACCOUNT_AUTO_BANNED);
+                stmt->setUInt32(0, acc_id);
+                stmt->setUInt32(1, WrongPassBanTime);
+                LoginDatabase.Execute(stmt);
+
+                TC_LOG_DEBUG("server.authserver", "'%s:%d' [AuthChallenge] account %s got banned for '%u' seconds because it failed to authenticate '%u' times",
+                    GetRemoteIpAddress().to_string().c_str(), GetRemotePort(), _login.c_str(), WrongPassBanTime, failed_logins);
+            }
+            else
+            {
+                PreparedStatement* stmt = LoginDatabase.GetPreparedStatement(LOGIN_INS_IP_AUTO_BANNED);
+                stmt->setString(0, GetRemoteIpAddress().to_string());
+                stmt->setUInt32(1, WrongPassBanTime);
+                LoginDatabase.Execute(stmt);
+
+                // the next challenge from this address is rejected without waiting for the ban list reload
+                sIpBanCache->AddBan(GetRemoteIpAddress().to_string(), WrongPassBanTime);
+
+                TC_LOG_DEBUG("server.authserver", "'%s:%d' [AuthChallenge] IP got banned for '%u' seconds because account %s failed to authenticate '%u' times",
+                    GetRemoteIpAddress().to_string().c_str(), GetRemotePort(), WrongPassBanTime, _login.c_str(), failed_logins);
             }
         }
     }
 
-    return true;
+    ProcessReadBuffer();
 }
 
 bool AuthSession::HandleReconnectChallenge()
@@ -659,18 +846,6 @@ bool AuthSession::HandleReconnectChallenge()
 
     _login.assign((const char*)challenge->I, challenge->I_len);
 
-    PreparedStatement* stmt = LoginDatabase.GetPreparedStatement(LOGIN_SEL_SESSIONKEY);
-    stmt->setString(0, _login);
-    PreparedQueryResult result = LoginDatabase.Query(stmt);
-
-    // Stop if the account is not found
-    if (!result)
-    {
-        TC_LOG_ERROR("server.authserver", "'%s:%d' [ERROR] user %s tried to login and we cannot find his session key in the database.",
-            GetRemoteIpAddress().to_string().c_str(), GetRemotePort(), _login.c_str());
-        return false;
-    }
-
     // Reinitialize build, expansion and the account securitylevel
     _build = challenge->build;
     _expversion = uint8(AuthHelper::IsPostBCAcceptedClientBuild(_build) ? POST_BC_EXP_FLAG : (AuthHelper::IsPreBCAcceptedClientBuild(_build) ? PRE_BC_EXP_FLAG : NO_VALID_EXP_FLAG));
@@ -682,9 +857,27 @@ bool AuthSession::HandleReconnectChallenge()
     // Restore string order as its byte order is reversed
     std::reverse(_os.begin(), _os.end());
 
+    PreparedStatement* stmt = LoginDatabase.GetPreparedStatement(LOGIN_SEL_SESSIONKEY);
+    stmt->setString(0, _login);
+    _reconnectChallengeCallback = LoginDatabase.AsyncQuery(stmt);
+    return true;
+}
+
+void AuthSession::ReconnectChallengeCallback(PreparedQueryResult result)
+{
+    // Stop if the account is not found
+    if (!result)
+    {
+        TC_LOG_ERROR("server.authserver", "'%s:%d' [ERROR] user %s tried to login and we cannot find his session key in the database.",
+            GetRemoteIpAddress().to_string().c_str(), GetRemotePort(), _login.c_str());
+        CloseSocket();
+        return;
+    }
+
     Field* fields = result->Fetch();
     uint8 secLevel = fields[2].GetUInt8();
     _accountSecurityLevel = secLevel <= SEC_ADMINISTRATOR ? AccountTypes(secLevel) : SEC_ADMINISTRATOR;
+    _accountId = fields[1].GetUInt32();
 
     K.SetHexStr((*result)[0].GetCString());
 
@@ -697,9 +890,9 @@ bool AuthSession::HandleReconnectChallenge()
     pkt << uint64(0x00) << uint64(0x00);                    // 16 bytes zeros
 
     SendPacket(pkt);
-
-    return true;
+    ProcessReadBuffer();
 }
+
 bool AuthSession::HandleReconnectProof()
 {
     TC_LOG_DEBUG("server.authserver", "Entering _HandleReconnectProof");
@@ -775,21 +968,27 @@ bool AuthSession::HandleRealmList()
 {
     TC_LOG_DEBUG("server.authserver", "Entering _HandleRealmList");
 
-    // Get the user id (else close the connection)
+    // Get the number of characters of the account on every realm
     // No SQL injection (prepared statement)
-    PreparedStatement* stmt = LoginDatabase.GetPreparedStatement(LOGIN_SEL_ACCOUNT_ID_BY_NAME);
-    stmt->setString(0, _login);
-    PreparedQueryResult result = LoginDatabase.Query(stmt);
-    if (!result)
+    PreparedStatement* stmt = LoginDatabase.GetPreparedStatement(LOGIN_SEL_REALM_CHARACTER_COUNTS);
+    stmt->setUInt32(0, _accountId);
+    _realmListCallback = LoginDatabase.AsyncQuery(stmt);
+    return true;
+}
+
+void AuthSession::RealmListCallback(PreparedQueryResult result)
+{
+    std::map<uint32, uint8> characterCounts;
+    if (result)
     {
-        TC_LOG_ERROR("server.authserver", "'%s:%d' [ERROR] user %s tried to login but we cannot find him in the database.", GetRemoteIpAddress().to_string().c_str(),
-            GetRemotePort(), _login.c_str());
-        return false;
+        do
+        {
+            Field* fields = result->Fetch();
+            characterCounts[fields[0].GetUInt32()] = fields[1].GetUInt8();
+        }
+        while (result->NextRow());
     }
 
-    Field* fields = result->Fetch();
-    uint32 id = fields[0].GetUInt32();
-
     // Update realm list if need
     sRealmList->UpdateIfNeed();
 
@@ -828,12 +1027,9 @@ bool AuthSession::HandleRealmList()
         uint8 lock = (realm.allowedSecurityLevel > _accountSecurityLevel) ? 1 : 0;
 
         uint8 AmountOfCharacters = 0;
-        stmt = LoginDatabase.GetPreparedStatement(LOGIN_SEL_NUM_CHARS_ON_REALM);
-        stmt->setUInt32(0, realm.m_ID);
-        stmt->setUInt32(1, id);
-        result = LoginDatabase.Query(stmt);
-        if (result)
-            AmountOfCharacters = (*result)[0].GetUInt8();
+        std::map<uint32, uint8>::const_iterator characterCount = characterCounts.find(realm.m_ID);
+        if (characterCount != characterCounts.end())
+            AmountOfCharacters = characterCount->second;
 
         pkt << realm.icon;                                  // realm type
         if (_expversion & POST_BC_EXP_FLAG)                 // only 2.x and 3.x clients
@@ -885,7 +1081,7 @@ bool AuthSession::HandleRealmList()
     hdr.append(RealmListSizeBuffer);                        // append RealmList's size buffer
     hdr.append(pkt);                                        // append realms in the realmlist
     SendPacket(hdr);
-    return true;
+    ProcessReadBuffer();
 }
 
 // Resume patch transfer
@@ -912,40 +1108,3 @@ bool AuthSession::HandleXferAccept()
     //uint8
     return true;
 }
-
-// Make the SRP6 calculation from hash in dB
-void AuthSession::SetVSFields(const std::string& rI)
-{
-    s.SetRand(int32(BufferSizes::SRP_6_S) * 8);
-
-    BigNumber I;
-    I.SetHexStr(rI.c_str());
-
-    // In case of leading zeros in the rI hash, restore them
-    uint8 mDigest[SHA_DIGEST_LENGTH];
-    memcpy(mDigest, I.AsByteArray(SHA_DIGEST_LENGTH).get(), SHA_DIGEST_LENGTH);
-
-    std::reverse(mDigest, mDigest + SHA_DIGEST_LENGTH);
-
-    SHA1Hash sha;
-    sha.UpdateData(s.AsByteArray(uint32(BufferSizes::SRP_6_S)).get(), (uint32(BufferSizes::SRP_6_S)));
-    sha.UpdateData(mDigest, SHA_DIGEST_LENGTH);
-    sha.Finalize();
-    BigNumber x;
-    x.SetBinary(sha.GetDigest(), sha.GetLength());
-    v = g.ModExp(x, N);
-
-    // No SQL injection (username escaped)
-    char *v_hex, *s_hex;
-    v_hex = v.AsHexStr();
-    s_hex = s.AsHexStr();
-
-    PreparedStatement* stmt = LoginDatabase.GetPreparedStatement(LOGIN_UPD_VS);
-    stmt->setString(0, v_hex);
-    stmt->setString(1, s_hex);
-    stmt->setString(2, _login);
-    LoginDatabase.Execute(stmt);
-
-    OPENSSL_free(v_hex);
-    OPENSSL_free(s_hex);
-}
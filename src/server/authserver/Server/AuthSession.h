@@ -23,20 +23,43 @@
 #include "ByteBuffer.h"
 #include "Socket.h"
 #include "BigNumber.h"
+#include "DatabaseEnv.h"
+#include "AuthCodes.h"
+#include "SHA1.h"
+#include <future>
 #include <memory>
+#include <mutex>
 #include <boost/asio/ip/tcp.hpp>
 
 using boost::asio::ip::tcp;
 
 struct AuthHandler;
 
+// results of the SRP6 calculations done on the compute pool
+struct SRP6ChallengeValues
+{
+    BigNumber s, v;
+    BigNumber b, B;
+    bool UpdateVS;                                          // v and s were generated from the password hash
+};
+
+struct SRP6ProofValues
+{
+    bool Valid;                                             // client M1 matched, the password is correct
+    BigNumber K;
+    uint8 M2[SHA_DIGEST_LENGTH];
+};
+
 class AuthSession : public Socket<AuthSession>
 {
+    typedef Socket<AuthSession> AuthSocket;
+
 public:
     static std::unordered_map<uint8, AuthHandler> InitHandlers();
 
     AuthSession(tcp::socket&& socket) : Socket(std::move(socket)),
-        _isAuthenticated(false), _build(0), _expversion(0), _accountSecurityLevel(SEC_PLAYER)
+        _isAuthenticated(false), _validToken(true), _accountId(0), _build(0), _expversion(0),
+        _accountBanResult(WOW_SUCCESS), _accountSecurityLevel(SEC_PLAYER)
     {
         N.SetHexStr("894B645E89E1535BBDAD5B8B290650530801B18EBFBF5E8FAB3C82872A3E9BB7");
         g.SetDword(7);
@@ -47,6 +70,8 @@ public:
         AsyncRead();
     }
 
+    bool Update() override;
+
     void SendPacket(ByteBuffer& packet);
 
 protected:
@@ -64,7 +89,21 @@ private:
     bool HandleXferCancel();
     bool HandleXferAccept();
 
-    void SetVSFields(const std::string& rI);
+    // handlers waiting for a query or calculation leave the rest of the read buffer to their callback
+    void ProcessReadBuffer();
+    void ProcessQueryCallbacks();
+    bool IsWaitingForCallback() const;
+
+    void LogonChallengeCallback(PreparedQueryResult result);
+    void LogonCountryCallback(PreparedQueryResult result);
+    void LogonChallengeCalculated(SRP6ChallengeValues const& values);
+    void LogonProofCalculated(SRP6ProofValues const& values);
+    void FailedLoginsCallback(PreparedQueryResult result);
+    void ReconnectChallengeCallback(PreparedQueryResult result);
+    void RealmListCallback(PreparedQueryResult result);
+
+    void ContinueLogonChallenge();
+    void SendLogonChallengeError(AuthResult result);
 
     BigNumber N, s, g, v;
     BigNumber b, B;
@@ -72,14 +111,30 @@ private:
     BigNumber _reconnectProof;
 
     bool _isAuthenticated;
+    bool _validToken;
+    uint32 _accountId;
+    std::string _passwordHash;                              // set while v and s still have to be generated
+    std::string _accountCountry;
     std::string _tokenKey;
     std::string _login;
     std::string _localizationName;
     std::string _os;
     uint16 _build;
     uint8 _expversion;
+    AuthResult _accountBanResult;                           // active account ban, WOW_SUCCESS if none
 
     AccountTypes _accountSecurityLevel;
+
+    // read handlers run on the io service, callbacks on the network thread
+    std::mutex _sessionLock;
+
+    PreparedQueryResultFuture _logonChallengeCallback;
+    PreparedQueryResultFuture _logonCountryCallback;
+    PreparedQueryResultFuture _failedLoginsCallback;
+    PreparedQueryResultFuture _reconnectChallengeCallback;
+    PreparedQueryResultFuture _realmListCallback;
+    std::future<SRP6ChallengeValues> _logonChallengeCalculation;
+    std::future<SRP6ProofValues> _logonProofCalculation;
 };
 
 #pragma pack(push, 1)
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2008-2015 TrinityCore <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "IpBanCache.h"
+#include "DatabaseEnv.h"
+#include "Log.h"
+
+void IpBanCache::LoadFromDB()
+{
+    BanMap bans;
+
+    // only bans that are still active are selected
+    if (PreparedQueryResult result = LoginDatabase.Query(LoginDatabase.GetPreparedStatement(LOGIN_SEL_IP_BANNED_ALL)))
+    {
+        do
+        {
+            Field* fields = result->Fetch();
+            uint32 banDate = fields[1].GetUInt32();
+            uint32 unbanDate = fields[2].GetUInt32();
+            bans[fields[0].GetString()] = banDate == unbanDate ? 0 : time_t(unbanDate);
+        }
+        while (result->NextRow());
+    }
+
+    TC_LOG_DEBUG("server.authserver", "Loaded %u banned ip addresses.", uint32(bans.size()));
+
+    std::lock_guard<std::mutex> lock(_lock);
+    _bans.swap(bans);
+}
+
+bool IpBanCache::IsBanned(std::string const& ip) const
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    BanMap::const_iterator itr = _bans.find(ip);
+    if (itr == _bans.end())
+        return false;
+
+    return !itr->second || itr->second > time(nullptr);
+}
+
+void IpBanCache::AddBan(std::string const& ip, uint32 duration)
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    _bans[ip] = duration ? time(nullptr) + duration : 0;
+}
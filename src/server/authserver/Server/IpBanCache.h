@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2008-2015 TrinityCore <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IpBanCache_h__
+#define IpBanCache_h__
+
+#include "Define.h"
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Active ip_banned rows, checked on every logon challenge instead of querying the table.
+// Reloaded periodically from Main, bans issued by the worldserver apply after the next reload.
+class IpBanCache
+{
+public:
+    static IpBanCache* instance()
+    {
+        static IpBanCache instance;
+        return &instance;
+    }
+
+    void LoadFromDB();
+
+    bool IsBanned(std::string const& ip) const;
+
+    // bans issued by the authserver itself apply right away, 0 duration is permanent
+    void AddBan(std::string const& ip, uint32 duration);
+
+private:
+    IpBanCache() { }
+
+    typedef std::unordered_map<std::string, time_t> BanMap;     // unban time, 0 if permanent
+
+    mutable std::mutex _lock;
+    BanMap _bans;
+};
+
+#define sIpBanCache IpBanCache::instance()
+
+#endif // IpBanCache_h__
@@ -17,6 +17,7 @@
  */
 
 #include "BoundingIntervalHierarchy.h"
+#include "MappedFile.h"
 
 #ifdef _MSC_VER
   #define isnan _isnan
@@ -275,6 +276,30 @@ bool BIH::readFromFile(FILE* rf)
     return uint64(check) == uint64(3 + 3 + 1 + 1 + uint64(treeSize) + uint64(count));
 }
 
+bool BIH::readFromFile(VMAP::MappedFileReader& reader)
+{
+    G3D::Vector3 lo, hi;
+    uint32 treeSize, count;
+    if (!reader.read(&lo, sizeof(float) * 3) || !reader.read(&hi, sizeof(float) * 3) || !reader.read(treeSize))
+        return false;
+
+    bounds = G3D::AABox(lo, hi);
+    const char* treeData = reader.get(sizeof(uint32) * treeSize);
+    if (!treeData)
+        return false;
+
+    tree.assign(reinterpret_cast<const uint32*>(treeData), reinterpret_cast<const uint32*>(treeData) + treeSize);
+    if (!reader.read(count))
+        return false;
+
+    const char* objectData = reader.get(sizeof(uint32) * count);
+    if (!objectData)
+        return false;
+
+    objects.assign(reinterpret_cast<const uint32*>(objectData), reinterpret_cast<const uint32*>(objectData) + count);
+    return true;
+}
+
 void BIH::BuildStats::updateLeaf(int depth, int n)
 {
     numLeaves++;
@@ -32,6 +32,7 @@
 #include <cmath>
 
 #define MAX_STACK_SIZE 64
+#define BIH_RAY_PACKET_SIZE 4
 
 static inline uint32 floatToRawIntBits(float f)
 {
@@ -55,6 +56,11 @@ static inline float intBitsToFloat(uint32 i)
     return temp.fval;
 }
 
+namespace VMAP
+{
+    class MappedFileReader;
+}
+
 struct AABound
 {
     G3D::Vector3 lo, hi;
@@ -256,6 +262,215 @@ class BIH
             }
         }
 
+        /**
+        Any-hit test of up to BIH_RAY_PACKET_SIZE rays in one traversal, for batched line of sight checks.
+        The rays don't need to share origin or direction: every lane keeps its own interval and a node is
+        entered while any lane still overlaps it. The lane loops have a fixed width so they can be vectorized.
+        Order of traversal doesn't matter for an any-hit test, so children are always visited left first.
+        Returns the mask of rays that hit an object within their maxDist.
+        */
+        template<typename RayCallback>
+        uint32 intersectRayPacket(const G3D::Ray* rays, const float* maxDist, uint32 count, RayCallback& intersectCallback) const
+        {
+            float org[3][BIH_RAY_PACKET_SIZE];
+            float invDir[3][BIH_RAY_PACKET_SIZE];
+            float intervalMin[BIH_RAY_PACKET_SIZE];
+            float intervalMax[BIH_RAY_PACKET_SIZE];
+            uint32 activeMask = 0;
+            uint32 hitMask = 0;
+
+            for (uint32 i = 0; i < BIH_RAY_PACKET_SIZE; ++i)
+            {
+                // unused lanes get an empty interval
+                intervalMin[i] = 1.f;
+                intervalMax[i] = -1.f;
+                for (int a = 0; a < 3; ++a)
+                {
+                    org[a][i] = 0.f;
+                    invDir[a][i] = 1.f;
+                }
+            }
+
+            for (uint32 i = 0; i < count && i < BIH_RAY_PACKET_SIZE; ++i)
+            {
+                G3D::Vector3 const& o = rays[i].origin();
+                G3D::Vector3 const& d = rays[i].direction();
+                intervalMin[i] = 0.f;
+                intervalMax[i] = maxDist[i];
+                for (int a = 0; a < 3; ++a)
+                {
+                    org[a][i] = o[a];
+                    invDir[a][i] = 1.f / d[a];
+                    if (G3D::fuzzyNe(d[a], 0.0f))
+                    {
+                        float t1 = (bounds.low()[a]  - o[a]) * invDir[a][i];
+                        float t2 = (bounds.high()[a] - o[a]) * invDir[a][i];
+                        if (t1 > t2)
+                            std::swap(t1, t2);
+                        intervalMin[i] = std::max(intervalMin[i], t1);
+                        intervalMax[i] = std::min(intervalMax[i], t2);
+                    }
+                }
+
+                if (intervalMin[i] <= intervalMax[i])
+                    activeMask |= 1 << i;
+            }
+
+            struct PacketStackNode
+            {
+                uint32 node;
+                float tnear[BIH_RAY_PACKET_SIZE];
+                float tfar[BIH_RAY_PACKET_SIZE];
+            };
+
+            PacketStackNode stack[MAX_STACK_SIZE];
+            int stackPos = 0;
+            uint32 node = 0;
+
+            while (activeMask)
+            {
+                while (true)
+                {
+                    uint32 tn = tree[node];
+                    uint32 axis = (tn & (3 << 30)) >> 30;
+                    bool BVH2 = (tn & (1 << 29)) != 0;
+                    int offset = tn & ~(7 << 29);
+                    if (!BVH2)
+                    {
+                        if (axis < 3)
+                        {
+                            // "normal" interior node, left child ends at the first clip plane, right child starts at the second
+                            float clipL = intBitsToFloat(tree[node + 1]);
+                            float clipR = intBitsToFloat(tree[node + 2]);
+                            float leftMin[BIH_RAY_PACKET_SIZE], leftMax[BIH_RAY_PACKET_SIZE];
+                            float rightMin[BIH_RAY_PACKET_SIZE], rightMax[BIH_RAY_PACKET_SIZE];
+                            uint32 leftMask = 0;
+                            uint32 rightMask = 0;
+                            for (uint32 i = 0; i < BIH_RAY_PACKET_SIZE; ++i)
+                            {
+                                float tl = (clipL - org[axis][i]) * invDir[axis][i];
+                                float tr = (clipR - org[axis][i]) * invDir[axis][i];
+                                // NaN planes (ray inside a plane) keep the whole interval
+                                if (invDir[axis][i] >= 0.f)
+                                {
+                                    leftMin[i] = intervalMin[i];
+                                    leftMax[i] = std::min(intervalMax[i], tl);
+                                    rightMin[i] = std::max(intervalMin[i], tr);
+                                    rightMax[i] = intervalMax[i];
+                                }
+                                else
+                                {
+                                    leftMin[i] = std::max(intervalMin[i], tl);
+                                    leftMax[i] = intervalMax[i];
+                                    rightMin[i] = intervalMin[i];
+                                    rightMax[i] = std::min(intervalMax[i], tr);
+                                }
+                                leftMask |= uint32(leftMin[i] <= leftMax[i]) << i;
+                                rightMask |= uint32(rightMin[i] <= rightMax[i]) << i;
+                            }
+
+                            leftMask &= activeMask;
+                            rightMask &= activeMask;
+                            // all rays pass between clip zones
+                            if (!leftMask && !rightMask)
+                                break;
+
+                            if (leftMask && rightMask)
+                            {
+                                // push right node
+                                stack[stackPos].node = offset + 3;
+                                std::copy(rightMin, rightMin + BIH_RAY_PACKET_SIZE, stack[stackPos].tnear);
+                                std::copy(rightMax, rightMax + BIH_RAY_PACKET_SIZE, stack[stackPos].tfar);
+                                stackPos++;
+                            }
+
+                            if (leftMask)
+                            {
+                                node = offset;
+                                std::copy(leftMin, leftMin + BIH_RAY_PACKET_SIZE, intervalMin);
+                                std::copy(leftMax, leftMax + BIH_RAY_PACKET_SIZE, intervalMax);
+                            }
+                            else
+                            {
+                                node = offset + 3;
+                                std::copy(rightMin, rightMin + BIH_RAY_PACKET_SIZE, intervalMin);
+                                std::copy(rightMax, rightMax + BIH_RAY_PACKET_SIZE, intervalMax);
+                            }
+                            continue;
+                        }
+                        else
+                        {
+                            // leaf - test some objects with every ray still looking for a hit
+                            int n = tree[node + 1];
+                            while (n > 0)
+                            {
+                                for (uint32 i = 0; i < count; ++i)
+                                {
+                                    if (!(activeMask & (1 << i)) || intervalMin[i] > intervalMax[i])
+                                        continue;
+
+                                    float dist = maxDist[i];
+                                    if (intersectCallback(rays[i], objects[offset], dist, true))
+                                    {
+                                        hitMask |= 1 << i;
+                                        activeMask &= ~(1 << i);
+                                    }
+                                }
+
+                                if (!activeMask)
+                                    return hitMask;
+                                --n;
+                                ++offset;
+                            }
+                            break;
+                        }
+                    }
+                    else
+                    {
+                        if (axis > 2)
+                            return hitMask; // should not happen
+                        float nodeL = intBitsToFloat(tree[node + 1]);
+                        float nodeR = intBitsToFloat(tree[node + 2]);
+                        uint32 mask = 0;
+                        for (uint32 i = 0; i < BIH_RAY_PACKET_SIZE; ++i)
+                        {
+                            float t1 = (nodeL - org[axis][i]) * invDir[axis][i];
+                            float t2 = (nodeR - org[axis][i]) * invDir[axis][i];
+                            if (invDir[axis][i] < 0.f)
+                                std::swap(t1, t2);
+                            intervalMin[i] = std::max(intervalMin[i], t1);
+                            intervalMax[i] = std::min(intervalMax[i], t2);
+                            mask |= uint32(intervalMin[i] <= intervalMax[i]) << i;
+                        }
+                        node = offset;
+                        if (!(mask & activeMask))
+                            break;
+                        continue;
+                    }
+                } // traversal loop
+
+                // move back up the stack to a node some ray still looking for a hit overlaps
+                uint32 mask = 0;
+                while (!mask)
+                {
+                    // stack is empty?
+                    if (stackPos == 0)
+                        return hitMask;
+                    stackPos--;
+                    node = stack[stackPos].node;
+                    for (uint32 i = 0; i < BIH_RAY_PACKET_SIZE; ++i)
+                    {
+                        intervalMin[i] = stack[stackPos].tnear[i];
+                        intervalMax[i] = stack[stackPos].tfar[i];
+                        mask |= uint32(intervalMin[i] <= intervalMax[i]) << i;
+                    }
+                    mask &= activeMask;
+                }
+            }
+
+            return hitMask;
+        }
+
         template<typename IsectCallback>
         void intersectPoint(const G3D::Vector3 &p, IsectCallback& intersectCallback) const
         {
@@ -336,6 +551,7 @@ class BIH
 
         bool writeToFile(FILE* wf) const;
         bool readFromFile(FILE* rf);
+        bool readFromFile(VMAP::MappedFileReader& reader);
 
     protected:
         std::vector<uint32> tree;
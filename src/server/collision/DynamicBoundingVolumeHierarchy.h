@@ -0,0 +1,447 @@
+/*
+ * Copyright (C) 2008-2015 TrinityCore <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _DYNAMIC_BVH_H
+#define _DYNAMIC_BVH_H
+
+#include "G3D/AABox.h"
+#include "G3D/Ray.h"
+#include "G3D/Vector3.h"
+#include "G3D/BoundsTrait.h"
+
+#include "Define.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#define DYNAMIC_BVH_MARGIN      1.0f    // leaf bounds are enlarged by this, small moves don't touch the tree
+#define DYNAMIC_BVH_STACK_SIZE  64
+#define DYNAMIC_BVH_MAX_HEIGHT  (DYNAMIC_BVH_STACK_SIZE - 2)
+
+/**
+Bounding volume hierarchy updated in place: objects are inserted and removed by walking one path of
+the tree and moved objects are only reinserted once they leave their enlarged leaf bounds.
+Drop-in replacement for BIHWrap, which rebuilds its whole tree after every change.
+*/
+template<class T, class BoundsFunc = BoundsTrait<T> >
+class DynamicBVH
+{
+    enum
+    {
+        NULL_NODE = -1
+    };
+
+    struct Node
+    {
+        G3D::AABox bounds;                                  // leaves: object bounds plus DYNAMIC_BVH_MARGIN
+        const T* object;                                    // leaves only
+        int32 parent;                                       // next free node for unused nodes
+        int32 left;                                         // NULL_NODE for leaves
+        int32 right;
+        int32 height;                                       // 0 for leaves, -1 for unused nodes
+
+        bool isLeaf() const { return left == NULL_NODE; }
+    };
+
+    std::vector<Node> m_nodes;
+    int32 m_root;
+    int32 m_freeList;
+    std::unordered_map<const T*, int32> m_leaves;
+
+public:
+    DynamicBVH() : m_root(NULL_NODE), m_freeList(NULL_NODE) { }
+
+    void insert(const T& obj)
+    {
+        if (m_leaves.count(&obj))
+        {
+            update(obj);
+            return;
+        }
+
+        int32 leaf = allocateNode();
+        m_nodes[leaf].object = &obj;
+        m_nodes[leaf].height = 0;
+        m_nodes[leaf].bounds = getEnlargedBounds(obj);
+        m_leaves[&obj] = leaf;
+        insertLeaf(leaf);
+    }
+
+    void remove(const T& obj)
+    {
+        typename std::unordered_map<const T*, int32>::iterator itr = m_leaves.find(&obj);
+        if (itr == m_leaves.end())
+            return;
+
+        removeLeaf(itr->second);
+        freeNode(itr->second);
+        m_leaves.erase(itr);
+    }
+
+    // call after the bounds of obj changed, returns true if the tree had to change
+    bool update(const T& obj)
+    {
+        typename std::unordered_map<const T*, int32>::iterator itr = m_leaves.find(&obj);
+        if (itr == m_leaves.end())
+            return false;
+
+        G3D::AABox bounds;
+        BoundsFunc::getBounds(obj, bounds);
+        int32 leaf = itr->second;
+        if (contains(m_nodes[leaf].bounds, bounds))
+            return false;
+
+        removeLeaf(leaf);
+        m_nodes[leaf].bounds = getEnlargedBounds(obj);
+        insertLeaf(leaf);
+        return true;
+    }
+
+    bool contains(const T& obj) const { return m_leaves.count(&obj) != 0; }
+    uint32 size() const { return uint32(m_leaves.size()); }
+
+    // rebuilds the tree from scratch, only when incremental changes made it too deep
+    void balance()
+    {
+        if (m_root == NULL_NODE)
+            return;
+
+        uint32 optimalHeight = 0;
+        while ((size_t(1) << optimalHeight) < m_leaves.size())
+            ++optimalHeight;
+
+        if (uint32(m_nodes[m_root].height) > 2 * optimalHeight + 2)
+            rebuild();
+    }
+
+    // visits the leaves near to far, maxDist shrinks with every hit so the nearest one is found.
+    // stopAtFirstHit returns at the first hit instead, enough to know if anything is hit at all
+    template<typename RayCallback>
+    void intersectRay(const G3D::Ray& ray, RayCallback& intersectCallback, float& maxDist, bool stopAtFirstHit = false)
+    {
+        float entryDist;
+        if (m_root == NULL_NODE || !intersectsRay(m_nodes[m_root].bounds, ray, maxDist, entryDist))
+            return;
+
+        // nodes whose bounds the ray enters at entry distance
+        std::pair<int32, float> stack[DYNAMIC_BVH_STACK_SIZE];
+        int32 stackPos = 0;
+        stack[stackPos++] = std::make_pair(m_root, entryDist);
+        while (stackPos)
+        {
+            std::pair<int32, float> entry = stack[--stackPos];
+            if (entry.second > maxDist)
+                continue;
+
+            Node const& node = m_nodes[entry.first];
+            if (node.isLeaf())
+            {
+                if (intersectCallback(ray, *node.object, maxDist) && stopAtFirstHit)
+                    return;
+                continue;
+            }
+
+            float leftDist, rightDist;
+            bool left = intersectsRay(m_nodes[node.left].bounds, ray, maxDist, leftDist);
+            bool right = intersectsRay(m_nodes[node.right].bounds, ray, maxDist, rightDist);
+
+            // the nearer child goes on top
+            if (left && right && leftDist < rightDist)
+            {
+                stack[stackPos++] = std::make_pair(node.right, rightDist);
+                stack[stackPos++] = std::make_pair(node.left, leftDist);
+            }
+            else
+            {
+                if (left)
+                    stack[stackPos++] = std::make_pair(node.left, leftDist);
+                if (right)
+                    stack[stackPos++] = std::make_pair(node.right, rightDist);
+            }
+        }
+    }
+
+    template<typename IsectCallback>
+    void intersectPoint(const G3D::Vector3& point, IsectCallback& intersectCallback)
+    {
+        if (m_root == NULL_NODE)
+            return;
+
+        int32 stack[DYNAMIC_BVH_STACK_SIZE];
+        int32 stackPos = 0;
+        stack[stackPos++] = m_root;
+        while (stackPos)
+        {
+            Node const& node = m_nodes[stack[--stackPos]];
+            if (!node.bounds.contains(point))
+                continue;
+
+            if (node.isLeaf())
+            {
+                intersectCallback(point, *node.object);
+                continue;
+            }
+
+            stack[stackPos++] = node.left;
+            stack[stackPos++] = node.right;
+        }
+    }
+
+private:
+    static G3D::AABox getEnlargedBounds(const T& obj)
+    {
+        G3D::AABox bounds;
+        BoundsFunc::getBounds(obj, bounds);
+        G3D::Vector3 margin(DYNAMIC_BVH_MARGIN, DYNAMIC_BVH_MARGIN, DYNAMIC_BVH_MARGIN);
+        return G3D::AABox(bounds.low() - margin, bounds.high() + margin);
+    }
+
+    static G3D::AABox merge(const G3D::AABox& a, const G3D::AABox& b)
+    {
+        return G3D::AABox(a.low().min(b.low()), a.high().max(b.high()));
+    }
+
+    static bool contains(const G3D::AABox& outer, const G3D::AABox& inner)
+    {
+        return outer.low().x <= inner.low().x && outer.low().y <= inner.low().y && outer.low().z <= inner.low().z &&
+            outer.high().x >= inner.high().x && outer.high().y >= inner.high().y && outer.high().z >= inner.high().z;
+    }
+
+    static float surfaceArea(const G3D::AABox& box)
+    {
+        G3D::Vector3 extent = box.high() - box.low();
+        return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+    }
+
+    // entryDist is the distance at which the ray enters box, 0 if it starts inside
+    static bool intersectsRay(const G3D::AABox& box, const G3D::Ray& ray, float maxDist, float& entryDist)
+    {
+        float tNear = 0.0f;
+        float tFar = maxDist;
+        for (int i = 0; i < 3; ++i)
+        {
+            float origin = ray.origin()[i];
+            float dir = ray.direction()[i];
+            if (dir == 0.0f)
+            {
+                if (origin < box.low()[i] || origin > box.high()[i])
+                    return false;
+                continue;
+            }
+
+            float t1 = (box.low()[i] - origin) / dir;
+            float t2 = (box.high()[i] - origin) / dir;
+            if (t1 > t2)
+                std::swap(t1, t2);
+
+            tNear = std::max(tNear, t1);
+            tFar = std::min(tFar, t2);
+            if (tNear > tFar)
+                return false;
+        }
+
+        entryDist = tNear;
+        return true;
+    }
+
+    int32 allocateNode()
+    {
+        int32 index;
+        if (m_freeList != NULL_NODE)
+        {
+            index = m_freeList;
+            m_freeList = m_nodes[index].parent;
+        }
+        else
+        {
+            index = int32(m_nodes.size());
+            m_nodes.push_back(Node());
+        }
+
+        Node& node = m_nodes[index];
+        node.object = NULL;
+        node.parent = NULL_NODE;
+        node.left = NULL_NODE;
+        node.right = NULL_NODE;
+        node.height = 0;
+        return index;
+    }
+
+    void freeNode(int32 index)
+    {
+        m_nodes[index].parent = m_freeList;
+        m_nodes[index].height = -1;
+        m_freeList = index;
+    }
+
+    // cost of making leafBounds a descendant of child
+    float getDescendCost(int32 child, const G3D::AABox& leafBounds) const
+    {
+        float area = surfaceArea(merge(m_nodes[child].bounds, leafBounds));
+        if (m_nodes[child].isLeaf())
+            return area;
+
+        return area - surfaceArea(m_nodes[child].bounds);
+    }
+
+    void insertLeaf(int32 leaf)
+    {
+        if (m_root == NULL_NODE)
+        {
+            m_root = leaf;
+            m_nodes[leaf].parent = NULL_NODE;
+            return;
+        }
+
+        // find the sibling adding the least surface area to the tree
+        G3D::AABox leafBounds = m_nodes[leaf].bounds;
+        int32 index = m_root;
+        while (!m_nodes[index].isLeaf())
+        {
+            float area = surfaceArea(m_nodes[index].bounds);
+            float combinedArea = surfaceArea(merge(m_nodes[index].bounds, leafBounds));
+
+            // cost of a new parent for this node and the leaf
+            float cost = 2.0f * combinedArea;
+            // minimum cost pushed down to the children
+            float inheritanceCost = 2.0f * (combinedArea - area);
+            float costLeft = getDescendCost(m_nodes[index].left, leafBounds) + inheritanceCost;
+            float costRight = getDescendCost(m_nodes[index].right, leafBounds) + inheritanceCost;
+
+            if (cost < costLeft && cost < costRight)
+                break;
+
+            index = costLeft < costRight ? m_nodes[index].left : m_nodes[index].right;
+        }
+
+        int32 sibling = index;
+        int32 oldParent = m_nodes[sibling].parent;
+        int32 newParent = allocateNode();
+        m_nodes[newParent].parent = oldParent;
+        m_nodes[newParent].bounds = merge(leafBounds, m_nodes[sibling].bounds);
+        m_nodes[newParent].height = m_nodes[sibling].height + 1;
+        m_nodes[newParent].left = sibling;
+        m_nodes[newParent].right = leaf;
+        m_nodes[sibling].parent = newParent;
+        m_nodes[leaf].parent = newParent;
+
+        if (oldParent == NULL_NODE)
+            m_root = newParent;
+        else if (m_nodes[oldParent].left == sibling)
+            m_nodes[oldParent].left = newParent;
+        else
+            m_nodes[oldParent].right = newParent;
+
+        refit(oldParent);
+
+        // the traversal stacks are fixed size
+        if (m_nodes[m_root].height > DYNAMIC_BVH_MAX_HEIGHT)
+            rebuild();
+    }
+
+    void removeLeaf(int32 leaf)
+    {
+        if (leaf == m_root)
+        {
+            m_root = NULL_NODE;
+            return;
+        }
+
+        int32 parent = m_nodes[leaf].parent;
+        int32 grandParent = m_nodes[parent].parent;
+        int32 sibling = m_nodes[parent].left == leaf ? m_nodes[parent].right : m_nodes[parent].left;
+
+        m_nodes[sibling].parent = grandParent;
+        if (grandParent == NULL_NODE)
+            m_root = sibling;
+        else if (m_nodes[grandParent].left == parent)
+            m_nodes[grandParent].left = sibling;
+        else
+            m_nodes[grandParent].right = sibling;
+
+        freeNode(parent);
+        refit(grandParent);
+    }
+
+    // recalculates bounds and heights from index up to the root
+    void refit(int32 index)
+    {
+        while (index != NULL_NODE)
+        {
+            Node& node = m_nodes[index];
+            node.bounds = merge(m_nodes[node.left].bounds, m_nodes[node.right].bounds);
+            node.height = 1 + std::max(m_nodes[node.left].height, m_nodes[node.right].height);
+            index = node.parent;
+        }
+    }
+
+    void rebuild()
+    {
+        // drop all interior nodes, the leaves stay where they are
+        for (int32 i = 0; i < int32(m_nodes.size()); ++i)
+            if (m_nodes[i].height > 0)
+                freeNode(i);
+
+        std::vector<int32> leaves;
+        leaves.reserve(m_leaves.size());
+        for (typename std::unordered_map<const T*, int32>::const_iterator itr = m_leaves.begin(); itr != m_leaves.end(); ++itr)
+            leaves.push_back(itr->second);
+
+        m_root = leaves.empty() ? int32(NULL_NODE) : build(leaves, 0, leaves.size());
+        if (m_root != NULL_NODE)
+            m_nodes[m_root].parent = NULL_NODE;
+    }
+
+    // top down median split along the longest axis of the leaf centers
+    int32 build(std::vector<int32>& leaves, size_t begin, size_t end)
+    {
+        if (end - begin == 1)
+            return leaves[begin];
+
+        G3D::Vector3 low = m_nodes[leaves[begin]].bounds.center();
+        G3D::Vector3 high = low;
+        for (size_t i = begin + 1; i < end; ++i)
+        {
+            G3D::Vector3 center = m_nodes[leaves[i]].bounds.center();
+            low = low.min(center);
+            high = high.max(center);
+        }
+
+        G3D::Vector3 extent = high - low;
+        int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+        size_t mid = (begin + end) / 2;
+        std::nth_element(leaves.begin() + begin, leaves.begin() + mid, leaves.begin() + end, [this, axis](int32 a, int32 b)
+        {
+            return m_nodes[a].bounds.center()[axis] < m_nodes[b].bounds.center()[axis];
+        });
+
+        int32 left = build(leaves, begin, mid);
+        int32 right = build(leaves, mid, end);
+        int32 node = allocateNode();
+        m_nodes[node].left = left;
+        m_nodes[node].right = right;
+        m_nodes[node].bounds = merge(m_nodes[left].bounds, m_nodes[right].bounds);
+        m_nodes[node].height = 1 + std::max(m_nodes[left].height, m_nodes[right].height);
+        m_nodes[left].parent = node;
+        m_nodes[right].parent = node;
+        return node;
+    }
+};
+
+#endif // _DYNAMIC_BVH_H
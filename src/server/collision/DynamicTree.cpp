@@ -19,7 +19,7 @@
 #include "DynamicTree.h"
 //#include "QuadTree.h"
 //#include "RegularGrid.h"
-#include "BoundingIntervalHierarchyWrapper.h"
+#include "DynamicBoundingVolumeHierarchy.h"
 
 #include "Log.h"
 #include "RegularGrid.h"
@@ -58,7 +58,7 @@ static bool operator == (const GameObjectModel& mdl, const GameObjectModel& mdl2
 }
 */
 
-typedef RegularGrid2D<GameObjectModel, BIHWrap<GameObjectModel> > ParentTree;
+typedef RegularGrid2D<GameObjectModel, DynamicBVH<GameObjectModel> > ParentTree;
 
 struct DynTreeImpl : public ParentTree/*, public Intersectable*/
 {
@@ -66,45 +66,25 @@ struct DynTreeImpl : public ParentTree/*, public Intersectable*/
     typedef ParentTree base;
 
     DynTreeImpl() :
-        rebalance_timer(CHECK_TREE_PERIOD),
-        unbalanced_times(0)
+        rebalance_timer(CHECK_TREE_PERIOD)
     {
     }
 
-    void insert(const Model& mdl)
-    {
-        base::insert(mdl);
-        ++unbalanced_times;
-    }
-
-    void remove(const Model& mdl)
-    {
-        base::remove(mdl);
-        ++unbalanced_times;
-    }
-
-    void balance()
-    {
-        base::balance();
-        unbalanced_times = 0;
-    }
-
     void update(uint32 difftime)
     {
         if (!size())
             return;
 
+        // the cell trees are updated in place, this only rebuilds those that became too deep
         rebalance_timer.Update(difftime);
         if (rebalance_timer.Passed())
         {
             rebalance_timer.Reset(CHECK_TREE_PERIOD);
-            if (unbalanced_times > 0)
-                balance();
+            balance();
         }
     }
 
     TimeTrackerSmall rebalance_timer;
-    int unbalanced_times;
 };
 
 DynamicMapTree::DynamicMapTree() : impl(new DynTreeImpl()) { }
@@ -124,6 +104,11 @@ void DynamicMapTree::remove(const GameObjectModel& mdl)
     impl->remove(mdl);
 }
 
+void DynamicMapTree::relocate(const GameObjectModel& mdl)
+{
+    impl->relocate(mdl);
+}
+
 bool DynamicMapTree::contains(const GameObjectModel& mdl) const
 {
     return impl->contains(mdl);
@@ -148,11 +133,15 @@ struct DynamicTreeIntersectionCallback
 {
     bool did_hit;
     uint32 phase_mask;
-    DynamicTreeIntersectionCallback(uint32 phasemask) : did_hit(false), phase_mask(phasemask) { }
+    bool stop_at_first_hit;
+    DynamicTreeIntersectionCallback(uint32 phasemask, bool stopAtFirstHit) : did_hit(false), phase_mask(phasemask), stop_at_first_hit(stopAtFirstHit) { }
     bool operator()(const G3D::Ray& r, const GameObjectModel& obj, float& distance)
     {
-        did_hit = obj.intersectRay(r, distance, true, phase_mask);
-        return did_hit;
+        // distance only shrinks, a later miss must not forget an earlier hit
+        bool hit = obj.intersectRay(r, distance, stop_at_first_hit, phase_mask);
+        if (hit)
+            did_hit = true;
+        return hit;
     }
     bool didHit() const { return did_hit;}
 };
@@ -183,7 +172,7 @@ bool DynamicMapTree::getIntersectionTime(const uint32 phasemask, const G3D::Ray&
                                          const G3D::Vector3& endPos, float& maxDist) const
 {
     float distance = maxDist;
-    DynamicTreeIntersectionCallback callback(phasemask);
+    DynamicTreeIntersectionCallback callback(phasemask, false);
     impl->intersectRay(ray, callback, distance, endPos);
     if (callback.didHit())
         maxDist = distance;
@@ -240,8 +229,8 @@ bool DynamicMapTree::isInLineOfSight(float x1, float y1, float z1, float x2, flo
         return true;
 
     G3D::Ray r(v1, (v2-v1) / maxDist);
-    DynamicTreeIntersectionCallback callback(phasemask);
-    impl->intersectRay(r, callback, maxDist, v2);
+    DynamicTreeIntersectionCallback callback(phasemask, true);
+    impl->intersectRay(r, callback, maxDist, v2, true);
 
     return !callback.did_hit;
 }
@@ -250,7 +239,7 @@ float DynamicMapTree::getHeight(float x, float y, float z, float maxSearchDist,
 {
     G3D::Vector3 v(x, y, z);
     G3D::Ray r(v, G3D::Vector3(0, 0, -1));
-    DynamicTreeIntersectionCallback callback(phasemask);
+    DynamicTreeIntersectionCallback callback(phasemask, false);
     impl->intersectZAllignedRay(r, callback, maxSearchDist);
 
     if (callback.didHit())
@@ -54,6 +54,7 @@ public:
 
     void insert(const GameObjectModel&);
     void remove(const GameObjectModel&);
+    void relocate(const GameObjectModel&);                  // after GameObjectModel::Relocate
     bool contains(const GameObjectModel&) const;
     int size() const;
 
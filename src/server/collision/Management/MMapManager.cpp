@@ -17,26 +17,30 @@
  */
 
 #include "MMapManager.h"
+#include "DetourNode.h"
 #include "Log.h"
 #include "World.h"
+#include <algorithm>
 
 namespace MMAP
 {
     // ######################## MMapManager ########################
     MMapManager::~MMapManager()
     {
-        for (MMapDataSet::iterator i = loadedMMaps.begin(); i != loadedMMaps.end(); ++i)
-            delete i->second;
+        loadedMMaps.clear();
+
+        for (PrefetchedTileSet::iterator i = _prefetchedTiles.begin(); i != _prefetchedTiles.end(); ++i)
+            dtFree(i->second.first);
 
         // by now we should not have maps loaded
         // if we had, tiles in MMapData->mmapLoadedTiles, their actual data is lost!
     }
 
-    bool MMapManager::loadMapData(uint32 mapId)
+    MMapDataPtr MMapManager::loadMapData(uint32 mapId)
     {
         // we already have this map loaded?
-        if (loadedMMaps.find(mapId) != loadedMMaps.end())
-            return true;
+        if (MMapDataPtr mmap = GetMMapData(mapId))
+            return mmap;
 
         // load and init dtNavMesh - read parameters from file
         uint32 pathLen = sWorld->GetDataPath().length() + strlen("mmaps/%03i.mmap")+1;
@@ -48,7 +52,7 @@ namespace MMAP
         {
             TC_LOG_DEBUG("maps", "MMAP:loadMapData: Error: Could not open mmap file '%s'", fileName);
             delete [] fileName;
-            return false;
+            return MMapDataPtr();
         }
 
         dtNavMeshParams params;
@@ -58,7 +62,7 @@ namespace MMAP
         {
             TC_LOG_DEBUG("maps", "MMAP:loadMapData: Error: Could not read params from file '%s'", fileName);
             delete [] fileName;
-            return false;
+            return MMapDataPtr();
         }
 
         dtNavMesh* mesh = dtAllocNavMesh();
@@ -68,19 +72,18 @@ namespace MMAP
             dtFreeNavMesh(mesh);
             TC_LOG_ERROR("maps", "MMAP:loadMapData: Failed to initialize dtNavMesh for mmap %03u from file %s", mapId, fileName);
             delete [] fileName;
-            return false;
+            return MMapDataPtr();
         }
 
         delete [] fileName;
 
         TC_LOG_DEBUG("maps", "MMAP:loadMapData: Loaded %03i.mmap", mapId);
 
-        // store inside our map list
-        MMapData* mmap_data = new MMapData(mesh);
-        mmap_data->mmapLoadedTiles.clear();
+        // store inside our map list, another instance of the map may have been faster
+        MMapDataPtr mmap_data = std::make_shared<MMapData>(mesh);
 
-        loadedMMaps.insert(std::pair<uint32, MMapData*>(mapId, mmap_data));
-        return true;
+        boost::unique_lock<boost::shared_mutex> lock(_loadedMMapsLock);
+        return loadedMMaps.insert(MMapDataSet::value_type(mapId, mmap_data)).first->second;
     }
 
     uint32 MMapManager::packTileID(int32 x, int32 y)
@@ -88,21 +91,8 @@ namespace MMAP
         return uint32(x << 16 | y);
     }
 
-    bool MMapManager::loadMap(const std::string& /*basePath*/, uint32 mapId, int32 x, int32 y)
+    bool MMapManager::readTile(uint32 mapId, int32 x, int32 y, unsigned char*& data, uint32& dataSize)
     {
-        // make sure the mmap is loaded and ready to load tiles
-        if (!loadMapData(mapId))
-            return false;
-
-        // get this mmap data
-        MMapData* mmap = loadedMMaps[mapId];
-        ASSERT(mmap->navMesh);
-
-        // check if we already have this tile loaded
-        uint32 packedGridPos = packTileID(x, y);
-        if (mmap->mmapLoadedTiles.find(packedGridPos) != mmap->mmapLoadedTiles.end())
-            return false;
-
         // load this tile :: mmaps/MMMXXYY.mmtile
         uint32 pathLen = sWorld->GetDataPath().length() + strlen("mmaps/%03i%02i%02i.mmtile")+1;
         char *fileName = new char[pathLen];
@@ -135,25 +125,106 @@ namespace MMAP
             return false;
         }
 
-        unsigned char* data = (unsigned char*)dtAlloc(fileHeader.size, DT_ALLOC_PERM);
+        data = (unsigned char*)dtAlloc(fileHeader.size, DT_ALLOC_PERM);
         ASSERT(data);
 
         size_t result = fread(data, fileHeader.size, 1, file);
         if (!result)
         {
             TC_LOG_ERROR("maps", "MMAP:loadMap: Bad header or data in mmap %03u%02i%02i.mmtile", mapId, x, y);
+            dtFree(data);
+            data = NULL;
             fclose(file);
             return false;
         }
 
         fclose(file);
 
+        dataSize = fileHeader.size;
+        return true;
+    }
+
+    void MMapManager::prefetchTile(uint32 mapId, int32 x, int32 y)
+    {
+        uint64 key = packPrefetchKey(mapId, x, y);
+        {
+            std::lock_guard<std::mutex> lock(_prefetchLock);
+            if (_prefetchedTiles.find(key) != _prefetchedTiles.end())
+                return;
+        }
+
+        unsigned char* data = NULL;
+        uint32 dataSize = 0;
+        if (!readTile(mapId, x, y, data, dataSize))
+            return;
+
+        std::lock_guard<std::mutex> lock(_prefetchLock);
+        if (!_prefetchedTiles.insert(PrefetchedTileSet::value_type(key, std::make_pair(data, dataSize))).second)
+            dtFree(data);                                   // another thread was faster
+    }
+
+    void MMapManager::releasePrefetchedTile(uint32 mapId, int32 x, int32 y)
+    {
+        std::lock_guard<std::mutex> lock(_prefetchLock);
+        PrefetchedTileSet::iterator prefetched = _prefetchedTiles.find(packPrefetchKey(mapId, x, y));
+        if (prefetched == _prefetchedTiles.end())
+            return;
+
+        dtFree(prefetched->second.first);
+        _prefetchedTiles.erase(prefetched);
+    }
+
+    bool MMapManager::loadMap(const std::string& /*basePath*/, uint32 mapId, int32 x, int32 y)
+    {
+        // make sure the mmap is loaded and ready to load tiles
+        MMapDataPtr mmap = loadMapData(mapId);
+        if (!mmap)
+            return false;
+
+        ASSERT(mmap->navMesh);
+
+        // check if we already have this tile loaded
+        uint32 packedGridPos = packTileID(x, y);
+        {
+            boost::shared_lock<boost::shared_mutex> lock(mmap->navMeshLock);
+            if (mmap->mmapLoadedTiles.find(packedGridPos) != mmap->mmapLoadedTiles.end())
+                return false;
+        }
+
+        // use the tile file if it was read ahead, read it now otherwise
+        unsigned char* data = NULL;
+        uint32 dataSize = 0;
+        {
+            std::lock_guard<std::mutex> lock(_prefetchLock);
+            PrefetchedTileSet::iterator prefetched = _prefetchedTiles.find(packPrefetchKey(mapId, x, y));
+            if (prefetched != _prefetchedTiles.end())
+            {
+                data = prefetched->second.first;
+                dataSize = prefetched->second.second;
+                _prefetchedTiles.erase(prefetched);
+            }
+        }
+
+        if (!data && !readTile(mapId, x, y, data, dataSize))
+            return false;
+
         dtMeshHeader* header = (dtMeshHeader*)data;
         dtTileRef tileRef = 0;
 
+        boost::unique_lock<boost::shared_mutex> lock(mmap->navMeshLock);
+
+        // another instance of the map may have loaded the tile meanwhile
+        if (mmap->mmapLoadedTiles.find(packedGridPos) != mmap->mmapLoadedTiles.end())
+        {
+            dtFree(data);
+            return false;
+        }
+
         // memory allocated for data is now managed by detour, and will be deallocated when the tile is removed
-        if (dtStatusSucceed(mmap->navMesh->addTile(data, fileHeader.size, DT_TILE_FREE_DATA, 0, &tileRef)))
+        if (dtStatusSucceed(mmap->navMesh->addTile(data, dataSize, DT_TILE_FREE_DATA, 0, &tileRef)))
         {
+            mmap->pathCache.Clear();
+            _pathCacheInvalidations.fetch_add(1, std::memory_order_relaxed);
             mmap->mmapLoadedTiles.insert(std::pair<uint32, dtTileRef>(packedGridPos, tileRef));
             ++loadedTiles;
             TC_LOG_DEBUG("maps", "MMAP:loadMap: Loaded mmtile %03i[%02i, %02i] into %03i[%02i, %02i]", mapId, x, y, mapId, header->x, header->y);
@@ -172,25 +243,27 @@ namespace MMAP
     bool MMapManager::unloadMap(uint32 mapId, int32 x, int32 y)
     {
         // check if we have this map loaded
-        if (loadedMMaps.find(mapId) == loadedMMaps.end())
+        MMapDataPtr mmap = GetMMapData(mapId);
+        if (!mmap)
         {
             // file may not exist, therefore not loaded
             TC_LOG_DEBUG("maps", "MMAP:unloadMap: Asked to unload not loaded navmesh map. %03u%02i%02i.mmtile", mapId, x, y);
             return false;
         }
 
-        MMapData* mmap = loadedMMaps[mapId];
+        boost::unique_lock<boost::shared_mutex> lock(mmap->navMeshLock);
 
         // check if we have this tile loaded
         uint32 packedGridPos = packTileID(x, y);
-        if (mmap->mmapLoadedTiles.find(packedGridPos) == mmap->mmapLoadedTiles.end())
+        MMapTileSet::const_iterator tile = mmap->mmapLoadedTiles.find(packedGridPos);
+        if (tile == mmap->mmapLoadedTiles.end())
         {
             // file may not exist, therefore not loaded
             TC_LOG_DEBUG("maps", "MMAP:unloadMap: Asked to unload not loaded navmesh tile. %03u%02i%02i.mmtile", mapId, x, y);
             return false;
         }
 
-        dtTileRef tileRef = mmap->mmapLoadedTiles[packedGridPos];
+        dtTileRef tileRef = tile->second;
 
         // unload, and mark as non loaded
         if (dtStatusFailed(mmap->navMesh->removeTile(tileRef, NULL, NULL)))
@@ -203,6 +276,8 @@ namespace MMAP
         }
         else
         {
+            mmap->pathCache.Clear();
+            _pathCacheInvalidations.fetch_add(1, std::memory_order_relaxed);
             mmap->mmapLoadedTiles.erase(packedGridPos);
             --loadedTiles;
             TC_LOG_DEBUG("maps", "MMAP:unloadMap: Unloaded mmtile %03i[%02i, %02i] from %03i", mapId, x, y, mapId);
@@ -214,15 +289,23 @@ namespace MMAP
 
     bool MMapManager::unloadMap(uint32 mapId)
     {
-        if (loadedMMaps.find(mapId) == loadedMMaps.end())
+        MMapDataPtr mmap;
         {
-            // file may not exist, therefore not loaded
-            TC_LOG_DEBUG("maps", "MMAP:unloadMap: Asked to unload not loaded navmesh map %03u", mapId);
-            return false;
+            boost::unique_lock<boost::shared_mutex> lock(_loadedMMapsLock);
+            MMapDataSet::iterator itr = loadedMMaps.find(mapId);
+            if (itr == loadedMMaps.end())
+            {
+                // file may not exist, therefore not loaded
+                TC_LOG_DEBUG("maps", "MMAP:unloadMap: Asked to unload not loaded navmesh map %03u", mapId);
+                return false;
+            }
+
+            mmap = itr->second;
+            loadedMMaps.erase(itr);
         }
 
-        // unload all tiles from given map
-        MMapData* mmap = loadedMMaps[mapId];
+        // unload all tiles from given map, searches still holding the data find them gone
+        boost::unique_lock<boost::shared_mutex> lock(mmap->navMeshLock);
         for (MMapTileSet::iterator i = mmap->mmapLoadedTiles.begin(); i != mmap->mmapLoadedTiles.end(); ++i)
         {
             uint32 x = (i->first >> 16);
@@ -236,69 +319,208 @@ namespace MMAP
             }
         }
 
-        delete mmap;
-        loadedMMaps.erase(mapId);
+        mmap->mmapLoadedTiles.clear();
+        mmap->pathCache.Clear();
         TC_LOG_DEBUG("maps", "MMAP:unloadMap: Unloaded %03i.mmap", mapId);
 
         return true;
     }
 
-    bool MMapManager::unloadMapInstance(uint32 mapId, uint32 instanceId)
+    dtNavMesh const* MMapManager::GetNavMesh(uint32 mapId)
     {
-        // check if we have this map loaded
-        if (loadedMMaps.find(mapId) == loadedMMaps.end())
+        MMapDataPtr mmap = GetMMapData(mapId);
+        if (!mmap)
+            return NULL;
+
+        return mmap->navMesh;
+    }
+
+    MMapDataPtr MMapManager::GetMMapData(uint32 mapId)
+    {
+        boost::shared_lock<boost::shared_mutex> lock(_loadedMMapsLock);
+        MMapDataSet::const_iterator itr = loadedMMaps.find(mapId);
+        if (itr == loadedMMaps.end())
+            return MMapDataPtr();
+
+        return itr->second;
+    }
+
+    // slot of the calling thread in MMapData::navMeshQueries, 0 until first use
+    static TRINITY_THREAD_LOCAL uint32 QueryThreadSlot = 0;
+    static std::atomic<uint32> NextQueryThreadSlot(0);
+
+    dtNavMeshQuery** MMapManager::GetThreadNavMeshQuery(MMapData* mmap)
+    {
+        if (!QueryThreadSlot)
+            QueryThreadSlot = ++NextQueryThreadSlot;
+
+        uint32 slot = QueryThreadSlot - 1;
+        if (slot < MMAP_MAX_QUERY_THREADS)
+            return &mmap->navMeshQueries[slot];
+
+        // the element itself is only ever used by this thread, the lock guards the container
+        std::lock_guard<std::mutex> lock(mmap->overflowNavMeshQueriesLock);
+        return &mmap->overflowNavMeshQueries[slot];
+    }
+
+    dtNavMeshQuery const* MMapManager::GetNavMeshQuery(uint32 mapId)
+    {
+        MMapDataPtr mmap = GetMMapData(mapId);
+        if (!mmap)
+            return NULL;
+
+        return GetNavMeshQuery(mmap.get(), mapId);
+    }
+
+    dtNavMeshQuery const* MMapManager::GetNavMeshQuery(MMapData* mmap, uint32 mapId)
+    {
+        dtNavMeshQuery** query = GetThreadNavMeshQuery(mmap);
+        if (!*query)
         {
-            // file may not exist, therefore not loaded
-            TC_LOG_DEBUG("maps", "MMAP:unloadMapInstance: Asked to unload not loaded navmesh map %03u", mapId);
-            return false;
+            // allocate mesh query
+            dtNavMeshQuery* newQuery = dtAllocNavMeshQuery();
+            ASSERT(newQuery);
+            if (dtStatusFailed(newQuery->init(mmap->navMesh, MMAP_MIN_QUERY_NODES)))
+            {
+                dtFreeNavMeshQuery(newQuery);
+                TC_LOG_ERROR("maps", "MMAP:GetNavMeshQuery: Failed to initialize dtNavMeshQuery for mapId %03u", mapId);
+                return NULL;
+            }
+
+            TC_LOG_DEBUG("maps", "MMAP:GetNavMeshQuery: created dtNavMeshQuery for mapId %03u thread slot %u", mapId, QueryThreadSlot - 1);
+            *query = newQuery;
+            _queries.fetch_add(1, std::memory_order_relaxed);
         }
 
-        MMapData* mmap = loadedMMaps[mapId];
-        if (mmap->navMeshQueries.find(instanceId) == mmap->navMeshQueries.end())
+        return *query;
+    }
+
+    bool MMapManager::GrowNavMeshQuery(MMapData* mmap, uint32 mapId)
+    {
+        dtNavMeshQuery* query = *GetThreadNavMeshQuery(mmap);
+        if (!query)
+            return false;
+
+        int maxNodes = query->getNodePool()->getMaxNodes();
+        if (maxNodes >= MMAP_MAX_QUERY_NODES)
+            return false;
+
+        maxNodes = std::min<int>(maxNodes * 2, MMAP_MAX_QUERY_NODES);
+        if (dtStatusFailed(query->init(mmap->navMesh, maxNodes)))
         {
-            TC_LOG_DEBUG("maps", "MMAP:unloadMapInstance: Asked to unload not loaded dtNavMeshQuery mapId %03u instanceId %u", mapId, instanceId);
+            TC_LOG_ERROR("maps", "MMAP:GrowNavMeshQuery: Failed to grow dtNavMeshQuery for mapId %03u to %i nodes", mapId, maxNodes);
             return false;
         }
 
-        dtNavMeshQuery* query = mmap->navMeshQueries[instanceId];
+        TC_LOG_DEBUG("maps", "MMAP:GrowNavMeshQuery: grew dtNavMeshQuery for mapId %03u thread slot %u to %i nodes", mapId, QueryThreadSlot - 1, maxNodes);
+        _nodePoolGrowths.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void MMapManager::AddPathStats(uint32 findPathCalls, uint32 nodesExpanded, uint64 pathTime)
+    {
+        _paths.fetch_add(1, std::memory_order_relaxed);
+        _findPathCalls.fetch_add(findPathCalls, std::memory_order_relaxed);
+        _nodesExpanded.fetch_add(nodesExpanded, std::memory_order_relaxed);
+        _pathTime.fetch_add(pathTime, std::memory_order_relaxed);
+    }
+
+    MMapQueryStats MMapManager::GetQueryStats() const
+    {
+        MMapQueryStats stats;
+        stats.Paths = _paths.load(std::memory_order_relaxed);
+        stats.FindPathCalls = _findPathCalls.load(std::memory_order_relaxed);
+        stats.NodesExpanded = _nodesExpanded.load(std::memory_order_relaxed);
+        stats.PathTime = _pathTime.load(std::memory_order_relaxed);
+        stats.NodePoolGrowths = _nodePoolGrowths.load(std::memory_order_relaxed);
+        stats.Queries = _queries.load(std::memory_order_relaxed);
+        return stats;
+    }
 
-        dtFreeNavMeshQuery(query);
-        mmap->navMeshQueries.erase(instanceId);
-        TC_LOG_DEBUG("maps", "MMAP:unloadMapInstance: Unloaded mapId %03u instanceId %u", mapId, instanceId);
+    bool MMapManager::FindCachedPath(MMapData* mmap, MMapPathCacheKey const& key, dtPolyRef* path, uint32* pathSize, uint32 maxPath)
+    {
+        if (!mmap->pathCache.Find(key, path, pathSize, maxPath))
+        {
+            _pathCacheMisses.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
 
+        _pathCacheHits.fetch_add(1, std::memory_order_relaxed);
         return true;
     }
 
-    dtNavMesh const* MMapManager::GetNavMesh(uint32 mapId)
+    void MMapManager::CachePath(MMapData* mmap, MMapPathCacheKey const& key, dtPolyRef const* path, uint32 pathSize)
     {
-        if (loadedMMaps.find(mapId) == loadedMMaps.end())
-            return NULL;
+        bool evicted = false;
+        mmap->pathCache.Insert(key, path, pathSize, evicted);
+        if (evicted)
+            _pathCacheEvictions.fetch_add(1, std::memory_order_relaxed);
+    }
 
-        return loadedMMaps[mapId]->navMesh;
+    MMapPathCacheStats MMapManager::GetPathCacheStats()
+    {
+        MMapPathCacheStats stats;
+        stats.Hits = _pathCacheHits.load(std::memory_order_relaxed);
+        stats.Misses = _pathCacheMisses.load(std::memory_order_relaxed);
+        stats.Evictions = _pathCacheEvictions.load(std::memory_order_relaxed);
+        stats.Invalidations = _pathCacheInvalidations.load(std::memory_order_relaxed);
+        stats.Entries = 0;
+
+        boost::shared_lock<boost::shared_mutex> lock(_loadedMMapsLock);
+        for (MMapDataSet::iterator i = loadedMMaps.begin(); i != loadedMMaps.end(); ++i)
+            stats.Entries += i->second->pathCache.GetSize();
+
+        return stats;
     }
 
-    dtNavMeshQuery const* MMapManager::GetNavMeshQuery(uint32 mapId, uint32 instanceId)
+    // ######################## MMapPathCache ########################
+    bool MMapPathCache::Find(MMapPathCacheKey const& key, dtPolyRef* path, uint32* pathSize, uint32 maxPath)
     {
-        if (loadedMMaps.find(mapId) == loadedMMaps.end())
-            return NULL;
+        std::lock_guard<std::mutex> lock(_lock);
 
-        MMapData* mmap = loadedMMaps[mapId];
-        if (mmap->navMeshQueries.find(instanceId) == mmap->navMeshQueries.end())
-        {
-            // allocate mesh query
-            dtNavMeshQuery* query = dtAllocNavMeshQuery();
-            ASSERT(query);
-            if (dtStatusFailed(query->init(mmap->navMesh, 1024)))
-            {
-                dtFreeNavMeshQuery(query);
-                TC_LOG_ERROR("maps", "MMAP:GetNavMeshQuery: Failed to initialize dtNavMeshQuery for mapId %03u instanceId %u", mapId, instanceId);
-                return NULL;
-            }
+        auto itr = _index.find(key);
+        if (itr == _index.end() || itr->second->second.size() > maxPath)
+            return false;
+
+        // move to front
+        _entries.splice(_entries.begin(), _entries, itr->second);
+
+        std::vector<dtPolyRef> const& corridor = itr->second->second;
+        std::copy(corridor.begin(), corridor.end(), path);
+        *pathSize = uint32(corridor.size());
+        return true;
+    }
+
+    bool MMapPathCache::Insert(MMapPathCacheKey const& key, dtPolyRef const* path, uint32 pathSize, bool& evicted)
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+
+        evicted = false;
+        if (_index.find(key) != _index.end())
+            return false;
 
-            TC_LOG_DEBUG("maps", "MMAP:GetNavMeshQuery: created dtNavMeshQuery for mapId %03u instanceId %u", mapId, instanceId);
-            mmap->navMeshQueries.insert(std::pair<uint32, dtNavMeshQuery*>(instanceId, query));
+        if (_index.size() >= MMAP_PATH_CACHE_SIZE)
+        {
+            _index.erase(_entries.back().first);
+            _entries.pop_back();
+            evicted = true;
         }
 
-        return mmap->navMeshQueries[instanceId];
+        _entries.push_front(Entry(key, std::vector<dtPolyRef>(path, path + pathSize)));
+        _index[key] = _entries.begin();
+        return true;
+    }
+
+    void MMapPathCache::Clear()
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        _index.clear();
+        _entries.clear();
+    }
+
+    uint32 MMapPathCache::GetSize()
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        return uint32(_index.size());
     }
-}
\ No newline at end of file
+}
@@ -23,22 +23,92 @@
 #include "DetourAlloc.h"
 #include "DetourNavMesh.h"
 #include "DetourNavMeshQuery.h"
+#include <boost/thread/shared_mutex.hpp>
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 //  move map related classes
 namespace MMAP
 {
+    enum MMapQueryLimits
+    {
+        MMAP_MIN_QUERY_NODES    = 256,      // node pool of a new dtNavMeshQuery
+        MMAP_MAX_QUERY_NODES    = 1024,     // node pools are doubled up to this size when a search runs out of nodes
+        MMAP_MAX_QUERY_THREADS  = 64,       // threads with a lock free query slot, further threads use NavMeshQuerySet
+        MMAP_PATH_CACHE_SIZE    = 512       // corridors kept by the path cache of a map
+    };
+
+    struct MMapPathCacheKey
+    {
+        MMapPathCacheKey(dtPolyRef start, dtPolyRef end, uint16 include, uint16 exclude) :
+            startRef(start), endRef(end), includeFlags(include), excludeFlags(exclude) { }
+
+        bool operator==(MMapPathCacheKey const& right) const
+        {
+            return startRef == right.startRef && endRef == right.endRef &&
+                includeFlags == right.includeFlags && excludeFlags == right.excludeFlags;
+        }
+
+        dtPolyRef startRef;
+        dtPolyRef endRef;
+        uint16 includeFlags;
+        uint16 excludeFlags;
+    };
+
+    struct MMapPathCacheKeyHash
+    {
+        size_t operator()(MMapPathCacheKey const& key) const
+        {
+            return std::hash<uint64>()((uint64(key.startRef) * 0x9E3779B97F4A7C15ULL) ^ uint64(key.endRef)) ^
+                (size_t(key.includeFlags) << 16 | key.excludeFlags);
+        }
+    };
+
+    // least recently used findPath corridors of a map, shared by all threads searching it
+    class MMapPathCache
+    {
+        public:
+            // true and the corridor copied to path if a corridor of at most maxPath polygons is cached
+            bool Find(MMapPathCacheKey const& key, dtPolyRef* path, uint32* pathSize, uint32 maxPath);
+            // false if the key was already cached, true otherwise. Evicts the least recently used corridor if full
+            bool Insert(MMapPathCacheKey const& key, dtPolyRef const* path, uint32 pathSize, bool& evicted);
+            // polygon references of removed tiles may be reused, so corridors don't survive tile changes
+            void Clear();
+            uint32 GetSize();
+
+        private:
+            typedef std::pair<MMapPathCacheKey, std::vector<dtPolyRef> > Entry;
+            typedef std::list<Entry> EntryList;
+
+            std::mutex _lock;
+            EntryList _entries;     // most recently used first
+            std::unordered_map<MMapPathCacheKey, EntryList::iterator, MMapPathCacheKeyHash> _index;
+    };
+
     typedef std::unordered_map<uint32, dtTileRef> MMapTileSet;
     typedef std::unordered_map<uint32, dtNavMeshQuery*> NavMeshQuerySet;
 
     // dummy struct to hold map's mmap data
     struct MMapData
     {
-        MMapData(dtNavMesh* mesh) : navMesh(mesh) { }
+        MMapData(dtNavMesh* mesh) : navMesh(mesh)
+        {
+            for (uint32 i = 0; i < MMAP_MAX_QUERY_THREADS; ++i)
+                navMeshQueries[i] = NULL;
+        }
+
         ~MMapData()
         {
-            for (NavMeshQuerySet::iterator i = navMeshQueries.begin(); i != navMeshQueries.end(); ++i)
+            for (uint32 i = 0; i < MMAP_MAX_QUERY_THREADS; ++i)
+                if (navMeshQueries[i])
+                    dtFreeNavMeshQuery(navMeshQueries[i]);
+
+            for (NavMeshQuerySet::iterator i = overflowNavMeshQueries.begin(); i != overflowNavMeshQueries.end(); ++i)
                 dtFreeNavMeshQuery(i->second);
 
             if (navMesh)
@@ -47,39 +117,109 @@ namespace MMAP
 
         dtNavMesh* navMesh;
 
-        // we have to use single dtNavMeshQuery for every instance, since those are not thread safe
-        NavMeshQuerySet navMeshQueries;     // instanceId to query
+        // dtNavMeshQuery is not thread safe, so every thread gets its own one, shared by all instances of the map
+        dtNavMeshQuery* navMeshQueries[MMAP_MAX_QUERY_THREADS];    // query thread slot to query
+        NavMeshQuerySet overflowNavMeshQueries;                     // query thread slot to query, slots past MMAP_MAX_QUERY_THREADS
+        std::mutex overflowNavMeshQueriesLock;
         MMapTileSet mmapLoadedTiles;        // maps [map grid coords] to [dtTile]
+
+        // tiles are added and removed while holding this exclusively, searches hold it shared
+        boost::shared_mutex navMeshLock;
+
+        MMapPathCache pathCache;
+    };
+
+    struct MMapQueryStats
+    {
+        uint64 Paths;                       // paths calculated on a navmesh
+        uint64 FindPathCalls;               // dtNavMeshQuery::findPath calls, including retries with a grown node pool
+        uint64 NodesExpanded;               // search nodes used by those calls
+        uint64 PathTime;                    // time spent calculating those paths, in microseconds
+        uint64 NodePoolGrowths;             // node pools grown after a search ran out of nodes
+        uint64 Queries;                     // dtNavMeshQuery objects allocated
     };
 
+    struct MMapPathCacheStats
+    {
+        uint64 Hits;                        // findPath calls answered by the path cache
+        uint64 Misses;                      // findPath calls that had to search
+        uint64 Evictions;                   // corridors dropped for more recently used ones
+        uint64 Invalidations;               // path caches cleared because a tile was loaded or unloaded
+        uint32 Entries;                     // corridors cached over all maps
+    };
 
-    typedef std::unordered_map<uint32, MMapData*> MMapDataSet;
+
+    // searches keep the data of their map alive, unloadMap may drop it meanwhile
+    typedef std::shared_ptr<MMapData> MMapDataPtr;
+    typedef std::unordered_map<uint32, MMapDataPtr> MMapDataSet;
 
     // singleton class
     // holds all all access to mmap loading unloading and meshes
     class MMapManager
     {
         public:
-            MMapManager() : loadedTiles(0) { }
+            MMapManager() : loadedTiles(0), _paths(0), _findPathCalls(0), _nodesExpanded(0), _pathTime(0), _nodePoolGrowths(0), _queries(0),
+                _pathCacheHits(0), _pathCacheMisses(0), _pathCacheEvictions(0), _pathCacheInvalidations(0) { }
             ~MMapManager();
 
             bool loadMap(const std::string& basePath, uint32 mapId, int32 x, int32 y);
             bool unloadMap(uint32 mapId, int32 x, int32 y);
             bool unloadMap(uint32 mapId);
-            bool unloadMapInstance(uint32 mapId, uint32 instanceId);
 
-            // the returned [dtNavMeshQuery const*] is NOT threadsafe
-            dtNavMeshQuery const* GetNavMeshQuery(uint32 mapId, uint32 instanceId);
+            // reads a tile file ahead of its loadMap, thread safe. Unused tiles must be released
+            void prefetchTile(uint32 mapId, int32 x, int32 y);
+            void releasePrefetchedTile(uint32 mapId, int32 x, int32 y);
+
+            // the returned [dtNavMeshQuery const*] belongs to the calling thread and must not be passed to another one
+            dtNavMeshQuery const* GetNavMeshQuery(uint32 mapId);
+            dtNavMeshQuery const* GetNavMeshQuery(MMapData* mmap, uint32 mapId);
+            // doubles the node pool of the calling thread's query, false if it is already at MMAP_MAX_QUERY_NODES
+            bool GrowNavMeshQuery(MMapData* mmap, uint32 mapId);
             dtNavMesh const* GetNavMesh(uint32 mapId);
+            // NULL if the map has no mmap data, its navMeshLock must be held shared while searching the navmesh
+            MMapDataPtr GetMMapData(uint32 mapId);
+
+            void AddPathStats(uint32 findPathCalls, uint32 nodesExpanded, uint64 pathTime);
+            MMapQueryStats GetQueryStats() const;
+
+            bool FindCachedPath(MMapData* mmap, MMapPathCacheKey const& key, dtPolyRef* path, uint32* pathSize, uint32 maxPath);
+            void CachePath(MMapData* mmap, MMapPathCacheKey const& key, dtPolyRef const* path, uint32 pathSize);
+            MMapPathCacheStats GetPathCacheStats();
 
             uint32 getLoadedTilesCount() const { return loadedTiles; }
-            uint32 getLoadedMapsCount() const { return loadedMMaps.size(); }
+            uint32 getLoadedMapsCount() const
+            {
+                boost::shared_lock<boost::shared_mutex> lock(_loadedMMapsLock);
+                return loadedMMaps.size();
+            }
         private:
-            bool loadMapData(uint32 mapId);
+            MMapDataPtr loadMapData(uint32 mapId);
             uint32 packTileID(int32 x, int32 y);
+            dtNavMeshQuery** GetThreadNavMeshQuery(MMapData* mmap);
+            static bool readTile(uint32 mapId, int32 x, int32 y, unsigned char*& data, uint32& dataSize);
+            static uint64 packPrefetchKey(uint32 mapId, int32 x, int32 y) { return uint64(mapId) << 32 | uint32(x << 16 | y); }
+
+            // tile data read by prefetchTile, handed to the navmesh by the next loadMap of the tile
+            typedef std::unordered_map<uint64, std::pair<unsigned char*, uint32> > PrefetchedTileSet;
+            std::mutex _prefetchLock;
+            PrefetchedTileSet _prefetchedTiles;
 
+            // map threads load and unload the maps they update, pathfinding workers look them up
+            mutable boost::shared_mutex _loadedMMapsLock;
             MMapDataSet loadedMMaps;
-            uint32 loadedTiles;
+            std::atomic<uint32> loadedTiles;
+
+            std::atomic<uint64> _paths;
+            std::atomic<uint64> _findPathCalls;
+            std::atomic<uint64> _nodesExpanded;
+            std::atomic<uint64> _pathTime;
+            std::atomic<uint64> _nodePoolGrowths;
+            std::atomic<uint64> _queries;
+
+            std::atomic<uint64> _pathCacheHits;
+            std::atomic<uint64> _pathCacheMisses;
+            std::atomic<uint64> _pathCacheEvictions;
+            std::atomic<uint64> _pathCacheInvalidations;
     };
 }
 
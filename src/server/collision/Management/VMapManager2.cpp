@@ -28,6 +28,9 @@
 #include "Log.h"
 #include "VMapDefinitions.h"
 #include "Errors.h"
+#include <atomic>
+#include <set>
+#include <thread>
 
 using G3D::Vector3;
 
@@ -81,6 +84,9 @@ namespace VMAP
                 result = VMAP_LOAD_RESULT_OK;
             else
                 result = VMAP_LOAD_RESULT_ERROR;
+
+            // the tile holds its own references now
+            releasePrefetchedTile(mapId, x, y);
         }
 
         return result;
@@ -152,6 +158,52 @@ namespace VMAP
         return true;
     }
 
+    void VMapManager2::isInLineOfSight(unsigned int mapId, LineOfSightRay* rays, uint32 count)
+    {
+        for (uint32 i = 0; i < count; ++i)
+            rays[i].inLineOfSight = true;
+
+        if (!isLineOfSightCalcEnabled() || IsVMAPDisabledForPtr(mapId, VMAP_DISABLE_LOS))
+            return;
+
+        InstanceTreeMap::iterator instanceTree = iInstanceMapTrees.find(mapId);
+        if (instanceTree == iInstanceMapTrees.end())
+            return;
+
+        // hand the rays to the tree in packets the BIH traverses together
+        Vector3 pos1[BIH_RAY_PACKET_SIZE];
+        Vector3 pos2[BIH_RAY_PACKET_SIZE];
+        bool results[BIH_RAY_PACKET_SIZE];
+        LineOfSightRay* packet[BIH_RAY_PACKET_SIZE];
+        uint32 packetSize = 0;
+        for (uint32 i = 0; i < count; ++i)
+        {
+            LineOfSightRay& ray = rays[i];
+            pos1[packetSize] = convertPositionToInternalRep(ray.x1, ray.y1, ray.z1);
+            pos2[packetSize] = convertPositionToInternalRep(ray.x2, ray.y2, ray.z2);
+            if (pos1[packetSize] == pos2[packetSize])
+                continue;
+
+            packet[packetSize++] = &ray;
+            if (packetSize < BIH_RAY_PACKET_SIZE && i + 1 < count)
+                continue;
+
+            instanceTree->second->isInLineOfSight(pos1, pos2, results, packetSize);
+            for (uint32 j = 0; j < packetSize; ++j)
+                packet[j]->inLineOfSight = results[j];
+
+            packetSize = 0;
+        }
+
+        // the last rays may have been skipped after the packet was started
+        if (packetSize)
+        {
+            instanceTree->second->isInLineOfSight(pos1, pos2, results, packetSize);
+            for (uint32 j = 0; j < packetSize; ++j)
+                packet[j]->inLineOfSight = results[j];
+        }
+    }
+
     /**
     get the hit position and return true if we hit something
     otherwise the result pos will be the dest pos
@@ -252,23 +304,39 @@ namespace VMAP
 
     WorldModel* VMapManager2::acquireModelInstance(const std::string& basepath, const std::string& filename)
     {
-        //! Critical section, thread safe access to iLoadedModelFiles
+        {
+            //! Critical section, thread safe access to iLoadedModelFiles
+            std::lock_guard<std::mutex> lock(LoadedModelFilesLock);
+
+            ModelFileMap::iterator model = iLoadedModelFiles.find(filename);
+            if (model != iLoadedModelFiles.end())
+            {
+                model->second.incRefCount();
+                return model->second.getModel();
+            }
+        }
+
+        // read outside of the lock so preloading threads don't wait for each other
+        WorldModel* worldmodel = new WorldModel();
+        if (!worldmodel->readFile(basepath + filename + ".vmo"))
+        {
+            VMAP_ERROR_LOG("misc", "VMapManager2: could not load '%s%s.vmo'", basepath.c_str(), filename.c_str());
+            delete worldmodel;
+            return NULL;
+        }
+
         std::lock_guard<std::mutex> lock(LoadedModelFilesLock);
 
         ModelFileMap::iterator model = iLoadedModelFiles.find(filename);
         if (model == iLoadedModelFiles.end())
         {
-            WorldModel* worldmodel = new WorldModel();
-            if (!worldmodel->readFile(basepath + filename + ".vmo"))
-            {
-                VMAP_ERROR_LOG("misc", "VMapManager2: could not load '%s%s.vmo'", basepath.c_str(), filename.c_str());
-                delete worldmodel;
-                return NULL;
-            }
             VMAP_DEBUG_LOG("maps", "VMapManager2: loading file '%s%s'", basepath.c_str(), filename.c_str());
             model = iLoadedModelFiles.insert(std::pair<std::string, ManagedModel>(filename, ManagedModel())).first;
             model->second.setModel(worldmodel);
         }
+        else
+            delete worldmodel;                              // another thread was faster
+
         model->second.incRefCount();
         return model->second.getModel();
     }
@@ -292,6 +360,87 @@ namespace VMAP
         }
     }
 
+    void VMapManager2::preloadMaps(const std::string& basePath, const std::vector<uint32>& mapIds, uint32 threadCount)
+    {
+        std::string path = basePath;
+        if (path.length() > 0 && path[path.length()-1] != '/' && path[path.length()-1] != '\\')
+            path.push_back('/');
+
+        std::set<std::string> modelNames;
+        uint32 tileCount = 0;
+        for (uint32 mapId : mapIds)
+            if (!StaticMapTree::getModelNames(path, mapId, modelNames, tileCount))
+                VMAP_ERROR_LOG("misc", "VMapManager2: could not preload map %u, no valid '%s%s'", mapId, path.c_str(), getMapFileName(mapId).c_str());
+
+        threadCount = std::max<uint32>(threadCount, 1);
+        std::vector<std::string> names(modelNames.begin(), modelNames.end());
+        std::vector<std::vector<std::string>> loaded(threadCount);
+        std::atomic<size_t> nextModel(0);
+
+        std::vector<std::thread> threads;
+        for (uint32 i = 0; i < threadCount; ++i)
+        {
+            threads.push_back(std::thread([this, &path, &names, &nextModel, &loaded, i]()
+            {
+                for (size_t model = nextModel++; model < names.size(); model = nextModel++)
+                    if (acquireModelInstance(path, names[model]))
+                        loaded[i].push_back(names[model]);
+            }));
+        }
+
+        for (std::thread& thread : threads)
+            thread.join();
+
+        for (uint32 i = 0; i < threadCount; ++i)
+            iPreloadedModels.insert(iPreloadedModels.end(), loaded[i].begin(), loaded[i].end());
+
+        VMAP_INFO_LOG("misc", "VMapManager2: preloaded " SZFMTD " models of %u tiles on %u threads", iPreloadedModels.size(), tileCount, threadCount);
+    }
+
+    void VMapManager2::prefetchTile(const std::string& basePath, unsigned int mapId, int x, int y)
+    {
+        uint64 key = uint64(mapId) << 32 | StaticMapTree::packTileID(x, y);
+        {
+            std::lock_guard<std::mutex> lock(PrefetchedTilesLock);
+            if (iPrefetchedTiles.find(key) != iPrefetchedTiles.end())
+                return;
+        }
+
+        std::string path = basePath;
+        if (path.length() > 0 && path[path.length()-1] != '/' && path[path.length()-1] != '\\')
+            path.push_back('/');
+
+        std::set<std::string> modelNames;
+        if (!StaticMapTree::getTileModelNames(path, mapId, x, y, modelNames))
+            return;
+
+        std::vector<std::string> acquired;
+        for (std::string const& name : modelNames)
+            if (acquireModelInstance(path, name))
+                acquired.push_back(name);
+
+        std::lock_guard<std::mutex> lock(PrefetchedTilesLock);
+        std::vector<std::string>& prefetched = iPrefetchedTiles[key];
+        prefetched.insert(prefetched.end(), acquired.begin(), acquired.end());
+    }
+
+    void VMapManager2::releasePrefetchedTile(unsigned int mapId, int x, int y)
+    {
+        std::vector<std::string> prefetched;
+        {
+            std::lock_guard<std::mutex> lock(PrefetchedTilesLock);
+            std::unordered_map<uint64, std::vector<std::string> >::iterator itr = iPrefetchedTiles.find(uint64(mapId) << 32 | StaticMapTree::packTileID(x, y));
+            if (itr == iPrefetchedTiles.end())
+                return;
+
+            prefetched.swap(itr->second);
+            iPrefetchedTiles.erase(itr);
+        }
+
+        for (std::string const& name : prefetched)
+            releaseModelInstance(name);
+    }
+
     bool VMapManager2::existsMap(const char* basePath, unsigned int mapId, int x, int y)
     {
         return StaticMapTree::CanLoadMap(std::string(basePath), mapId, x, y);
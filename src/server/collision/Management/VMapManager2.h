@@ -21,6 +21,7 @@
 
 #include <mutex>
 #include <unordered_map>
+#include <vector>
 #include "Define.h"
 #include "IVMapManager.h"
 
@@ -82,6 +83,11 @@ namespace VMAP
             InstanceTreeMap iInstanceMapTrees;
             // Mutex for iLoadedModelFiles
             std::mutex LoadedModelFilesLock;
+            // models referenced by preloadMaps, kept loaded until shutdown
+            std::vector<std::string> iPreloadedModels;
+            // models acquired by prefetchTile, released once their tile is loaded
+            std::unordered_map<uint64, std::vector<std::string> > iPrefetchedTiles;
+            std::mutex PrefetchedTilesLock;
 
             bool _loadMap(uint32 mapId, const std::string& basePath, uint32 tileX, uint32 tileY);
             /* void _unloadMap(uint32 pMapId, uint32 x, uint32 y); */
@@ -103,6 +109,7 @@ namespace VMAP
             void unloadMap(unsigned int mapId) override;
 
             bool isInLineOfSight(unsigned int mapId, float x1, float y1, float z1, float x2, float y2, float z2) override ;
+            void isInLineOfSight(unsigned int mapId, LineOfSightRay* rays, uint32 count) override;
             /**
             fill the hit pos and return true, if an object was hit
             */
@@ -117,6 +124,19 @@ namespace VMAP
             WorldModel* acquireModelInstance(const std::string& basepath, const std::string& filename);
             void releaseModelInstance(const std::string& filename);
 
+            /**
+            Loads the models of all tiles of the given maps on threadCount threads and keeps them loaded,
+            later tile loads of these maps only read their small tile files. Call before any map is loaded.
+            */
+            void preloadMaps(const std::string& basePath, const std::vector<uint32>& mapIds, uint32 threadCount);
+
+            /**
+            Loads the models of a tile ahead of its loadMap from any thread, loadMap then only reads the tile file.
+            Tiles that end up not being loaded must be released.
+            */
+            void prefetchTile(const std::string& basePath, unsigned int mapId, int x, int y);
+            void releasePrefetchedTile(unsigned int mapId, int x, int y);
+
             // what's the use of this? o.O
             virtual std::string getDirFileName(unsigned int mapId, int /*x*/, int /*y*/) const override
             {
@@ -20,6 +20,7 @@
 #include "ModelInstance.h"
 #include "VMapManager2.h"
 #include "VMapDefinitions.h"
+#include "MappedFile.h"
 #include "Log.h"
 #include "Errors.h"
 
@@ -173,6 +174,42 @@ namespace VMAP
         return true;
     }
     //=========================================================
+
+    void StaticMapTree::isInLineOfSight(const Vector3* pos1, const Vector3* pos2, bool* results, uint32 count) const
+    {
+        G3D::Ray rays[BIH_RAY_PACKET_SIZE];
+        float maxDist[BIH_RAY_PACKET_SIZE];
+        uint32 lanes[BIH_RAY_PACKET_SIZE];
+        uint32 laneCount = 0;
+        for (uint32 i = 0; i < count && i < BIH_RAY_PACKET_SIZE; ++i)
+        {
+            // same special cases as the single ray check
+            float dist = (pos2[i] - pos1[i]).magnitude();
+            if (dist == std::numeric_limits<float>::max() || !std::isfinite(dist))
+            {
+                results[i] = false;
+                continue;
+            }
+
+            results[i] = true;
+            if (dist < 1e-10f)
+                continue;
+
+            rays[laneCount] = G3D::Ray::fromOriginAndDirection(pos1[i], (pos2[i] - pos1[i]) / dist);
+            maxDist[laneCount] = dist;
+            lanes[laneCount++] = i;
+        }
+
+        if (!laneCount)
+            return;
+
+        MapRayCallback intersectionCallBack(iTreeValues);
+        uint32 hitMask = iTree.intersectRayPacket(rays, maxDist, laneCount, intersectionCallBack);
+        for (uint32 i = 0; i < laneCount; ++i)
+            if (hitMask & (1 << i))
+                results[lanes[i]] = false;
+    }
+    //=========================================================
     /**
     When moving from pos1 to pos2 check if we hit an object. Return true and the position if we hit one
     Return the hit pos or the original dest pos
@@ -244,33 +281,79 @@ namespace VMAP
         if (basePath.length() > 0 && basePath[basePath.length()-1] != '/' && basePath[basePath.length()-1] != '\\')
             basePath.push_back('/');
         std::string fullname = basePath + VMapManager2::getMapFileName(mapID);
-        bool success = true;
-        FILE* rf = fopen(fullname.c_str(), "rb");
-        if (!rf)
+        MappedFile rf;
+        if (!rf.open(fullname))
             return false;
         /// @todo check magic number when implemented...
+        MappedFileReader reader(rf);
         char tiled;
-        char chunk[8];
-        if (!readChunk(rf, chunk, VMAP_MAGIC, 8) || fread(&tiled, sizeof(char), 1, rf) != 1)
-        {
-            fclose(rf);
+        if (!reader.readChunk(VMAP_MAGIC, 8) || !reader.read(tiled))
             return false;
-        }
         if (tiled)
         {
             std::string tilefile = basePath + getTileFileName(mapID, tileX, tileY);
-            FILE* tf = fopen(tilefile.c_str(), "rb");
-            if (!tf)
-                success = false;
-            else
-            {
-                if (!readChunk(tf, chunk, VMAP_MAGIC, 8))
-                    success = false;
-                fclose(tf);
-            }
+            MappedFile tf;
+            if (!tf.open(tilefile))
+                return false;
+
+            MappedFileReader tileReader(tf);
+            if (!tileReader.readChunk(VMAP_MAGIC, 8))
+                return false;
         }
-        fclose(rf);
-        return success;
+        return true;
+    }
+
+    //=========================================================
+
+    bool StaticMapTree::getModelNames(const std::string &vmapPath, uint32 mapID, std::set<std::string> &names, uint32 &tileCount)
+    {
+        std::string basePath = vmapPath;
+        if (basePath.length() > 0 && basePath[basePath.length()-1] != '/' && basePath[basePath.length()-1] != '\\')
+            basePath.push_back('/');
+        MappedFile rf;
+        if (!rf.open(basePath + VMapManager2::getMapFileName(mapID)))
+            return false;
+
+        MappedFileReader reader(rf);
+        char tiled = '\0';
+        BIH tree;
+        if (!reader.readChunk(VMAP_MAGIC, 8) || !reader.read(tiled) ||
+            !reader.readChunk("NODE", 4) || !tree.readFromFile(reader) || !reader.readChunk("GOBJ", 4))
+            return false;
+
+        ModelSpawn spawn;
+        if (!tiled)
+        {
+            if (ModelSpawn::readFromFile(reader, spawn))
+                names.insert(spawn.name);
+            return true;
+        }
+
+        for (uint32 tileX = 0; tileX < 64; ++tileX)
+            for (uint32 tileY = 0; tileY < 64; ++tileY)
+                if (getTileModelNames(basePath, mapID, tileX, tileY, names))
+                    ++tileCount;
+
+        return true;
+    }
+
+    bool StaticMapTree::getTileModelNames(const std::string &basePath, uint32 mapID, uint32 tileX, uint32 tileY, std::set<std::string> &names)
+    {
+        MappedFile tf;
+        if (!tf.open(basePath + getTileFileName(mapID, tileX, tileY)))
+            return false;
+
+        MappedFileReader tileReader(tf);
+        uint32 numSpawns = 0;
+        if (!tileReader.readChunk(VMAP_MAGIC, 8) || !tileReader.read(numSpawns))
+            return false;
+
+        ModelSpawn spawn;
+        uint32 referencedVal;
+        for (uint32 i = 0; i < numSpawns && ModelSpawn::readFromFile(tileReader, spawn) && tileReader.read(referencedVal); ++i)
+            names.insert(spawn.name);
+
+        return true;
     }
 
     //=========================================================
@@ -280,19 +363,19 @@ namespace VMAP
         VMAP_DEBUG_LOG("maps", "StaticMapTree::InitMap() : initializing StaticMapTree '%s'", fname.c_str());
         bool success = false;
         std::string fullname = iBasePath + fname;
-        FILE* rf = fopen(fullname.c_str(), "rb");
-        if (!rf)
+        MappedFile rf;
+        if (!rf.open(fullname))
             return false;
 
-        char chunk[8];
+        MappedFileReader reader(rf);
         char tiled = '\0';
 
-        if (readChunk(rf, chunk, VMAP_MAGIC, 8) && fread(&tiled, sizeof(char), 1, rf) == 1 &&
-            readChunk(rf, chunk, "NODE", 4) && iTree.readFromFile(rf))
+        if (reader.readChunk(VMAP_MAGIC, 8) && reader.read(tiled) &&
+            reader.readChunk("NODE", 4) && iTree.readFromFile(reader))
         {
             iNTreeValues = iTree.primCount();
             iTreeValues = new ModelInstance[iNTreeValues];
-            success = readChunk(rf, chunk, "GOBJ", 4);
+            success = reader.readChunk("GOBJ", 4);
         }
 
         iIsTiled = tiled != '\0';
@@ -303,7 +386,7 @@ namespace VMAP
 #ifdef VMAP_DEBUG
         TC_LOG_DEBUG("maps", "StaticMapTree::InitMap() : map isTiled: %u", static_cast<uint32>(iIsTiled));
 #endif
-        if (!iIsTiled && ModelSpawn::readFromFile(rf, spawn))
+        if (!iIsTiled && ModelSpawn::readFromFile(reader, spawn))
         {
             WorldModel* model = vm->acquireModelInstance(iBasePath, spawn.name);
             VMAP_DEBUG_LOG("maps", "StaticMapTree::InitMap() : loading %s", spawn.name.c_str());
@@ -320,7 +403,6 @@ namespace VMAP
             }
         }
 
-        fclose(rf);
         return success;
     }
 
@@ -357,21 +439,21 @@ namespace VMAP
         bool result = true;
 
         std::string tilefile = iBasePath + getTileFileName(iMapID, tileX, tileY);
-        FILE* tf = fopen(tilefile.c_str(), "rb");
-        if (tf)
+        MappedFile tf;
+        if (tf.open(tilefile))
         {
-            char chunk[8];
+            MappedFileReader reader(tf);
 
-            if (!readChunk(tf, chunk, VMAP_MAGIC, 8))
+            if (!reader.readChunk(VMAP_MAGIC, 8))
                 result = false;
             uint32 numSpawns = 0;
-            if (result && fread(&numSpawns, sizeof(uint32), 1, tf) != 1)
+            if (result && !reader.read(numSpawns))
                 result = false;
             for (uint32 i=0; i<numSpawns && result; ++i)
             {
                 // read model spawns
                 ModelSpawn spawn;
-                result = ModelSpawn::readFromFile(tf, spawn);
+                result = ModelSpawn::readFromFile(reader, spawn);
                 if (result)
                 {
                     // acquire model instance
@@ -382,7 +464,7 @@ namespace VMAP
                     // update tree
                     uint32 referencedVal;
 
-                    if (fread(&referencedVal, sizeof(uint32), 1, tf) == 1)
+                    if (reader.read(referencedVal))
                     {
                         if (!iLoadedSpawns.count(referencedVal))
                         {
@@ -411,7 +493,6 @@ namespace VMAP
                 }
             }
             iLoadedTiles[packTileID(tileX, tileY)] = true;
-            fclose(tf);
         }
         else
             iLoadedTiles[packTileID(tileX, tileY)] = false;
@@ -432,21 +513,21 @@ namespace VMAP
         if (tile->second) // file associated with tile
         {
             std::string tilefile = iBasePath + getTileFileName(iMapID, tileX, tileY);
-            FILE* tf = fopen(tilefile.c_str(), "rb");
-            if (tf)
+            MappedFile tf;
+            if (tf.open(tilefile))
             {
+                MappedFileReader reader(tf);
                 bool result=true;
-                char chunk[8];
-                if (!readChunk(tf, chunk, VMAP_MAGIC, 8))
+                if (!reader.readChunk(VMAP_MAGIC, 8))
                     result = false;
-                uint32 numSpawns;
-                if (fread(&numSpawns, sizeof(uint32), 1, tf) != 1)
+                uint32 numSpawns = 0;
+                if (!reader.read(numSpawns))
                     result = false;
                 for (uint32 i=0; i<numSpawns && result; ++i)
                 {
                     // read model spawns
                     ModelSpawn spawn;
-                    result = ModelSpawn::readFromFile(tf, spawn);
+                    result = ModelSpawn::readFromFile(reader, spawn);
                     if (result)
                     {
                         // release model instance
@@ -455,7 +536,7 @@ namespace VMAP
                         // update tree
                         uint32 referencedNode;
 
-                        if (fread(&referencedNode, sizeof(uint32), 1, tf) != 1)
+                        if (!reader.read(referencedNode))
                             result = false;
                         else
                         {
@@ -469,7 +550,6 @@ namespace VMAP
                         }
                     }
                 }
-                fclose(tf);
             }
         }
         iLoadedTiles.erase(tile);
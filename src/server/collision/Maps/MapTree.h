@@ -21,6 +21,8 @@
 
 #include "Define.h"
 #include "BoundingIntervalHierarchy.h"
+#include <set>
+#include <string>
 #include <unordered_map>
 
 namespace VMAP
@@ -64,11 +66,17 @@ namespace VMAP
             static uint32 packTileID(uint32 tileX, uint32 tileY) { return tileX<<16 | tileY; }
             static void unpackTileID(uint32 ID, uint32 &tileX, uint32 &tileY) { tileX = ID>>16; tileY = ID&0xFF; }
             static bool CanLoadMap(const std::string &basePath, uint32 mapID, uint32 tileX, uint32 tileY);
+            // names of all models spawned on the map, reads the map and all its tile files
+            static bool getModelNames(const std::string &basePath, uint32 mapID, std::set<std::string> &names, uint32 &tileCount);
+            // names of the models spawned on one tile, basePath must end with a separator
+            static bool getTileModelNames(const std::string &basePath, uint32 mapID, uint32 tileX, uint32 tileY, std::set<std::string> &names);
 
             StaticMapTree(uint32 mapID, const std::string &basePath);
             ~StaticMapTree();
 
             bool isInLineOfSight(const G3D::Vector3& pos1, const G3D::Vector3& pos2) const;
+            // up to BIH_RAY_PACKET_SIZE rays traced together, results[i] is set for the ray from pos1[i] to pos2[i]
+            void isInLineOfSight(const G3D::Vector3* pos1, const G3D::Vector3* pos2, bool* results, uint32 count) const;
             bool getObjectHitPos(const G3D::Vector3& pos1, const G3D::Vector3& pos2, G3D::Vector3& pResultHitPos, float pModifyDist) const;
             float getHeight(const G3D::Vector3& pPos, float maxSearchDist) const;
             bool getAreaInfo(G3D::Vector3 &pos, uint32 &flags, int32 &adtId, int32 &rootId, int32 &groupId) const;
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2008-2015 TrinityCore <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MappedFile.h"
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+namespace VMAP
+{
+    bool MappedFile::open(const std::string& fileName)
+    {
+        close();
+
+        try
+        {
+            boost::interprocess::file_mapping file(fileName.c_str(), boost::interprocess::read_only);
+            // the region keeps the mapping alive after the file handle is closed
+            iRegion = new boost::interprocess::mapped_region(file, boost::interprocess::read_only);
+        }
+        catch (boost::interprocess::interprocess_exception const&)
+        {
+            // missing or empty file, empty files can't be mapped
+            iRegion = nullptr;
+            return false;
+        }
+
+        return true;
+    }
+
+    void MappedFile::close()
+    {
+        delete iRegion;
+        iRegion = nullptr;
+    }
+
+    const char* MappedFile::data() const
+    {
+        return iRegion ? static_cast<const char*>(iRegion->get_address()) : nullptr;
+    }
+
+    size_t MappedFile::size() const
+    {
+        return iRegion ? iRegion->get_size() : 0;
+    }
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2008-2015 TrinityCore <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _MAPPEDFILE_H
+#define _MAPPEDFILE_H
+
+#include "Define.h"
+#include <cstring>
+#include <string>
+
+namespace boost
+{
+    namespace interprocess
+    {
+        class mapped_region;
+    }
+}
+
+namespace VMAP
+{
+    /**
+    Read-only memory mapping of a vmap file. The pages come straight from the OS page cache,
+    which is shared with every other process mapping or reading the same file (extractors, other worldservers).
+    */
+    class MappedFile
+    {
+        public:
+            MappedFile() : iRegion(nullptr) { }
+            ~MappedFile() { close(); }
+
+            bool open(const std::string& fileName);
+            void close();
+
+            bool isOpen() const { return iRegion != nullptr; }
+            const char* data() const;
+            size_t size() const;
+
+        private:
+            MappedFile(MappedFile const& right) = delete;
+            MappedFile& operator=(MappedFile const& right) = delete;
+
+            boost::interprocess::mapped_region* iRegion;
+    };
+
+    /**
+    Sequential reader over a mapped file, replaces fread() when parsing vmap files
+    */
+    class MappedFileReader
+    {
+        public:
+            explicit MappedFileReader(const MappedFile& file) : iData(file.data()), iSize(file.size()), iOffset(0) { }
+
+            bool read(void* dest, size_t size)
+            {
+                const char* src = get(size);
+                if (!src)
+                    return false;
+
+                memcpy(dest, src, size);
+                return true;
+            }
+
+            template<class T>
+            bool read(T& value) { return read(&value, sizeof(T)); }
+
+            // returns a pointer into the mapping and advances past it, NULL if the file is too short
+            const char* get(size_t size)
+            {
+                if (size > iSize - iOffset)
+                    return nullptr;
+
+                const char* src = iData + iOffset;
+                iOffset += size;
+                return src;
+            }
+
+            bool readChunk(const char* compare, uint32 len)
+            {
+                const char* chunk = get(len);
+                return chunk && memcmp(chunk, compare, len) == 0;
+            }
+
+            bool eof() const { return iOffset >= iSize; }
+
+        private:
+            const char* iData;
+            size_t iSize;
+            size_t iOffset;
+    };
+}
+
+#endif // _MAPPEDFILE_H
@@ -19,6 +19,7 @@
 #include "ModelInstance.h"
 #include "WorldModel.h"
 #include "MapTree.h"
+#include "MappedFile.h"
 
 using G3D::Vector3;
 using G3D::Ray;
@@ -196,6 +197,45 @@ namespace VMAP
         return true;
     }
 
+    bool ModelSpawn::readFromFile(MappedFileReader& reader, ModelSpawn &spawn)
+    {
+        // EoF?
+        if (reader.eof())
+            return false;
+
+        bool check = reader.read(spawn.flags) && reader.read(spawn.adtId) && reader.read(spawn.ID) &&
+            reader.read(&spawn.iPos, sizeof(float) * 3) && reader.read(&spawn.iRot, sizeof(float) * 3) && reader.read(spawn.iScale);
+        if (check && (spawn.flags & MOD_HAS_BOUND) != 0) // only WMOs have bound in MPQ, only available after computation
+        {
+            Vector3 bLow, bHigh;
+            check = reader.read(&bLow, sizeof(float) * 3) && reader.read(&bHigh, sizeof(float) * 3);
+            spawn.iBound = G3D::AABox(bLow, bHigh);
+        }
+
+        uint32 nameLen = 0;
+        if (!check || !reader.read(nameLen))
+        {
+            std::cout << "Error reading ModelSpawn!\n";
+            return false;
+        }
+
+        if (nameLen > 500) // file names should never be that long, must be file error
+        {
+            std::cout << "Error reading ModelSpawn, file name too long!\n";
+            return false;
+        }
+
+        const char* name = reader.get(nameLen);
+        if (!name)
+        {
+            std::cout << "Error reading ModelSpawn!\n";
+            return false;
+        }
+
+        spawn.name = std::string(name, nameLen);
+        return true;
+    }
+
     bool ModelSpawn::writeToFile(FILE* wf, const ModelSpawn &spawn)
     {
         uint32 check=0;
@@ -24,6 +24,7 @@
 #include "ScriptMgr.h"
 #include "Util.h"
 #include "SHA1.h"
+#include "World.h"
 #include "WorldSession.h"
 
 AccountMgr::AccountMgr() { }
@@ -494,6 +495,9 @@ void AccountMgr::UpdateAccountAccess(rbac::RBACData* rbac, uint32 accountId, uin
     if (rbac && securityLevel == rbac->GetSecurityLevel())
         rbac->SetSecurityLevel(securityLevel);
 
+    // the default permissions of the new security level may add or remove GM broadcast receivers
+    sWorld->InvalidateInWorldGameMasters();
+
     // Delete old security level from DB
     if (realmId == -1)
     {
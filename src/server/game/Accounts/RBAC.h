@@ -41,10 +41,14 @@
 #define _RBAC_H
 
 #include "Define.h"
+#include <memory>
 #include <string>
 #include <set>
 #include <map>
 
+class PreparedResultSet;
+typedef std::shared_ptr<PreparedResultSet> PreparedQueryResult;
+
 namespace rbac
 {
 
@@ -700,6 +704,11 @@ enum RBACPermissions
     RBAC_PERM_COMMAND_QUESTCOMPLETER_ADD                     = 1004,
     RBAC_PERM_COMMAND_QUESTCOMPLETER_DEL                     = 1005,
     RBAC_PERM_COMMAND_QUESTCOMPLETER_COMP                    = 1006,
+    RBAC_PERM_COMMAND_DEBUG_PROCSTATS                        = 1007,
+    RBAC_PERM_COMMAND_DEBUG_AURAPOOLS                        = 1008,
+    RBAC_PERM_COMMAND_MMAP_PATHCACHE                         = 1009,
+    RBAC_PERM_COMMAND_DEBUG_QUERYCACHE                       = 1010,
+    RBAC_PERM_COMMAND_DEBUG_PROFILER                         = 1011,
 
     // custom permissions 1000+
     RBAC_PERM_MAX
@@ -865,6 +874,8 @@ class RBACData
 
         /// Loads all permissions assigned to current account
         void LoadFromDB();
+        /// Same as LoadFromDB, with the result of LOGIN_SEL_RBAC_ACCOUNT_PERMISSIONS queried by the caller
+        void LoadFromDBCallback(PreparedQueryResult result);
 
         /// Sets security level
         void SetSecurityLevel(uint8 id)
@@ -27,11 +27,18 @@
 #include "Player.h"
 #include "ObjectAccessor.h"
 
+enum ArenaRatingWindow
+{
+    ARENA_RATING_WINDOW_STEP        = 50,
+    ARENA_RATING_WINDOW_STEP_TIME   = 30000,
+    ARENA_RATING_WINDOW_MAX_STEPS   = 19
+};
+
 /*********************************************************/
 /***            BATTLEGROUND QUEUE SYSTEM              ***/
 /*********************************************************/
 
-BattlegroundQueue::BattlegroundQueue()
+BattlegroundQueue::BattlegroundQueue() : m_SelectionStamp(0)
 {
     for (uint32 i = 0; i < BG_TEAMS_COUNT; ++i)
     {
@@ -122,6 +129,23 @@ bool BattlegroundQueue::SelectionPool::AddGroup(GroupQueueInfo* ginfo, uint32 de
     return false;
 }
 
+// add group to the bucket of its player count
+void BattlegroundQueue::AddGroupBySize(GroupsBySizeType& groupsBySize, GroupQueueInfo* ginfo)
+{
+    size_t size = ginfo->Players.size();
+    if (groupsBySize.size() <= size)
+        groupsBySize.resize(size + 1);
+
+    groupsBySize[size].push_back(ginfo);
+}
+
+// empty all buckets, keeping their storage for the next selection
+void BattlegroundQueue::ClearGroupsBySize(GroupsBySizeType& groupsBySize)
+{
+    for (GroupsBySizeType::iterator itr = groupsBySize.begin(); itr != groupsBySize.end(); ++itr)
+        itr->clear();
+}
+
 /*********************************************************/
 /***               BATTLEGROUND QUEUES                 ***/
 /*********************************************************/
@@ -145,6 +169,7 @@ GroupQueueInfo* BattlegroundQueue::AddGroup(Player* leader, Group* grp, Battlegr
     ginfo->ArenaMatchmakerRating     = MatchmakerRating;
     ginfo->OpponentsTeamRating       = 0;
     ginfo->OpponentsMatchmakerRating = 0;
+    ginfo->SelectionStamp            = 0;
 
     ginfo->Players.clear();
 
@@ -517,6 +542,21 @@ bool BattlegroundQueue::InviteGroupToBG(GroupQueueInfo* ginfo, Battleground* bg,
     return false;
 }
 
+// the accepted matchmaker rating window widens by ARENA_RATING_WINDOW_STEP for every
+// ARENA_RATING_WINDOW_STEP_TIME the group waited, after the rating discard timer any rating is accepted
+bool BattlegroundQueue::IsArenaMatchmakerRatingInRange(GroupQueueInfo const* ginfo, uint32 minRating, uint32 maxRating, uint32 now) const
+{
+    uint32 waitTime = getMSTimeDiff(ginfo->JoinTime, now);
+    if (waitTime > sBattlegroundMgr->GetRatingDiscardTimer())
+        return true;
+
+    uint32 steps = waitTime ? std::min<uint32>((waitTime - 1) / ARENA_RATING_WINDOW_STEP_TIME, ARENA_RATING_WINDOW_MAX_STEPS) : 0;
+    uint32 widen = steps * ARENA_RATING_WINDOW_STEP;
+    uint32 windowMin = minRating > widen ? minRating - widen : 0;
+
+    return ginfo->ArenaMatchmakerRating >= windowMin && ginfo->ArenaMatchmakerRating <= maxRating + widen;
+}
+
 /*
 This function is inviting players to already running battlegrounds
 Invitation type is based on config file
@@ -929,6 +969,7 @@ void BattlegroundQueue::BattlegroundQueueUpdate(uint32 /*diff*/, BattlegroundTyp
         GroupsQueueType::iterator itr_teams[BG_TEAMS_COUNT];
         uint8 found = 0;
         uint8 team = 0;
+        uint32 now = getMSTime();
 
         for (uint8 i = BG_QUEUE_PREMADE_ALLIANCE; i < BG_QUEUE_NORMAL_ALLIANCE; i++)
         {
@@ -937,28 +978,7 @@ void BattlegroundQueue::BattlegroundQueueUpdate(uint32 /*diff*/, BattlegroundTyp
             for (; itr2 != m_QueuedGroups[bracket_id][i].end(); ++itr2)
             {
                 // if group match conditions, then add it to pool
-                if (!(*itr2)->IsInvitedToBGInstanceGUID
-                    && (((*itr2)->ArenaMatchmakerRating >= arenaMinRating && (*itr2)->ArenaMatchmakerRating <= arenaMaxRating)
-                    || ((*itr2)->ArenaMatchmakerRating >= arenaMinRating - 50 && (*itr2)->ArenaMatchmakerRating <= arenaMaxRating + 50 && (*itr2)->JoinTime + 30000 < getMSTime())
-                    || ((*itr2)->ArenaMatchmakerRating >= arenaMinRating - 100 && (*itr2)->ArenaMatchmakerRating <= arenaMaxRating + 100 && (*itr2)->JoinTime + 60000 < getMSTime())
-                    || ((*itr2)->ArenaMatchmakerRating >= arenaMinRating - 150 && (*itr2)->ArenaMatchmakerRating <= arenaMaxRating + 150 && (*itr2)->JoinTime + 90000 < getMSTime())
-                    || ((*itr2)->ArenaMatchmakerRating >= arenaMinRating - 200 && (*itr2)->ArenaMatchmakerRating <= arenaMaxRating + 200 && (*itr2)->JoinTime + 120000 < getMSTime())
-                    || ((*itr2)->ArenaMatchmakerRating >= arenaMinRating - 250 && (*itr2)->ArenaMatchmakerRating <= arenaMaxRating + 250 && (*itr2)->JoinTime + 150000 < getMSTime())
-                    || ((*itr2)->ArenaMatchmakerRating >= arenaMinRating - 300 && (*itr2)->ArenaMatchmakerRating <= arenaMaxRating + 300 && (*itr2)->JoinTime + 180000 < getMSTime())
-                    || ((*itr2)->ArenaMatchmakerRating >= arenaMinRating - 350 && (*itr2)->ArenaMatchmakerRating <= arenaMaxRating + 350 && (*itr2)->JoinTime + 210000 < getMSTime())
-                    || ((*itr2)->ArenaMatchmakerRating >= arenaMinRating - 400 && (*itr2)->ArenaMatchmakerRating <= arenaMaxRating + 400 && (*itr2)->JoinTime + 240000 < getMSTime())
-                    || ((*itr2)->ArenaMatchmakerRating >= arenaMinRating - 450 && (*itr2)->ArenaMatchmakerRating <= arenaMaxRating + 450 && (*itr2)->JoinTime + 270000 < getMSTime())
-                    || ((*itr2)->ArenaMatchmakerRating >= arenaMinRating - 500 && (*itr2)->ArenaMatchmakerRating <= arenaMaxRating + 500 && (*itr2)->JoinTime + 300000 < getMSTime())
-                    || ((*itr2)->ArenaMatchmakerRating >= arenaMinRating - 550 && (*itr2)->ArenaMatchmakerRating <= arenaMaxRating + 550 && (*itr2)->JoinTime + 330000 < getMSTime())
-                    || ((*itr2)->ArenaMatchmakerRating >= arenaMinRating - 600 && (*itr2)->ArenaMatchmakerRating <= arenaMaxRating + 600 && (*itr2)->JoinTime + 360000 < getMSTime())
-                    || ((*itr2)->ArenaMatchmakerRating >= arenaMinRating - 650 && (*itr2)->ArenaMatchmakerRating <= arenaMaxRating + 650 && (*itr2)->JoinTime + 390000 < getMSTime())
-                    || ((*itr2)->ArenaMatchmakerRating >= arenaMinRating - 700 && (*itr2)->ArenaMatchmakerRating <= arenaMaxRating + 700 && (*itr2)->JoinTime + 420000 < getMSTime())
-                    || ((*itr2)->ArenaMatchmakerRating >= arenaMinRating - 750 && (*itr2)->ArenaMatchmakerRating <= arenaMaxRating + 750 && (*itr2)->JoinTime + 450000 < getMSTime())
-                    || ((*itr2)->ArenaMatchmakerRating >= arenaMinRating - 800 && (*itr2)->ArenaMatchmakerRating <= arenaMaxRating + 800 && (*itr2)->JoinTime + 480000 < getMSTime())
-                    || ((*itr2)->ArenaMatchmakerRating >= arenaMinRating - 850 && (*itr2)->ArenaMatchmakerRating <= arenaMaxRating + 850 && (*itr2)->JoinTime + 510000 < getMSTime())
-                    || ((*itr2)->ArenaMatchmakerRating >= arenaMinRating - 900 && (*itr2)->ArenaMatchmakerRating <= arenaMaxRating + 900 && (*itr2)->JoinTime + 540000 < getMSTime())
-                    || ((*itr2)->ArenaMatchmakerRating >= arenaMinRating - 950 && (*itr2)->ArenaMatchmakerRating <= arenaMaxRating + 950 && (*itr2)->JoinTime + 570000 < getMSTime())
-                        ||  getMSTimeDiff((*itr2)->JoinTime, getMSTime()) > sBattlegroundMgr->GetRatingDiscardTimer()))
+                if (!(*itr2)->IsInvitedToBGInstanceGUID && IsArenaMatchmakerRatingInRange(*itr2, arenaMinRating, arenaMaxRating, now))
                 {
                     itr_teams[found++] = itr2;
                     team = i;
@@ -974,28 +994,7 @@ void BattlegroundQueue::BattlegroundQueueUpdate(uint32 /*diff*/, BattlegroundTyp
         {
             for (GroupsQueueType::iterator itr3 = itr_teams[0]; itr3 != m_QueuedGroups[bracket_id][team].end(); ++itr3)
             {
-                if (!(*itr3)->IsInvitedToBGInstanceGUID
-                    && (((*itr3)->ArenaMatchmakerRating >= arenaMinRating && (*itr3)->ArenaMatchmakerRating <= arenaMaxRating)
-                    || ((*itr3)->ArenaMatchmakerRating >= arenaMinRating - 50 && (*itr3)->ArenaMatchmakerRating <= arenaMaxRating + 50 && (*itr3)->JoinTime + 30000 < getMSTime())
-                    || ((*itr3)->ArenaMatchmakerRating >= arenaMinRating - 100 && (*itr3)->ArenaMatchmakerRating <= arenaMaxRating + 100 && (*itr3)->JoinTime + 60000 < getMSTime())
-                    || ((*itr3)->ArenaMatchmakerRating >= arenaMinRating - 150 && (*itr3)->ArenaMatchmakerRating <= arenaMaxRating + 150 && (*itr3)->JoinTime + 90000 < getMSTime())
-                    || ((*itr3)->ArenaMatchmakerRating >= arenaMinRating - 200 && (*itr3)->ArenaMatchmakerRating <= arenaMaxRating + 200 && (*itr3)->JoinTime + 120000 < getMSTime())
-                    || ((*itr3)->ArenaMatchmakerRating >= arenaMinRating - 250 && (*itr3)->ArenaMatchmakerRating <= arenaMaxRating + 250 && (*itr3)->JoinTime + 150000 < getMSTime())
-                    || ((*itr3)->ArenaMatchmakerRating >= arenaMinRating - 300 && (*itr3)->ArenaMatchmakerRating <= arenaMaxRating + 300 && (*itr3)->JoinTime + 180000 < getMSTime())
-                    || ((*itr3)->ArenaMatchmakerRating >= arenaMinRating - 350 && (*itr3)->ArenaMatchmakerRating <= arenaMaxRating + 350 && (*itr3)->JoinTime + 210000 < getMSTime())
-                    || ((*itr3)->ArenaMatchmakerRating >= arenaMinRating - 400 && (*itr3)->ArenaMatchmakerRating <= arenaMaxRating + 400 && (*itr3)->JoinTime + 240000 < getMSTime())
-                    || ((*itr3)->ArenaMatchmakerRating >= arenaMinRating - 450 && (*itr3)->ArenaMatchmakerRating <= arenaMaxRating + 450 && (*itr3)->JoinTime + 270000 < getMSTime())
-                    || ((*itr3)->ArenaMatchmakerRating >= arenaMinRating - 500 && (*itr3)->ArenaMatchmakerRating <= arenaMaxRating + 500 && (*itr3)->JoinTime + 300000 < getMSTime())
-                    || ((*itr3)->ArenaMatchmakerRating >= arenaMinRating - 550 && (*itr3)->ArenaMatchmakerRating <= arenaMaxRating + 550 && (*itr3)->JoinTime + 330000 < getMSTime())
-                    || ((*itr3)->ArenaMatchmakerRating >= arenaMinRating - 600 && (*itr3)->ArenaMatchmakerRating <= arenaMaxRating + 600 && (*itr3)->JoinTime + 360000 < getMSTime())
-                    || ((*itr3)->ArenaMatchmakerRating >= arenaMinRating - 650 && (*itr3)->ArenaMatchmakerRating <= arenaMaxRating + 650 && (*itr3)->JoinTime + 390000 < getMSTime())
-                    || ((*itr3)->ArenaMatchmakerRating >= arenaMinRating - 700 && (*itr3)->ArenaMatchmakerRating <= arenaMaxRating + 700 && (*itr3)->JoinTime + 420000 < getMSTime())
-                    || ((*itr3)->ArenaMatchmakerRating >= arenaMinRating - 750 && (*itr3)->ArenaMatchmakerRating <= arenaMaxRating + 750 && (*itr3)->JoinTime + 450000 < getMSTime())
-                    || ((*itr3)->ArenaMatchmakerRating >= arenaMinRating - 800 && (*itr3)->ArenaMatchmakerRating <= arenaMaxRating + 800 && (*itr3)->JoinTime + 480000 < getMSTime())
-                    || ((*itr3)->ArenaMatchmakerRating >= arenaMinRating - 850 && (*itr3)->ArenaMatchmakerRating <= arenaMaxRating + 850 && (*itr3)->JoinTime + 510000 < getMSTime())
-                    || ((*itr3)->ArenaMatchmakerRating >= arenaMinRating - 900 && (*itr3)->ArenaMatchmakerRating <= arenaMaxRating + 900 && (*itr3)->JoinTime + 540000 < getMSTime())
-                    || ((*itr3)->ArenaMatchmakerRating >= arenaMinRating - 950 && (*itr3)->ArenaMatchmakerRating <= arenaMaxRating + 950 && (*itr3)->JoinTime + 570000 < getMSTime())
-                        || getMSTimeDiff((*itr3)->JoinTime, getMSTime()) > sBattlegroundMgr->GetRatingDiscardTimer())
+                if (!(*itr3)->IsInvitedToBGInstanceGUID && IsArenaMatchmakerRatingInRange(*itr3, arenaMinRating, arenaMaxRating, now)
                     && (*itr_teams[0])->ArenaTeamId != (*itr3)->ArenaTeamId)
                 {
                     itr_teams[found++] = itr3;
@@ -54,6 +54,7 @@ struct GroupQueueInfo                                       // stores informatio
     uint32  ArenaMatchmakerRating;                          // if rated match, inited to the rating of the team
     uint32  OpponentsTeamRating;                            // for rated arena matches
     uint32  OpponentsMatchmakerRating;                      // for rated arena matches
+    uint32  SelectionStamp;                                 // last cross faction selection pass that picked this group
 };
 
 enum BattlegroundQueueGroupTypes
@@ -77,8 +78,9 @@ class BattlegroundQueue
         void UpdateEvents(uint32 diff);
 
         bool FillXPlayersToBG(BattlegroundBracketId bracket_id, Battleground* bg, bool start = false);
-        typedef std::multimap<int32, GroupQueueInfo*> QueuedGroupMap;
-        int32 PreAddPlayers(QueuedGroupMap m_PreGroupMap, int32 MaxAdd, uint32 MaxInTeam);
+        // queued groups indexed by their player count, groups of same size kept in queue order
+        typedef std::vector<std::vector<GroupQueueInfo*> > GroupsBySizeType;
+        int32 PreAddPlayers(GroupsBySizeType const& groupsBySize, int32 MaxAdd, uint32 MaxInTeam);
         bool CheckCrossFactionMatch(BattlegroundBracketId bracket_id, Battleground* bg);
 
         void FillPlayersToBG(Battleground* bg, BattlegroundBracketId bracket_id);
@@ -130,6 +132,14 @@ class BattlegroundQueue
     private:
 
         bool InviteGroupToBG(GroupQueueInfo* ginfo, Battleground* bg, uint32 side);
+        bool IsArenaMatchmakerRatingInRange(GroupQueueInfo const* ginfo, uint32 minRating, uint32 maxRating, uint32 now) const;
+
+        static void AddGroupBySize(GroupsBySizeType& groupsBySize, GroupQueueInfo* ginfo);
+        static void ClearGroupsBySize(GroupsBySizeType& groupsBySize);
+
+        // reused by FillXPlayersToBG: alliance, horde and all queued groups by size
+        GroupsBySizeType m_GroupsBySize[BG_TEAMS_COUNT + 1];
+        uint32 m_SelectionStamp;
         uint32 m_WaitTimes[BG_TEAMS_COUNT][MAX_BATTLEGROUND_BRACKETS][COUNT_OF_PLAYERS_TO_AVERAGE_WAIT_TIME];
         uint32 m_WaitTimeLastPlayer[BG_TEAMS_COUNT][MAX_BATTLEGROUND_BRACKETS];
         uint32 m_SumOfWaitTimes[BG_TEAMS_COUNT][MAX_BATTLEGROUND_BRACKETS];
@@ -217,7 +217,7 @@ bool BattlegroundQueue::CheckCrossFactionMatch(BattlegroundBracketId bracket_id,
 // which is useful in FillPlayersToBG. Because then we can interrupt the regular invitation if cross faction bg's are enabled.
 bool BattlegroundQueue::FillXPlayersToBG(BattlegroundBracketId bracket_id, Battleground* bg, bool start)
 {
-    uint8 queuedPeople = 0;
+    uint32 queuedPeople = 0;
     for (GroupsQueueType::const_iterator itr = m_QueuedGroups[bracket_id][BG_QUEUE_MIXED].begin(); itr != m_QueuedGroups[bracket_id][BG_QUEUE_MIXED].end(); ++itr)
         if (!(*itr)->IsInvitedToBGInstanceGUID)
             queuedPeople += (*itr)->Players.size();
@@ -234,10 +234,14 @@ bool BattlegroundQueue::FillXPlayersToBG(BattlegroundBracketId bracket_id, Battl
         int32 diff = 0;
 
 
+        // Each group is picked at most once per pass, remember the ones already selected
+        uint32 stamp = ++m_SelectionStamp;
+
         // Add teams to their own factions as far as possible.
         if (start)
         {
-            QueuedGroupMap m_PreGroupMap_a, m_PreGroupMap_h;
+            ClearGroupsBySize(m_GroupsBySize[TEAM_ALLIANCE]);
+            ClearGroupsBySize(m_GroupsBySize[TEAM_HORDE]);
             int32 m_SmallestOfTeams = 0;
             int32 queuedAlliance = 0;
             int32 queuedHorde = 0;
@@ -251,52 +255,59 @@ bool BattlegroundQueue::FillXPlayersToBG(BattlegroundBracketId bracket_id, Battl
 
                 if (alliance)
                 {
-                    m_PreGroupMap_a.insert(std::make_pair((*itr)->Players.size(), *itr));
+                    AddGroupBySize(m_GroupsBySize[TEAM_ALLIANCE], *itr);
                     queuedAlliance += (*itr)->Players.size();
                 }
                 else
                 {
-                    m_PreGroupMap_h.insert(std::make_pair((*itr)->Players.size(), *itr));
+                    AddGroupBySize(m_GroupsBySize[TEAM_HORDE], *itr);
                     queuedHorde += (*itr)->Players.size();
                 }
             }
 
             m_SmallestOfTeams = std::min(std::min(aliFree, queuedAlliance), std::min(hordeFree, queuedHorde));
 
-            valiFree -= PreAddPlayers(m_PreGroupMap_a, m_SmallestOfTeams, aliFree);
-            vhordeFree -= PreAddPlayers(m_PreGroupMap_h, m_SmallestOfTeams, hordeFree);
+            valiFree -= PreAddPlayers(m_GroupsBySize[TEAM_ALLIANCE], m_SmallestOfTeams, aliFree);
+            vhordeFree -= PreAddPlayers(m_GroupsBySize[TEAM_HORDE], m_SmallestOfTeams, hordeFree);
+
+            for (uint8 i = 0; i < BG_TEAMS_COUNT; ++i)
+                for (GroupsQueueType::const_iterator itr = m_SelectionPools[i].SelectedGroups.begin(); itr != m_SelectionPools[i].SelectedGroups.end(); ++itr)
+                    (*itr)->SelectionStamp = stamp;
         }
 
-        QueuedGroupMap m_QueuedGroupMap;
+        GroupsBySizeType& groupsBySize = m_GroupsBySize[BG_TEAMS_COUNT];
+        ClearGroupsBySize(groupsBySize);
 
         for (GroupsQueueType::const_iterator itr = m_QueuedGroups[bracket_id][BG_QUEUE_MIXED].begin(); itr != m_QueuedGroups[bracket_id][BG_QUEUE_MIXED].end(); ++itr)
-            m_QueuedGroupMap.insert(std::make_pair((*itr)->Players.size(), *itr));
+            AddGroupBySize(groupsBySize, *itr);
 
-        for (QueuedGroupMap::reverse_iterator itr = m_QueuedGroupMap.rbegin(); itr != m_QueuedGroupMap.rend(); ++itr)
+        // Largest groups first, latest queued first among groups of the same size
+        for (size_t size = groupsBySize.size(); size-- > 0;)
         {
-            GroupsQueueType allypool = m_SelectionPools[TEAM_ALLIANCE].SelectedGroups;
-            GroupsQueueType hordepool = m_SelectionPools[TEAM_HORDE].SelectedGroups;
+            for (std::vector<GroupQueueInfo*>::const_reverse_iterator itr = groupsBySize[size].rbegin(); itr != groupsBySize[size].rend(); ++itr)
+            {
+                // Both pools are complete, nothing left to do
+                if (m_SelectionPools[TEAM_ALLIANCE].GetPlayerCount() >= bg->GetMinPlayersPerTeam() &&
+                    m_SelectionPools[TEAM_HORDE].GetPlayerCount() >= bg->GetMinPlayersPerTeam())
+                    return true;
 
-            GroupQueueInfo* ginfo = itr->second;
+                GroupQueueInfo* ginfo = *itr;
 
-            // If player already was invited via pre adding (add to own team first) or he was already invited to a bg, skip.
-            if (ginfo->IsInvitedToBGInstanceGUID ||
-                std::find(allypool.begin(), allypool.end(), ginfo) != allypool.end() ||
-                std::find(hordepool.begin(), hordepool.end(), ginfo) != hordepool.end() ||
-                (m_SelectionPools[TEAM_ALLIANCE].GetPlayerCount() >= bg->GetMinPlayersPerTeam() &&
-                m_SelectionPools[TEAM_HORDE].GetPlayerCount() >= bg->GetMinPlayersPerTeam()))
-                continue;
+                // If player already was invited via pre adding (add to own team first) or he was already invited to a bg, skip.
+                if (ginfo->IsInvitedToBGInstanceGUID || ginfo->SelectionStamp == stamp)
+                    continue;
 
-            diff = abs(valiFree - vhordeFree);
-            bool moreAli = valiFree < vhordeFree;
+                diff = abs(valiFree - vhordeFree);
+                bool moreAli = valiFree < vhordeFree;
 
-            if (diff > 0)
-                ginfo->Team = moreAli ? HORDE : ALLIANCE;
+                if (diff > 0)
+                    ginfo->Team = moreAli ? HORDE : ALLIANCE;
 
-            bool alliance = ginfo->Team == ALLIANCE;
+                bool alliance = ginfo->Team == ALLIANCE;
 
-            if (m_SelectionPools[alliance ? TEAM_ALLIANCE : TEAM_HORDE].AddGroup(ginfo, alliance ? aliFree : hordeFree))
-                alliance ? valiFree -= ginfo->Players.size() : vhordeFree -= ginfo->Players.size();
+                if (m_SelectionPools[alliance ? TEAM_ALLIANCE : TEAM_HORDE].AddGroup(ginfo, alliance ? aliFree : hordeFree))
+                    alliance ? valiFree -= ginfo->Players.size() : vhordeFree -= ginfo->Players.size();
+            }
         }
 
         return true;
@@ -304,18 +315,24 @@ bool BattlegroundQueue::FillXPlayersToBG(BattlegroundBracketId bracket_id, Battl
     return false;
 }
 
-int32 BattlegroundQueue::PreAddPlayers(QueuedGroupMap m_PreGroupMap, int32 MaxAdd, uint32 MaxInTeam)
+int32 BattlegroundQueue::PreAddPlayers(GroupsBySizeType const& groupsBySize, int32 MaxAdd, uint32 MaxInTeam)
 {
     int32 LeftToAdd = MaxAdd;
-    uint32 Added = 0;
 
-    for (QueuedGroupMap::reverse_iterator itr = m_PreGroupMap.rbegin(); itr != m_PreGroupMap.rend(); ++itr)
+    // Only buckets of groups that still fit need to be visited
+    for (size_t size = std::min<size_t>(groupsBySize.size(), std::max<int32>(LeftToAdd + 1, 0)); size-- > 0 && LeftToAdd > 0;)
     {
-        int32 PlayerSize = itr->first;
-        bool alliance = itr->second->OTeam == ALLIANCE;
+        for (std::vector<GroupQueueInfo*>::const_reverse_iterator itr = groupsBySize[size].rbegin(); itr != groupsBySize[size].rend(); ++itr)
+        {
+            int32 PlayerSize = int32(size);
+            if (PlayerSize > LeftToAdd)
+                break;
 
-        if (PlayerSize <= LeftToAdd && m_SelectionPools[alliance ? TEAM_ALLIANCE : TEAM_HORDE].AddGroup(itr->second, MaxInTeam))
-            LeftToAdd -= PlayerSize, Added -= PlayerSize;
+            bool alliance = (*itr)->OTeam == ALLIANCE;
+
+            if (m_SelectionPools[alliance ? TEAM_ALLIANCE : TEAM_HORDE].AddGroup(*itr, MaxInTeam))
+                LeftToAdd -= PlayerSize;
+        }
     }
 
     return LeftToAdd;
@@ -198,10 +198,7 @@ void Channel::JoinChannel(Player* player, std::string const& pass)
         SendToAll(&data);
     }
 
-    PlayerInfo pinfo;
-    pinfo.player = guid;
-    pinfo.flags = MEMBER_FLAG_NONE;
-    playersStore[guid] = pinfo;
+    AddMember(player);
 
     WorldPacket data;
     MakeYouJoined(&data);
@@ -250,7 +247,7 @@ void Channel::LeaveChannel(Player* player, bool send)
 
     bool changeowner = playersStore[guid].IsOwner();
 
-    playersStore.erase(guid);
+    RemoveMember(guid);
 
     if (_announce && !player->GetSession()->HasPermission(rbac::RBAC_PERM_SILENTLY_JOIN_CHANNEL))
     {
@@ -335,7 +332,7 @@ void Channel::KickOrBan(Player const* player, std::string const& badname, bool b
         SendToAll(&data);
     }
 
-    playersStore.erase(victim);
+    RemoveMember(victim);
     bad->LeftChannel(this);
 
     if (changeowner && _ownership && !playersStore.empty())
@@ -541,19 +538,16 @@ void Channel::List(Player const* player)
     uint32 gmLevelInWhoList = sWorld->getIntConfig(CONFIG_GM_LEVEL_IN_WHO_LIST);
 
     uint32 count  = 0;
-    for (PlayerContainer::const_iterator i = playersStore.begin(); i != playersStore.end(); ++i)
+    for (Player* member : _members)
     {
-        Player* member = ObjectAccessor::FindConnectedPlayer(i->first);
-
         // PLAYER can't see MODERATOR, GAME MASTER, ADMINISTRATOR characters
         // MODERATOR, GAME MASTER, ADMINISTRATOR can see all
-        if (member &&
-            (player->GetSession()->HasPermission(rbac::RBAC_PERM_WHO_SEE_ALL_SEC_LEVELS) ||
+        if ((player->GetSession()->HasPermission(rbac::RBAC_PERM_WHO_SEE_ALL_SEC_LEVELS) ||
              member->GetSession()->GetSecurity() <= AccountTypes(gmLevelInWhoList)) &&
             member->IsVisibleGloballyFor(player))
         {
-            data << uint64(i->first);
-            data << uint8(i->second.flags);             // flags seems to be changed...
+            data << uint64(member->GetGUID());
+            data << uint8(GetPlayerFlags(member->GetGUID()));   // flags seems to be changed...
             ++count;
         }
     }
@@ -621,7 +615,7 @@ void Channel::Say(ObjectGuid guid, std::string const& what, uint32 lang)
     }
 
     WorldPacket data;
-    if (Player* player = ObjectAccessor::FindConnectedPlayer(guid))
+    if (Player* player = GetMember(guid))
         ChatHandler::BuildChatPacket(data, CHAT_MSG_CHANNEL, Language(lang), player, player, what, 0, _name);
     else
         ChatHandler::BuildChatPacket(data, CHAT_MSG_CHANNEL, Language(lang), guid, guid, what, 0, "", "", 0, false, _name);
@@ -720,25 +714,71 @@ void Channel::SetOwner(ObjectGuid guid, bool exclaim)
     }
 }
 
+void Channel::AddMember(Player* player)
+{
+    PlayerInfo pinfo;
+    pinfo.player = player->GetGUID();
+    pinfo.flags = MEMBER_FLAG_NONE;
+    pinfo.memberIndex = _members.size();
+    playersStore[pinfo.player] = pinfo;
+
+    _members.push_back(player);
+}
+
+void Channel::RemoveMember(ObjectGuid guid)
+{
+    PlayerContainer::iterator itr = playersStore.find(guid);
+    if (itr == playersStore.end())
+        return;
+
+    // order doesn't matter, move the last member into the freed slot
+    uint32 index = itr->second.memberIndex;
+    if (index < _members.size() && _members[index]->GetGUID() == guid)
+    {
+        Player* last = _members.back();
+        _members[index] = last;
+        _members.pop_back();
+        if (last->GetGUID() != guid)
+            playersStore[last->GetGUID()].memberIndex = index;
+    }
+
+    playersStore.erase(itr);
+}
+
+Player* Channel::GetMember(ObjectGuid guid) const
+{
+    PlayerContainer::const_iterator itr = playersStore.find(guid);
+    if (itr == playersStore.end() || itr->second.memberIndex >= _members.size())
+        return NULL;
+
+    Player* player = _members[itr->second.memberIndex];
+    return player->GetGUID() == guid ? player : NULL;
+}
+
 void Channel::SendToAll(WorldPacket* data, ObjectGuid guid)
 {
-    for (PlayerContainer::const_iterator i = playersStore.begin(); i != playersStore.end(); ++i)
-        if (Player* player = ObjectAccessor::FindConnectedPlayer(i->first))
-            if (!guid || !player->GetSocial()->HasIgnore(guid.GetCounter()))
-                player->GetSession()->SendPacket(data);
+    uint32 ignoredGuid = guid.GetCounter();
+    for (Player* player : _members)
+    {
+        // most players have nobody on ignore, skip the lookup for them
+        PlayerSocial* social = player->GetSocial();
+        if (!guid || !social->HasIgnores() || !social->HasIgnore(ignoredGuid))
+            player->GetSession()->SendPacket(data);
+    }
 }
 
 void Channel::SendToAllButOne(WorldPacket* data, ObjectGuid who)
 {
-    for (PlayerContainer::const_iterator i = playersStore.begin(); i != playersStore.end(); ++i)
-        if (i->first != who)
-            if (Player* player = ObjectAccessor::FindConnectedPlayer(i->first))
-                player->GetSession()->SendPacket(data);
+    for (Player* player : _members)
+        if (player->GetGUID() != who)
+            player->GetSession()->SendPacket(data);
 }
 
 void Channel::SendToOne(WorldPacket* data, ObjectGuid who)
 {
-    if (Player* player = ObjectAccessor::FindConnectedPlayer(who))
+    if (Player* player = GetMember(who))
+        player->GetSession()->SendPacket(data);
+    else if (Player* player = ObjectAccessor::FindConnectedPlayer(who))
         player->GetSession()->SendPacket(data);
 }
 
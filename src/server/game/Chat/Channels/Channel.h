@@ -22,6 +22,7 @@
 #include <list>
 #include <map>
 #include <string>
+#include <vector>
 
 #include "Common.h"
 
@@ -124,6 +125,7 @@ class Channel
     {
         ObjectGuid player;
         uint8 flags;
+        uint32 memberIndex;                             // position in _members
 
         bool HasFlag(uint8 flag) const { return (flags & flag) != 0; }
         void SetFlag(uint8 flag) { flags |= flag; }
@@ -230,6 +232,10 @@ class Channel
         void SendToAllButOne(WorldPacket* data, ObjectGuid who);
         void SendToOne(WorldPacket* data, ObjectGuid who);
 
+        void AddMember(Player* player);
+        void RemoveMember(ObjectGuid guid);
+        Player* GetMember(ObjectGuid guid) const;
+
         bool IsOn(ObjectGuid who) const { return playersStore.find(who) != playersStore.end(); }
         bool IsBanned(ObjectGuid guid) const { return bannedStore.find(guid) != bannedStore.end(); }
 
@@ -269,6 +275,7 @@ class Channel
         }
 
         typedef std::map<ObjectGuid, PlayerInfo> PlayerContainer;
+        typedef std::vector<Player*> MemberList;
         typedef GuidSet BannedContainer;
 
         bool _announce;
@@ -281,6 +288,8 @@ class Channel
         std::string _name;
         std::string _password;
         PlayerContainer playersStore;
+        // members leave the channel in Player::CleanupChannels before logging out, so the pointers stay valid
+        MemberList _members;
         BannedContainer bannedStore;
 };
 #endif
@@ -303,7 +303,20 @@ void ThreatContainer::modifyThreatPercent(Unit* victim, int32 percent)
 void ThreatContainer::update()
 {
     if (iDirty && iThreatList.size() > 1)
-        iThreatList.sort(Trinity::ThreatOrderPred());
+    {
+        // Between two updates only a few references change their threat, so the
+        // container is nearly sorted: a stable insertion pass only moves the
+        // changed entries into place instead of re-sorting the whole table
+        Trinity::ThreatOrderPred pred;
+        for (StorageType::size_type i = 1; i < iThreatList.size(); ++i)
+        {
+            HostileReference* ref = iThreatList[i];
+            StorageType::size_type j = i;
+            for (; j > 0 && pred(ref, iThreatList[j - 1]); --j)
+                iThreatList[j] = iThreatList[j - 1];
+            iThreatList[j] = ref;
+        }
+    }
 
     iDirty = false;
 }
@@ -25,7 +25,8 @@
 #include "UnitEvents.h"
 #include "ObjectGuid.h"
 
-#include <list>
+#include <algorithm>
+#include <vector>
 
 //==============================================================
 
@@ -146,7 +147,9 @@ class ThreatContainer
         friend class ThreatManager;
 
     public:
-        typedef std::list<HostileReference*> StorageType;
+        // Kept contiguous and sorted by descending threat, so the most hated
+        // reference is always the front element once update() has run
+        typedef std::vector<HostileReference*> StorageType;
 
         ThreatContainer(): iDirty(false) { }
 
@@ -179,7 +182,10 @@ class ThreatContainer
     private:
         void remove(HostileReference* hostileRef)
         {
-            iThreatList.remove(hostileRef);
+            // erase keeps the relative order of the remaining references
+            StorageType::iterator itr = std::find(iThreatList.begin(), iThreatList.end(), hostileRef);
+            if (itr != iThreatList.end())
+                iThreatList.erase(itr);
         }
 
         void addReference(HostileReference* hostileRef)
@@ -189,7 +195,7 @@ class ThreatContainer
 
         void clearReferences();
 
-        // Sort the list if necessary
+        // Restore the threat order if necessary
         void update();
 
         StorageType iThreatList;
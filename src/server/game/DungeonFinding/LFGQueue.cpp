@@ -80,6 +80,99 @@ char const* GetCompatibleString(LfgCompatibility compatibles)
     }
 }
 
+/**
+   Inserts a queue id keeping the key sorted
+
+   @param[in]     id Queue id to add
+   @returns False if the key is already full
+*/
+bool LfgCompatibleKey::Add(uint32 id)
+{
+    if (Contains(id))
+        return true;
+
+    if (size >= MaxSize)
+        return false;
+
+    uint8 pos = size++;
+    for (; pos > 0 && ids[pos - 1] > id; --pos)
+        ids[pos] = ids[pos - 1];
+    ids[pos] = id;
+    return true;
+}
+
+bool LfgCompatibleKey::Contains(uint32 id) const
+{
+    for (uint8 i = 0; i < size; ++i)
+        if (ids[i] == id)
+            return true;
+
+    return false;
+}
+
+std::string LfgCompatibleKey::ToString() const
+{
+    std::ostringstream o;
+    for (uint8 i = 0; i < size; ++i)
+    {
+        if (i)
+            o << '|';
+        o << ids[i];
+    }
+    return o.str();
+}
+
+LfgQueueFilter::LfgQueueFilter(LfgDungeonSet const& dungeons, LfgRolesMap const& roles):
+    dungeonMask(0), players(0), tanks(0), healers(0), dps(0)
+{
+    for (LfgDungeonSet::const_iterator itr = dungeons.begin(); itr != dungeons.end(); ++itr)
+        dungeonMask |= uint64(1) << (*itr % 64);
+
+    for (LfgRolesMap::const_iterator itr = roles.begin(); itr != roles.end(); ++itr)
+    {
+        ++players;
+        switch (itr->second & ~PLAYER_ROLE_LEADER)
+        {
+            case PLAYER_ROLE_TANK:
+                ++tanks;
+                break;
+            case PLAYER_ROLE_HEALER:
+                ++healers;
+                break;
+            case PLAYER_ROLE_DAMAGE:
+                ++dps;
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+/**
+   Cheap necessary condition for CheckCompatibility: no common dungeon, too many
+   players or too many players locked to the same role can never match
+
+   @param[in]     other Summary of the player/group to add
+   @returns False if the combination can be discarded without a full check
+*/
+bool LfgQueueFilter::CanMerge(LfgQueueFilter const& other) const
+{
+    return (dungeonMask & other.dungeonMask) != 0 &&
+        players + other.players <= MAXGROUPSIZE &&
+        tanks + other.tanks <= LFG_TANKS_NEEDED &&
+        healers + other.healers <= LFG_HEALERS_NEEDED &&
+        dps + other.dps <= LFG_DPS_NEEDED;
+}
+
+void LfgQueueFilter::Merge(LfgQueueFilter const& other)
+{
+    dungeonMask &= other.dungeonMask;
+    players += other.players;
+    tanks += other.tanks;
+    healers += other.healers;
+    dps += other.dps;
+}
+
 void LFGQueue::AddToQueue(ObjectGuid guid)
 {
     LfgQueueDataContainer::iterator itQueue = QueueDataStore.find(guid);
@@ -98,25 +191,19 @@ void LFGQueue::RemoveFromQueue(ObjectGuid guid)
     RemoveFromCurrentQueue(guid);
     RemoveFromCompatibles(guid);
 
-    std::ostringstream o;
-    o << guid.GetRawValue();
-    std::string sguid = o.str();
+    LfgQueueDataContainer::iterator itDelete = QueueDataStore.find(guid);
+    if (itDelete == QueueDataStore.end())
+        return;
 
-    LfgQueueDataContainer::iterator itDelete = QueueDataStore.end();
+    uint32 queueId = itDelete->second.queueId;
     for (LfgQueueDataContainer::iterator itr = QueueDataStore.begin(); itr != QueueDataStore.end(); ++itr)
-        if (itr->first != guid)
+        if (itr != itDelete && itr->second.bestCompatible.Contains(queueId))
         {
-            if (std::string::npos != itr->second.bestCompatible.find(sguid))
-            {
-                itr->second.bestCompatible.clear();
-                FindBestCompatibleInQueue(itr);
-            }
+            itr->second.bestCompatible = LfgCompatibleKey();
+            FindBestCompatibleInQueue(itr);
         }
-        else
-            itDelete = itr;
 
-    if (itDelete != QueueDataStore.end())
-        QueueDataStore.erase(itDelete);
+    QueueDataStore.erase(itDelete);
 }
 
 void LFGQueue::AddToNewQueue(ObjectGuid guid)
@@ -141,7 +228,11 @@ void LFGQueue::RemoveFromCurrentQueue(ObjectGuid guid)
 
 void LFGQueue::AddQueueData(ObjectGuid guid, time_t joinTime, LfgDungeonSet const& dungeons, LfgRolesMap const& rolesMap)
 {
-    QueueDataStore[guid] = LfgQueueData(joinTime, dungeons, rolesMap);
+    // Keep the queue id when re-adding, cached compatibilities still refer to it
+    LfgQueueDataContainer::const_iterator itQueue = QueueDataStore.find(guid);
+    uint32 queueId = itQueue != QueueDataStore.end() && itQueue->second.queueId ? itQueue->second.queueId : nextQueueId++;
+
+    QueueDataStore[guid] = LfgQueueData(joinTime, queueId, dungeons, rolesMap);
     AddToQueue(guid);
 }
 
@@ -187,43 +278,70 @@ void LFGQueue::UpdateWaitTimeDps(int32 waitTime, uint32 dungeonId)
 */
 void LFGQueue::RemoveFromCompatibles(ObjectGuid guid)
 {
-    std::stringstream out;
-    out << guid.GetRawValue();
-    std::string strGuid = out.str();
+    LfgQueueDataContainer::const_iterator itQueue = QueueDataStore.find(guid);
+    if (itQueue == QueueDataStore.end())
+        return;
+
+    uint32 queueId = itQueue->second.queueId;
 
-    TC_LOG_DEBUG("lfg.queue.data.compatibles.remove", "Removing %s", guid.ToString().c_str());
+    TC_LOG_DEBUG("lfg.queue.data.compatibles.remove", "Removing %s (queue id %u)", guid.ToString().c_str(), queueId);
     for (LfgCompatibleContainer::iterator itNext = CompatibleMapStore.begin(); itNext != CompatibleMapStore.end();)
     {
         LfgCompatibleContainer::iterator it = itNext++;
-        if (std::string::npos != it->first.find(strGuid))
+        if (it->first.Contains(queueId))
             CompatibleMapStore.erase(it);
     }
 }
 
+/**
+   Builds the compatibility cache key of a list of guids
+
+   @param[in]     check list of guids
+   @returns Key with the queue ids of the guids, empty if any of them is not queued
+*/
+LfgCompatibleKey LFGQueue::GetCompatibleKey(GuidList const& check) const
+{
+    LfgCompatibleKey key;
+    for (GuidList::const_iterator it = check.begin(); it != check.end(); ++it)
+    {
+        LfgQueueDataContainer::const_iterator itQueue = QueueDataStore.find(*it);
+        if (itQueue == QueueDataStore.end() || !key.Add(itQueue->second.queueId))
+            return LfgCompatibleKey();
+    }
+
+    return key;
+}
+
 /**
    Stores the compatibility of a list of guids
 
-   @param[in]     key String concatenation of guids (| used as separator)
+   @param[in]     key Sorted queue ids of the guids
    @param[in]     compatibles type of compatibility
 */
-void LFGQueue::SetCompatibles(std::string const& key, LfgCompatibility compatibles)
+void LFGQueue::SetCompatibles(LfgCompatibleKey const& key, LfgCompatibility compatibles)
 {
+    if (key.IsEmpty())
+        return;
+
     LfgCompatibilityData& data = CompatibleMapStore[key];
     data.compatibility = compatibles;
 }
 
-void LFGQueue::SetCompatibilityData(std::string const& key, LfgCompatibilityData const& data)
+void LFGQueue::SetCompatibilityData(LfgCompatibleKey const& key, LfgCompatibilityData const& data)
 {
+    if (key.IsEmpty())
+        return;
+
     CompatibleMapStore[key] = data;
 }
 
 /**
    Get the compatibility of a group of guids
 
-   @param[in]     key String concatenation of guids (| used as separator)
+   @param[in]     key Sorted queue ids of the guids
    @return LfgCompatibility type of compatibility
 */
-LfgCompatibility LFGQueue::GetCompatibles(std::string const& key)
+LfgCompatibility LFGQueue::GetCompatibles(LfgCompatibleKey const& key)
 {
     LfgCompatibleContainer::iterator itr = CompatibleMapStore.find(key);
     if (itr != CompatibleMapStore.end())
@@ -232,7 +350,7 @@ LfgCompatibility LFGQueue::GetCompatibles(std::string const& key)
     return LFG_COMPATIBILITY_PENDING;
 }
 
-LfgCompatibilityData* LFGQueue::GetCompatibilityData(std::string const& key)
+LfgCompatibilityData* LFGQueue::GetCompatibilityData(LfgCompatibleKey const& key)
 {
     LfgCompatibleContainer::iterator itr = CompatibleMapStore.find(key);
     if (itr != CompatibleMapStore.end())
@@ -255,8 +373,11 @@ uint8 LFGQueue::FindGroups()
         firstNew.push_back(frontguid);
         RemoveFromNewQueue(frontguid);
 
+        LfgQueueDataContainer::const_iterator itQueue = QueueDataStore.find(frontguid);
+        LfgQueueFilter filter = itQueue != QueueDataStore.end() ? itQueue->second.filter : LfgQueueFilter();
+
         GuidList temporalList = currentQueueStore;
-        LfgCompatibility compatibles = FindNewGroups(firstNew, temporalList);
+        LfgCompatibility compatibles = FindNewGroups(firstNew, filter, temporalList);
 
         if (compatibles == LFG_COMPATIBLES_MATCH)
             ++proposals;
@@ -270,22 +391,23 @@ uint8 LFGQueue::FindGroups()
    Checks que main queue to try to form a Lfg group. Returns first match found (if any)
 
    @param[in]     check List of guids trying to match with other groups
+   @param[in]     filter Role and dungeon summary of check
    @param[in]     all List of all other guids in main queue to match against
    @return LfgCompatibility type of compatibility between groups
 */
-LfgCompatibility LFGQueue::FindNewGroups(GuidList& check, GuidList& all)
+LfgCompatibility LFGQueue::FindNewGroups(GuidList& check, LfgQueueFilter const& filter, GuidList& all)
 {
-    std::string strGuids = ConcatenateGuids(check);
-    LfgCompatibility compatibles = GetCompatibles(strGuids);
+    LfgCompatibleKey key = GetCompatibleKey(check);
+    LfgCompatibility compatibles = GetCompatibles(key);
 
-    TC_LOG_DEBUG("lfg.queue.match.check", "Guids: (%s): %s - all(%s)", strGuids.c_str(), GetCompatibleString(compatibles), ConcatenateGuids(all).c_str());
+    TC_LOG_DEBUG("lfg.queue.match.check", "Guids: (%s): %s - all(%s)", ConcatenateGuids(check).c_str(), GetCompatibleString(compatibles), ConcatenateGuids(all).c_str());
     if (compatibles == LFG_COMPATIBILITY_PENDING) // Not previously cached, calculate
         compatibles = CheckCompatibility(check);
 
     if (compatibles == LFG_COMPATIBLES_BAD_STATES && sLFGMgr->AllQueued(check))
     {
-        TC_LOG_DEBUG("lfg.queue.match.check", "Guids: (%s) compatibles (cached) changed from bad states to match", strGuids.c_str());
-        SetCompatibles(strGuids, LFG_COMPATIBLES_MATCH);
+        TC_LOG_DEBUG("lfg.queue.match.check", "Guids: (%s) compatibles (cached) changed from bad states to match", ConcatenateGuids(check).c_str());
+        SetCompatibles(key, LFG_COMPATIBLES_MATCH);
         return LFG_COMPATIBLES_MATCH;
     }
 
@@ -295,9 +417,22 @@ LfgCompatibility LFGQueue::FindNewGroups(GuidList& check, GuidList& all)
     // Try to match with queued groups
     while (!all.empty())
     {
-        check.push_back(all.front());
+        ObjectGuid guid = all.front();
         all.pop_front();
-        LfgCompatibility subcompatibility = FindNewGroups(check, all);
+
+        // Skip groups that can never be compatible without a full check (and without caching the result)
+        LfgQueueFilter merged = filter;
+        LfgQueueDataContainer::const_iterator itQueue = QueueDataStore.find(guid);
+        if (itQueue != QueueDataStore.end())
+        {
+            if (!filter.CanMerge(itQueue->second.filter))
+                continue;
+
+            merged.Merge(itQueue->second.filter);
+        }
+
+        check.push_back(guid);
+        LfgCompatibility subcompatibility = FindNewGroups(check, merged, all);
         if (subcompatibility == LFG_COMPATIBLES_MATCH)
             return LFG_COMPATIBLES_MATCH;
         check.pop_back();
@@ -308,12 +443,12 @@ LfgCompatibility LFGQueue::FindNewGroups(GuidList& check, GuidList& all)
 /**
    Check compatibilities between groups. If group is Matched proposal will be created
 
-   @param[in]     check List of guids to check compatibilities
+   @param[in]     check List of guids to check compatibilities (restored on return)
    @return LfgCompatibility type of compatibility
 */
-LfgCompatibility LFGQueue::CheckCompatibility(GuidList check)
+LfgCompatibility LFGQueue::CheckCompatibility(GuidList& check)
 {
-    std::string strGuids = ConcatenateGuids(check);
+    LfgCompatibleKey key = GetCompatibleKey(check);
     LfgProposal proposal;
     LfgDungeonSet proposalDungeons;
     LfgGroupsMap proposalGroups;
@@ -322,7 +457,7 @@ LfgCompatibility LFGQueue::CheckCompatibility(GuidList check)
     // Check for correct size
     if (check.size() > MAXGROUPSIZE || check.empty())
     {
-        TC_LOG_DEBUG("lfg.queue.match.compatibility.check", "Guids: (%s): Size wrong - Not compatibles", strGuids.c_str());
+        TC_LOG_DEBUG("lfg.queue.match.compatibility.check", "Guids: (%s): Size wrong - Not compatibles", ConcatenateGuids(check).c_str());
         return LFG_INCOMPATIBLES_WRONG_GROUP_SIZE;
     }
 
@@ -336,8 +471,9 @@ LfgCompatibility LFGQueue::CheckCompatibility(GuidList check)
         LfgCompatibility child_compatibles = CheckCompatibility(check);
         if (child_compatibles < LFG_COMPATIBLES_WITH_LESS_PLAYERS) // Group not compatible
         {
-            TC_LOG_DEBUG("lfg.queue.match.compatibility.check", "Guids: (%s) child %s not compatibles", strGuids.c_str(), ConcatenateGuids(check).c_str());
-            SetCompatibles(strGuids, child_compatibles);
+            TC_LOG_DEBUG("lfg.queue.match.compatibility.check", "Guids: (%s) child %s not compatibles", key.ToString().c_str(), ConcatenateGuids(check).c_str());
+            check.push_front(frontGuid);
+            SetCompatibles(key, child_compatibles);
             return child_compatibles;
         }
         check.push_front(frontGuid);
@@ -374,29 +510,29 @@ LfgCompatibility LFGQueue::CheckCompatibility(GuidList check)
     // Group with less that MAXGROUPSIZE members always compatible
     if (check.size() == 1 && numPlayers != MAXGROUPSIZE)
     {
-        TC_LOG_DEBUG("lfg.queue.match.compatibility.check", "Guids: (%s) single group. Compatibles", strGuids.c_str());
+        TC_LOG_DEBUG("lfg.queue.match.compatibility.check", "Guids: (%s) single group. Compatibles", ConcatenateGuids(check).c_str());
         LfgQueueDataContainer::iterator itQueue = QueueDataStore.find(check.front());
 
         LfgCompatibilityData data(LFG_COMPATIBLES_WITH_LESS_PLAYERS);
         data.roles = itQueue->second.roles;
         LFGMgr::CheckGroupRoles(data.roles);
 
-        UpdateBestCompatibleInQueue(itQueue, strGuids, data.roles);
-        SetCompatibilityData(strGuids, data);
+        UpdateBestCompatibleInQueue(itQueue, key, data.roles);
+        SetCompatibilityData(key, data);
         return LFG_COMPATIBLES_WITH_LESS_PLAYERS;
     }
 
     if (numLfgGroups > 1)
     {
-        TC_LOG_DEBUG("lfg.queue.match.compatibility.check", "Guids: (%s) More than one Lfggroup (%u)", strGuids.c_str(), numLfgGroups);
-        SetCompatibles(strGuids, LFG_INCOMPATIBLES_MULTIPLE_LFG_GROUPS);
+        TC_LOG_DEBUG("lfg.queue.match.compatibility.check", "Guids: (%s) More than one Lfggroup (%u)", ConcatenateGuids(check).c_str(), numLfgGroups);
+        SetCompatibles(key, LFG_INCOMPATIBLES_MULTIPLE_LFG_GROUPS);
         return LFG_INCOMPATIBLES_MULTIPLE_LFG_GROUPS;
     }
 
     if (numPlayers > MAXGROUPSIZE)
     {
-        TC_LOG_DEBUG("lfg.queue.match.compatibility.check", "Guids: (%s) Too much players (%u)", strGuids.c_str(), numPlayers);
-        SetCompatibles(strGuids, LFG_INCOMPATIBLES_TOO_MUCH_PLAYERS);
+        TC_LOG_DEBUG("lfg.queue.match.compatibility.check", "Guids: (%s) Too much players (%u)", ConcatenateGuids(check).c_str(), numPlayers);
+        SetCompatibles(key, LFG_INCOMPATIBLES_TOO_MUCH_PLAYERS);
         return LFG_INCOMPATIBLES_TOO_MUCH_PLAYERS;
     }
 
@@ -423,8 +559,8 @@ LfgCompatibility LFGQueue::CheckCompatibility(GuidList check)
 
         if (uint8 playersize = numPlayers - proposalRoles.size())
         {
-            TC_LOG_DEBUG("lfg.queue.match.compatibility.check", "Guids: (%s) not compatible, %u players are ignoring each other", strGuids.c_str(), playersize);
-            SetCompatibles(strGuids, LFG_INCOMPATIBLES_HAS_IGNORES);
+            TC_LOG_DEBUG("lfg.queue.match.compatibility.check", "Guids: (%s) not compatible, %u players are ignoring each other", ConcatenateGuids(check).c_str(), playersize);
+            SetCompatibles(key, LFG_INCOMPATIBLES_HAS_IGNORES);
             return LFG_INCOMPATIBLES_HAS_IGNORES;
         }
 
@@ -435,8 +571,8 @@ LfgCompatibility LFGQueue::CheckCompatibility(GuidList check)
             for (LfgRolesMap::const_iterator it = debugRoles.begin(); it != debugRoles.end(); ++it)
                 o << ", " << it->first.GetRawValue() << ": " << GetRolesString(it->second);
 
-            TC_LOG_DEBUG("lfg.queue.match.compatibility.check", "Guids: (%s) Roles not compatible%s", strGuids.c_str(), o.str().c_str());
-            SetCompatibles(strGuids, LFG_INCOMPATIBLES_NO_ROLES);
+            TC_LOG_DEBUG("lfg.queue.match.compatibility.check", "Guids: (%s) Roles not compatible%s", ConcatenateGuids(check).c_str(), o.str().c_str());
+            SetCompatibles(key, LFG_INCOMPATIBLES_NO_ROLES);
             return LFG_INCOMPATIBLES_NO_ROLES;
         }
 
@@ -455,8 +591,8 @@ LfgCompatibility LFGQueue::CheckCompatibility(GuidList check)
 
         if (proposalDungeons.empty())
         {
-            TC_LOG_DEBUG("lfg.queue.match.compatibility.check", "Guids: (%s) No compatible dungeons%s", strGuids.c_str(), o.str().c_str());
-            SetCompatibles(strGuids, LFG_INCOMPATIBLES_NO_DUNGEONS);
+            TC_LOG_DEBUG("lfg.queue.match.compatibility.check", "Guids: (%s) No compatible dungeons%s", ConcatenateGuids(check).c_str(), o.str().c_str());
+            SetCompatibles(key, LFG_INCOMPATIBLES_NO_DUNGEONS);
             return LFG_INCOMPATIBLES_NO_DUNGEONS;
         }
     }
@@ -472,14 +608,14 @@ LfgCompatibility LFGQueue::CheckCompatibility(GuidList check)
     // Enough players?
     if (numPlayers != MAXGROUPSIZE)
     {
-        TC_LOG_DEBUG("lfg.queue.match.compatibility.check", "Guids: (%s) Compatibles but not enough players(%u)", strGuids.c_str(), numPlayers);
+        TC_LOG_DEBUG("lfg.queue.match.compatibility.check", "Guids: (%s) Compatibles but not enough players(%u)", ConcatenateGuids(check).c_str(), numPlayers);
         LfgCompatibilityData data(LFG_COMPATIBLES_WITH_LESS_PLAYERS);
         data.roles = proposalRoles;
 
         for (GuidList::const_iterator itr = check.begin(); itr != check.end(); ++itr)
-            UpdateBestCompatibleInQueue(QueueDataStore.find(*itr), strGuids, data.roles);
+            UpdateBestCompatibleInQueue(QueueDataStore.find(*itr), key, data.roles);
 
-        SetCompatibilityData(strGuids, data);
+        SetCompatibilityData(key, data);
         return LFG_COMPATIBLES_WITH_LESS_PLAYERS;
     }
 
@@ -489,8 +625,8 @@ LfgCompatibility LFGQueue::CheckCompatibility(GuidList check)
 
     if (!sLFGMgr->AllQueued(check))
     {
-        TC_LOG_DEBUG("lfg.queue.match.compatibility.check", "Guids: (%s) Group MATCH but can't create proposal!", strGuids.c_str());
-        SetCompatibles(strGuids, LFG_COMPATIBLES_BAD_STATES);
+        TC_LOG_DEBUG("lfg.queue.match.compatibility.check", "Guids: (%s) Group MATCH but can't create proposal!", ConcatenateGuids(check).c_str());
+        SetCompatibles(key, LFG_COMPATIBLES_BAD_STATES);
         return LFG_COMPATIBLES_BAD_STATES;
     }
 
@@ -531,8 +667,8 @@ LfgCompatibility LFGQueue::CheckCompatibility(GuidList check)
 
     sLFGMgr->AddProposal(proposal);
 
-    TC_LOG_DEBUG("lfg.queue.match.compatibility.check", "Guids: (%s) MATCH! Group formed", strGuids.c_str());
-    SetCompatibles(strGuids, LFG_COMPATIBLES_MATCH);
+    TC_LOG_DEBUG("lfg.queue.match.compatibility.check", "Guids: (%s) MATCH! Group formed", ConcatenateGuids(check).c_str());
+    SetCompatibles(key, LFG_COMPATIBLES_MATCH);
     return LFG_COMPATIBLES_MATCH;
 }
 
@@ -574,7 +710,7 @@ void LFGQueue::UpdateQueueTimers(time_t currTime)
                 break;
         }
 
-        if (queueinfo.bestCompatible.empty())
+        if (queueinfo.bestCompatible.IsEmpty())
             FindBestCompatibleInQueue(itQueue);
 
         LfgQueueStatusData queueData(dungeonId, waitTime, wtAvg, wtTank, wtHealer, wtDps, queuedTime, queueinfo.tanks, queueinfo.healers, queueinfo.dps);
@@ -623,7 +759,7 @@ std::string LFGQueue::DumpCompatibleInfo(bool full /* = false */) const
     o << "Compatible Map size: " << CompatibleMapStore.size() << "\n";
     if (full)
         for (LfgCompatibleContainer::const_iterator itr = CompatibleMapStore.begin(); itr != CompatibleMapStore.end(); ++itr)
-            o << "(" << itr->first << "): " << GetCompatibleString(itr->second.compatibility) << "\n";
+            o << "(" << itr->first.ToString() << "): " << GetCompatibleString(itr->second.compatibility) << "\n";
 
     return o.str();
 }
@@ -631,32 +767,25 @@ std::string LFGQueue::DumpCompatibleInfo(bool full /* = false */) const
 void LFGQueue::FindBestCompatibleInQueue(LfgQueueDataContainer::iterator itrQueue)
 {
     TC_LOG_DEBUG("lfg.queue.compatibles.find", "%s", itrQueue->first.ToString().c_str());
-    std::ostringstream o;
-    o << itrQueue->first.GetRawValue();
-    std::string sguid = o.str();
+    uint32 queueId = itrQueue->second.queueId;
 
     for (LfgCompatibleContainer::const_iterator itr = CompatibleMapStore.begin(); itr != CompatibleMapStore.end(); ++itr)
         if (itr->second.compatibility == LFG_COMPATIBLES_WITH_LESS_PLAYERS &&
-            std::string::npos != itr->first.find(sguid))
+            itr->first.Contains(queueId))
         {
             UpdateBestCompatibleInQueue(itrQueue, itr->first, itr->second.roles);
         }
 }
 
-void LFGQueue::UpdateBestCompatibleInQueue(LfgQueueDataContainer::iterator itrQueue, std::string const& key, LfgRolesMap const& roles)
+void LFGQueue::UpdateBestCompatibleInQueue(LfgQueueDataContainer::iterator itrQueue, LfgCompatibleKey const& key, LfgRolesMap const& roles)
 {
     LfgQueueData& queueData = itrQueue->second;
 
-    uint8 storedSize = queueData.bestCompatible.empty() ? 0 :
-        std::count(queueData.bestCompatible.begin(), queueData.bestCompatible.end(), '|') + 1;
-
-    uint8 size = std::count(key.begin(), key.end(), '|') + 1;
-
-    if (size <= storedSize)
+    if (key.size <= queueData.bestCompatible.size)
         return;
 
     TC_LOG_DEBUG("lfg.queue.compatibles.update", "Changed (%s) to (%s) as best compatible group for %s",
-        queueData.bestCompatible.c_str(), key.c_str(), itrQueue->first.ToString().c_str());
+        queueData.bestCompatible.ToString().c_str(), key.ToString().c_str(), itrQueue->first.ToString().c_str());
 
     queueData.bestCompatible = key;
     queueData.tanks = LFG_TANKS_NEEDED;
@@ -48,25 +48,71 @@ struct LfgCompatibilityData
     LfgRolesMap roles;
 };
 
+/// Sorted queue ids of a combination of queued players/groups, used as compatibility cache key
+struct LfgCompatibleKey
+{
+    static uint8 const MaxSize = LFG_TANKS_NEEDED + LFG_HEALERS_NEEDED + LFG_DPS_NEEDED;
+
+    LfgCompatibleKey(): size(0)
+    {
+        for (uint8 i = 0; i < MaxSize; ++i)
+            ids[i] = 0;
+    }
+
+    bool Add(uint32 id);
+    bool Contains(uint32 id) const;
+    bool IsEmpty() const { return size == 0; }
+    std::string ToString() const;
+
+    bool operator<(LfgCompatibleKey const& right) const
+    {
+        for (uint8 i = 0; i < MaxSize; ++i)
+            if (ids[i] != right.ids[i])
+                return ids[i] < right.ids[i];
+        return false;
+    }
+
+    uint32 ids[MaxSize];
+    uint8 size;
+};
+
+/// Role and dungeon summary of queued players/groups, rejects combinations that can never be compatible
+struct LfgQueueFilter
+{
+    LfgQueueFilter(): dungeonMask(~uint64(0)), players(0), tanks(0), healers(0), dps(0) { }
+    LfgQueueFilter(LfgDungeonSet const& dungeons, LfgRolesMap const& roles);
+
+    bool CanMerge(LfgQueueFilter const& other) const;
+    void Merge(LfgQueueFilter const& other);
+
+    uint64 dungeonMask;                                    ///< One bit per (dungeon id % 64) of the selected dungeons
+    uint8 players;                                         ///< Number of players
+    uint8 tanks;                                           ///< Players that can only tank
+    uint8 healers;                                         ///< Players that can only heal
+    uint8 dps;                                             ///< Players that can only dps
+};
+
 /// Stores player or group queue info
 struct LfgQueueData
 {
-    LfgQueueData(): joinTime(time_t(time(NULL))), tanks(LFG_TANKS_NEEDED),
+    LfgQueueData(): joinTime(time_t(time(NULL))), queueId(0), tanks(LFG_TANKS_NEEDED),
         healers(LFG_HEALERS_NEEDED), dps(LFG_DPS_NEEDED)
         { }
 
-    LfgQueueData(time_t _joinTime, LfgDungeonSet const& _dungeons, LfgRolesMap const& _roles):
-        joinTime(_joinTime), tanks(LFG_TANKS_NEEDED), healers(LFG_HEALERS_NEEDED),
-        dps(LFG_DPS_NEEDED), dungeons(_dungeons), roles(_roles)
+    LfgQueueData(time_t _joinTime, uint32 _queueId, LfgDungeonSet const& _dungeons, LfgRolesMap const& _roles):
+        joinTime(_joinTime), queueId(_queueId), tanks(LFG_TANKS_NEEDED), healers(LFG_HEALERS_NEEDED),
+        dps(LFG_DPS_NEEDED), dungeons(_dungeons), roles(_roles), filter(_dungeons, _roles)
         { }
 
     time_t joinTime;                                       ///< Player queue join time (to calculate wait times)
+    uint32 queueId;                                        ///< Compact id used in compatibility cache keys
     uint8 tanks;                                           ///< Tanks needed
     uint8 healers;                                         ///< Healers needed
     uint8 dps;                                             ///< Dps needed
     LfgDungeonSet dungeons;                                ///< Selected Player/Group Dungeon/s
     LfgRolesMap roles;                                     ///< Selected Player Role/s
-    std::string bestCompatible;                            ///< Best compatible combination of people queued
+    LfgQueueFilter filter;                                 ///< Summary of dungeons and roles
+    LfgCompatibleKey bestCompatible;                       ///< Best compatible combination of people queued
 };
 
 struct LfgWaitTime
@@ -77,7 +123,7 @@ struct LfgWaitTime
 };
 
 typedef std::map<uint32, LfgWaitTime> LfgWaitTimesContainer;
-typedef std::map<std::string, LfgCompatibilityData> LfgCompatibleContainer;
+typedef std::map<LfgCompatibleKey, LfgCompatibilityData> LfgCompatibleContainer;
 typedef std::map<ObjectGuid, LfgQueueData> LfgQueueDataContainer;
 
 /**
@@ -86,6 +132,7 @@ typedef std::map<ObjectGuid, LfgQueueData> LfgQueueDataContainer;
 class LFGQueue
 {
     public:
+        LFGQueue(): nextQueueId(1) { }
 
         // Add/Remove from queue
         void AddToQueue(ObjectGuid guid);
@@ -111,24 +158,24 @@ class LFGQueue
         std::string DumpCompatibleInfo(bool full = false) const;
 
     private:
-        void SetQueueUpdateData(std::string const& strGuids, LfgRolesMap const& proposalRoles);
 
         void AddToNewQueue(ObjectGuid guid);
         void AddToCurrentQueue(ObjectGuid guid);
         void RemoveFromNewQueue(ObjectGuid guid);
         void RemoveFromCurrentQueue(ObjectGuid guid);
 
-        void SetCompatibles(std::string const& key, LfgCompatibility compatibles);
-        LfgCompatibility GetCompatibles(std::string const& key);
+        LfgCompatibleKey GetCompatibleKey(GuidList const& check) const;
+        void SetCompatibles(LfgCompatibleKey const& key, LfgCompatibility compatibles);
+        LfgCompatibility GetCompatibles(LfgCompatibleKey const& key);
         void RemoveFromCompatibles(ObjectGuid guid);
 
-        void SetCompatibilityData(std::string const& key, LfgCompatibilityData const& compatibles);
-        LfgCompatibilityData* GetCompatibilityData(std::string const& key);
+        void SetCompatibilityData(LfgCompatibleKey const& key, LfgCompatibilityData const& compatibles);
+        LfgCompatibilityData* GetCompatibilityData(LfgCompatibleKey const& key);
         void FindBestCompatibleInQueue(LfgQueueDataContainer::iterator itrQueue);
-        void UpdateBestCompatibleInQueue(LfgQueueDataContainer::iterator itrQueue, std::string const& key, LfgRolesMap const& roles);
+        void UpdateBestCompatibleInQueue(LfgQueueDataContainer::iterator itrQueue, LfgCompatibleKey const& key, LfgRolesMap const& roles);
 
-        LfgCompatibility FindNewGroups(GuidList& check, GuidList& all);
-        LfgCompatibility CheckCompatibility(GuidList check);
+        LfgCompatibility FindNewGroups(GuidList& check, LfgQueueFilter const& filter, GuidList& all);
+        LfgCompatibility CheckCompatibility(GuidList& check);
 
         // Queue
         LfgQueueDataContainer QueueDataStore;              ///< Queued groups
@@ -140,6 +187,7 @@ class LFGQueue
         LfgWaitTimesContainer waitTimesDpsStore;           ///< Average wait time to find a group queuing as dps
         GuidList currentQueueStore;                        ///< Ordered list. Used to find groups
         GuidList newToQueueStore;                          ///< New groups to add to queue
+        uint32 nextQueueId;                                ///< Next id handed out to a queued player/group
 };
 
 } // namespace lfg
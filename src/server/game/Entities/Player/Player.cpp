@@ -2621,8 +2621,12 @@ void Player::AddToWorld()
     ///- Do not add/remove the player from the object storage
     ///- It will crash when updating the ObjectAccessor
     ///- The player should only be added when logging in
+    bool wasInWorld = IsInWorld();
     Unit::AddToWorld();
 
+    if (!wasInWorld)
+        sWorld->AddInWorldPlayer(this);
+
     for (uint8 i = PLAYER_SLOT_START; i < PLAYER_SLOT_END; ++i)
         if (m_items[i])
             m_items[i]->AddToWorld();
@@ -2639,6 +2643,7 @@ void Player::RemoveFromWorld()
         UnsummonPetTemporaryIfAny();
         sOutdoorPvPMgr->HandlePlayerLeaveZone(this, m_zoneUpdateId);
         sBattlefieldMgr->HandlePlayerLeaveZone(this, m_zoneUpdateId);
+        sWorld->RemoveInWorldPlayer(this);
     }
 
     ///- Do not add/remove the player from the object storage
@@ -4890,8 +4895,8 @@ TrainerSpellState Player::GetTrainerSpellState(TrainerSpell const* trainer_spell
                 return TRAINER_SPELL_RED;
         }
 
-        SpellsRequiringSpellMapBounds spellsRequired = sSpellMgr->GetSpellsRequiredForSpellBounds(trainer_spell->learnedSpell[i]);
-        for (SpellsRequiringSpellMap::const_iterator itr = spellsRequired.first; itr != spellsRequired.second; ++itr)
+        SpellRequiredMapBounds spellsRequired = sSpellMgr->GetSpellsRequiredForSpellBounds(trainer_spell->learnedSpell[i]);
+        for (SpellRequiredIndex::const_iterator itr = spellsRequired.first; itr != spellsRequired.second; ++itr)
         {
             // check additional spell requirement
             if (!HasSpell(itr->second))
@@ -7890,6 +7895,8 @@ void Player::UpdateZone(uint32 newZone, uint32 newArea)
         SendInitWorldStates(newZone, newArea);              // only if really enters to new zone, not just area change, works strange...
         if (Guild* guild = GetGuild())
             guild->UpdateMemberData(this, GUILD_MEMBER_DATA_ZONEID, newZone);
+        if (IsInWorld())
+            sWorld->UpdateInWorldPlayerZone(this, m_zoneUpdateId, newZone);
     }
 
     // group update
@@ -16543,7 +16550,7 @@ void Player::SendQuestUpdate(uint32 questId)
     {
         GetZoneAndAreaId(zone, area);
 
-        for (SpellAreaForAreaMap::const_iterator itr = saBounds.first; itr != saBounds.second; ++itr)
+        for (SpellAreaForQuestMap::const_iterator itr = saBounds.first; itr != saBounds.second; ++itr)
             if (itr->second->autocast && itr->second->IsFitToRequirements(this, zone, area))
                 if (!HasAura(itr->second->spellId))
                     CastSpell(this, itr->second->spellId, true);
@@ -16555,7 +16562,7 @@ void Player::SendQuestUpdate(uint32 questId)
         if (!zone || !area)
             GetZoneAndAreaId(zone, area);
 
-        for (SpellAreaForAreaMap::const_iterator itr = saBounds.first; itr != saBounds.second; ++itr)
+        for (SpellAreaForQuestMap::const_iterator itr = saBounds.first; itr != saBounds.second; ++itr)
             if (!itr->second->IsFitToRequirements(this, zone, area))
                 RemoveAurasDueToSpell(itr->second->spellId);
     }
@@ -23753,8 +23760,8 @@ void Player::LearnQuestRewardedSpells(Quest const* quest)
         if (!HasSpell(learnedInfo->GetFirstRankSpell()->Id))
             return;
 
-        SpellsRequiringSpellMapBounds spellsRequired = sSpellMgr->GetSpellsRequiredForSpellBounds(learned_0);
-        for (SpellsRequiringSpellMap::const_iterator itr2 = spellsRequired.first; itr2 != spellsRequired.second; ++itr2)
+        SpellRequiredMapBounds spellsRequired = sSpellMgr->GetSpellsRequiredForSpellBounds(learned_0);
+        for (SpellRequiredIndex::const_iterator itr2 = spellsRequired.first; itr2 != spellsRequired.second; ++itr2)
         {
             uint32 profSpell = itr2->second;
 
@@ -24657,7 +24664,7 @@ void Player::UpdateZoneDependentAuras(uint32 newZone)
 {
     // Some spells applied at enter into zone (with subzones), aura removed in UpdateAreaDependentAuras that called always at zone->area update
     SpellAreaForAreaMapBounds saBounds = sSpellMgr->GetSpellAreaForAreaMapBounds(newZone);
-    for (SpellAreaForAreaMap::const_iterator itr = saBounds.first; itr != saBounds.second; ++itr)
+    for (SpellAreaForAreaIndex::const_iterator itr = saBounds.first; itr != saBounds.second; ++itr)
         if (itr->second->autocast && itr->second->IsFitToRequirements(this, newZone, 0))
             if (!HasAura(itr->second->spellId))
                 CastSpell(this, itr->second->spellId, true);
@@ -24677,7 +24684,7 @@ void Player::UpdateAreaDependentAuras(uint32 newArea)
 
     // some auras applied at subzone enter
     SpellAreaForAreaMapBounds saBounds = sSpellMgr->GetSpellAreaForAreaMapBounds(newArea);
-    for (SpellAreaForAreaMap::const_iterator itr = saBounds.first; itr != saBounds.second; ++itr)
+    for (SpellAreaForAreaIndex::const_iterator itr = saBounds.first; itr != saBounds.second; ++itr)
         if (itr->second->autocast && itr->second->IsFitToRequirements(this, m_zoneUpdateId, newArea))
             if (!HasAura(itr->second->spellId))
                 CastSpell(this, itr->second->spellId, true);
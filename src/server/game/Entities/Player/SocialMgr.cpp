@@ -27,7 +27,7 @@
 #include "Util.h"
 #include "AccountMgr.h"
 
-PlayerSocial::PlayerSocial(): m_playerGUID()
+PlayerSocial::PlayerSocial(): m_playerGUID(), m_ignoreCount(0)
 { }
 
 uint32 PlayerSocial::GetNumberOfSocialsWithFlag(SocialFlag flag)
@@ -69,6 +69,9 @@ bool PlayerSocial::AddToSocialList(uint32 friendGuid, bool ignore)
 
         CharacterDatabase.Execute(stmt);
 
+        if (ignore && !(itr->second.Flags & SOCIAL_FLAG_IGNORED))
+            ++m_ignoreCount;
+
         m_playerSocialMap[friendGuid].Flags |= flag;
     }
     else
@@ -84,6 +87,9 @@ bool PlayerSocial::AddToSocialList(uint32 friendGuid, bool ignore)
         FriendInfo fi;
         fi.Flags |= flag;
         m_playerSocialMap[friendGuid] = fi;
+
+        if (ignore)
+            ++m_ignoreCount;
     }
     return true;
 }
@@ -98,6 +104,9 @@ void PlayerSocial::RemoveFromSocialList(uint32 friendGuid, bool ignore)
     if (ignore)
         flag = SOCIAL_FLAG_IGNORED;
 
+    if (ignore && (itr->second.Flags & SOCIAL_FLAG_IGNORED))
+        --m_ignoreCount;
+
     itr->second.Flags &= ~flag;
     if (itr->second.Flags == 0)
     {
@@ -338,5 +347,7 @@ PlayerSocial* SocialMgr::LoadFromDB(PreparedQueryResult result, uint32 guid)
     }
     while (result->NextRow());
 
+    social->m_ignoreCount = social->GetNumberOfSocialsWithFlag(SOCIAL_FLAG_IGNORED);
+
     return social;
 }
@@ -112,12 +112,14 @@ class PlayerSocial
         // Misc
         bool HasFriend(uint32 friend_guid);
         bool HasIgnore(uint32 ignore_guid);
+        bool HasIgnores() const { return m_ignoreCount != 0; }
         uint32 GetPlayerGUID() const { return m_playerGUID; }
         void SetPlayerGUID(uint32 guid) { m_playerGUID = guid; }
         uint32 GetNumberOfSocialsWithFlag(SocialFlag flag);
     private:
         PlayerSocialMap m_playerSocialMap;
         uint32 m_playerGUID;
+        uint32 m_ignoreCount;                               // entries with SOCIAL_FLAG_IGNORED
 };
 
 class SocialMgr
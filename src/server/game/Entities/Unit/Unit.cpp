@@ -198,6 +198,8 @@ Unit::Unit(bool isWorldObject) :
     m_auraUpdateIterator = m_ownedAuras.end();
 
     m_interruptMask = 0;
+    m_procAuraMask = 0;
+    m_procAuraGeneration = sSpellMgr->GetSpellProcGeneration();
     m_transform = 0;
     m_canModifyStats = false;
 
@@ -529,6 +531,29 @@ void Unit::UpdateInterruptMask()
             m_interruptMask |= spell->m_spellInfo->ChannelInterruptFlags;
 }
 
+void Unit::UpdateProcAuraMask()
+{
+    m_procAuraMask = 0;
+    for (AuraApplicationMap::const_iterator i = m_procAuras.begin(); i != m_procAuras.end(); ++i)
+        m_procAuraMask |= sSpellMgr->GetSpellProcEventFlags(i->second->GetBase()->GetSpellInfo());
+}
+
+void Unit::RebuildProcAuras()
+{
+    m_procAuras.clear();
+    m_procAuraMask = 0;
+    for (AuraApplicationMap::const_iterator i = m_appliedAuras.begin(); i != m_appliedAuras.end(); ++i)
+    {
+        if (uint32 procFlags = sSpellMgr->GetSpellProcEventFlags(i->second->GetBase()->GetSpellInfo()))
+        {
+            m_procAuras.insert(m_procAuras.end(), *i);
+            m_procAuraMask |= procFlags;
+        }
+    }
+
+    m_procAuraGeneration = sSpellMgr->GetSpellProcGeneration();
+}
+
 bool Unit::HasAuraTypeWithFamilyFlags(AuraType auraType, uint32 familyName, uint32 familyFlags) const
 {
     if (!HasAuraType(auraType))
@@ -3386,6 +3411,12 @@ AuraApplication * Unit::_CreateAuraApplication(Aura* aura, uint8 effMask)
     if (AuraStateType aState = aura->GetSpellInfo()->GetAuraState())
         m_auraStateAuras.insert(AuraStateAurasMap::value_type(aState, aurApp));
 
+    if (uint32 procFlags = sSpellMgr->GetSpellProcEventFlags(aurSpellInfo))
+    {
+        m_procAuras.insert(AuraApplicationMap::value_type(aurId, aurApp));
+        m_procAuraMask |= procFlags;
+    }
+
     aura->_ApplyForTarget(this, caster, aurApp);
     return aurApp;
 }
@@ -3468,6 +3499,17 @@ void Unit::_UnapplyAura(AuraApplicationMap::iterator &i, AuraRemoveMode removeMo
         UpdateInterruptMask();
     }
 
+    AuraApplicationMapBoundsNonConst procRange = m_procAuras.equal_range(aura->GetId());
+    for (AuraApplicationMap::iterator itr = procRange.first; itr != procRange.second; ++itr)
+    {
+        if (itr->second == aurApp)
+        {
+            m_procAuras.erase(itr);
+            UpdateProcAuraMask();
+            break;
+        }
+    }
+
     bool auraStateFound = false;
     AuraStateType auraState = aura->GetSpellInfo()->GetAuraState();
     if (auraState)
@@ -14230,21 +14272,35 @@ void Unit::ProcDamageAndSpellFor(bool isVictim, Unit* target, uint32 procFlag, u
     HealInfo healInfo = HealInfo(damage);
     ProcEventInfo eventInfo = ProcEventInfo(actor, actionTarget, target, procFlag, 0, 0, procExtra, NULL, &damageInfo, &healInfo);
 
+    if (isVictim)
+        procExtra &= ~PROC_EX_INTERNAL_REQ_FAMILY;
+
+    // Only auras indexed in m_procAuras can pass IsTriggeredAtSpellProcEvent, skip the rest of the applied auras
+    uint32 procCandidates = 0;
+
     ProcTriggeredList procTriggered;
     // Fill procTriggered list
-    for (AuraApplicationMap::const_iterator itr = GetAppliedAuras().begin(); itr!= GetAppliedAuras().end(); ++itr)
+    // spell_proc_event or spell_proc was reloaded since the index was built
+    if (m_procAuraGeneration != sSpellMgr->GetSpellProcGeneration())
+        RebuildProcAuras();
+
+    AuraApplicationMap::const_iterator procAurasEnd = (procFlag & m_procAuraMask) ? m_procAuras.end() : m_procAuras.begin();
+    for (AuraApplicationMap::const_iterator itr = m_procAuras.begin(); itr != procAurasEnd; ++itr)
     {
         // Do not allow auras to proc from effect triggered by itself
         if (procAura && procAura->Id == itr->first)
             continue;
+
+        SpellInfo const* spellProto = itr->second->GetBase()->GetSpellInfo();
+        if (!(sSpellMgr->GetSpellProcEventFlags(spellProto) & procFlag))
+            continue;
+
+        ++procCandidates;
+
         ProcTriggeredData triggerData(itr->second->GetBase());
         // Defensive procs are active on absorbs (so absorption effects are not a hindrance)
         bool active = damage || (procExtra & PROC_EX_BLOCK && isVictim);
-        if (isVictim)
-            procExtra &= ~PROC_EX_INTERNAL_REQ_FAMILY;
 
-        SpellInfo const* spellProto = itr->second->GetBase()->GetSpellInfo();
-    
         if (spellProto && (procExtra & PROC_EX_BLOCK || procExtra & PROC_EX_ABSORB))
         {
             switch (spellProto->Id)
@@ -14307,6 +14363,14 @@ void Unit::ProcDamageAndSpellFor(bool isVictim, Unit* target, uint32 procFlag, u
             procTriggered.push_front(triggerData);
     }
 
+    if (Map* map = FindMap())
+    {
+        MapProcStats& stats = map->GetProcStats();
+        ++stats.Passes;
+        stats.CandidateAuras += procCandidates;
+        stats.SkippedAuras += m_appliedAuras.size() - procCandidates;
+    }
+
     // Nothing found
     if (procTriggered.empty())
         return;
@@ -16546,15 +16610,13 @@ void Unit::SetPhaseMask(uint32 newPhaseMask, bool update)
             // modify threat lists for new phasemask
             if (GetTypeId() != TYPEID_PLAYER)
             {
-                std::list<HostileReference*> threatList = getThreatManager().getThreatList();
-                std::list<HostileReference*> offlineThreatList = getThreatManager().getOfflineThreatList();
+                ThreatContainer::StorageType threatList = getThreatManager().getThreatList();
+                ThreatContainer::StorageType const& offlineThreatList = getThreatManager().getOfflineThreatList();
 
-                // merge expects sorted lists
-                threatList.sort();
-                offlineThreatList.sort();
-                threatList.merge(offlineThreatList);
+                // work on a copy, changing the online state moves references between both containers
+                threatList.insert(threatList.end(), offlineThreatList.begin(), offlineThreatList.end());
 
-                for (std::list<HostileReference*>::const_iterator itr = threatList.begin(); itr != threatList.end(); ++itr)
+                for (ThreatContainer::StorageType::const_iterator itr = threatList.begin(); itr != threatList.end(); ++itr)
                     if (Unit* unit = (*itr)->getTarget())
                         unit->getHostileRefManager().setOnlineOfflineState(ToCreature(), unit->InSamePhase(newPhaseMask));
             }
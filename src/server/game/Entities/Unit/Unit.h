@@ -28,6 +28,7 @@
 #include "Object.h"
 #include "SpellAuraDefines.h"
 #include "ThreatManager.h"
+#include "ObjectPool.h"
 
 #define WORLD_TRIGGER   12999
 
@@ -1259,18 +1260,19 @@ class Unit : public WorldObject
         typedef std::set<Unit*> AttackerSet;
         typedef std::set<Unit*> ControlList;
 
-        typedef std::multimap<uint32, Aura*> AuraMap;
+        // per-unit aura indexes draw their nodes from ObjectPool, auras churn too fast for the general heap
+        typedef std::multimap<uint32, Aura*, std::less<uint32>, PoolAllocator<std::pair<uint32 const, Aura*> > > AuraMap;
         typedef std::pair<AuraMap::const_iterator, AuraMap::const_iterator> AuraMapBounds;
         typedef std::pair<AuraMap::iterator, AuraMap::iterator> AuraMapBoundsNonConst;
 
-        typedef std::multimap<uint32,  AuraApplication*> AuraApplicationMap;
+        typedef std::multimap<uint32, AuraApplication*, std::less<uint32>, PoolAllocator<std::pair<uint32 const, AuraApplication*> > > AuraApplicationMap;
         typedef std::pair<AuraApplicationMap::const_iterator, AuraApplicationMap::const_iterator> AuraApplicationMapBounds;
         typedef std::pair<AuraApplicationMap::iterator, AuraApplicationMap::iterator> AuraApplicationMapBoundsNonConst;
 
         typedef std::multimap<AuraStateType,  AuraApplication*> AuraStateAurasMap;
         typedef std::pair<AuraStateAurasMap::const_iterator, AuraStateAurasMap::const_iterator> AuraStateAurasMapBounds;
 
-        typedef std::list<AuraEffect*> AuraEffectList;
+        typedef std::list<AuraEffect*, PoolAllocator<AuraEffect*> > AuraEffectList;
         typedef std::list<Aura*> AuraList;
         typedef std::list<AuraApplication *> AuraApplicationList;
         typedef std::list<DiminishingReturn> Diminishing;
@@ -1949,6 +1951,11 @@ class Unit : public WorldObject
         void AddInterruptMask(uint32 mask) { m_interruptMask |= mask; }
         void UpdateInterruptMask();
 
+        uint32 GetProcAuraMask() const { return m_procAuraMask; }
+        uint32 GetProcAuraCount() const { return uint32(m_procAuras.size()); }
+        void UpdateProcAuraMask();
+        void RebuildProcAuras();
+
         uint32 GetDisplayId() const { return GetUInt32Value(UNIT_FIELD_DISPLAYID); }
         virtual void SetDisplayId(uint32 modelId);
         uint32 GetNativeDisplayId() const { return GetUInt32Value(UNIT_FIELD_NATIVEDISPLAYID); }
@@ -2222,6 +2229,9 @@ class Unit : public WorldObject
         AuraApplicationList m_interruptableAuras;  // auras which have interrupt mask applied on unit
         AuraStateAurasMap m_auraStateAuras;        // Used for improve performance of aura state checks on aura apply/remove
         uint32 m_interruptMask;
+        AuraApplicationMap m_procAuras;            // applied auras which can react to proc flags, same order as m_appliedAuras
+        uint32 m_procAuraMask;                     // union of the proc flags of m_procAuras
+        uint32 m_procAuraGeneration;               // SpellMgr proc data generation m_procAuras was built for
 
         float m_auraModifiersGroup[UNIT_MOD_END][MODIFIER_TYPE_END];
         float m_weaponDamage[MAX_ATTACK][2];
@@ -27,6 +27,7 @@
 #include "GridNotifiers.h"
 #include "Item.h"
 #include "Map.h"
+#include "MapThreadChecker.h"
 #include "ObjectDefines.h"
 #include "ObjectMgr.h"
 #include "Pet.h"
@@ -187,28 +188,34 @@ Creature* ObjectAccessor::GetCreatureOrPetOrVehicle(WorldObject const& u, Object
 
 Pet* ObjectAccessor::FindPet(ObjectGuid guid)
 {
-    return GetObjectInWorld(guid, (Pet*)NULL);
+    Pet* pet = GetObjectInWorld(guid, (Pet*)NULL);
+    CHECK_MAP_THREAD_ACCESS(pet);
+    return pet;
 }
 
 Player* ObjectAccessor::FindPlayer(ObjectGuid guid)
 {
-    return GetObjectInWorld(guid, (Player*)NULL);
+    Player* player = GetObjectInWorld(guid, (Player*)NULL);
+    CHECK_MAP_THREAD_ACCESS(player);
+    return player;
 }
 
 Player* ObjectAccessor::FindConnectedPlayer(ObjectGuid guid)
 {
-    return HashMapHolder<Player>::Find(guid);
+    Player* player = HashMapHolder<Player>::Find(guid);
+    CHECK_MAP_THREAD_ACCESS(player);
+    return player;
 }
 
 Unit* ObjectAccessor::FindUnit(ObjectGuid guid)
 {
-    return GetObjectInWorld(guid, (Unit*)NULL);
+    Unit* unit = GetObjectInWorld(guid, (Unit*)NULL);
+    CHECK_MAP_THREAD_ACCESS(unit);
+    return unit;
 }
 
 Player* ObjectAccessor::FindPlayerByName(std::string const& name)
 {
-    boost::shared_lock<boost::shared_mutex> lock(*HashMapHolder<Player>::GetLock());
-
     std::string nameStr = name;
     std::transform(nameStr.begin(), nameStr.end(), nameStr.begin(), ::tolower);
     HashMapHolder<Player>::MapType const& m = GetPlayers();
@@ -219,7 +226,10 @@ Player* ObjectAccessor::FindPlayerByName(std::string const& name)
         std::string currentName = iter->second->GetName();
         std::transform(currentName.begin(), currentName.end(), currentName.begin(), ::tolower);
         if (nameStr.compare(currentName) == 0)
+        {
+            CHECK_MAP_THREAD_ACCESS(iter->second);
             return iter->second;
+        }
     }
 
     return NULL;
@@ -227,8 +237,6 @@ Player* ObjectAccessor::FindPlayerByName(std::string const& name)
 
 Player* ObjectAccessor::FindConnectedPlayerByName(std::string const& name)
 {
-    boost::shared_lock<boost::shared_mutex> lock(*HashMapHolder<Player>::GetLock());
-
     std::string nameStr = name;
     std::transform(nameStr.begin(), nameStr.end(), nameStr.begin(), ::tolower);
     HashMapHolder<Player>::MapType const& m = GetPlayers();
@@ -237,7 +245,10 @@ Player* ObjectAccessor::FindConnectedPlayerByName(std::string const& name)
         std::string currentName = iter->second->GetName();
         std::transform(currentName.begin(), currentName.end(), currentName.begin(), ::tolower);
         if (nameStr.compare(currentName) == 0)
+        {
+            CHECK_MAP_THREAD_ACCESS(iter->second);
             return iter->second;
+        }
     }
 
     return NULL;
@@ -245,8 +256,6 @@ Player* ObjectAccessor::FindConnectedPlayerByName(std::string const& name)
 
 void ObjectAccessor::SaveAllPlayers()
 {
-    boost::shared_lock<boost::shared_mutex> lock(*HashMapHolder<Player>::GetLock());
-
     HashMapHolder<Player>::MapType const& m = GetPlayers();
     for (HashMapHolder<Player>::MapType::const_iterator itr = m.begin(); itr != m.end(); ++itr)
         itr->second->SaveToDB();
@@ -425,6 +434,9 @@ void ObjectAccessor::RemoveOldCorpses()
 
 void ObjectAccessor::Update(uint32 /*diff*/)
 {
+    // map update threads are done with the player snapshots replaced during their update
+    HashMapHolder<Player>::ReclaimSnapshots();
+
     UpdateDataMapType update_players;
 
     while (!i_objects.empty())
@@ -458,9 +470,49 @@ void ObjectAccessor::UnloadAll()
 template <class T> typename HashMapHolder<T>::MapType HashMapHolder<T>::_objectMap;
 template <class T> boost::shared_mutex HashMapHolder<T>::_lock;
 
+std::mutex HashMapHolder<Player>::_writeLock;
+std::atomic<HashMapHolder<Player>::MapType const*> HashMapHolder<Player>::_objectMap(new HashMapHolder<Player>::MapType());
+std::vector<HashMapHolder<Player>::MapType const*> HashMapHolder<Player>::_retiredMaps;
+
+void HashMapHolder<Player>::Insert(Player* o)
+{
+    std::lock_guard<std::mutex> lock(_writeLock);
+
+    MapType const* oldMap = _objectMap.load(std::memory_order_relaxed);
+    MapType* newMap = new MapType(*oldMap);
+    (*newMap)[o->GetGUID()] = o;
+
+    _objectMap.store(newMap, std::memory_order_release);
+    _retiredMaps.push_back(oldMap);
+}
+
+void HashMapHolder<Player>::Remove(Player* o)
+{
+    std::lock_guard<std::mutex> lock(_writeLock);
+
+    MapType const* oldMap = _objectMap.load(std::memory_order_relaxed);
+    if (oldMap->find(o->GetGUID()) == oldMap->end())
+        return;
+
+    MapType* newMap = new MapType(*oldMap);
+    newMap->erase(o->GetGUID());
+
+    _objectMap.store(newMap, std::memory_order_release);
+    _retiredMaps.push_back(oldMap);
+}
+
+void HashMapHolder<Player>::ReclaimSnapshots()
+{
+    std::lock_guard<std::mutex> lock(_writeLock);
+
+    for (MapType const* objectMap : _retiredMaps)
+        delete objectMap;
+
+    _retiredMaps.clear();
+}
+
 /// Global definitions for the hashmap storage
 
-template class HashMapHolder<Player>;
 template class HashMapHolder<Pet>;
 template class HashMapHolder<GameObject>;
 template class HashMapHolder<DynamicObject>;
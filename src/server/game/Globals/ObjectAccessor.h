@@ -19,9 +19,11 @@
 #ifndef TRINITY_OBJECTACCESSOR_H
 #define TRINITY_OBJECTACCESSOR_H
 
+#include <atomic>
 #include <mutex>
 #include <set>
 #include <unordered_map>
+#include <vector>
 #include <boost/thread/locks.hpp>
 #include <boost/thread/shared_mutex.hpp>
 
@@ -83,6 +85,42 @@ class HashMapHolder
         static MapType _objectMap;
 };
 
+// Players are looked up from every map update thread but only added and removed on login and logout.
+// Readers use the current snapshot without locking, writers publish a modified copy and the old
+// snapshot is freed by ReclaimSnapshots once the map update threads have finished their update.
+template <>
+class HashMapHolder<Player>
+{
+    public:
+
+        typedef std::unordered_map<ObjectGuid, Player*> MapType;
+
+        static void Insert(Player* o);
+        static void Remove(Player* o);
+
+        static Player* Find(ObjectGuid guid)
+        {
+            MapType const* objectMap = _objectMap.load(std::memory_order_acquire);
+
+            MapType::const_iterator itr = objectMap->find(guid);
+            return (itr != objectMap->end()) ? itr->second : NULL;
+        }
+
+        // the snapshot stays valid until the next ReclaimSnapshots, do not keep it across updates
+        static MapType const& GetContainer() { return *_objectMap.load(std::memory_order_acquire); }
+
+        // world thread only, while no map is being updated
+        static void ReclaimSnapshots();
+
+    private:
+        //Non instanceable only static
+        HashMapHolder() { }
+
+        static std::mutex _writeLock;
+        static std::atomic<MapType const*> _objectMap;
+        static std::vector<MapType const*> _retiredMaps;
+};
+
 class ObjectAccessor
 {
     private:
@@ -36,6 +36,7 @@
 #include "ObjectAccessor.h"
 #include "ObjectDefines.h"
 #include "VehicleDefines.h"
+#include <atomic>
 #include <string>
 #include <map>
 #include <limits>
@@ -1311,19 +1312,20 @@ class ObjectMgr
         uint32 _auctionId;
         uint64 _equipmentSetGuid;
         uint32 _itemTextId;
-        uint32 _mailId;
-        uint32 _hiPetNumber;
+        std::atomic<uint32> _mailId;
+        std::atomic<uint32> _hiPetNumber;
 
         // first free low guid for selected guid type
+        // all but the character guids are also generated by handlers and spells running on map threads
         uint32 _hiCharGuid;
-        uint32 _hiCreatureGuid;
-        uint32 _hiPetGuid;
-        uint32 _hiVehicleGuid;
-        uint32 _hiItemGuid;
-        uint32 _hiGoGuid;
-        uint32 _hiDoGuid;
-        uint32 _hiCorpseGuid;
-        uint32 _hiMoTransGuid;
+        std::atomic<uint32> _hiCreatureGuid;
+        std::atomic<uint32> _hiPetGuid;
+        std::atomic<uint32> _hiVehicleGuid;
+        std::atomic<uint32> _hiItemGuid;
+        std::atomic<uint32> _hiGoGuid;
+        std::atomic<uint32> _hiDoGuid;
+        std::atomic<uint32> _hiCorpseGuid;
+        std::atomic<uint32> _hiMoTransGuid;
 
         QuestMap _questTemplates;
 
@@ -52,7 +52,7 @@ LootStore LootTemplates_Reference("reference_loot_template",         "reference
 LootStore LootTemplates_Skinning("skinning_loot_template",           "creature skinning id",            true);
 LootStore LootTemplates_Spell("spell_loot_template",                 "spell id (random item creating)", false);
 
-// Selects invalid loot items to be removed from group possible entries (before rolling)
+// Selects invalid loot items to be skipped from group possible entries (while rolling)
 struct LootGroupInvalidSelector : public std::unary_function<LootStoreItem*, bool>
 {
     explicit LootGroupInvalidSelector(Loot const& loot, uint16 lootMode) : _loot(loot), _lootMode(lootMode) { }
@@ -79,7 +79,7 @@ private:
 class LootTemplate::LootGroup                               // A set of loot definitions for items (refs are not allowed)
 {
     public:
-        LootGroup() { }
+        LootGroup() : CommonLootMode(0xFFFF) { }
         ~LootGroup();
 
         void AddEntry(LootStoreItem* item);                 // Adds an entry to the group (at loading stage)
@@ -99,8 +99,12 @@ class LootTemplate::LootGroup                               // A set of loot def
     private:
         LootStoreItemList ExplicitlyChanced;                // Entries with chances defined in DB
         LootStoreItemList EqualChanced;                     // Zero chances - every entry takes the same chance
+        std::vector<float> ExplicitlyChancedSums;           // Running chance totals of ExplicitlyChanced, rolled with a binary search
+        std::vector<uint32> ItemIds;                        // Sorted item ids of all entries, for the duplicate pre-check
+        uint16 CommonLootMode;                              // Loot mode bits shared by every entry
 
         LootStoreItem const* Roll(Loot& loot, uint16 lootMode) const;   // Rolls an item from the group, returns NULL if all miss their chances
+        bool AllEntriesValid(Loot const& loot, uint16 lootMode) const;  // True if no entry would be removed by LootGroupInvalidSelector
 
         // This class must never be copied - storing pointers
         LootGroup(LootGroup const&);
@@ -1098,39 +1102,93 @@ LootTemplate::LootGroup::~LootGroup()
 void LootTemplate::LootGroup::AddEntry(LootStoreItem* item)
 {
     if (item->chance != 0)
+    {
+        ExplicitlyChancedSums.push_back((ExplicitlyChancedSums.empty() ? 0.0f : ExplicitlyChancedSums.back()) + item->chance);
         ExplicitlyChanced.push_back(item);
+    }
     else
         EqualChanced.push_back(item);
+
+    std::vector<uint32>::iterator itr = std::lower_bound(ItemIds.begin(), ItemIds.end(), item->itemid);
+    if (itr == ItemIds.end() || *itr != item->itemid)
+        ItemIds.insert(itr, item->itemid);
+
+    CommonLootMode &= item->lootmode;
+}
+
+// Cheap check whether rolling can use the whole group as loaded: every entry
+// matches the loot mode and none of the group's items has dropped yet
+bool LootTemplate::LootGroup::AllEntriesValid(Loot const& loot, uint16 lootMode) const
+{
+    if (!(CommonLootMode & lootMode))
+        return false;
+
+    for (std::vector<LootItem>::const_iterator itr = loot.items.begin(); itr != loot.items.end(); ++itr)
+        if (std::binary_search(ItemIds.begin(), ItemIds.end(), itr->itemid))
+            return false;
+
+    return true;
 }
 
 // Rolls an item from the group, returns NULL if all miss their chances
 LootStoreItem const* LootTemplate::LootGroup::Roll(Loot& loot, uint16 lootMode) const
 {
-    LootStoreItemList possibleLoot = ExplicitlyChanced;
-    possibleLoot.remove_if(LootGroupInvalidSelector(loot, lootMode));
+    if (AllEntriesValid(loot, lootMode))
+    {
+        if (!ExplicitlyChanced.empty())                     // First explicitly chanced entries are checked
+        {
+            // An entry with chance >= 100 always covers the rest of the roll range, no special case needed
+            float roll = (float)rand_chance();
+            std::vector<float>::const_iterator itr = std::upper_bound(ExplicitlyChancedSums.begin(), ExplicitlyChancedSums.end(), roll);
+            if (itr != ExplicitlyChancedSums.end())
+                return ExplicitlyChanced[itr - ExplicitlyChancedSums.begin()];
+        }
+
+        if (!EqualChanced.empty())                          // If nothing selected yet - an item is taken from equal-chanced part
+            return Trinity::Containers::SelectRandomContainerElement(EqualChanced);
+
+        return NULL;                                        // Empty drop from the group
+    }
+
+    // Some entries are filtered out, walk the remaining ones in place
+    LootGroupInvalidSelector isInvalid(loot, lootMode);
 
-    if (!possibleLoot.empty())                             // First explicitly chanced entries are checked
+    bool rolled = false;
+    float roll = 0.0f;
+    for (LootStoreItemList::const_iterator itr = ExplicitlyChanced.begin(); itr != ExplicitlyChanced.end(); ++itr)
     {
-        float roll = (float)rand_chance();
+        LootStoreItem* item = *itr;
+        if (isInvalid(item))
+            continue;
 
-        for (LootStoreItemList::const_iterator itr = possibleLoot.begin(); itr != possibleLoot.end(); ++itr)   // check each explicitly chanced entry in the template and modify its chance based on quality.
+        if (!rolled)
         {
-            LootStoreItem* item = *itr;
-            if (item->chance >= 100.0f)
-                return item;
-
-            roll -= item->chance;
-            if (roll < 0)
-                return item;
+            roll = (float)rand_chance();
+            rolled = true;
         }
+
+        if (item->chance >= 100.0f)
+            return item;
+
+        roll -= item->chance;
+        if (roll < 0)
+            return item;
     }
 
-    possibleLoot = EqualChanced;
-    possibleLoot.remove_if(LootGroupInvalidSelector(loot, lootMode));
-    if (!possibleLoot.empty())                              // If nothing selected yet - an item is taken from equal-chanced part
-        return Trinity::Containers::SelectRandomContainerElement(possibleLoot);
+    uint32 validCount = 0;
+    for (LootStoreItemList::const_iterator itr = EqualChanced.begin(); itr != EqualChanced.end(); ++itr)
+        if (!isInvalid(*itr))
+            ++validCount;
+
+    if (!validCount)
+        return NULL;                                        // Empty drop from the group
+
+    uint32 selected = urand(0, validCount - 1);
+    for (LootStoreItemList::const_iterator itr = EqualChanced.begin(); itr != EqualChanced.end(); ++itr)
+        if (!isInvalid(*itr) && !selected--)
+            return *itr;
 
-    return NULL;                                            // Empty drop from the group
+    return NULL;
 }
 
 // True if group includes at least 1 quest drop entry
@@ -25,6 +25,7 @@
 #include "SharedDefines.h"
 #include "ConditionMgr.h"
 #include "ObjectGuid.h"
+#include "ObjectPool.h"
 #include <map>
 #include <vector>
 #include <list>
@@ -197,8 +198,8 @@ class LootTemplate;
 
 typedef std::vector<QuestItem> QuestItemList;
 typedef std::vector<LootItem> LootItemList;
-typedef std::map<uint32, QuestItemList*> QuestItemMap;
-typedef std::list<LootStoreItem*> LootStoreItemList;
+typedef std::map<uint32, QuestItemList*, std::less<uint32>, PoolAllocator<std::pair<uint32 const, QuestItemList*> > > QuestItemMap;
+typedef std::vector<LootStoreItem*> LootStoreItemList;
 typedef std::unordered_map<uint32, LootTemplate*> LootTemplateMap;
 
 typedef std::set<uint32> LootIdSet;
@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2008-2015 TrinityCore <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "GridPreloader.h"
+#include "Log.h"
+#include "Map.h"
+#include "MMapFactory.h"
+#include "VMapFactory.h"
+#include "VMapManager2.h"
+#include "World.h"
+
+// preloaded data of grids that were not created in time is released after this long
+#define GRID_PRELOAD_EXPIRY (60 * IN_MILLISECONDS)
+
+void GridPreloader::Activate(uint32 threads, uint32 lookAhead)
+{
+    _cancelationToken = false;
+    _lookAhead = lookAhead;
+
+    for (uint32 i = 0; i < threads; ++i)
+        _workerThreads.push_back(std::thread(&GridPreloader::WorkerThread, this));
+
+    TC_LOG_INFO("server.loading", "Started %u grid preloading threads", threads);
+}
+
+void GridPreloader::Deactivate()
+{
+    if (!IsActive())
+        return;
+
+    _cancelationToken = true;
+
+    // deletes the requests still queued
+    _queue.Cancel();
+
+    for (std::thread& thread : _workerThreads)
+        thread.join();
+
+    _workerThreads.clear();
+
+    std::lock_guard<std::mutex> lock(_gridsLock);
+    for (std::unordered_map<uint32, PreloadedGrid>::iterator itr = _grids.begin(); itr != _grids.end(); ++itr)
+        Release(itr->first, itr->second);
+
+    _grids.clear();
+}
+
+void GridPreloader::Request(uint32 mapId, int32 gx, int32 gy, bool vmap, bool mmap)
+{
+    {
+        std::lock_guard<std::mutex> lock(_gridsLock);
+        if (!_grids.insert(std::make_pair(MakeKey(mapId, gx, gy), PreloadedGrid())).second)
+            return;
+    }
+
+    PreloadRequest* request = new PreloadRequest();
+    request->MapId = mapId;
+    request->X = gx;
+    request->Y = gy;
+    request->VMap = vmap;
+    request->MMap = mmap;
+    _queue.Push(request);
+}
+
+GridMap* GridPreloader::TakeGridMap(uint32 mapId, int32 gx, int32 gy)
+{
+    std::lock_guard<std::mutex> lock(_gridsLock);
+    std::unordered_map<uint32, PreloadedGrid>::iterator itr = _grids.find(MakeKey(mapId, gx, gy));
+    if (itr == _grids.end() || !itr->second.Done)
+        return NULL;
+
+    // the entry stays until it expires, so the grid isn't requested again meanwhile
+    GridMap* gridMap = itr->second.Map;
+    itr->second.Map = NULL;
+    return gridMap;
+}
+
+void GridPreloader::Update(uint32 diff)
+{
+    std::lock_guard<std::mutex> lock(_gridsLock);
+    for (std::unordered_map<uint32, PreloadedGrid>::iterator itr = _grids.begin(); itr != _grids.end();)
+    {
+        if (!itr->second.Done)
+        {
+            ++itr;
+            continue;
+        }
+
+        itr->second.Age += diff;
+        if (itr->second.Age < GRID_PRELOAD_EXPIRY)
+        {
+            ++itr;
+            continue;
+        }
+
+        Release(itr->first, itr->second);
+        itr = _grids.erase(itr);
+    }
+}
+
+void GridPreloader::Load(PreloadRequest const& request)
+{
+    int len = sWorld->GetDataPath().length() + strlen("maps/%03u%02u%02u.map") + 1;
+    char* fileName = new char[len];
+    snprintf(fileName, len, (char *)(sWorld->GetDataPath() + "maps/%03u%02u%02u.map").c_str(), request.MapId, request.X, request.Y);
+
+    // failures are reported by Map::LoadMap when it loads the file itself
+    GridMap* gridMap = new GridMap();
+    if (!gridMap->loadData(fileName))
+    {
+        delete gridMap;
+        gridMap = NULL;
+    }
+    delete[] fileName;
+
+    if (request.VMap)
+        if (VMAP::VMapManager2* vmmgr2 = dynamic_cast<VMAP::VMapManager2*>(VMAP::VMapFactory::createOrGetVMapManager()))
+            vmmgr2->prefetchTile(sWorld->GetDataPath() + "vmaps", request.MapId, request.X, request.Y);
+
+    if (request.MMap)
+        MMAP::MMapFactory::createOrGetMMapManager()->prefetchTile(request.MapId, request.X, request.Y);
+
+    TC_LOG_DEBUG("maps", "GridPreloader: preloaded grid [%d, %d] of map %u", request.X, request.Y, request.MapId);
+
+    std::lock_guard<std::mutex> lock(_gridsLock);
+    PreloadedGrid& grid = _grids[MakeKey(request.MapId, request.X, request.Y)];
+    grid.Map = gridMap;
+    grid.VMap = request.VMap;
+    grid.MMap = request.MMap;
+    grid.Done = true;
+}
+
+void GridPreloader::Release(uint32 key, PreloadedGrid& grid)
+{
+    delete grid.Map;
+    grid.Map = NULL;
+
+    uint32 mapId = key >> 12;
+    int32 gx = (key >> 6) & 0x3F;
+    int32 gy = key & 0x3F;
+
+    // no-ops if the tiles were loaded, their loadMap took the prefetched data
+    if (grid.VMap)
+        if (VMAP::VMapManager2* vmmgr2 = dynamic_cast<VMAP::VMapManager2*>(VMAP::VMapFactory::createOrGetVMapManager()))
+            vmmgr2->releasePrefetchedTile(mapId, gx, gy);
+
+    if (grid.MMap)
+        MMAP::MMapFactory::createOrGetMMapManager()->releasePrefetchedTile(mapId, gx, gy);
+}
+
+void GridPreloader::WorkerThread()
+{
+    while (1)
+    {
+        PreloadRequest* request = nullptr;
+
+        _queue.WaitAndPop(request);
+
+        if (_cancelationToken)
+            return;
+
+        Load(*request);
+
+        delete request;
+    }
+}
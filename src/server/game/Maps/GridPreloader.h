@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2008-2015 TrinityCore <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRINITY_GRIDPRELOADER_H
+#define TRINITY_GRIDPRELOADER_H
+
+#include "Define.h"
+#include "ProducerConsumerQueue.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+class GridMap;
+
+// Loads the terrain of grids players are heading to on worker threads: the .map file, the models
+// of the vmap tile and the mmap tile file. Map::LoadMap and the vmap/mmap managers pick the data up
+// when the grid is created, leaving only the tree and navmesh insertion to the map thread.
+class GridPreloader
+{
+    public:
+        static GridPreloader* instance()
+        {
+            static GridPreloader instance;
+            return &instance;
+        }
+
+        void Activate(uint32 threads, uint32 lookAhead);
+        void Deactivate();
+        bool IsActive() const { return !_workerThreads.empty(); }
+
+        // seconds of movement the grids are loaded ahead
+        uint32 GetLookAhead() const { return _lookAhead; }
+
+        // gx and gy as passed to Map::LoadMap, ignored if already requested
+        void Request(uint32 mapId, int32 gx, int32 gy, bool vmap, bool mmap);
+
+        // the caller takes ownership, NULL if the grid map was not (yet) preloaded
+        GridMap* TakeGridMap(uint32 mapId, int32 gx, int32 gy);
+
+        // releases what was preloaded for grids that were not loaded in time, world thread only
+        void Update(uint32 diff);
+
+    private:
+        struct PreloadRequest
+        {
+            uint32 MapId;
+            int32 X;
+            int32 Y;
+            bool VMap;
+            bool MMap;
+        };
+
+        struct PreloadedGrid
+        {
+            PreloadedGrid() : Map(NULL), Done(false), VMap(false), MMap(false), Age(0) { }
+
+            GridMap* Map;
+            bool Done;
+            bool VMap;
+            bool MMap;
+            uint32 Age;                                     // time since it was done
+        };
+
+        GridPreloader() : _lookAhead(0), _cancelationToken(false) { }
+        ~GridPreloader() { }
+
+        static uint32 MakeKey(uint32 mapId, int32 gx, int32 gy) { return mapId << 12 | uint32(gx) << 6 | uint32(gy); }
+
+        void Load(PreloadRequest const& request);
+        void Release(uint32 key, PreloadedGrid& grid);
+        void WorkerThread();
+
+        uint32 _lookAhead;
+        ProducerConsumerQueue<PreloadRequest*> _queue;
+        std::vector<std::thread> _workerThreads;
+        std::atomic<bool> _cancelationToken;
+
+        std::mutex _gridsLock;
+        std::unordered_map<uint32, PreloadedGrid> _grids;
+};
+
+#define sGridPreloader GridPreloader::instance()
+
+#endif
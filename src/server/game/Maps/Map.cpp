@@ -24,6 +24,7 @@
 #include "DynamicTree.h"
 #include "GridNotifiers.h"
 #include "GridNotifiersImpl.h"
+#include "GridPreloader.h"
 #include "GridStates.h"
 #include "Group.h"
 #include "InstanceScript.h"
@@ -35,15 +36,21 @@
 #include "Transport.h"
 #include "Vehicle.h"
 #include "VMapFactory.h"
+#include "VMapManager2.h"
+#include "WaypointMovementGenerator.h"
+#include "zlib.h"
 
 u_map_magic MapMagic        = { {'M','A','P','S'} };
-u_map_magic MapVersionMagic = { {'v','1','.','3'} };
+u_map_magic MapVersionMagic = { {'v','1','.','4'} };
+u_map_magic MapVersionMagicUncompressed = { {'v','1','.','3'} }; // still loaded, same layout without the v1.4 section flags
 u_map_magic MapAreaMagic    = { {'A','R','E','A'} };
 u_map_magic MapHeightMagic  = { {'M','H','G','T'} };
 u_map_magic MapLiquidMagic  = { {'M','L','I','Q'} };
 
 #define DEFAULT_GRID_EXPIRY     300
 #define MAX_GRID_LOAD_TIME      50
+#define GRID_PRELOAD_INTERVAL   1000
+#define GRID_PRELOAD_TAXI_SPEED 32.0f                       // yards per second flown on flight paths
 #define MAX_CREATURE_ATTACK_RADIUS  (45.0f * sWorld->getRate(RATE_CREATURE_AGGRO))
 
 GridState* si_GridStates[MAX_GRID_STATE];
@@ -65,8 +72,6 @@ Map::~Map()
 
     if (!m_scriptSchedule.empty())
         sScriptMgr->DecreaseScheduledScriptCount(m_scriptSchedule.size());
-
-    MMAP::MMapFactory::createOrGetMMapManager()->unloadMapInstance(GetId(), i_InstanceId);
 }
 
 bool Map::ExistMap(uint32 mapid, int gx, int gy)
@@ -88,7 +93,8 @@ bool Map::ExistMap(uint32 mapid, int gx, int gy)
         map_fileheader header;
         if (fread(&header, sizeof(header), 1, pf) == 1)
         {
-            if (header.mapMagic.asUInt != MapMagic.asUInt || header.versionMagic.asUInt != MapVersionMagic.asUInt)
+            if (header.mapMagic.asUInt != MapMagic.asUInt ||
+                (header.versionMagic.asUInt != MapVersionMagic.asUInt && header.versionMagic.asUInt != MapVersionMagicUncompressed.asUInt))
                 TC_LOG_ERROR("maps", "Map file '%s' is from an incompatible map version (%.*s %.*s), %.*s %.*s is expected. Please recreate using the mapextractor.",
                     fileName, 4, header.mapMagic.asChar, 4, header.versionMagic.asChar, 4, MapMagic.asChar, 4, MapVersionMagic.asChar);
             else
@@ -143,6 +149,8 @@ void Map::LoadVMap(int gx, int gy)
     switch (vmapLoadResult)
     {
         case VMAP::VMAP_LOAD_RESULT_OK:
+            // results cached without this tile are outdated now
+            MapQueryCache::Invalidate(GetId());
             TC_LOG_DEBUG("maps", "VMAP loaded name:%s, id:%d, x:%d, y:%d (vmap rep.: x:%d, y:%d)", GetMapName(), GetId(), gx, gy, gx, gy);
             break;
         case VMAP::VMAP_LOAD_RESULT_ERROR:
@@ -189,10 +197,16 @@ void Map::LoadMap(int gx, int gy, bool reload)
     tmp = new char[len];
     snprintf(tmp, len, (char *)(sWorld->GetDataPath() + "maps/%03u%02u%02u.map").c_str(), GetId(), gx, gy);
     TC_LOG_DEBUG("maps", "Loading map %s", tmp);
-    // loading data
-    GridMaps[gx][gy] = new GridMap();
-    if (!GridMaps[gx][gy]->loadData(tmp))
-        TC_LOG_ERROR("maps", "Error loading map file: \n %s\n", tmp);
+    // loading data, unless the grid preloader already did
+    GridMap* preloaded = sGridPreloader->IsActive() ? sGridPreloader->TakeGridMap(GetId(), gx, gy) : NULL;
+    if (preloaded)
+        GridMaps[gx][gy] = preloaded;
+    else
+    {
+        GridMaps[gx][gy] = new GridMap();
+        if (!GridMaps[gx][gy]->loadData(tmp))
+            TC_LOG_ERROR("maps", "Error loading map file: \n %s\n", tmp);
+    }
     delete[] tmp;
 
     sScriptMgr->OnLoadGridMap(this, GridMaps[gx][gy], gx, gy);
@@ -228,7 +242,7 @@ void Map::DeleteStateMachine()
 Map::Map(uint32 id, time_t expiry, uint32 InstanceId, uint8 SpawnMode, Map* _parent):
 _creatureToMoveLock(false), _gameObjectsToMoveLock(false), _dynamicObjectsToMoveLock(false),
 i_mapEntry(sMapStore.LookupEntry(id)), i_spawnMode(SpawnMode), i_InstanceId(InstanceId),
-m_unloadTimer(0), m_VisibleDistance(DEFAULT_VISIBILITY_DISTANCE),
+m_unloadTimer(0), m_VisibleDistance(DEFAULT_VISIBILITY_DISTANCE), _queryCache(id),
 m_VisibilityNotifyPeriod(DEFAULT_VISIBILITY_NOTIFY_PERIOD),
 m_activeNonPlayersIter(m_activeNonPlayers.end()), _transportsUpdateIter(_transports.end()),
 i_gridExpiry(expiry),
@@ -466,6 +480,71 @@ void Map::LoadGrid(float x, float y)
     EnsureGridLoaded(Cell(x, y));
 }
 
+void Map::PreloadGridsAhead(Player* player)
+{
+    float lookAhead = float(sGridPreloader->GetLookAhead());
+
+    if (player->IsInFlight())
+    {
+        if (player->GetMotionMaster()->GetCurrentMovementGeneratorType() != FLIGHT_MOTION_TYPE)
+            return;
+
+        // follow the flight path for as far as it is flown during the look ahead time
+        FlightPathMovementGenerator* flight = static_cast<FlightPathMovementGenerator*>(player->GetMotionMaster()->top());
+        TaxiPathNodeList const& path = flight->GetPath();
+        float distance = lookAhead * GRID_PRELOAD_TAXI_SPEED;
+        float lastX = player->GetPositionX();
+        float lastY = player->GetPositionY();
+        for (uint32 i = flight->GetCurrentNode(); i < path.size() && distance > 0.0f; ++i)
+        {
+            TaxiPathNodeEntry const& node = path[i];
+            if (node.mapid != GetId())
+                break;
+
+            distance -= std::sqrt((node.x - lastX) * (node.x - lastX) + (node.y - lastY) * (node.y - lastY));
+            lastX = node.x;
+            lastY = node.y;
+            PreloadGrid(node.x, node.y);
+        }
+        return;
+    }
+
+    if (!player->isMoving() || player->GetTransport())
+        return;
+
+    float angle = player->GetOrientation();
+    if (player->m_movementInfo.HasMovementFlag(MOVEMENTFLAG_BACKWARD))
+        angle += float(M_PI);
+    if (player->m_movementInfo.HasMovementFlag(MOVEMENTFLAG_STRAFE_LEFT))
+        angle += float(M_PI) / 2;
+    else if (player->m_movementInfo.HasMovementFlag(MOVEMENTFLAG_STRAFE_RIGHT))
+        angle -= float(M_PI) / 2;
+
+    float distance = lookAhead * player->GetSpeed(player->IsFlying() ? MOVE_FLIGHT : MOVE_RUN);
+    float dx = std::cos(angle);
+    float dy = std::sin(angle);
+    for (float step = SIZE_OF_GRIDS / 2; step < distance; step += SIZE_OF_GRIDS / 2)
+        PreloadGrid(player->GetPositionX() + dx * step, player->GetPositionY() + dy * step);
+
+    PreloadGrid(player->GetPositionX() + dx * distance, player->GetPositionY() + dy * distance);
+}
+
+void Map::PreloadGrid(float x, float y)
+{
+    if (!Trinity::IsValidMapCoord(x, y))
+        return;
+
+    GridCoord p = Trinity::ComputeGridCoord(x, y);
+    int gx = (MAX_NUMBER_OF_GRIDS - 1) - p.x_coord;
+    int gy = (MAX_NUMBER_OF_GRIDS - 1) - p.y_coord;
+    if (GridMaps[gx][gy])
+        return;
+
+    // instances load their tiles through the parent map, the map id is the same
+    sGridPreloader->Request(GetId(), gx, gy, VMAP::VMapFactory::createOrGetVMapManager()->isMapLoadingEnabled(),
+        DisableMgr::IsPathfindingEnabled(GetId()));
+}
+
 bool Map::AddPlayerToMap(Player* player)
 {
     CellCoord cellCoord = Trinity::ComputeCellCoord(player->GetPositionX(), player->GetPositionY());
@@ -627,6 +706,12 @@ void Map::VisitNearbyCellsOf(WorldObject* obj, TypeContainerVisitor<Trinity::Obj
 
 void Map::Update(const uint32 t_diff)
 {
+    {
+        std::lock_guard<std::mutex> lock(_procStatsLock);
+        _lastUpdateProcStats = _procStats;
+    }
+    _procStats = MapProcStats();
+
     _dynamicTree.update(t_diff);
     /// update worldsessions for existing players
     for (m_mapRefIter = m_mapRefManager.begin(); m_mapRefIter != m_mapRefManager.end(); ++m_mapRefIter)
@@ -643,6 +728,17 @@ void Map::Update(const uint32 t_diff)
     /// update active cells around players and active objects
     resetMarkedCells();
 
+    bool preloadGrids = false;
+    if (sGridPreloader->IsActive())
+    {
+        _gridPreloadTimer.Update(t_diff);
+        if (_gridPreloadTimer.Passed())
+        {
+            _gridPreloadTimer.Reset(GRID_PRELOAD_INTERVAL);
+            preloadGrids = true;
+        }
+    }
+
     Trinity::ObjectUpdater updater(t_diff);
     // for creature
     TypeContainerVisitor<Trinity::ObjectUpdater, GridTypeMapContainer  > grid_object_update(updater);
@@ -662,6 +758,9 @@ void Map::Update(const uint32 t_diff)
         player->Update(t_diff);
 
         VisitNearbyCellsOf(player, grid_object_update, world_object_update);
+
+        if (preloadGrids)
+            PreloadGridsAhead(player);
     }
 
     // non-player active objects, increasing iterator in the loop in case of object removal
@@ -1508,6 +1607,7 @@ bool Map::UnloadGrid(NGridType& ngrid, bool unloadAll)
             }
             VMAP::VMapFactory::createOrGetVMapManager()->unloadMap(GetId(), gx, gy);
             MMAP::MMapFactory::createOrGetMMapManager()->unloadMap(GetId(), gx, gy);
+            MapQueryCache::Invalidate(GetId());
         }
         else
             ((MapInstanced*)m_parentMap)->RemoveGridMapReference(GridCoord(gx, gy));
@@ -1606,7 +1706,8 @@ bool GridMap::loadData(const char* filename)
         return false;
     }
 
-    if (header.mapMagic.asUInt == MapMagic.asUInt && header.versionMagic.asUInt == MapVersionMagic.asUInt)
+    if (header.mapMagic.asUInt == MapMagic.asUInt &&
+        (header.versionMagic.asUInt == MapVersionMagic.asUInt || header.versionMagic.asUInt == MapVersionMagicUncompressed.asUInt))
     {
         // load up area data
         if (header.areaMapOffset && !loadAreaData(in, header.areaMapOffset, header.areaMapSize))
@@ -1656,7 +1757,60 @@ void GridMap::unloadData()
     _gridGetHeight = &GridMap::getHeightFromFlat;
 }
 
-bool GridMap::loadAreaData(FILE* in, uint32 offset, uint32 /*size*/)
+// Reads the data following a map file section header, compressed sections are inflated as a whole first
+class MapSectionReader
+{
+    public:
+        explicit MapSectionReader(FILE* in) : _in(in), _compressed(false), _pos(0) { }
+
+        // called right after reading the section header
+        bool Inflate(uint32 sectionSize, uint32 headerSize)
+        {
+            uint32 size;
+            if (sectionSize <= headerSize + sizeof(size) || fread(&size, sizeof(size), 1, _in) != 1)
+                return false;
+
+            std::vector<uint8> packed(sectionSize - headerSize - sizeof(size));
+            if (fread(packed.data(), 1, packed.size(), _in) != packed.size())
+                return false;
+
+            _data.resize(size);
+            uLongf inflatedSize = size;
+            if (uncompress(_data.data(), &inflatedSize, packed.data(), uLong(packed.size())) != Z_OK || inflatedSize != size)
+                return false;
+
+            _compressed = true;
+            return true;
+        }
+
+        bool Read(void* dest, uint32 size)
+        {
+            if (!_compressed)
+                return fread(dest, 1, size, _in) == size;
+
+            if (_pos + size > _data.size())
+                return false;
+
+            memcpy(dest, &_data[_pos], size);
+            _pos += size;
+            return true;
+        }
+
+    private:
+        FILE* _in;
+        bool _compressed;
+        std::vector<uint8> _data;
+        uint32 _pos;
+};
+
+template<class T>
+static void DecodeHeightDeltas(T* heights, uint32 count)
+{
+    for (uint32 i = 1; i < count; ++i)
+        heights[i] = T(heights[i] + heights[i - 1]);
+}
+
+bool GridMap::loadAreaData(FILE* in, uint32 offset, uint32 size)
 {
     map_areaHeader header;
     fseek(in, offset, SEEK_SET);
@@ -1664,17 +1818,21 @@ bool GridMap::loadAreaData(FILE* in, uint32 offset, uint32 /*size*/)
     if (fread(&header, sizeof(header), 1, in) != 1 || header.fourcc != MapAreaMagic.asUInt)
         return false;
 
+    MapSectionReader reader(in);
+    if ((header.flags & MAP_AREA_COMPRESSED) && !reader.Inflate(size, sizeof(header)))
+        return false;
+
     _gridArea = header.gridArea;
     if (!(header.flags & MAP_AREA_NO_AREA))
     {
         _areaMap = new uint16 [16*16];
-        if (fread(_areaMap, sizeof(uint16), 16*16, in) != 16*16)
+        if (!reader.Read(_areaMap, sizeof(uint16) * 16*16))
             return false;
     }
     return true;
 }
 
-bool GridMap::loadHeightData(FILE* in, uint32 offset, uint32 /*size*/)
+bool GridMap::loadHeightData(FILE* in, uint32 offset, uint32 size)
 {
     map_heightHeader header;
     fseek(in, offset, SEEK_SET);
@@ -1682,6 +1840,10 @@ bool GridMap::loadHeightData(FILE* in, uint32 offset, uint32 /*size*/)
     if (fread(&header, sizeof(header), 1, in) != 1 || header.fourcc != MapHeightMagic.asUInt)
         return false;
 
+    MapSectionReader reader(in);
+    if ((header.flags & MAP_HEIGHT_COMPRESSED) && !reader.Inflate(size, sizeof(header)))
+        return false;
+
     _gridHeight = header.gridHeight;
     if (!(header.flags & MAP_HEIGHT_NO_HEIGHT))
     {
@@ -1689,9 +1851,14 @@ bool GridMap::loadHeightData(FILE* in, uint32 offset, uint32 /*size*/)
         {
             m_uint16_V9 = new uint16 [129*129];
             m_uint16_V8 = new uint16 [128*128];
-            if (fread(m_uint16_V9, sizeof(uint16), 129*129, in) != 129*129 ||
-                fread(m_uint16_V8, sizeof(uint16), 128*128, in) != 128*128)
+            if (!reader.Read(m_uint16_V9, sizeof(uint16) * 129*129) ||
+                !reader.Read(m_uint16_V8, sizeof(uint16) * 128*128))
                 return false;
+            if (header.flags & MAP_HEIGHT_DELTA)
+            {
+                DecodeHeightDeltas(m_uint16_V9, 129*129);
+                DecodeHeightDeltas(m_uint16_V8, 128*128);
+            }
             _gridIntHeightMultiplier = (header.gridMaxHeight - header.gridHeight) / 65535;
             _gridGetHeight = &GridMap::getHeightFromUint16;
         }
@@ -1699,9 +1866,14 @@ bool GridMap::loadHeightData(FILE* in, uint32 offset, uint32 /*size*/)
         {
             m_uint8_V9 = new uint8 [129*129];
             m_uint8_V8 = new uint8 [128*128];
-            if (fread(m_uint8_V9, sizeof(uint8), 129*129, in) != 129*129 ||
-                fread(m_uint8_V8, sizeof(uint8), 128*128, in) != 128*128)
+            if (!reader.Read(m_uint8_V9, sizeof(uint8) * 129*129) ||
+                !reader.Read(m_uint8_V8, sizeof(uint8) * 128*128))
                 return false;
+            if (header.flags & MAP_HEIGHT_DELTA)
+            {
+                DecodeHeightDeltas(m_uint8_V9, 129*129);
+                DecodeHeightDeltas(m_uint8_V8, 128*128);
+            }
             _gridIntHeightMultiplier = (header.gridMaxHeight - header.gridHeight) / 255;
             _gridGetHeight = &GridMap::getHeightFromUint8;
         }
@@ -1709,8 +1881,8 @@ bool GridMap::loadHeightData(FILE* in, uint32 offset, uint32 /*size*/)
         {
             m_V9 = new float [129*129];
             m_V8 = new float [128*128];
-            if (fread(m_V9, sizeof(float), 129*129, in) != 129*129 ||
-                fread(m_V8, sizeof(float), 128*128, in) != 128*128)
+            if (!reader.Read(m_V9, sizeof(float) * 129*129) ||
+                !reader.Read(m_V8, sizeof(float) * 128*128))
                 return false;
             _gridGetHeight = &GridMap::getHeightFromFloat;
         }
@@ -1720,7 +1892,7 @@ bool GridMap::loadHeightData(FILE* in, uint32 offset, uint32 /*size*/)
     return true;
 }
 
-bool GridMap::loadLiquidData(FILE* in, uint32 offset, uint32 /*size*/)
+bool GridMap::loadLiquidData(FILE* in, uint32 offset, uint32 size)
 {
     map_liquidHeader header;
     fseek(in, offset, SEEK_SET);
@@ -1728,6 +1900,10 @@ bool GridMap::loadLiquidData(FILE* in, uint32 offset, uint32 /*size*/)
     if (fread(&header, sizeof(header), 1, in) != 1 || header.fourcc != MapLiquidMagic.asUInt)
         return false;
 
+    MapSectionReader reader(in);
+    if ((header.flags & MAP_LIQUID_COMPRESSED) && !reader.Inflate(size, sizeof(header)))
+        return false;
+
     _liquidType   = header.liquidType;
     _liquidOffX  = header.offsetX;
     _liquidOffY  = header.offsetY;
@@ -1738,17 +1914,34 @@ bool GridMap::loadLiquidData(FILE* in, uint32 offset, uint32 /*size*/)
     if (!(header.flags & MAP_LIQUID_NO_TYPE))
     {
         _liquidEntry = new uint16[16*16];
-        if (fread(_liquidEntry, sizeof(uint16), 16*16, in) != 16*16)
+        if (!reader.Read(_liquidEntry, sizeof(uint16) * 16*16))
             return false;
 
         _liquidFlags = new uint8[16*16];
-        if (fread(_liquidFlags, sizeof(uint8), 16*16, in) != 16*16)
+        if (!reader.Read(_liquidFlags, sizeof(uint8) * 16*16))
             return false;
     }
-    if (!(header.flags & MAP_LIQUID_NO_HEIGHT))
+    if (header.flags & MAP_LIQUID_AS_INT16)
+    {
+        float minHeight, maxHeight;
+        if (!reader.Read(&minHeight, sizeof(minHeight)) || !reader.Read(&maxHeight, sizeof(maxHeight)))
+            return false;
+
+        // expanded at load, lookups stay as cheap as for float heights
+        uint32 count = uint32(_liquidWidth) * uint32(_liquidHeight);
+        std::vector<uint16> heights(count);
+        if (!reader.Read(heights.data(), sizeof(uint16) * count))
+            return false;
+
+        float multiplier = (maxHeight - minHeight) / 65535;
+        _liquidMap = new float[count];
+        for (uint32 i = 0; i < count; ++i)
+            _liquidMap[i] = minHeight + heights[i] * multiplier;
+    }
+    else if (!(header.flags & MAP_LIQUID_NO_HEIGHT))
     {
         _liquidMap = new float[uint32(_liquidWidth) * uint32(_liquidHeight)];
-        if (fread(_liquidMap, sizeof(float), _liquidWidth*_liquidHeight, in) != (uint32(_liquidWidth) * uint32(_liquidHeight)))
+        if (!reader.Read(_liquidMap, sizeof(float) * _liquidWidth*_liquidHeight))
             return false;
     }
     return true;
@@ -2162,7 +2355,7 @@ float Map::GetHeight(float x, float y, float z, bool checkVMap /*= true*/, float
     {
         VMAP::IVMapManager* vmgr = VMAP::VMapFactory::createOrGetVMapManager();
         if (vmgr->isHeightCalcEnabled())
-            vmapHeight = vmgr->getHeight(GetId(), x, y, z + 2.0f, maxSearchDist);   // look from a bit higher pos to find the floor
+            vmapHeight = GetVMapHeight(x, y, z + 2.0f, maxSearchDist);             // look from a bit higher pos to find the floor
     }
 
     // mapHeight set for any above raw ground Z or <= INVALID_HEIGHT
@@ -2242,8 +2435,7 @@ bool Map::IsOutdoors(float x, float y, float z) const
 bool Map::GetAreaInfo(float x, float y, float z, uint32 &flags, int32 &adtId, int32 &rootId, int32 &groupId) const
 {
     float vmap_z = z;
-    VMAP::IVMapManager* vmgr = VMAP::VMapFactory::createOrGetVMapManager();
-    if (vmgr->getAreaInfo(GetId(), x, y, vmap_z, flags, adtId, rootId, groupId))
+    if (GetVMapAreaInfo(x, y, vmap_z, flags, adtId, rootId, groupId))
     {
         // check if there's terrain between player height and object height
         if (GridMap* gmap = const_cast<Map*>(this)->GetGrid(x, y))
@@ -2308,11 +2500,10 @@ uint8 Map::GetTerrainType(float x, float y) const
 ZLiquidStatus Map::getLiquidStatus(float x, float y, float z, uint8 ReqLiquidType, LiquidData* data) const
 {
     ZLiquidStatus result = LIQUID_MAP_NO_WATER;
-    VMAP::IVMapManager* vmgr = VMAP::VMapFactory::createOrGetVMapManager();
     float liquid_level = INVALID_HEIGHT;
     float ground_level = INVALID_HEIGHT;
     uint32 liquid_type = 0;
-    if (vmgr->GetLiquidLevel(GetId(), x, y, z, ReqLiquidType, liquid_level, ground_level, liquid_type))
+    if (GetVMapLiquidLevel(x, y, z, ReqLiquidType, liquid_level, ground_level, liquid_type))
     {
         TC_LOG_DEBUG("maps", "getLiquidStatus(): vmap liquid level: %f ground: %f type: %u", liquid_level, ground_level, liquid_type);
         // Check water level and ground level
@@ -2428,10 +2619,121 @@ void Map::GetZoneAndAreaIdByAreaFlag(uint32& zoneid, uint32& areaid, uint16 area
 
 bool Map::isInLineOfSight(float x1, float y1, float z1, float x2, float y2, float z2, uint32 phasemask) const
 {
-    return VMAP::VMapFactory::createOrGetVMapManager()->isInLineOfSight(GetId(), x1, y1, z1, x2, y2, z2)
+    return IsInVMapLineOfSight(x1, y1, z1, x2, y2, z2)
         && _dynamicTree.isInLineOfSight(x1, y1, z1, x2, y2, z2, phasemask);
 }
 
+bool Map::UseQueryCache(MapQueryType type, float minX, float minY, float maxX, float maxY) const
+{
+    // exact positions matter around doors and elevators, query those uncached
+    if (_queryCache.HasModelsInArea(minX, minY, maxX, maxY))
+    {
+        MapQueryCache::CountBypass(type);
+        return false;
+    }
+
+    return true;
+}
+
+float Map::GetVMapHeight(float x, float y, float z, float maxSearchDist) const
+{
+    VMAP::IVMapManager* vmgr = VMAP::VMapFactory::createOrGetVMapManager();
+    if (!UseQueryCache(MAP_QUERY_HEIGHT, x, y, x, y))
+        return vmgr->getHeight(GetId(), x, y, z, maxSearchDist);
+
+    uint32 searchDist;
+    memcpy(&searchDist, &maxSearchDist, sizeof(searchDist));
+    MapQueryCacheKey key(x, y, z, searchDist);
+
+    float height;
+    if (!_queryCache.FindHeight(key, height))
+    {
+        height = vmgr->getHeight(GetId(), x, y, z, maxSearchDist);
+        _queryCache.StoreHeight(key, height);
+    }
+
+    return height;
+}
+
+bool Map::GetVMapAreaInfo(float x, float y, float& z, uint32& flags, int32& adtId, int32& rootId, int32& groupId) const
+{
+    VMAP::IVMapManager* vmgr = VMAP::VMapFactory::createOrGetVMapManager();
+    if (!UseQueryCache(MAP_QUERY_AREA_INFO, x, y, x, y))
+        return vmgr->getAreaInfo(GetId(), x, y, z, flags, adtId, rootId, groupId);
+
+    MapQueryCacheKey key(x, y, z, 0);
+    MapAreaInfoResult result;
+    if (!_queryCache.FindAreaInfo(key, result))
+    {
+        result.Z = z;
+        result.Found = vmgr->getAreaInfo(GetId(), x, y, result.Z, result.Flags, result.AdtId, result.RootId, result.GroupId);
+        _queryCache.StoreAreaInfo(key, result);
+    }
+
+    if (!result.Found)
+        return false;
+
+    z = result.Z;
+    flags = result.Flags;
+    adtId = result.AdtId;
+    rootId = result.RootId;
+    groupId = result.GroupId;
+    return true;
+}
+
+bool Map::GetVMapLiquidLevel(float x, float y, float z, uint8 reqLiquidType, float& level, float& floor, uint32& type) const
+{
+    VMAP::IVMapManager* vmgr = VMAP::VMapFactory::createOrGetVMapManager();
+    if (!UseQueryCache(MAP_QUERY_LIQUID, x, y, x, y))
+        return vmgr->GetLiquidLevel(GetId(), x, y, z, reqLiquidType, level, floor, type);
+
+    MapQueryCacheKey key(x, y, z, reqLiquidType);
+    MapLiquidResult result;
+    if (!_queryCache.FindLiquid(key, result))
+    {
+        result.Level = level;
+        result.Floor = floor;
+        result.Type = type;
+        result.Found = vmgr->GetLiquidLevel(GetId(), x, y, z, reqLiquidType, result.Level, result.Floor, result.Type);
+        _queryCache.StoreLiquid(key, result);
+    }
+
+    // the outputs are partially set even if no liquid was found
+    level = result.Level;
+    floor = result.Floor;
+    type = result.Type;
+    return result.Found;
+}
+
+bool Map::IsInVMapLineOfSight(float x1, float y1, float z1, float x2, float y2, float z2) const
+{
+    VMAP::IVMapManager* vmgr = VMAP::VMapFactory::createOrGetVMapManager();
+    if (!UseQueryCache(MAP_QUERY_LINE_OF_SIGHT, std::min(x1, x2), std::min(y1, y2), std::max(x1, x2), std::max(y1, y2)))
+        return vmgr->isInLineOfSight(GetId(), x1, y1, z1, x2, y2, z2);
+
+    MapQueryCacheKey key(x1, y1, z1, x2, y2, z2);
+    bool inLineOfSight;
+    if (!_queryCache.FindLineOfSight(key, inLineOfSight))
+    {
+        inLineOfSight = vmgr->isInLineOfSight(GetId(), x1, y1, z1, x2, y2, z2);
+        _queryCache.StoreLineOfSight(key, inLineOfSight);
+    }
+
+    return inLineOfSight;
+}
+
+void Map::isInLineOfSight(VMAP::LineOfSightRay* rays, uint32 count) const
+{
+    VMAP::VMapFactory::createOrGetVMapManager()->isInLineOfSight(GetId(), rays, count);
+
+    for (uint32 i = 0; i < count; ++i)
+    {
+        VMAP::LineOfSightRay& ray = rays[i];
+        if (ray.inLineOfSight)
+            ray.inLineOfSight = _dynamicTree.isInLineOfSight(ray.x1, ray.y1, ray.z1, ray.x2, ray.y2, ray.z2, ray.phaseMask);
+    }
+}
+
 bool Map::getObjectHitPos(uint32 phasemask, float x1, float y1, float z1, float x2, float y2, float z2, float& rx, float& ry, float& rz, float modifyDist)
 {
     G3D::Vector3 startPos(x1, y1, z1);
@@ -2448,7 +2750,13 @@ bool Map::getObjectHitPos(uint32 phasemask, float x1, float y1, float z1, float
 
 float Map::GetHeight(uint32 phasemask, float x, float y, float z, bool vmap/*=true*/, float maxSearchDist/*=DEFAULT_HEIGHT_SEARCH*/) const
 {
-    return std::max<float>(GetHeight(x, y, z, vmap, maxSearchDist), _dynamicTree.getHeight(x, y, z, maxSearchDist, phasemask));
+    float staticHeight = GetHeight(x, y, z, vmap, maxSearchDist);
+
+    // no gameobject model around, nothing for the dynamic tree to find
+    if (!_queryCache.HasModelsInArea(x, y, x, y))
+        return staticHeight;
+
+    return std::max<float>(staticHeight, _dynamicTree.getHeight(x, y, z, maxSearchDist, phasemask));
 }
 
 bool Map::IsInWater(float x, float y, float pZ, LiquidData* data) const
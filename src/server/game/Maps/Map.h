@@ -30,6 +30,7 @@
 #include "MapRefManager.h"
 #include "DynamicTree.h"
 #include "GameObjectModel.h"
+#include "MapQueryCache.h"
 #include "ObjectGuid.h"
 
 #include <bitset>
@@ -54,6 +55,7 @@ class BattlegroundMap;
 class InstanceMap;
 class Transport;
 namespace Trinity { struct ObjectUpdater; }
+namespace VMAP { struct LineOfSightRay; }
 
 struct ScriptAction
 {
@@ -73,6 +75,8 @@ union u_map_magic
 // ******************************************
 // Map file format defines
 // ******************************************
+// Since v1.4 the data following a section header may be zlib compressed (*_COMPRESSED flags):
+// the uncompressed size of the data as uint32, then the zlib stream up to the end of the section
 struct map_fileheader
 {
     u_map_magic mapMagic;
@@ -89,6 +93,7 @@ struct map_fileheader
 };
 
 #define MAP_AREA_NO_AREA      0x0001
+#define MAP_AREA_COMPRESSED   0x0002
 
 struct map_areaHeader
 {
@@ -100,6 +105,8 @@ struct map_areaHeader
 #define MAP_HEIGHT_NO_HEIGHT  0x0001
 #define MAP_HEIGHT_AS_INT16   0x0002
 #define MAP_HEIGHT_AS_INT8    0x0004
+#define MAP_HEIGHT_DELTA      0x0008                        // integer heights stored as difference to the previous one
+#define MAP_HEIGHT_COMPRESSED 0x0010
 
 struct map_heightHeader
 {
@@ -111,6 +118,8 @@ struct map_heightHeader
 
 #define MAP_LIQUID_NO_TYPE    0x0001
 #define MAP_LIQUID_NO_HEIGHT  0x0002
+#define MAP_LIQUID_AS_INT16   0x0004                        // heights stored as uint16 after their float min and max
+#define MAP_LIQUID_COMPRESSED 0x0008
 
 struct map_liquidHeader
 {
@@ -257,6 +266,16 @@ typedef std::map<uint32/*leaderDBGUID*/, CreatureGroup*>        CreatureGroupHol
 
 typedef std::unordered_map<uint32 /*zoneId*/, ZoneDynamicInfo> ZoneDynamicInfoMap;
 
+// Unit::ProcDamageAndSpellFor counters, collected per map update
+struct MapProcStats
+{
+    MapProcStats() : Passes(0), CandidateAuras(0), SkippedAuras(0) { }
+
+    uint32 Passes;                                          // calls of Unit::ProcDamageAndSpellFor
+    uint32 CandidateAuras;                                  // auras checked against the proc event
+    uint32 SkippedAuras;                                    // applied auras skipped through the proc aura index
+};
+
 class Map : public GridRefManager<NGridType>
 {
     friend class MapReference;
@@ -469,9 +488,12 @@ class Map : public GridRefManager<NGridType>
         float GetWaterOrGroundLevel(float x, float y, float z, float* ground = NULL, bool swim = false) const;
         float GetHeight(uint32 phasemask, float x, float y, float z, bool vmap = true, float maxSearchDist = DEFAULT_HEIGHT_SEARCH) const;
         bool isInLineOfSight(float x1, float y1, float z1, float x2, float y2, float z2, uint32 phasemask) const;
+        // checks many rays at once, static geometry is traced in ray packets
+        void isInLineOfSight(VMAP::LineOfSightRay* rays, uint32 count) const;
         void Balance() { _dynamicTree.balance(); }
-        void RemoveGameObjectModel(const GameObjectModel& model) { _dynamicTree.remove(model); }
-        void InsertGameObjectModel(const GameObjectModel& model) { _dynamicTree.insert(model); }
+        void RemoveGameObjectModel(const GameObjectModel& model) { _dynamicTree.remove(model); _queryCache.RemoveModel(model); }
+        void InsertGameObjectModel(const GameObjectModel& model) { _dynamicTree.insert(model); _queryCache.AddModel(model); }
+        void RelocateGameObjectModel(const GameObjectModel& model) { _dynamicTree.relocate(model); _queryCache.RemoveModel(model); _queryCache.AddModel(model); }
         bool ContainsGameObjectModel(const GameObjectModel& model) const { return _dynamicTree.contains(model);}
         bool getObjectHitPos(uint32 phasemask, float x1, float y1, float z1, float x2, float y2, float z2, float& rx, float &ry, float& rz, float modifyDist);
 
@@ -516,6 +538,15 @@ class Map : public GridRefManager<NGridType>
 
         void UpdateAreaDependentAuras();
 
+        // counters of the running update, only for the thread updating the map
+        MapProcStats& GetProcStats() { return _procStats; }
+        // copy of the counters of the last finished update, safe from any thread
+        MapProcStats GetLastUpdateProcStats() const
+        {
+            std::lock_guard<std::mutex> lock(_procStatsLock);
+            return _lastUpdateProcStats;
+        }
+
     private:
         void LoadMapAndVMap(int gx, int gy);
         void LoadVMap(int gx, int gy);
@@ -523,6 +554,17 @@ class Map : public GridRefManager<NGridType>
         void LoadMMap(int gx, int gy);
         GridMap* GetGrid(float x, float y);
 
+        // requests the terrain of the grids the player is heading to from the grid preloader
+        void PreloadGridsAhead(Player* player);
+        void PreloadGrid(float x, float y);
+
+        // static vmap queries, answered from _queryCache unless gameobject models are close
+        bool UseQueryCache(MapQueryType type, float minX, float minY, float maxX, float maxY) const;
+        float GetVMapHeight(float x, float y, float z, float maxSearchDist) const;
+        bool GetVMapAreaInfo(float x, float y, float& z, uint32& flags, int32& adtId, int32& rootId, int32& groupId) const;
+        bool GetVMapLiquidLevel(float x, float y, float z, uint8 reqLiquidType, float& level, float& floor, uint32& type) const;
+        bool IsInVMapLineOfSight(float x1, float y1, float z1, float x2, float y2, float z2) const;
+
         void SetTimer(uint32 t) { i_gridExpiry = t < MIN_GRID_DELAY ? MIN_GRID_DELAY : t; }
 
         void SendInitSelf(Player* player);
@@ -582,6 +624,7 @@ class Map : public GridRefManager<NGridType>
         uint32 m_unloadTimer;
         float m_VisibleDistance;
         DynamicMapTree _dynamicTree;
+        mutable MapQueryCache _queryCache;
 
         MapRefManager m_mapRefManager;
         MapRefManager::iterator m_mapRefIter;
@@ -662,6 +705,12 @@ class Map : public GridRefManager<NGridType>
 
         ZoneDynamicInfoMap _zoneDynamicInfo;
         uint32 _defaultLight;
+
+        MapProcStats _procStats;
+        MapProcStats _lastUpdateProcStats;
+        mutable std::mutex _procStatsLock;
+
+        TimeTrackerSmall _gridPreloadTimer;
 };
 
 enum InstanceResetMethod
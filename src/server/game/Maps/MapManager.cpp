@@ -36,6 +36,9 @@
 #include "WorldSession.h"
 #include "Opcodes.h"
 #include "AchievementMgr.h"
+#include "GridPreloader.h"
+#include "PathfindingService.h"
+#include "UpdateProfiler.h"
 
 MapManager::MapManager()
 {
@@ -54,6 +57,14 @@ void MapManager::Initialize()
     // Start mtmaps if needed.
     if (num_threads > 0)
         m_updater.activate(num_threads);
+
+    uint32 pathfindingThreads = sWorld->getIntConfig(CONFIG_PATHFINDING_THREADS);
+    if (pathfindingThreads > 0 && sWorld->getBoolConfig(CONFIG_ENABLE_MMAPS))
+        sPathfindingService->Activate(pathfindingThreads);
+
+    uint32 gridPreloadThreads = sWorld->getIntConfig(CONFIG_GRID_PRELOAD_THREADS);
+    if (gridPreloadThreads > 0)
+        sGridPreloader->Activate(gridPreloadThreads, sWorld->getIntConfig(CONFIG_GRID_PRELOAD_LOOKAHEAD));
 }
 
 void MapManager::InitializeVisibilityDistanceInfo()
@@ -242,7 +253,11 @@ void MapManager::Update(uint32 diff)
         if (m_updater.activated())
             m_updater.schedule_update(*iter->second, uint32(i_timer.GetCurrent()));
         else
+        {
+            uint64 start = sUpdateProfiler->Start();
             iter->second->Update(uint32(i_timer.GetCurrent()));
+            sUpdateProfiler->RecordMap(iter->second->GetId(), start);
+        }
     }
     if (m_updater.activated())
         m_updater.wait();
@@ -252,6 +267,9 @@ void MapManager::Update(uint32 diff)
 
     sObjectAccessor->Update(uint32(i_timer.GetCurrent()));
 
+    if (sGridPreloader->IsActive())
+        sGridPreloader->Update(uint32(i_timer.GetCurrent()));
+
     i_timer.SetCurrent(0);
 }
 
@@ -281,6 +299,10 @@ bool MapManager::IsValidMAP(uint32 mapid, bool startUp)
 
 void MapManager::UnloadAll()
 {
+    // workers may still search the navmeshes of the maps
+    sPathfindingService->Deactivate();
+    sGridPreloader->Deactivate();
+
     for (MapMapType::iterator iter = i_maps.begin(); iter != i_maps.end();)
     {
         iter->second->UnloadAll();
@@ -0,0 +1,236 @@
+/*
+ * Copyright (C) 2008-2015 TrinityCore <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MapQueryCache.h"
+#include "GameObjectModel.h"
+#include "GridDefines.h"
+#include <algorithm>
+#include <cmath>
+
+std::atomic<uint32> MapQueryCache::_generations[MAP_QUERY_CACHE_GENERATIONS];
+std::atomic<uint64> MapQueryCache::_hits[MAX_MAP_QUERY_TYPES];
+std::atomic<uint64> MapQueryCache::_misses[MAX_MAP_QUERY_TYPES];
+std::atomic<uint64> MapQueryCache::_bypasses[MAX_MAP_QUERY_TYPES];
+std::atomic<uint64> MapQueryCache::_invalidations;
+
+static inline int32 QuantizeQueryPosition(float pos)
+{
+    return int32(std::floor(pos * (1.0f / MAP_QUERY_CACHE_STEP)));
+}
+
+MapQueryCacheKey::MapQueryCacheKey(float x, float y, float z, uint32 extra) :
+    X1(QuantizeQueryPosition(x)), Y1(QuantizeQueryPosition(y)), Z1(QuantizeQueryPosition(z)), X2(0), Y2(0), Z2(0), Extra(extra)
+{
+}
+
+MapQueryCacheKey::MapQueryCacheKey(float x1, float y1, float z1, float x2, float y2, float z2) :
+    X1(QuantizeQueryPosition(x1)), Y1(QuantizeQueryPosition(y1)), Z1(QuantizeQueryPosition(z1)),
+    X2(QuantizeQueryPosition(x2)), Y2(QuantizeQueryPosition(y2)), Z2(QuantizeQueryPosition(z2)), Extra(0)
+{
+}
+
+bool MapQueryCacheKey::operator==(MapQueryCacheKey const& right) const
+{
+    return X1 == right.X1 && Y1 == right.Y1 && Z1 == right.Z1 &&
+        X2 == right.X2 && Y2 == right.Y2 && Z2 == right.Z2 && Extra == right.Extra;
+}
+
+uint32 MapQueryCacheKey::GetHash() const
+{
+    // FNV-1a over the cell coordinates
+    int32 const values[7] = { X1, Y1, Z1, X2, Y2, Z2, int32(Extra) };
+    uint32 hash = 2166136261u;
+    for (int32 value : values)
+    {
+        hash ^= uint32(value);
+        hash *= 16777619u;
+    }
+
+    return hash ^ (hash >> 15);
+}
+
+MapQueryCache::MapQueryCache(uint32 mapId) : _mapId(mapId)
+{
+    _generation = _generations[_mapId % MAP_QUERY_CACHE_GENERATIONS].load(std::memory_order_acquire);
+}
+
+void MapQueryCache::CheckGeneration()
+{
+    uint32 generation = _generations[_mapId % MAP_QUERY_CACHE_GENERATIONS].load(std::memory_order_acquire);
+    if (generation == _generation)
+        return;
+
+    _generation = generation;
+    _heights.Clear();
+    _areaInfos.Clear();
+    _liquids.Clear();
+    _lineOfSights.Clear();
+    _invalidations.fetch_add(1, std::memory_order_relaxed);
+}
+
+template<class T>
+bool MapQueryCache::Find(Table<T> const& table, MapQueryType type, MapQueryCacheKey const& key, T& value)
+{
+    CheckGeneration();
+
+    if (table.Find(key, value))
+    {
+        _hits[type].fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    _misses[type].fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+bool MapQueryCache::FindHeight(MapQueryCacheKey const& key, float& height)
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    return Find(_heights, MAP_QUERY_HEIGHT, key, height);
+}
+
+void MapQueryCache::StoreHeight(MapQueryCacheKey const& key, float height)
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    _heights.Store(key, height);
+}
+
+bool MapQueryCache::FindAreaInfo(MapQueryCacheKey const& key, MapAreaInfoResult& result)
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    return Find(_areaInfos, MAP_QUERY_AREA_INFO, key, result);
+}
+
+void MapQueryCache::StoreAreaInfo(MapQueryCacheKey const& key, MapAreaInfoResult const& result)
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    _areaInfos.Store(key, result);
+}
+
+bool MapQueryCache::FindLiquid(MapQueryCacheKey const& key, MapLiquidResult& result)
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    return Find(_liquids, MAP_QUERY_LIQUID, key, result);
+}
+
+void MapQueryCache::StoreLiquid(MapQueryCacheKey const& key, MapLiquidResult const& result)
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    _liquids.Store(key, result);
+}
+
+bool MapQueryCache::FindLineOfSight(MapQueryCacheKey const& key, bool& inLineOfSight)
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    return Find(_lineOfSights, MAP_QUERY_LINE_OF_SIGHT, key, inLineOfSight);
+}
+
+void MapQueryCache::StoreLineOfSight(MapQueryCacheKey const& key, bool inLineOfSight)
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    _lineOfSights.Store(key, inLineOfSight);
+}
+
+int32 MapQueryCache::GetModelCell(float pos)
+{
+    // shifted to stay positive, clamped so broken model bounds can't blow up the coverage
+    pos = std::max(-MAP_HALFSIZE, std::min(MAP_HALFSIZE, pos));
+    return int32(std::floor(pos * (1.0f / MAP_QUERY_CACHE_MODEL_CELL))) + 0x4000;
+}
+
+void MapQueryCache::AddModel(GameObjectModel const& model)
+{
+    G3D::AABox const& bounds = model.getBounds();
+
+    ModelCoverage coverage;
+    coverage.MinX = GetModelCell(bounds.low().x);
+    coverage.MinY = GetModelCell(bounds.low().y);
+    coverage.MaxX = GetModelCell(bounds.high().x);
+    coverage.MaxY = GetModelCell(bounds.high().y);
+
+    std::lock_guard<std::mutex> lock(_lock);
+    if (!_models.insert(std::make_pair(&model, coverage)).second)
+        return;
+
+    for (int32 x = coverage.MinX; x <= coverage.MaxX; ++x)
+        for (int32 y = coverage.MinY; y <= coverage.MaxY; ++y)
+            ++_modelCells[GetModelCellKey(x, y)];
+}
+
+void MapQueryCache::RemoveModel(GameObjectModel const& model)
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    std::unordered_map<GameObjectModel const*, ModelCoverage>::iterator itr = _models.find(&model);
+    if (itr == _models.end())
+        return;
+
+    // the bounds may have changed since the model was added, use the stored cells
+    ModelCoverage const& coverage = itr->second;
+    for (int32 x = coverage.MinX; x <= coverage.MaxX; ++x)
+    {
+        for (int32 y = coverage.MinY; y <= coverage.MaxY; ++y)
+        {
+            std::unordered_map<uint32, uint32>::iterator cell = _modelCells.find(GetModelCellKey(x, y));
+            if (cell != _modelCells.end() && !--cell->second)
+                _modelCells.erase(cell);
+        }
+    }
+
+    _models.erase(itr);
+}
+
+bool MapQueryCache::HasModelsInArea(float minX, float minY, float maxX, float maxY)
+{
+    int32 cellMinX = GetModelCell(minX);
+    int32 cellMinY = GetModelCell(minY);
+    int32 cellMaxX = GetModelCell(maxX);
+    int32 cellMaxY = GetModelCell(maxY);
+
+    std::lock_guard<std::mutex> lock(_lock);
+    if (_modelCells.empty())
+        return false;
+
+    // not worth scanning, treat long rays as covered
+    if (cellMaxX - cellMinX > 8 || cellMaxY - cellMinY > 8)
+        return true;
+
+    for (int32 x = cellMinX; x <= cellMaxX; ++x)
+        for (int32 y = cellMinY; y <= cellMaxY; ++y)
+            if (_modelCells.count(GetModelCellKey(x, y)))
+                return true;
+
+    return false;
+}
+
+void MapQueryCache::Invalidate(uint32 mapId)
+{
+    _generations[mapId % MAP_QUERY_CACHE_GENERATIONS].fetch_add(1, std::memory_order_acq_rel);
+}
+
+MapQueryCacheStats MapQueryCache::GetStats()
+{
+    MapQueryCacheStats stats;
+    for (uint8 i = 0; i < MAX_MAP_QUERY_TYPES; ++i)
+    {
+        stats.Hits[i] = _hits[i].load(std::memory_order_relaxed);
+        stats.Misses[i] = _misses[i].load(std::memory_order_relaxed);
+        stats.Bypasses[i] = _bypasses[i].load(std::memory_order_relaxed);
+    }
+
+    stats.Invalidations = _invalidations.load(std::memory_order_relaxed);
+    return stats;
+}
@@ -0,0 +1,197 @@
+/*
+ * Copyright (C) 2008-2015 TrinityCore <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRINITY_MAPQUERYCACHE_H
+#define TRINITY_MAPQUERYCACHE_H
+
+#include "Define.h"
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+class GameObjectModel;
+
+#define MAP_QUERY_CACHE_SIZE        2048        // entries per query type and map, direct mapped
+#define MAP_QUERY_CACHE_STEP        0.25f       // yards, positions within the same step share their results
+#define MAP_QUERY_CACHE_MODEL_CELL  32.0f       // yards, granularity of the dynamic model coverage
+#define MAP_QUERY_CACHE_GENERATIONS 1024        // vmap tile generation slots, indexed by map id
+
+enum MapQueryType
+{
+    MAP_QUERY_HEIGHT            = 0,
+    MAP_QUERY_AREA_INFO         = 1,
+    MAP_QUERY_LIQUID            = 2,
+    MAP_QUERY_LINE_OF_SIGHT     = 3,
+    MAX_MAP_QUERY_TYPES
+};
+
+struct MapQueryCacheStats
+{
+    uint64 Hits[MAX_MAP_QUERY_TYPES];
+    uint64 Misses[MAX_MAP_QUERY_TYPES];
+    uint64 Bypasses[MAX_MAP_QUERY_TYPES];                   // queries near dynamic models, never cached
+    uint64 Invalidations;                                   // caches cleared after vmap tiles were loaded or unloaded
+};
+
+// quantized query position, the second cell is only used by line of sight queries
+struct MapQueryCacheKey
+{
+    MapQueryCacheKey(float x, float y, float z, uint32 extra);
+    MapQueryCacheKey(float x1, float y1, float z1, float x2, float y2, float z2);
+
+    bool operator==(MapQueryCacheKey const& right) const;
+    uint32 GetHash() const;
+
+    int32 X1, Y1, Z1;
+    int32 X2, Y2, Z2;
+    uint32 Extra;                                           // query parameters the result depends on
+};
+
+// VMapManager2::getAreaInfo result
+struct MapAreaInfoResult
+{
+    bool Found;
+    float Z;
+    uint32 Flags;
+    int32 AdtId;
+    int32 RootId;
+    int32 GroupId;
+};
+
+// VMapManager2::GetLiquidLevel result
+struct MapLiquidResult
+{
+    bool Found;
+    float Level;
+    float Floor;
+    uint32 Type;
+};
+
+// Results of static vmap queries of one map. Static geometry never changes while its tiles stay loaded,
+// so height, area, liquid and line of sight results are reused for queries from the same quantized position.
+// Areas covered by gameobject models (doors, elevators, transports) bypass the cache, see Map::UseQueryCache.
+class MapQueryCache
+{
+    public:
+        explicit MapQueryCache(uint32 mapId);
+
+        bool FindHeight(MapQueryCacheKey const& key, float& height);
+        void StoreHeight(MapQueryCacheKey const& key, float height);
+
+        bool FindAreaInfo(MapQueryCacheKey const& key, MapAreaInfoResult& result);
+        void StoreAreaInfo(MapQueryCacheKey const& key, MapAreaInfoResult const& result);
+
+        bool FindLiquid(MapQueryCacheKey const& key, MapLiquidResult& result);
+        void StoreLiquid(MapQueryCacheKey const& key, MapLiquidResult const& result);
+
+        bool FindLineOfSight(MapQueryCacheKey const& key, bool& inLineOfSight);
+        void StoreLineOfSight(MapQueryCacheKey const& key, bool inLineOfSight);
+
+        // dynamic model coverage, kept in sync with the DynamicMapTree of the map
+        void AddModel(GameObjectModel const& model);
+        void RemoveModel(GameObjectModel const& model);
+        bool HasModelsInArea(float minX, float minY, float maxX, float maxY);
+
+        static void CountBypass(MapQueryType type) { _bypasses[type].fetch_add(1, std::memory_order_relaxed); }
+
+        // call after loading or unloading vmap tiles of the map id, clears the caches of all its maps
+        static void Invalidate(uint32 mapId);
+
+        static MapQueryCacheStats GetStats();
+
+    private:
+        template<class T>
+        class Table
+        {
+            public:
+                bool Find(MapQueryCacheKey const& key, T& value) const
+                {
+                    if (_entries.empty())
+                        return false;
+
+                    Entry const& entry = _entries[key.GetHash() % MAP_QUERY_CACHE_SIZE];
+                    if (!entry.Used || !(entry.Key == key))
+                        return false;
+
+                    value = entry.Value;
+                    return true;
+                }
+
+                void Store(MapQueryCacheKey const& key, T const& value)
+                {
+                    // allocated on first use, most instances never query much
+                    if (_entries.empty())
+                        _entries.resize(MAP_QUERY_CACHE_SIZE);
+
+                    Entry& entry = _entries[key.GetHash() % MAP_QUERY_CACHE_SIZE];
+                    entry.Key = key;
+                    entry.Value = value;
+                    entry.Used = true;
+                }
+
+                void Clear()
+                {
+                    for (Entry& entry : _entries)
+                        entry.Used = false;
+                }
+
+            private:
+                struct Entry
+                {
+                    Entry() : Key(0.0f, 0.0f, 0.0f, 0), Value(), Used(false) { }
+
+                    MapQueryCacheKey Key;
+                    T Value;
+                    bool Used;
+                };
+
+                std::vector<Entry> _entries;
+        };
+
+        struct ModelCoverage
+        {
+            int32 MinX, MinY, MaxX, MaxY;
+        };
+
+        // clears the tables when vmap tiles changed since they were filled, _lock must be held
+        void CheckGeneration();
+        template<class T> bool Find(Table<T> const& table, MapQueryType type, MapQueryCacheKey const& key, T& value);
+
+        static int32 GetModelCell(float pos);
+        static uint32 GetModelCellKey(int32 x, int32 y) { return uint32(x) << 16 | uint32(y); }
+
+        uint32 _mapId;
+        uint32 _generation;
+        std::mutex _lock;
+
+        Table<float> _heights;
+        Table<MapAreaInfoResult> _areaInfos;
+        Table<MapLiquidResult> _liquids;
+        Table<bool> _lineOfSights;
+
+        std::unordered_map<uint32, uint32> _modelCells;     // models touching each coverage cell
+        std::unordered_map<GameObjectModel const*, ModelCoverage> _models;
+
+        static std::atomic<uint32> _generations[MAP_QUERY_CACHE_GENERATIONS];
+        static std::atomic<uint64> _hits[MAX_MAP_QUERY_TYPES];
+        static std::atomic<uint64> _misses[MAX_MAP_QUERY_TYPES];
+        static std::atomic<uint64> _bypasses[MAX_MAP_QUERY_TYPES];
+        static std::atomic<uint64> _invalidations;
+};
+
+#endif
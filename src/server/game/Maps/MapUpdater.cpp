@@ -21,6 +21,7 @@
 
 #include "MapUpdater.h"
 #include "Map.h"
+#include "UpdateProfiler.h"
 
 
 class MapUpdateRequest
@@ -40,7 +41,9 @@ class MapUpdateRequest
 
         void call()
         {
+            uint64 start = sUpdateProfiler->Start();
             m_map.Update (m_diff);
+            sUpdateProfiler->RecordMap(m_map.GetId(), start);
             m_updater.update_finished();
         }
 };
@@ -39,6 +39,10 @@ void TargetedMovementGeneratorMedium<T, D>::_setTargetLocation(T* owner, bool up
     if (owner->GetTypeId() == TYPEID_UNIT && !i_target->isInAccessiblePlaceFor(owner->ToCreature()))
         return;
 
+    // a path is already being searched, DoUpdate applies it
+    if (i_pathRequest)
+        return;
+
     float x, y, z;
 
     if (updateDestination || !i_path)
@@ -93,6 +97,23 @@ void TargetedMovementGeneratorMedium<T, D>::_setTargetLocation(T* owner, bool up
     bool forceDest = (owner->GetTypeId() == TYPEID_UNIT && owner->ToCreature()->IsPet()
         && owner->HasUnitState(UNIT_STATE_FOLLOW));
 
+    if (sPathfindingService->IsActive() && i_path->PrepareDetachedPath(x, y, z, forceDest))
+    {
+        // units chasing the same target are searched together
+        i_pathRequest = sPathfindingService->Submit(*i_path, i_target->GetGUID());
+        i_recalculateTravel = false;
+
+        // keep following the current path meanwhile, standing units head straight for the destination
+        if (owner->movespline->Finalized())
+        {
+            Movement::PointsArray path(2);
+            path[0] = G3D::Vector3(owner->GetPositionX(), owner->GetPositionY(), owner->GetPositionZ());
+            path[1] = G3D::Vector3(x, y, z);
+            _launchMovement(owner, path);
+        }
+        return;
+    }
+
     bool result = i_path->CalculatePath(x, y, z, forceDest);
     if (!result || (i_path->GetPathType() & PATHFIND_NOPATH))
     {
@@ -101,13 +122,57 @@ void TargetedMovementGeneratorMedium<T, D>::_setTargetLocation(T* owner, bool up
         return;
     }
 
+    _launchMovement(owner, i_path->GetPath());
+}
+
+template<class T, typename D>
+void TargetedMovementGeneratorMedium<T, D>::_applyPathRequest(T* owner)
+{
+    PathRequestState state = i_pathRequest->GetState();
+    PathGenerator* path = i_pathRequest->TakePath();
+    i_pathRequest.reset();
+
+    // we may have been teleported meanwhile
+    if (path->GetMapId() != owner->GetMapId())
+    {
+        delete path;
+        i_recalculateTravel = true;
+        return;
+    }
+
+    delete i_path;
+    i_path = path;
+
+    bool result = true;
+    if (state == PATH_REQUEST_DONE)
+        i_path->FinishDetachedPath();
+    else
+    {
+        // the search needed terrain data only the map thread has access to, or the service stopped before it
+        G3D::Vector3 const& end = i_path->GetEndPosition();
+        result = i_path->CalculatePath(end.x, end.y, end.z, i_path->IsForcedDestination());
+    }
+
+    if (!result || (i_path->GetPathType() & PATHFIND_NOPATH))
+    {
+        // Cant reach target
+        i_recalculateTravel = true;
+        return;
+    }
+
+    _launchMovement(owner, i_path->GetPath());
+}
+
+template<class T, typename D>
+void TargetedMovementGeneratorMedium<T, D>::_launchMovement(T* owner, Movement::PointsArray const& path)
+{
     D::_addUnitStateMove(owner);
     i_targetReached = false;
     i_recalculateTravel = false;
     owner->AddUnitState(UNIT_STATE_CHASE);
 
     Movement::MoveSplineInit init(owner);
-    init.MovebyPath(i_path->GetPath());
+    init.MovebyPath(path);
     init.SetWalk(((D*)this)->EnableWalking());
     // Using the same condition for facing target as the one that is used for SetInFront on movement end
     // - applies to ChaseMovementGenerator mostly
@@ -147,6 +212,9 @@ bool TargetedMovementGeneratorMedium<T, D>::DoUpdate(T* owner, uint32 time_diff)
         return true;
     }
 
+    if (i_pathRequest && !i_pathRequest->IsPending())
+        _applyPathRequest(owner);
+
     bool targetMoved = false;
     i_recheckDistance.Update(time_diff);
     if (i_recheckDistance.Passed())
@@ -312,6 +380,10 @@ template void TargetedMovementGeneratorMedium<Player, ChaseMovementGenerator<Pla
 template void TargetedMovementGeneratorMedium<Player, FollowMovementGenerator<Player> >::_setTargetLocation(Player*, bool);
 template void TargetedMovementGeneratorMedium<Creature, ChaseMovementGenerator<Creature> >::_setTargetLocation(Creature*, bool);
 template void TargetedMovementGeneratorMedium<Creature, FollowMovementGenerator<Creature> >::_setTargetLocation(Creature*, bool);
+template void TargetedMovementGeneratorMedium<Player, ChaseMovementGenerator<Player> >::_applyPathRequest(Player*);
+template void TargetedMovementGeneratorMedium<Player, FollowMovementGenerator<Player> >::_applyPathRequest(Player*);
+template void TargetedMovementGeneratorMedium<Creature, ChaseMovementGenerator<Creature> >::_applyPathRequest(Creature*);
+template void TargetedMovementGeneratorMedium<Creature, FollowMovementGenerator<Creature> >::_applyPathRequest(Creature*);
 template bool TargetedMovementGeneratorMedium<Player, ChaseMovementGenerator<Player> >::DoUpdate(Player*, uint32);
 template bool TargetedMovementGeneratorMedium<Player, FollowMovementGenerator<Player> >::DoUpdate(Player*, uint32);
 template bool TargetedMovementGeneratorMedium<Creature, ChaseMovementGenerator<Creature> >::DoUpdate(Creature*, uint32);
@@ -24,6 +24,7 @@
 #include "Timer.h"
 #include "Unit.h"
 #include "PathGenerator.h"
+#include "PathfindingService.h"
 
 class TargetedMovementGeneratorBase
 {
@@ -44,7 +45,13 @@ class TargetedMovementGeneratorMedium : public MovementGeneratorMedium< T, D >,
             i_recalculateTravel(false), i_targetReached(false)
         {
         }
-        ~TargetedMovementGeneratorMedium() { delete i_path; }
+        ~TargetedMovementGeneratorMedium()
+        {
+            if (i_pathRequest)
+                i_pathRequest->Cancel();
+
+            delete i_path;
+        }
 
     public:
         bool DoUpdate(T*, uint32);
@@ -54,8 +61,11 @@ class TargetedMovementGeneratorMedium : public MovementGeneratorMedium< T, D >,
         bool IsReachable() const { return (i_path) ? (i_path->GetPathType() & PATHFIND_NORMAL) : true; }
     protected:
         void _setTargetLocation(T* owner, bool updateDestination);
+        void _applyPathRequest(T* owner);
+        void _launchMovement(T* owner, Movement::PointsArray const& path);
 
         PathGenerator* i_path;
+        PathRequestPtr i_pathRequest;   // path being searched by sPathfindingService
         TimeTrackerSmall i_recheckDistance;
         float i_offset;
         float i_angle;
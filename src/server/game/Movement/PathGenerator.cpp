@@ -25,35 +25,99 @@
 #include "DisableMgr.h"
 #include "DetourCommon.h"
 #include "DetourNavMeshQuery.h"
+#include "DetourNode.h"
+#include <boost/thread/locks.hpp>
+#include <algorithm>
+#include <chrono>
 
 ////////////////// PathGenerator //////////////////
 PathGenerator::PathGenerator(const Unit* owner) :
     _polyLength(0), _type(PATHFIND_BLANK), _useStraightPath(false),
     _forceDestination(false), _pointPathLimit(MAX_POINT_PATH_LENGTH), _straightLine(false),
-    _endPosition(G3D::Vector3::zero()), _sourceUnit(owner), _navMesh(NULL),
-    _navMeshQuery(NULL)
+    _endPosition(G3D::Vector3::zero()), _sourceUnit(owner), _sourceMapId(owner->GetMapId()),
+    _sourceGuidLow(owner->GetGUIDLow()), _sourceCanFly(false), _sourceCanSwim(false), _detached(false),
+    _normalizePending(false), _actualEndOnPath(false), _sharedCorridor(NULL), _navMesh(NULL),
+    _navMeshQuery(NULL), _mmapData(NULL), _findPathCalls(0), _nodesExpanded(0)
 {
     memset(_pathPolyRefs, 0, sizeof(_pathPolyRefs));
 
-    TC_LOG_DEBUG("maps", "++ PathGenerator::PathGenerator for %u \n", _sourceUnit->GetGUIDLow());
+    TC_LOG_DEBUG("maps", "++ PathGenerator::PathGenerator for %u \n", _sourceGuidLow);
 
-    uint32 mapId = _sourceUnit->GetMapId();
-    if (DisableMgr::IsPathfindingEnabled(mapId))
-    {
-        MMAP::MMapManager* mmap = MMAP::MMapFactory::createOrGetMMapManager();
-        _navMesh = mmap->GetNavMesh(mapId);
-        _navMeshQuery = mmap->GetNavMeshQuery(mapId, _sourceUnit->GetInstanceId());
-    }
+    if (DisableMgr::IsPathfindingEnabled(_sourceMapId))
+        _navMesh = MMAP::MMapFactory::createOrGetMMapManager()->GetNavMesh(_sourceMapId);
 
     CreateFilter();
 }
 
 PathGenerator::~PathGenerator()
 {
-    TC_LOG_DEBUG("maps", "++ PathGenerator::~PathGenerator() for %u \n", _sourceUnit->GetGUIDLow());
+    TC_LOG_DEBUG("maps", "++ PathGenerator::~PathGenerator() for %u \n", _sourceGuidLow);
 }
 
 bool PathGenerator::CalculatePath(float destX, float destY, float destZ, bool forceDest, bool straightLine)
+{
+    if (!StartPath(destX, destY, destZ, forceDest, straightLine))
+        return false;
+
+    TC_LOG_DEBUG("maps", "++ PathGenerator::CalculatePath() for %u \n", _sourceGuidLow);
+
+    // make sure navMesh works - we can run on map w/o mmap
+    if (!_navMesh || _sourceUnit->HasUnitState(UNIT_STATE_IGNORE_PATHFINDING))
+    {
+        BuildShortcut();
+        _type = PathType(PATHFIND_NORMAL | PATHFIND_NOT_USING_PATH);
+        return true;
+    }
+
+    UpdateFilter();
+    SearchPath();
+    return true;
+}
+
+bool PathGenerator::PrepareDetachedPath(float destX, float destY, float destZ, bool forceDest)
+{
+    if (!_navMesh || _sourceUnit->HasUnitState(UNIT_STATE_IGNORE_PATHFINDING))
+        return false;
+
+    if (!StartPath(destX, destY, destZ, forceDest, false))
+        return false;
+
+    UpdateFilter();
+    return true;
+}
+
+bool PathGenerator::CalculateDetachedPath(PathGenerator const* sharedCorridor)
+{
+    TC_LOG_DEBUG("maps", "++ PathGenerator::CalculateDetachedPath() for %u \n", _sourceGuidLow);
+
+    _detached = true;
+    _normalizePending = false;
+    _actualEndOnPath = false;
+    _sharedCorridor = CanShareCorridor(sharedCorridor) ? sharedCorridor : NULL;
+
+    // stays blank if the search had to stop for terrain data
+    _type = PATHFIND_BLANK;
+    SearchPath();
+
+    _detached = false;
+    _sharedCorridor = NULL;
+    return _type != PATHFIND_BLANK;
+}
+
+void PathGenerator::FinishDetachedPath()
+{
+    if (!_normalizePending)
+        return;
+
+    _normalizePending = false;
+    NormalizePath();
+
+    if (_actualEndOnPath)
+        SetActualEndPosition(_pathPoints[_pathPoints.size() - 1]);
+}
+
+// captures the owner state used by the search, called from the owner's map thread
+bool PathGenerator::StartPath(float destX, float destY, float destZ, bool forceDest, bool straightLine)
 {
     float x, y, z;
     _sourceUnit->GetPosition(x, y, z);
@@ -70,22 +134,67 @@ bool PathGenerator::CalculatePath(float destX, float destY, float destZ, bool fo
     _forceDestination = forceDest;
     _straightLine = straightLine;
 
-    TC_LOG_DEBUG("maps", "++ PathGenerator::CalculatePath() for %u \n", _sourceUnit->GetGUIDLow());
+    _sourceMapId = _sourceUnit->GetMapId();
+    _sourceCanFly = _sourceUnit->GetTypeId() == TYPEID_UNIT && _sourceUnit->ToCreature()->CanFly();
+    _sourceCanSwim = _sourceUnit->GetTypeId() == TYPEID_UNIT && _sourceUnit->ToCreature()->CanSwim();
+    return true;
+}
+
+// searches the navmesh between the start and end position, does not touch the owner when detached
+void PathGenerator::SearchPath()
+{
+    MMAP::MMapManager* mmap = MMAP::MMapFactory::createOrGetMMapManager();
+
+    // tiles may be loaded or unloaded by other map threads meanwhile, the whole map even while searching detached
+    MMAP::MMapDataPtr mmapData = mmap->GetMMapData(_sourceMapId);
+    if (!mmapData)
+    {
+        BuildShortcut();
+        _type = PathType(PATHFIND_NORMAL | PATHFIND_NOT_USING_PATH);
+        return;
+    }
+
+    boost::shared_lock<boost::shared_mutex> lock(mmapData->navMeshLock);
+
+    // the map may have been reloaded since the path was created
+    _navMesh = mmapData->navMesh;
+    _mmapData = mmapData.get();
+
+    // the query belongs to the calling thread, our map may be updated by another thread next time
+    _navMeshQuery = mmap->GetNavMeshQuery(_mmapData, _sourceMapId);
 
-    // make sure navMesh works - we can run on map w/o mmap
     // check if the start and end point have a .mmtile loaded (can we pass via not loaded tile on the way?)
-    if (!_navMesh || !_navMeshQuery || _sourceUnit->HasUnitState(UNIT_STATE_IGNORE_PATHFINDING) ||
-        !HaveTile(start) || !HaveTile(dest))
+    if (!_navMeshQuery || !HaveTile(_startPosition) || !HaveTile(_endPosition))
     {
+        _mmapData = NULL;
         BuildShortcut();
         _type = PathType(PATHFIND_NORMAL | PATHFIND_NOT_USING_PATH);
-        return true;
+        return;
     }
 
-    UpdateFilter();
+    std::chrono::steady_clock::time_point buildStart = std::chrono::steady_clock::now();
+    _findPathCalls = 0;
+    _nodesExpanded = 0;
 
-    BuildPolyPath(start, dest);
-    return true;
+    BuildPolyPath(_startPosition, _endPosition);
+    _mmapData = NULL;
+
+    mmap->AddPathStats(_findPathCalls, _nodesExpanded,
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - buildStart).count());
+}
+
+// a corridor searched with the same filter can be followed from any of its polygons
+bool PathGenerator::CanShareCorridor(PathGenerator const* path) const
+{
+    if (!path || path == this || _straightLine || path->_straightLine || !path->_polyLength)
+        return false;
+
+    if (path->_sourceMapId != _sourceMapId || (path->_type & PATHFIND_NOT_USING_PATH) ||
+        !(path->_type & (PATHFIND_NORMAL | PATHFIND_INCOMPLETE)))
+        return false;
+
+    return path->_filter.getIncludeFlags() == _filter.getIncludeFlags() &&
+        path->_filter.getExcludeFlags() == _filter.getExcludeFlags();
 }
 
 dtPolyRef PathGenerator::GetPathPolyByPosition(dtPolyRef const* polyPath, uint32 polyPathSize, float const* point, float* distance) const
@@ -173,11 +282,18 @@ void PathGenerator::BuildPolyPath(G3D::Vector3 const& startPos, G3D::Vector3 con
     {
         TC_LOG_DEBUG("maps", "++ BuildPolyPath :: (startPoly == 0 || endPoly == 0)\n");
         BuildShortcut();
-        bool path = _sourceUnit->GetTypeId() == TYPEID_UNIT && _sourceUnit->ToCreature()->CanFly();
+        bool path = _sourceCanFly;
 
-        bool waterPath = _sourceUnit->GetTypeId() == TYPEID_UNIT && _sourceUnit->ToCreature()->CanSwim();
+        bool waterPath = _sourceCanSwim && !path;
         if (waterPath)
         {
+            // the liquid checks need the owner's map
+            if (_detached)
+            {
+                _type = PATHFIND_BLANK;
+                return;
+            }
+
             // Check both start and end points, if they're both in water, then we can *safely* let the creature move
             for (uint32 i = 0; i < _pathPoints.size(); ++i)
             {
@@ -201,23 +317,27 @@ void PathGenerator::BuildPolyPath(G3D::Vector3 const& startPos, G3D::Vector3 con
     {
         TC_LOG_DEBUG("maps", "++ BuildPolyPath :: farFromPoly distToStartPoly=%.3f distToEndPoly=%.3f\n", distToStartPoly, distToEndPoly);
 
-        bool buildShotrcut = false;
-        if (_sourceUnit->GetTypeId() == TYPEID_UNIT)
+        // only creatures that can either swim or fly care whether the point is underwater
+        bool buildShotrcut = _sourceCanFly && _sourceCanSwim;
+        if (_sourceCanFly != _sourceCanSwim)
         {
-            Creature* owner = (Creature*)_sourceUnit;
+            // the liquid check needs the owner's map
+            if (_detached)
+            {
+                _type = PATHFIND_BLANK;
+                return;
+            }
 
             G3D::Vector3 const& p = (distToStartPoly > 7.0f) ? startPos : endPos;
             if (_sourceUnit->GetBaseMap()->IsUnderWater(p.x, p.y, p.z))
             {
                 TC_LOG_DEBUG("maps", "++ BuildPolyPath :: underWater case\n");
-                if (owner->CanSwim())
-                    buildShotrcut = true;
+                buildShotrcut = _sourceCanSwim;
             }
             else
             {
                 TC_LOG_DEBUG("maps", "++ BuildPolyPath :: flying case\n");
-                if (owner->CanFly())
-                    buildShotrcut = true;
+                buildShotrcut = _sourceCanFly;
             }
         }
 
@@ -276,7 +396,7 @@ void PathGenerator::BuildPolyPath(G3D::Vector3 const& startPos, G3D::Vector3 con
                 TC_LOG_ERROR("maps", "Invalid poly ref in BuildPolyPath. _polyLength: %u, pathStartIndex: %u,"
                                      " startPos: %s, endPos: %s, mapid: %u",
                                      _polyLength, pathStartIndex, startPos.toString().c_str(), endPos.toString().c_str(),
-                                     _sourceUnit->GetMapId());
+                                     _sourceMapId);
 
                 break;
             }
@@ -296,6 +416,26 @@ void PathGenerator::BuildPolyPath(G3D::Vector3 const& startPos, G3D::Vector3 con
             }
     }
 
+    // another unit may just have searched a corridor through both of our polygons, e.g. when chasing the same target
+    if (!(startPolyFound && endPolyFound) && _sharedCorridor)
+    {
+        dtPolyRef const* sharedBegin = _sharedCorridor->_pathPolyRefs;
+        dtPolyRef const* sharedEnd = sharedBegin + _sharedCorridor->_polyLength;
+        dtPolyRef const* sharedStart = std::find(sharedBegin, sharedEnd, startPoly);
+        dtPolyRef const* sharedStop = std::find(sharedStart, sharedEnd, endPoly);
+        if (sharedStop != sharedEnd)
+        {
+            TC_LOG_DEBUG("maps", "++ BuildPolyPath :: following shared corridor\n");
+
+            _polyLength = uint32(sharedStop - sharedStart) + 1;
+            memcpy(_pathPolyRefs, sharedStart, _polyLength * sizeof(dtPolyRef));
+            pathStartIndex = 0;
+            pathEndIndex = _polyLength - 1;
+            startPolyFound = true;
+            endPolyFound = true;
+        }
+    }
+
     if (startPolyFound && endPolyFound)
     {
         TC_LOG_DEBUG("maps", "++ BuildPolyPath :: (startPolyFound && endPolyFound)\n");
@@ -376,14 +516,13 @@ void PathGenerator::BuildPolyPath(G3D::Vector3 const& startPos, G3D::Vector3 con
         }
         else
         {
-            dtResult = _navMeshQuery->findPath(
+            dtResult = FindPath(
                             suffixStartPoly,    // start polygon
                             endPoly,            // end polygon
                             suffixEndPoint,     // start position
                             endPoint,           // end position
-                            &_filter,            // polygon search filter
                             _pathPolyRefs + prefixPolyLength - 1,    // [out] path
-                            (int*)&suffixPolyLength,
+                            &suffixPolyLength,
                             MAX_PATH_LENGTH - prefixPolyLength);   // max number of polygons in output path
         }
 
@@ -392,7 +531,7 @@ void PathGenerator::BuildPolyPath(G3D::Vector3 const& startPos, G3D::Vector3 con
             // this is probably an error state, but we'll leave it
             // and hopefully recover on the next Update
             // we still need to copy our preffix
-            TC_LOG_ERROR("maps", "%u's Path Build failed: 0 length path", _sourceUnit->GetGUIDLow());
+            TC_LOG_ERROR("maps", "%u's Path Build failed: 0 length path", _sourceGuidLow);
         }
 
         TC_LOG_DEBUG("maps", "++  m_polyLength=%u prefixPolyLength=%u suffixPolyLength=%u \n", _polyLength, prefixPolyLength, suffixPolyLength);
@@ -439,21 +578,20 @@ void PathGenerator::BuildPolyPath(G3D::Vector3 const& startPos, G3D::Vector3 con
         }
         else
         {
-            dtResult = _navMeshQuery->findPath(
+            dtResult = FindPath(
                             startPoly,          // start polygon
                             endPoly,            // end polygon
                             startPoint,         // start position
                             endPoint,           // end position
-                            &_filter,           // polygon search filter
                             _pathPolyRefs,     // [out] path
-                            (int*)&_polyLength,
+                            &_polyLength,
                             MAX_PATH_LENGTH);   // max number of polygons in output path
         }
 
         if (!_polyLength || dtStatusFailed(dtResult))
         {
             // only happens if we passed bad data to findPath(), or navmesh is messed up
-            TC_LOG_ERROR("maps", "%u's Path Build failed: 0 length path", _sourceUnit->GetGUIDLow());
+            TC_LOG_ERROR("maps", "%u's Path Build failed: 0 length path", _sourceGuidLow);
             BuildShortcut();
             _type = PATHFIND_NOPATH;
             return;
@@ -470,6 +608,30 @@ void PathGenerator::BuildPolyPath(G3D::Vector3 const& startPos, G3D::Vector3 con
     BuildPointPath(startPoint, endPoint);
 }
 
+// runs findPath, growing the node pool of our query and searching again whenever it ran out of nodes
+// complete corridors are cached per map, they connect the two polygons from any position within them
+dtStatus PathGenerator::FindPath(dtPolyRef startRef, dtPolyRef endRef, float const* startPos, float const* endPos, dtPolyRef* path, uint32* pathSize, uint32 maxPath)
+{
+    MMAP::MMapManager* mmap = MMAP::MMapFactory::createOrGetMMapManager();
+    MMAP::MMapPathCacheKey key(startRef, endRef, _filter.getIncludeFlags(), _filter.getExcludeFlags());
+    if (mmap->FindCachedPath(_mmapData, key, path, pathSize, maxPath))
+        return DT_SUCCESS;
+
+    dtStatus result;
+    do
+    {
+        result = _navMeshQuery->findPath(startRef, endRef, startPos, endPos, &_filter, path, (int*)pathSize, maxPath);
+        ++_findPathCalls;
+        _nodesExpanded += _navMeshQuery->getNodePool()->getNodeCount();
+    }
+    while (dtStatusDetail(result, DT_OUT_OF_NODES) && mmap->GrowNavMeshQuery(_mmapData, _sourceMapId));
+
+    if (dtStatusSucceed(result) && !dtStatusDetail(result, DT_PARTIAL_RESULT) && *pathSize && path[*pathSize - 1] == endRef)
+        mmap->CachePath(_mmapData, key, path, *pathSize);
+
+    return result;
+}
+
 void PathGenerator::BuildPointPath(const float *startPoint, const float *endPoint)
 {
     float pathPoints[MAX_POINT_PATH_LENGTH*VERTEX_SIZE];
@@ -552,6 +714,7 @@ void PathGenerator::BuildPointPath(const float *startPoint, const float *endPoin
 
     // first point is always our current location - we need the next one
     SetActualEndPosition(_pathPoints[pointCount-1]);
+    _actualEndOnPath = true;
 
     // force the given destination, if needed
     if (_forceDestination &&
@@ -569,6 +732,8 @@ void PathGenerator::BuildPointPath(const float *startPoint, const float *endPoin
             BuildShortcut();
         }
 
+        _actualEndOnPath = false;
+
         _type = PathType(PATHFIND_NORMAL | PATHFIND_NOT_USING_PATH);
     }
 
@@ -577,6 +742,13 @@ void PathGenerator::BuildPointPath(const float *startPoint, const float *endPoin
 
 void PathGenerator::NormalizePath()
 {
+    // heights come from the owner's map, FinishDetachedPath applies them
+    if (_detached)
+    {
+        _normalizePending = true;
+        return;
+    }
+
     for (uint32 i = 0; i < _pathPoints.size(); ++i)
         _sourceUnit->UpdateAllowedPositionZ(_pathPoints[i].x, _pathPoints[i].y, _pathPoints[i].z);
 }
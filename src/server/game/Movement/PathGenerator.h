@@ -26,6 +26,11 @@
 
 class Unit;
 
+namespace MMAP
+{
+    struct MMapData;
+}
+
 // 74*4.0f=296y  number_of_points*interval = max_path_len
 // this is way more than actual evade range
 // I think we can safely cut those down even more
@@ -59,9 +64,21 @@ class PathGenerator
         // return: true if new path was calculated, false otherwise (no change needed)
         bool CalculatePath(float destX, float destY, float destZ, bool forceDest = false, bool straightLine = false);
 
+        // Asynchronous calculation, see PathfindingService
+        // Captures the owner state for a path to the given destination, must be called from the owner's map thread
+        // return: false if there is nothing to search for, CalculatePath builds such paths right away
+        bool PrepareDetachedPath(float destX, float destY, float destZ, bool forceDest = false);
+        // Searches the prepared path without touching the owner or its map, may follow the corridor of a path
+        // searched for another unit with the same filter
+        // return: false if the result depends on terrain data, the path then has to be calculated with CalculatePath
+        bool CalculateDetachedPath(PathGenerator const* sharedCorridor = NULL);
+        // Applies the terrain height of the owner's map to a detached path, must be called from the owner's map thread
+        void FinishDetachedPath();
+
         // option setters - use optional
         void SetUseStraightPath(bool useStraightPath) { _useStraightPath = useStraightPath; }
         void SetPathLengthLimit(float distance) { _pointPathLimit = std::min<uint32>(uint32(distance/SMOOTH_PATH_STEP_SIZE), MAX_POINT_PATH_LENGTH); }
+        bool IsForcedDestination() const { return _forceDestination; }
 
         // result getters
         G3D::Vector3 const& GetStartPosition() const { return _startPosition; }
@@ -71,6 +88,7 @@ class PathGenerator
         Movement::PointsArray const& GetPath() const { return _pathPoints; }
 
         PathType GetPathType() const { return _type; }
+        uint32 GetMapId() const { return _sourceMapId; }
 
         void ReducePathLenghtByDist(float dist); // path must be already built
 
@@ -91,9 +109,22 @@ class PathGenerator
         G3D::Vector3 _endPosition;          // {x, y, z} of the destination
         G3D::Vector3 _actualEndPosition;    // {x, y, z} of the closest possible point to given destination
 
-        Unit const* const _sourceUnit;          // the unit that is moving
+        Unit const* const _sourceUnit;          // the unit that is moving, never accessed by a detached search
+        uint32 _sourceMapId;                    // state of the unit when the path was requested
+        uint32 _sourceGuidLow;
+        bool _sourceCanFly;
+        bool _sourceCanSwim;
+
+        bool _detached;                         // searching on a pathfinding worker thread
+        bool _normalizePending;                 // detached path points still need the terrain height
+        bool _actualEndOnPath;                  // actual end position is the last path point, see FinishDetachedPath
+        PathGenerator const* _sharedCorridor;   // path of another unit that may be followed by a detached search
         dtNavMesh const* _navMesh;              // the nav mesh
-        dtNavMeshQuery const* _navMeshQuery;    // the nav mesh query used to find the path
+        dtNavMeshQuery const* _navMeshQuery;    // the nav mesh query used to find the path, owned by the calling thread
+        MMAP::MMapData* _mmapData;              // mmap data of the map, kept alive by SearchPath while it runs
+
+        uint32 _findPathCalls;  // findPath calls of the path being built, for MMapManager statistics
+        uint32 _nodesExpanded;  // search nodes used by those calls
 
         dtQueryFilter _filter;  // use single filter for all movements, update it when needed
 
@@ -116,7 +147,12 @@ class PathGenerator
         dtPolyRef GetPolyByLocation(float const* Point, float* Distance) const;
         bool HaveTile(G3D::Vector3 const& p) const;
 
+        bool StartPath(float destX, float destY, float destZ, bool forceDest, bool straightLine);
+        void SearchPath();
+        bool CanShareCorridor(PathGenerator const* path) const;
+
         void BuildPolyPath(G3D::Vector3 const& startPos, G3D::Vector3 const& endPos);
+        dtStatus FindPath(dtPolyRef startRef, dtPolyRef endRef, float const* startPos, float const* endPos, dtPolyRef* path, uint32* pathSize, uint32 maxPath);
         void BuildPointPath(float const* startPoint, float const* endPoint);
         void BuildShortcut();
 
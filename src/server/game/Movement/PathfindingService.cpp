@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2008-2015 TrinityCore <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PathfindingService.h"
+#include "PathGenerator.h"
+#include "Log.h"
+
+PathRequest::PathRequest(PathGenerator const& path) : _path(new PathGenerator(path)), _state(PATH_REQUEST_PENDING)
+{
+}
+
+PathRequest::~PathRequest()
+{
+    delete _path;
+}
+
+void PathRequest::Cancel()
+{
+    PathRequestState expected = PATH_REQUEST_PENDING;
+    _state.compare_exchange_strong(expected, PATH_REQUEST_CANCELLED, std::memory_order_acq_rel);
+}
+
+PathGenerator* PathRequest::TakePath()
+{
+    ASSERT(!IsPending());
+
+    PathGenerator* path = _path;
+    _path = NULL;
+    return path;
+}
+
+void PathfindingService::Activate(uint32 threads)
+{
+    _cancelationToken = false;
+
+    for (uint32 i = 0; i < threads; ++i)
+        _workerThreads.push_back(std::thread(&PathfindingService::WorkerThread, this));
+
+    TC_LOG_INFO("server.loading", "Started %u pathfinding threads", threads);
+}
+
+void PathfindingService::Deactivate()
+{
+    if (!IsActive())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(_pendingBatchesLock);
+        _cancelationToken = true;
+        _pendingBatches.clear();
+    }
+
+    // wakes every worker, each one stops at the first batch it takes off the queue
+    for (size_t i = 0; i < _workerThreads.size(); ++i)
+        _queue.Push(nullptr);
+
+    for (std::thread& thread : _workerThreads)
+        thread.join();
+
+    _workerThreads.clear();
+
+    // the requesters calculate the paths still queued themselves, the queue is reused by the next Activate
+    PathRequestBatch* batch = nullptr;
+    while (_queue.Pop(batch))
+    {
+        if (batch)
+        {
+            FailBatch(batch);
+            delete batch;
+        }
+    }
+}
+
+PathRequestPtr PathfindingService::Submit(PathGenerator const& path, uint64 coalesceKey)
+{
+    PathRequestPtr request = std::make_shared<PathRequest>(path);
+
+    std::lock_guard<std::mutex> lock(_pendingBatchesLock);
+
+    if (_cancelationToken)
+    {
+        request->_state.store(PATH_REQUEST_FAILED, std::memory_order_release);
+        return request;
+    }
+
+    if (coalesceKey)
+    {
+        std::unordered_map<uint64, PathRequestBatch*>::iterator itr = _pendingBatches.find(coalesceKey);
+        if (itr != _pendingBatches.end())
+        {
+            itr->second->Requests.push_back(request);
+            return request;
+        }
+    }
+
+    PathRequestBatch* batch = new PathRequestBatch(coalesceKey);
+    batch->Requests.push_back(request);
+    if (coalesceKey)
+        _pendingBatches[coalesceKey] = batch;
+
+    _queue.Push(batch);
+    return request;
+}
+
+void PathfindingService::ProcessBatch(PathRequestBatch* batch)
+{
+    // no more requests join the batch once it is taken off the queue
+    if (batch->CoalesceKey)
+    {
+        std::lock_guard<std::mutex> lock(_pendingBatchesLock);
+        std::unordered_map<uint64, PathRequestBatch*>::iterator itr = _pendingBatches.find(batch->CoalesceKey);
+        if (itr != _pendingBatches.end() && itr->second == batch)
+            _pendingBatches.erase(itr);
+    }
+
+    // a finished path may be the corridor of the later requests, so none is handed back to its
+    // requester before the whole batch is searched, the requester is free to change it after that
+    std::vector<PathRequestState> states(batch->Requests.size(), PATH_REQUEST_DEFERRED);
+    PathGenerator const* sharedCorridor = NULL;
+    for (size_t i = 0; i < batch->Requests.size(); ++i)
+    {
+        PathRequestPtr const& request = batch->Requests[i];
+        if (!request->IsPending())
+            continue;
+
+        if (request->_path->CalculateDetachedPath(sharedCorridor))
+        {
+            states[i] = PATH_REQUEST_DONE;
+            sharedCorridor = request->_path;
+        }
+    }
+
+    for (size_t i = 0; i < batch->Requests.size(); ++i)
+    {
+        PathRequestState expected = PATH_REQUEST_PENDING;
+        batch->Requests[i]->_state.compare_exchange_strong(expected, states[i], std::memory_order_acq_rel);
+    }
+
+    TC_LOG_DEBUG("maps", "PathfindingService::ProcessBatch: searched " SZFMTD " paths for coalesce key " UI64FMTD,
+        batch->Requests.size(), batch->CoalesceKey);
+}
+
+void PathfindingService::FailBatch(PathRequestBatch* batch)
+{
+    for (PathRequestPtr const& request : batch->Requests)
+    {
+        PathRequestState expected = PATH_REQUEST_PENDING;
+        request->_state.compare_exchange_strong(expected, PATH_REQUEST_FAILED, std::memory_order_acq_rel);
+    }
+}
+
+void PathfindingService::WorkerThread()
+{
+    while (1)
+    {
+        PathRequestBatch* batch = nullptr;
+
+        _queue.WaitAndPop(batch);
+
+        if (_cancelationToken)
+        {
+            if (batch)
+            {
+                FailBatch(batch);
+                delete batch;
+            }
+
+            return;
+        }
+
+        ProcessBatch(batch);
+
+        delete batch;
+    }
+}
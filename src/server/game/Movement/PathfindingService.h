@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2008-2015 TrinityCore <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRINITY_PATHFINDINGSERVICE_H
+#define TRINITY_PATHFINDINGSERVICE_H
+
+#include "Define.h"
+#include "ProducerConsumerQueue.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+class PathGenerator;
+
+enum PathRequestState
+{
+    PATH_REQUEST_PENDING    = 0,    // queued or being searched
+    PATH_REQUEST_DONE       = 1,    // searched, finish the path with PathGenerator::FinishDetachedPath
+    PATH_REQUEST_DEFERRED   = 2,    // depends on terrain data, calculate the path on the map thread instead
+    PATH_REQUEST_CANCELLED  = 3,    // the requester lost interest, not searched
+    PATH_REQUEST_FAILED     = 4     // the service stopped before searching it, calculate the path on the map thread instead
+};
+
+// a path search shared by the requesting movement generator and a pathfinding worker
+class PathRequest
+{
+    public:
+        explicit PathRequest(PathGenerator const& path);
+        ~PathRequest();
+
+        PathRequestState GetState() const { return _state.load(std::memory_order_acquire); }
+        bool IsPending() const { return GetState() == PATH_REQUEST_PENDING; }
+
+        void Cancel();
+
+        // the caller takes ownership, only valid once the request is no longer pending
+        PathGenerator* TakePath();
+
+    private:
+        friend class PathfindingService;
+
+        PathGenerator* _path;
+        std::atomic<PathRequestState> _state;
+};
+
+typedef std::shared_ptr<PathRequest> PathRequestPtr;
+
+// Searches paths prepared by PathGenerator::PrepareDetachedPath on worker threads,
+// the requester picks the result up on one of its next updates
+class PathfindingService
+{
+    public:
+        static PathfindingService* instance()
+        {
+            static PathfindingService instance;
+            return &instance;
+        }
+
+        void Activate(uint32 threads);
+        void Deactivate();
+        bool IsActive() const { return !_workerThreads.empty(); }
+
+        // Queues a copy of the prepared path. Requests sharing a non zero coalesce key (usually the chased unit)
+        // are searched together while queued, later ones follow the corridor found for earlier ones when they can.
+        PathRequestPtr Submit(PathGenerator const& path, uint64 coalesceKey);
+
+    private:
+        struct PathRequestBatch
+        {
+            explicit PathRequestBatch(uint64 coalesceKey) : CoalesceKey(coalesceKey) { }
+
+            uint64 CoalesceKey;
+            std::vector<PathRequestPtr> Requests;
+        };
+
+        PathfindingService() : _cancelationToken(false) { }
+        ~PathfindingService() { }
+
+        void ProcessBatch(PathRequestBatch* batch);
+        static void FailBatch(PathRequestBatch* batch);
+        void WorkerThread();
+
+        ProducerConsumerQueue<PathRequestBatch*> _queue;
+        std::vector<std::thread> _workerThreads;
+        std::atomic<bool> _cancelationToken;
+
+        std::mutex _pendingBatchesLock;
+        std::unordered_map<uint64, PathRequestBatch*> _pendingBatches;  // queued batches by coalesce key
+};
+
+#define sPathfindingService PathfindingService::instance()
+
+#endif
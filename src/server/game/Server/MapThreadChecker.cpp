@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2008-2015 TrinityCore <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MapThreadChecker.h"
+#include "Log.h"
+#include "Map.h"
+#include "Object.h"
+#include "Opcodes.h"
+
+thread_local Map const* MapThreadChecker::_map = NULL;
+thread_local uint16 MapThreadChecker::_opcode = 0;
+
+MapThreadChecker::Scope::Scope(Map const* map, uint16 opcode) : _previousMap(_map), _previousOpcode(_opcode)
+{
+    _map = map;
+    _opcode = opcode;
+}
+
+MapThreadChecker::Scope::~Scope()
+{
+    _map = _previousMap;
+    _opcode = _previousOpcode;
+}
+
+void MapThreadChecker::CheckAccess(WorldObject const* object, char const* accessor)
+{
+    if (!_map || !object || !object->IsInWorld() || object->GetMap() == _map)
+        return;
+
+    TC_LOG_ERROR("network.opcode", "MapThreadChecker: %s handled for map %u (instance %u) got %s of map %u (instance %u) from %s",
+        GetOpcodeNameForLogging(_opcode).c_str(), _map->GetId(), _map->GetInstanceId(), object->GetGUID().ToString().c_str(),
+        object->GetMapId(), object->GetInstanceId(), accessor);
+}
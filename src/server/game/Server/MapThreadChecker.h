@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2008-2015 TrinityCore <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRINITY_MAPTHREADCHECKER_H
+#define TRINITY_MAPTHREADCHECKER_H
+
+#include "Define.h"
+
+class Map;
+class WorldObject;
+
+// Remembers the map a PROCESS_THREADSAFE opcode handler runs for. Objects of other maps handed out
+// to it by the world wide ObjectAccessor lookups are reported, those may be updated by another map
+// thread at the same time. Only debug builds check, see CHECK_MAP_THREAD_ACCESS.
+class MapThreadChecker
+{
+    public:
+        class Scope
+        {
+            public:
+                // map is NULL for handlers not running on a map thread
+                Scope(Map const* map, uint16 opcode);
+                ~Scope();
+
+            private:
+                Map const* _previousMap;
+                uint16 _previousOpcode;
+        };
+
+        static void CheckAccess(WorldObject const* object, char const* accessor);
+
+    private:
+        static thread_local Map const* _map;
+        static thread_local uint16 _opcode;
+};
+
+#ifdef TRINITY_DEBUG
+#  define CHECK_MAP_THREAD_ACCESS(object) MapThreadChecker::CheckAccess(object, __FUNCTION__)
+#else
+#  define CHECK_MAP_THREAD_ACCESS(object)
+#endif
+
+#endif
@@ -1353,6 +1353,10 @@ enum SessionStatus
     STATUS_UNHANDLED                                        // Opcode not handled yet
 };
 
+// PROCESS_THREADSAFE handlers run on the map update thread of the player's map, so they may only touch
+// objects of that map and data that is read only or synchronized (debug builds report other maps'
+// objects, see MapThreadChecker). A session's queue is only read from its front, so packets of
+// different kinds are still handled in the order they were received.
 enum PacketProcessing
 {
     PROCESS_INPLACE = 0,                                    //process packet whenever we receive it - mostly for non-handled or non-implemented packets
@@ -0,0 +1,209 @@
+/*
+ * Copyright (C) 2008-2015 TrinityCore <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "UpdateProfiler.h"
+#include "Log.h"
+#include "Config.h"
+#include <cstdio>
+
+void UpdateProfiler::Entry::Record(uint64 time)
+{
+    Calls.fetch_add(1, std::memory_order_relaxed);
+    TotalTime.fetch_add(time, std::memory_order_relaxed);
+
+    uint64 maxTime = MaxTime.load(std::memory_order_relaxed);
+    while (time > maxTime && !MaxTime.compare_exchange_weak(maxTime, time, std::memory_order_relaxed))
+        ;
+
+    uint32 bucket = 0;
+    for (uint64 micro = time / 1000; micro && bucket + 1 < PROFILER_HISTOGRAM_BUCKETS; micro >>= 1)
+        ++bucket;
+
+    Histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+void UpdateProfiler::Entry::Reset()
+{
+    Calls.store(0, std::memory_order_relaxed);
+    TotalTime.store(0, std::memory_order_relaxed);
+    MaxTime.store(0, std::memory_order_relaxed);
+    for (uint32 i = 0; i < PROFILER_HISTOGRAM_BUCKETS; ++i)
+        Histogram[i].store(0, std::memory_order_relaxed);
+}
+
+ProfilerStats UpdateProfiler::Entry::GetStats() const
+{
+    ProfilerStats stats;
+    stats.Calls = Calls.load(std::memory_order_relaxed);
+    stats.TotalTime = TotalTime.load(std::memory_order_relaxed);
+    stats.MaxTime = MaxTime.load(std::memory_order_relaxed);
+    for (uint32 i = 0; i < PROFILER_HISTOGRAM_BUCKETS; ++i)
+        stats.Histogram[i] = Histogram[i].load(std::memory_order_relaxed);
+    return stats;
+}
+
+void UpdateProfiler::Initialize(uint32 mapCount)
+{
+    std::vector<Entry>(mapCount).swap(_maps);
+}
+
+void UpdateProfiler::Reset()
+{
+    for (Entry& entry : _opcodes)
+        entry.Reset();
+    for (Entry& entry : _processing)
+        entry.Reset();
+    for (Entry& entry : _maps)
+        entry.Reset();
+    for (Entry& entry : _worldPhases)
+        entry.Reset();
+}
+
+void UpdateProfiler::RecordOpcode(uint16 opcode, PacketProcessing processing, uint64 start)
+{
+    if (!start)
+        return;
+
+    uint64 time = Now() - start;
+    if (opcode < _opcodes.size())
+        _opcodes[opcode].Record(time);
+    if (uint32(processing) < _processing.size())
+        _processing[processing].Record(time);
+}
+
+void UpdateProfiler::RecordMap(uint32 mapId, uint64 start)
+{
+    if (!start || mapId >= _maps.size())
+        return;
+
+    _maps[mapId].Record(Now() - start);
+}
+
+void UpdateProfiler::RecordWorldPhase(ProfiledWorldPhase phase, uint64 start)
+{
+    if (!start)
+        return;
+
+    _worldPhases[phase].Record(Now() - start);
+}
+
+ProfilerStats UpdateProfiler::GetOpcodeStats(uint16 opcode) const
+{
+    return opcode < _opcodes.size() ? _opcodes[opcode].GetStats() : ProfilerStats();
+}
+
+ProfilerStats UpdateProfiler::GetProcessingStats(PacketProcessing processing) const
+{
+    return uint32(processing) < _processing.size() ? _processing[processing].GetStats() : ProfilerStats();
+}
+
+ProfilerStats UpdateProfiler::GetMapStats(uint32 mapId) const
+{
+    return mapId < _maps.size() ? _maps[mapId].GetStats() : ProfilerStats();
+}
+
+ProfilerStats UpdateProfiler::GetWorldPhaseStats(ProfiledWorldPhase phase) const
+{
+    return _worldPhases[phase].GetStats();
+}
+
+char const* UpdateProfiler::GetWorldPhaseName(ProfiledWorldPhase phase)
+{
+    switch (phase)
+    {
+        case PROFILE_WORLD_UPDATE:          return "WorldUpdate";
+        case PROFILE_WORLD_SESSIONS:        return "UpdateSessions";
+        case PROFILE_WORLD_MAPS:            return "UpdateMapMgr";
+        case PROFILE_WORLD_BATTLEGROUNDS:   return "UpdateBattlegroundMgr";
+        case PROFILE_WORLD_OUTDOORPVP:      return "UpdateOutdoorPvPMgr";
+        case PROFILE_WORLD_BATTLEFIELDS:    return "UpdateBattlefieldMgr";
+        case PROFILE_WORLD_LFG:             return "UpdateLFGMgr";
+        case PROFILE_WORLD_QUERY_CALLBACKS: return "ProcessQueryCallbacks";
+        default:
+            break;
+    }
+
+    return "Unknown";
+}
+
+char const* UpdateProfiler::GetProcessingName(PacketProcessing processing)
+{
+    switch (processing)
+    {
+        case PROCESS_INPLACE:       return "PROCESS_INPLACE";
+        case PROCESS_THREADUNSAFE:  return "PROCESS_THREADUNSAFE";
+        case PROCESS_THREADSAFE:    return "PROCESS_THREADSAFE";
+        default:
+            break;
+    }
+
+    return "Unknown";
+}
+
+static void DumpEntry(FILE* file, char const* type, std::string const& name, ProfilerStats const& stats)
+{
+    if (!stats.Calls)
+        return;
+
+    fprintf(file, "%s;%s;" UI64FMTD ";" UI64FMTD ";" UI64FMTD ";" UI64FMTD, type, name.c_str(),
+        stats.Calls, stats.TotalTime / 1000, stats.TotalTime / 1000 / stats.Calls, stats.MaxTime / 1000);
+
+    for (uint32 i = 0; i < PROFILER_HISTOGRAM_BUCKETS; ++i)
+        fprintf(file, ";" UI64FMTD, stats.Histogram[i]);
+
+    fprintf(file, "\n");
+}
+
+bool UpdateProfiler::Dump(std::string const& fileName) const
+{
+    std::string logsDir = sConfigMgr->GetStringDefault("LogsDir", "");
+    if (!logsDir.empty())
+        if ((logsDir.at(logsDir.length() - 1) != '/') && (logsDir.at(logsDir.length() - 1) != '\\'))
+            logsDir.push_back('/');
+
+    FILE* file = fopen((logsDir + fileName).c_str(), "w");
+    if (!file)
+        return false;
+
+    // times in microseconds, the histogram columns count calls below the given microseconds
+    fprintf(file, "type;name;calls;total_us;avg_us;max_us");
+    for (uint32 i = 0; i < PROFILER_HISTOGRAM_BUCKETS; ++i)
+    {
+        if (uint32 limit = GetBucketLimit(i))
+            fprintf(file, ";<%u", limit);
+        else
+            fprintf(file, ";>=%u", GetBucketLimit(i - 1));
+    }
+    fprintf(file, "\n");
+
+    for (uint32 i = 0; i < MAX_PROFILED_WORLD_PHASES; ++i)
+        DumpEntry(file, "world", GetWorldPhaseName(ProfiledWorldPhase(i)), GetWorldPhaseStats(ProfiledWorldPhase(i)));
+
+    for (uint32 i = 0; i < _maps.size(); ++i)
+        DumpEntry(file, "map", std::to_string(i), GetMapStats(i));
+
+    for (uint32 i = 0; i < MAX_PACKET_PROCESSING_MODES; ++i)
+        DumpEntry(file, "processing", GetProcessingName(PacketProcessing(i)), GetProcessingStats(PacketProcessing(i)));
+
+    for (uint32 i = 0; i < NUM_MSG_TYPES; ++i)
+        DumpEntry(file, "opcode", GetOpcodeNameForLogging(uint16(i)), GetOpcodeStats(uint16(i)));
+
+    fclose(file);
+
+    TC_LOG_INFO("misc", "UpdateProfiler: statistics written to %s", fileName.c_str());
+    return true;
+}
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2008-2015 TrinityCore <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRINITY_UPDATEPROFILER_H
+#define TRINITY_UPDATEPROFILER_H
+
+#include "Define.h"
+#include "Opcodes.h"
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+// latencies are counted in power of two microsecond buckets: < 1us, < 2us, < 4us, ... and the rest
+#define PROFILER_HISTOGRAM_BUCKETS 20
+
+enum ProfiledWorldPhase
+{
+    PROFILE_WORLD_UPDATE = 0,                               // the whole World::Update
+    PROFILE_WORLD_SESSIONS,
+    PROFILE_WORLD_MAPS,
+    PROFILE_WORLD_BATTLEGROUNDS,
+    PROFILE_WORLD_OUTDOORPVP,
+    PROFILE_WORLD_BATTLEFIELDS,
+    PROFILE_WORLD_LFG,
+    PROFILE_WORLD_QUERY_CALLBACKS,
+    MAX_PROFILED_WORLD_PHASES
+};
+
+#define MAX_PACKET_PROCESSING_MODES (PROCESS_THREADSAFE + 1)
+
+struct ProfilerStats
+{
+    ProfilerStats() : Calls(0), TotalTime(0), MaxTime(0), Histogram() { }
+
+    uint64 Calls;
+    uint64 TotalTime;                                       // nanoseconds
+    uint64 MaxTime;                                         // nanoseconds
+    uint64 Histogram[PROFILER_HISTOGRAM_BUCKETS];
+};
+
+// Call count, total and max time and a latency histogram per opcode handler, packet processing mode,
+// map id and world update phase. Disabled it costs one relaxed load per measured call, enabled two
+// clock reads and a few relaxed atomic adds, so it can run on a live realm.
+// Recorded from the world thread and the map update threads.
+class UpdateProfiler
+{
+    public:
+        static UpdateProfiler* instance()
+        {
+            static UpdateProfiler instance;
+            return &instance;
+        }
+
+        // sizes the map table, call after the DBC stores are loaded
+        void Initialize(uint32 mapCount);
+
+        void SetEnabled(bool enabled) { _enabled.store(enabled, std::memory_order_relaxed); }
+        bool IsEnabled() const { return _enabled.load(std::memory_order_relaxed); }
+        void Reset();
+
+        // returns 0 while disabled, the Record functions ignore such measurements
+        uint64 Start() const { return IsEnabled() ? Now() : 0; }
+
+        void RecordOpcode(uint16 opcode, PacketProcessing processing, uint64 start);
+        void RecordMap(uint32 mapId, uint64 start);
+        void RecordWorldPhase(ProfiledWorldPhase phase, uint64 start);
+
+        ProfilerStats GetOpcodeStats(uint16 opcode) const;
+        ProfilerStats GetProcessingStats(PacketProcessing processing) const;
+        ProfilerStats GetMapStats(uint32 mapId) const;
+        ProfilerStats GetWorldPhaseStats(ProfiledWorldPhase phase) const;
+        uint32 GetMapCount() const { return uint32(_maps.size()); }
+
+        static char const* GetWorldPhaseName(ProfiledWorldPhase phase);
+        static char const* GetProcessingName(PacketProcessing processing);
+
+        // upper bound of a histogram bucket in microseconds, 0 for the last one
+        static uint32 GetBucketLimit(uint32 bucket) { return bucket + 1 < PROFILER_HISTOGRAM_BUCKETS ? 1 << bucket : 0; }
+
+        // writes all non empty entries with their histograms to fileName in the logs directory, false if the file can't be written
+        bool Dump(std::string const& fileName) const;
+
+    private:
+        struct Entry
+        {
+            Entry() : Calls(0), TotalTime(0), MaxTime(0) { for (uint32 i = 0; i < PROFILER_HISTOGRAM_BUCKETS; ++i) Histogram[i] = 0; }
+
+            void Record(uint64 time);
+            void Reset();
+            ProfilerStats GetStats() const;
+
+            std::atomic<uint64> Calls;
+            std::atomic<uint64> TotalTime;
+            std::atomic<uint64> MaxTime;
+            std::atomic<uint64> Histogram[PROFILER_HISTOGRAM_BUCKETS];
+        };
+
+        UpdateProfiler() : _enabled(false), _opcodes(NUM_MSG_TYPES), _processing(MAX_PACKET_PROCESSING_MODES), _worldPhases(MAX_PROFILED_WORLD_PHASES) { }
+        ~UpdateProfiler() { }
+
+        static uint64 Now()
+        {
+            return uint64(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+
+        std::atomic<bool> _enabled;
+        std::vector<Entry> _opcodes;
+        std::vector<Entry> _processing;
+        std::vector<Entry> _maps;
+        std::vector<Entry> _worldPhases;
+};
+
+#define sUpdateProfiler UpdateProfiler::instance()
+
+#endif
@@ -43,6 +43,8 @@
 #include "ScriptMgr.h"
 #include "WardenWin.h"
 #include "MoveSpline.h"
+#include "MapThreadChecker.h"
+#include "UpdateProfiler.h"
 
 namespace {
 
@@ -254,6 +256,20 @@ void WorldSession::LogUnprocessedTail(WorldPacket* packet)
     packet->print_storage();
 }
 
+void WorldSession::CallOpcodeHandler(OpcodeHandler const& opHandle, WorldPacket& packet)
+{
+    uint16 opcode = packet.GetOpcode();
+
+#ifdef TRINITY_DEBUG
+    // PROCESS_THREADSAFE handlers of players in world only run from Map::Update
+    MapThreadChecker::Scope mapThreadScope(opHandle.packetProcessing == PROCESS_THREADSAFE && _player && _player->IsInWorld() ? _player->GetMap() : NULL, opcode);
+#endif
+
+    uint64 start = sUpdateProfiler->Start();
+    (this->*opHandle.handler)(packet);
+    sUpdateProfiler->RecordOpcode(opcode, opHandle.packetProcessing, start);
+}
+
 /// Update the WorldSession (triggered by World update)
 bool WorldSession::Update(uint32 diff, PacketFilter& updater)
 {
@@ -317,7 +333,7 @@ bool WorldSession::Update(uint32 diff, PacketFilter& updater)
                         else if (_player->IsInWorld() && AntiDOS.EvaluateOpcode(*packet, currentTime))
                         {
                             sScriptMgr->OnPacketReceive(this, *packet);
-                            (this->*opHandle.handler)(*packet);
+                            CallOpcodeHandler(opHandle, *packet);
                             LogUnprocessedTail(packet);
                         }
                         // lag can cause STATUS_LOGGEDIN opcodes to arrive after the player started a transfer
@@ -330,7 +346,7 @@ bool WorldSession::Update(uint32 diff, PacketFilter& updater)
                         {
                             // not expected _player or must checked in packet handler
                             sScriptMgr->OnPacketReceive(this, *packet);
-                            (this->*opHandle.handler)(*packet);
+                            CallOpcodeHandler(opHandle, *packet);
                             LogUnprocessedTail(packet);
                         }
                         break;
@@ -342,7 +358,7 @@ bool WorldSession::Update(uint32 diff, PacketFilter& updater)
                         else if(AntiDOS.EvaluateOpcode(*packet, currentTime))
                         {
                             sScriptMgr->OnPacketReceive(this, *packet);
-                            (this->*opHandle.handler)(*packet);
+                            CallOpcodeHandler(opHandle, *packet);
                             LogUnprocessedTail(packet);
                         }
                         break;
@@ -362,7 +378,7 @@ bool WorldSession::Update(uint32 diff, PacketFilter& updater)
                         if (AntiDOS.EvaluateOpcode(*packet, currentTime))
                         {
                             sScriptMgr->OnPacketReceive(this, *packet);
-                            (this->*opHandle.handler)(*packet);
+                            CallOpcodeHandler(opHandle, *packet);
                             LogUnprocessedTail(packet);
                         }
                         break;
@@ -698,11 +714,9 @@ void WorldSession::SendAuthWaitQue(uint32 position)
     }
 }
 
-void WorldSession::LoadGlobalAccountData()
+void WorldSession::LoadGlobalAccountData(PreparedQueryResult result)
 {
-    PreparedStatement* stmt = CharacterDatabase.GetPreparedStatement(CHAR_SEL_ACCOUNT_DATA);
-    stmt->setUInt32(0, GetAccountId());
-    LoadAccountData(CharacterDatabase.Query(stmt), GLOBAL_CACHE_MASK);
+    LoadAccountData(result, GLOBAL_CACHE_MASK);
 }
 
 void WorldSession::LoadAccountData(PreparedQueryResult result, uint32 mask)
@@ -780,13 +794,11 @@ void WorldSession::SendAccountDataTimes(uint32 mask)
     SendPacket(&data);
 }
 
-void WorldSession::LoadTutorialsData()
+void WorldSession::LoadTutorialsData(PreparedQueryResult result)
 {
     memset(m_Tutorials, 0, sizeof(uint32) * MAX_ACCOUNT_TUTORIAL_VALUES);
 
-    PreparedStatement* stmt = CharacterDatabase.GetPreparedStatement(CHAR_SEL_TUTORIALS);
-    stmt->setUInt32(0, GetAccountId());
-    if (PreparedQueryResult result = CharacterDatabase.Query(stmt))
+    if (result)
         for (uint8 i = 0; i < MAX_ACCOUNT_TUTORIAL_VALUES; ++i)
             m_Tutorials[i] = (*result)[i].GetUInt32();
 
@@ -1258,6 +1270,18 @@ void WorldSession::LoadPermissions()
                    id, name.c_str(), realmID, secLevel);
 }
 
+void WorldSession::LoadPermissions(std::string const& accountName, PreparedQueryResult result)
+{
+    uint32 id = GetAccountId();
+    uint8 secLevel = GetSecurity();
+
+    _RBACData = new rbac::RBACData(id, accountName, realmID, secLevel);
+    _RBACData->LoadFromDBCallback(result);
+
+    TC_LOG_DEBUG("rbac", "WorldSession::LoadPermissions [AccountId: %u, Name: %s, realmId: %d, secLevel: %u]",
+                   id, accountName.c_str(), realmID, secLevel);
+}
+
 rbac::RBACData* WorldSession::GetRBACData()
 {
     return _RBACData;
@@ -1281,6 +1305,7 @@ void WorldSession::InvalidateRBACData()
                    _RBACData->GetId(), _RBACData->GetName().c_str(), realmID);
     delete _RBACData;
     _RBACData = NULL;
+    sWorld->InvalidateInWorldGameMasters();
 }
 
 bool WorldSession::DosProtection::EvaluateOpcode(WorldPacket& p, time_t time) const
@@ -27,18 +27,122 @@
 
 using boost::asio::ip::tcp;
 
+/// CMSG_AUTH_SESSION and the account it logs in, kept while the handshake waits for its queries
+struct AuthSession
+{
+    AuthSession(WorldPacket&& packet) : Packet(std::move(packet)) { }
+
+    uint32 Build = 0;
+    uint32 ServerId = 0;
+    uint32 LoginServerType = 0;
+    uint32 LocalChallenge = 0;
+    uint32 RegionId = 0;
+    uint32 BattlegroupId = 0;
+    uint32 RealmId = 0;
+    uint64 DosResponse = 0;
+    uint8 Digest[SHA_DIGEST_LENGTH];
+    std::string Account;
+    WorldPacket Packet;                                     // read position is at the addon data once parsed
+
+    // LOGIN_SEL_ACCOUNT_INFO_BY_NAME
+    uint32 AccountId = 0;
+    BigNumber SessionKey;
+    std::string LastIP;
+    bool IsLockedToIP = false;
+    uint8 Expansion = 0;
+    int64 MuteTime = 0;
+    LocaleConstant Locale = LOCALE_enUS;
+    uint32 Recruiter = 0;
+    std::string OS;
+    std::string Address;
+};
+
+enum AuthSessionLoginQueryIndex
+{
+    AUTH_SESSION_QUERY_GM_LEVEL,
+    AUTH_SESSION_QUERY_BANS,
+    AUTH_SESSION_QUERY_PREMIUM,
+    AUTH_SESSION_QUERY_RECRUITER,
+    AUTH_SESSION_QUERY_PERMISSIONS,
+
+    MAX_AUTH_SESSION_LOGIN_QUERY
+};
+
+enum AuthSessionCharacterQueryIndex
+{
+    AUTH_SESSION_QUERY_ACCOUNT_DATA,
+    AUTH_SESSION_QUERY_TUTORIALS,
+
+    MAX_AUTH_SESSION_CHARACTER_QUERY
+};
+
 WorldSocket::WorldSocket(tcp::socket&& socket)
     : Socket(std::move(socket)), _authSeed(rand32()), _OverSpeedPings(0), _worldSession(nullptr), _authed(false)
 {
     _headerBuffer.Resize(sizeof(ClientPktHeader));
 }
 
+WorldSocket::~WorldSocket()
+{
+    // Update keeps closed connections until their holders were executed, so holders are only
+    // still pending here when the network stops. The database async threads outlive the network
+    ReleaseQueryHolders(true);
+}
+
 void WorldSocket::Start()
 {
     AsyncRead();
     HandleSendAuthSession();
 }
 
+bool WorldSocket::Update()
+{
+    if (!BaseSocket::Update())
+    {
+        // the network thread drops the connection once the database is done with the holders we own
+        return !ReleaseQueryHolders(false);
+    }
+
+    ProcessQueryCallbacks();
+    return true;
+}
+
+void WorldSocket::ProcessQueryCallbacks()
+{
+    if (_accountInfoCallback.valid() && _accountInfoCallback.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+        HandleAuthSessionCallback(_accountInfoCallback.get());
+
+    if (_accountLoginDataCallback.valid() && _accountLoginDataCallback.wait_for(std::chrono::seconds(0)) == std::future_status::ready &&
+        _accountCharacterDataCallback.valid() && _accountCharacterDataCallback.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+    {
+        SQLQueryHolder* loginHolder = _accountLoginDataCallback.get();
+        SQLQueryHolder* characterHolder = _accountCharacterDataCallback.get();
+        HandleAuthSessionAccountCallback(loginHolder, characterHolder);
+        delete loginHolder;
+        delete characterHolder;
+    }
+}
+
+bool WorldSocket::ReleaseQueryHolders(bool wait)
+{
+    bool released = true;
+    for (QueryResultHolderFuture* callback : { &_accountLoginDataCallback, &_accountCharacterDataCallback })
+    {
+        if (!callback->valid())
+            continue;
+
+        if (!wait && callback->wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            released = false;
+            continue;
+        }
+
+        delete callback->get();
+    }
+
+    return released;
+}
+
 void WorldSocket::HandleSendAuthSession()
 {
     WorldPacket packet(SMSG_AUTH_CHALLENGE, 37);
@@ -111,13 +215,15 @@ void WorldSocket::ReadHandler()
         }
 
         // just received fresh new payload
-        if (!ReadDataHandler())
+        ReadDataHandlerResult result = ReadDataHandler();
+        _headerBuffer.Reset();
+        if (result != ReadDataHandlerResult::Ok)
         {
-            CloseSocket();
+            if (result != ReadDataHandlerResult::WaitingForQuery)
+                CloseSocket();
+
             return;
         }
-
-        _headerBuffer.Reset();
     }
 
     AsyncRead();
@@ -145,7 +251,7 @@ bool WorldSocket::ReadHeaderHandler()
     return true;
 }
 
-bool WorldSocket::ReadDataHandler()
+WorldSocket::ReadDataHandlerResult WorldSocket::ReadDataHandler()
 {
     ClientPktHeader* header = reinterpret_cast<ClientPktHeader*>(_headerBuffer.GetReadPointer());
 
@@ -162,19 +268,19 @@ bool WorldSocket::ReadDataHandler()
     {
         case CMSG_PING:
             LogOpcodeText(opcode, sessionGuard);
-            return HandlePing(packet);
+            return HandlePing(packet) ? ReadDataHandlerResult::Ok : ReadDataHandlerResult::Error;
         case CMSG_AUTH_SESSION:
             LogOpcodeText(opcode, sessionGuard);
-            if (_authed)
+            if (_authed || _authSession)
             {
                 // locking just to safely log offending user is probably overkill but we are disconnecting him anyway
-                if (sessionGuard.try_lock())
+                if (sessionGuard.try_lock() && _worldSession)
                     TC_LOG_ERROR("network", "WorldSocket::ProcessIncoming: received duplicate CMSG_AUTH_SESSION from %s", _worldSession->GetPlayerInfo().c_str());
-                return false;
+                return ReadDataHandlerResult::Error;
             }
 
             HandleAuthSession(packet);
-            break;
+            return ReadDataHandlerResult::WaitingForQuery;
         case CMSG_KEEP_ALIVE:
             LogOpcodeText(opcode, sessionGuard);
             break;
@@ -186,7 +292,7 @@ bool WorldSocket::ReadDataHandler()
             {
                 TC_LOG_ERROR("network.opcode", "ProcessIncoming: Client not authed opcode = %u", uint32(opcode));
                 CloseSocket();
-                return false;
+                return ReadDataHandlerResult::Error;
             }
 
             // Our Idle timer will reset on any non PING opcodes.
@@ -199,7 +305,7 @@ bool WorldSocket::ReadDataHandler()
         }
     }
 
-    return true;
+    return ReadDataHandlerResult::Ok;
 }
 
 void WorldSocket::LogOpcodeText(uint16 opcode, std::unique_lock<std::mutex> const& guard) const
@@ -256,48 +362,42 @@ void WorldSocket::SendPacket(WorldPacket const& packet)
 
 void WorldSocket::HandleAuthSession(WorldPacket& recvPacket)
 {
-    uint8 digest[SHA_DIGEST_LENGTH];
-    uint32 clientSeed;
-    uint8 security;
-    uint32 id;
-    LocaleConstant locale;
-    std::string account;
-    bool isPremium = false;
-    SHA1Hash sha;
-    uint32 clientBuild;
-    uint32 serverId, loginServerType, region, battlegroup, realmIndex;
-    uint64 unk4;
-    WorldPacket packet, SendAddonPacked;
-    BigNumber k;
-    bool wardenActive = sWorld->getBoolConfig(CONFIG_WARDEN_ENABLED);
+    _authSession.reset(new AuthSession(std::move(recvPacket)));
+    AuthSession* authSession = _authSession.get();
+    WorldPacket& packet = authSession->Packet;
 
     // Read the content of the packet
-    recvPacket >> clientBuild;
-    recvPacket >> serverId;                 // Used for GRUNT only
-    recvPacket >> account;
-    recvPacket >> loginServerType;          // 0 GRUNT, 1 Battle.net
-    recvPacket >> clientSeed;
-    recvPacket >> region >> battlegroup;    // Used for Battle.net only
-    recvPacket >> realmIndex;               // realmId from auth_database.realmlist table
-    recvPacket >> unk4;
-    recvPacket.read(digest, 20);
+    packet >> authSession->Build;
+    packet >> authSession->ServerId;                        // Used for GRUNT only
+    packet >> authSession->Account;
+    packet >> authSession->LoginServerType;                 // 0 GRUNT, 1 Battle.net
+    packet >> authSession->LocalChallenge;
+    packet >> authSession->RegionId >> authSession->BattlegroupId;  // Used for Battle.net only
+    packet >> authSession->RealmId;                         // realmId from auth_database.realmlist table
+    packet >> authSession->DosResponse;
+    packet.read(authSession->Digest, 20);
 
     TC_LOG_DEBUG("network", "WorldSocket::HandleAuthSession: client %u, serverId %u, account %s, loginServerType %u, clientseed %u, realmIndex %u",
-        clientBuild,
-        serverId,
-        account.c_str(),
-        loginServerType,
-        clientSeed,
-        realmIndex);
+        authSession->Build,
+        authSession->ServerId,
+        authSession->Account.c_str(),
+        authSession->LoginServerType,
+        authSession->LocalChallenge,
+        authSession->RealmId);
 
     // Get the account information from the auth database
     //         0           1        2       3          4         5       6          7   8
     // SELECT id, sessionkey, last_ip, locked, expansion, mutetime, locale, recruiter, os FROM account WHERE username = ?
     PreparedStatement* stmt = LoginDatabase.GetPreparedStatement(LOGIN_SEL_ACCOUNT_INFO_BY_NAME);
 
-    stmt->setString(0, account);
+    stmt->setString(0, authSession->Account);
 
-    PreparedQueryResult result = LoginDatabase.Query(stmt);
+    _accountInfoCallback = LoginDatabase.AsyncQuery(stmt);
+}
+
+void WorldSocket::HandleAuthSessionCallback(PreparedQueryResult result)
+{
+    AuthSession* authSession = _authSession.get();
 
     // Stop if the account is not found
     if (!result)
@@ -311,41 +411,43 @@ void WorldSocket::HandleAuthSession(WorldPacket& recvPacket)
 
     Field* fields = result->Fetch();
 
-    uint8 expansion = fields[4].GetUInt8();
+    authSession->Expansion = fields[4].GetUInt8();
     uint32 world_expansion = sWorld->getIntConfig(CONFIG_EXPANSION);
-    if (expansion > world_expansion)
-        expansion = world_expansion;
+    if (authSession->Expansion > world_expansion)
+        authSession->Expansion = world_expansion;
 
     // For hook purposes, we get Remoteaddress at this point.
-    std::string address = GetRemoteIpAddress().to_string();
+    authSession->Address = GetRemoteIpAddress().to_string();
+    std::string const& address = authSession->Address;
 
     // As we don't know if attempted login process by ip works, we update last_attempt_ip right away
-    stmt = LoginDatabase.GetPreparedStatement(LOGIN_UPD_LAST_ATTEMPT_IP);
+    PreparedStatement* stmt = LoginDatabase.GetPreparedStatement(LOGIN_UPD_LAST_ATTEMPT_IP);
 
     stmt->setString(0, address);
-    stmt->setString(1, account);
+    stmt->setString(1, authSession->Account);
 
     LoginDatabase.Execute(stmt);
     // This also allows to check for possible "hack" attempts on account
 
     // id has to be fetched at this point, so that first actual account response that fails can be logged
-    id = fields[0].GetUInt32();
+    uint32 id = fields[0].GetUInt32();
+    authSession->AccountId = id;
 
-    k.SetHexStr(fields[1].GetCString());
+    authSession->SessionKey.SetHexStr(fields[1].GetCString());
 
     // even if auth credentials are bad, try using the session key we have - client cannot read auth response error without it
-    _authCrypt.Init(&k);
+    _authCrypt.Init(&authSession->SessionKey);
 
     // First reject the connection if packet contains invalid data or realm state doesn't allow logging in
     if (sWorld->IsClosed())
     {
         SendAuthResponseError(AUTH_REJECT);
-        TC_LOG_ERROR("network", "WorldSocket::HandleAuthSession: World closed, denying client (%s).", GetRemoteIpAddress().to_string().c_str());
+        TC_LOG_ERROR("network", "WorldSocket::HandleAuthSession: World closed, denying client (%s).", address.c_str());
         DelayedCloseSocket();
         return;
     }
 
-    if (realmIndex != realmID)
+    if (authSession->RealmId != realmID)
     {
         SendAuthResponseError(REALM_LIST_REALM_NOT_FOUND);
         TC_LOG_ERROR("network", "WorldSocket::HandleAuthSession: Sent Auth Response (bad realm).");
@@ -353,13 +455,13 @@ void WorldSocket::HandleAuthSession(WorldPacket& recvPacket)
         return;
     }
 
-    std::string os = fields[8].GetString();
+    authSession->OS = fields[8].GetString();
 
     // Must be done before WorldSession is created
-    if (wardenActive && os != "Win" && os != "OSX")
+    if (sWorld->getBoolConfig(CONFIG_WARDEN_ENABLED) && authSession->OS != "Win" && authSession->OS != "OSX")
     {
         SendAuthResponseError(AUTH_REJECT);
-        TC_LOG_ERROR("network", "WorldSocket::HandleAuthSession: Client %s attempted to log in using invalid client OS (%s).", address.c_str(), os.c_str());
+        TC_LOG_ERROR("network", "WorldSocket::HandleAuthSession: Client %s attempted to log in using invalid client OS (%s).", address.c_str(), authSession->OS.c_str());
         DelayedCloseSocket();
         return;
     }
@@ -367,17 +469,18 @@ void WorldSocket::HandleAuthSession(WorldPacket& recvPacket)
     // Check that Key and account name are the same on client and server
     uint32 t = 0;
 
-    sha.UpdateData(account);
+    SHA1Hash sha;
+    sha.UpdateData(authSession->Account);
     sha.UpdateData((uint8*)&t, 4);
-    sha.UpdateData((uint8*)&clientSeed, 4);
+    sha.UpdateData((uint8*)&authSession->LocalChallenge, 4);
     sha.UpdateData((uint8*)&_authSeed, 4);
-    sha.UpdateBigNumbers(&k, NULL);
+    sha.UpdateBigNumbers(&authSession->SessionKey, NULL);
     sha.Finalize();
 
-    if (memcmp(sha.GetDigest(), digest, SHA_DIGEST_LENGTH) != 0)
+    if (memcmp(sha.GetDigest(), authSession->Digest, SHA_DIGEST_LENGTH) != 0)
     {
         SendAuthResponseError(AUTH_FAILED);
-        TC_LOG_ERROR("network", "WorldSocket::HandleAuthSession: Authentication failed for account: %u ('%s') address: %s", id, account.c_str(), address.c_str());
+        TC_LOG_ERROR("network", "WorldSocket::HandleAuthSession: Authentication failed for account: %u ('%s') address: %s", id, authSession->Account.c_str(), address.c_str());
         DelayedCloseSocket();
         return;
     }
@@ -396,50 +499,80 @@ void WorldSocket::HandleAuthSession(WorldPacket& recvPacket)
         }
     }
 
-    int64 mutetime = fields[5].GetInt64();
+    authSession->MuteTime = fields[5].GetInt64();
     //! Negative mutetime indicates amount of seconds to be muted effective on next login - which is now.
-    if (mutetime < 0)
+    if (authSession->MuteTime < 0)
     {
-        mutetime = time(NULL) + llabs(mutetime);
+        authSession->MuteTime = time(NULL) + llabs(authSession->MuteTime);
 
-        PreparedStatement* stmt = LoginDatabase.GetPreparedStatement(LOGIN_UPD_MUTE_TIME_LOGIN);
+        stmt = LoginDatabase.GetPreparedStatement(LOGIN_UPD_MUTE_TIME_LOGIN);
 
-        stmt->setInt64(0, mutetime);
+        stmt->setInt64(0, authSession->MuteTime);
         stmt->setUInt32(1, id);
 
         LoginDatabase.Execute(stmt);
     }
 
-    locale = LocaleConstant(fields[6].GetUInt8());
-    if (locale >= TOTAL_LOCALES)
-        locale = LOCALE_enUS;
+    authSession->Locale = LocaleConstant(fields[6].GetUInt8());
+    if (authSession->Locale >= TOTAL_LOCALES)
+        authSession->Locale = LOCALE_enUS;
+
+    authSession->Recruiter = fields[7].GetUInt32();
+
+    // Load everything else the session needs at once, the login and character databases are queried in parallel
+    SQLQueryHolder* loginHolder = new SQLQueryHolder();
+    loginHolder->SetSize(MAX_AUTH_SESSION_LOGIN_QUERY);
 
-    uint32 recruiter = fields[7].GetUInt32();
     // Checks gmlevel per Realm
     stmt = LoginDatabase.GetPreparedStatement(LOGIN_GET_GMLEVEL_BY_REALMID);
-
     stmt->setUInt32(0, id);
     stmt->setInt32(1, int32(realmID));
-
-    result = LoginDatabase.Query(stmt);
-
-    if (!result)
-        security = 0;
-    else
-    {
-        fields = result->Fetch();
-        security = fields[0].GetUInt8();
-    }
+    loginHolder->SetPreparedQuery(AUTH_SESSION_QUERY_GM_LEVEL, stmt);
 
     // Re-check account ban (same check as in auth)
     stmt = LoginDatabase.GetPreparedStatement(LOGIN_SEL_BANS);
-
     stmt->setUInt32(0, id);
     stmt->setString(1, address);
+    loginHolder->SetPreparedQuery(AUTH_SESSION_QUERY_BANS, stmt);
 
-    PreparedQueryResult banresult = LoginDatabase.Query(stmt);
+    stmt = LoginDatabase.GetPreparedStatement(LOGIN_SEL_PREMIUM);
+    stmt->setUInt32(0, id);
+    loginHolder->SetPreparedQuery(AUTH_SESSION_QUERY_PREMIUM, stmt);
+
+    stmt = LoginDatabase.GetPreparedStatement(LOGIN_SEL_ACCOUNT_RECRUITER);
+    stmt->setUInt32(0, id);
+    loginHolder->SetPreparedQuery(AUTH_SESSION_QUERY_RECRUITER, stmt);
+
+    stmt = LoginDatabase.GetPreparedStatement(LOGIN_SEL_RBAC_ACCOUNT_PERMISSIONS);
+    stmt->setUInt32(0, id);
+    stmt->setInt32(1, int32(realmID));
+    loginHolder->SetPreparedQuery(AUTH_SESSION_QUERY_PERMISSIONS, stmt);
+
+    SQLQueryHolder* characterHolder = new SQLQueryHolder();
+    characterHolder->SetSize(MAX_AUTH_SESSION_CHARACTER_QUERY);
+
+    stmt = CharacterDatabase.GetPreparedStatement(CHAR_SEL_ACCOUNT_DATA);
+    stmt->setUInt32(0, id);
+    characterHolder->SetPreparedQuery(AUTH_SESSION_QUERY_ACCOUNT_DATA, stmt);
+
+    stmt = CharacterDatabase.GetPreparedStatement(CHAR_SEL_TUTORIALS);
+    stmt->setUInt32(0, id);
+    characterHolder->SetPreparedQuery(AUTH_SESSION_QUERY_TUTORIALS, stmt);
 
-    if (banresult) // if account banned
+    _accountLoginDataCallback = LoginDatabase.DelayQueryHolder(loginHolder);
+    _accountCharacterDataCallback = CharacterDatabase.DelayQueryHolder(characterHolder);
+}
+
+void WorldSocket::HandleAuthSessionAccountCallback(SQLQueryHolder* loginHolder, SQLQueryHolder* characterHolder)
+{
+    AuthSession* authSession = _authSession.get();
+    uint32 id = authSession->AccountId;
+
+    uint8 security = 0;
+    if (PreparedQueryResult result = loginHolder->GetPreparedResult(AUTH_SESSION_QUERY_GM_LEVEL))
+        security = (*result)[0].GetUInt8();
+
+    if (loginHolder->GetPreparedResult(AUTH_SESSION_QUERY_BANS)) // if account banned
     {
         SendAuthResponseError(AUTH_BANNED);
         TC_LOG_ERROR("network", "WorldSocket::HandleAuthSession: Sent Auth Response (Account banned).");
@@ -449,14 +582,7 @@ void WorldSocket::HandleAuthSession(WorldPacket& recvPacket)
     }
 
     // Check premium
-    stmt = LoginDatabase.GetPreparedStatement(LOGIN_SEL_PREMIUM);
-    stmt->setUInt32(0, id);
-    PreparedQueryResult premresult = LoginDatabase.Query(stmt);
-
-    if (premresult)
-    {
-        isPremium = true;
-    }
+    bool isPremium = loginHolder->GetPreparedResult(AUTH_SESSION_QUERY_PREMIUM) != nullptr;
 
     // Check locked state for server
     AccountTypes allowedAccountType = sWorld->GetPlayerSecurityLimit();
@@ -471,43 +597,46 @@ void WorldSocket::HandleAuthSession(WorldPacket& recvPacket)
     }
 
     TC_LOG_DEBUG("network", "WorldSocket::HandleAuthSession: Client '%s' authenticated successfully from %s.",
-        account.c_str(),
-        address.c_str());
+        authSession->Account.c_str(),
+        authSession->Address.c_str());
 
     // Check if this user is by any chance a recruiter
-    stmt = LoginDatabase.GetPreparedStatement(LOGIN_SEL_ACCOUNT_RECRUITER);
-
-    stmt->setUInt32(0, id);
-
-    result = LoginDatabase.Query(stmt);
-
-    bool isRecruiter = false;
-    if (result)
-        isRecruiter = true;
+    bool isRecruiter = loginHolder->GetPreparedResult(AUTH_SESSION_QUERY_RECRUITER) != nullptr;
 
     // Update the last_ip in the database as it was successful for login
-    stmt = LoginDatabase.GetPreparedStatement(LOGIN_UPD_LAST_IP);
+    PreparedStatement* stmt = LoginDatabase.GetPreparedStatement(LOGIN_UPD_LAST_IP);
 
-    stmt->setString(0, address);
-    stmt->setString(1, account);
+    stmt->setString(0, authSession->Address);
+    stmt->setString(1, authSession->Account);
 
     LoginDatabase.Execute(stmt);
 
     // At this point, we can safely hook a successful login
     sScriptMgr->OnAccountLogin(id);
 
-    _authed = true;
-    _worldSession = new WorldSession(id, shared_from_this(), AccountTypes(security), isPremium, expansion, mutetime, locale, recruiter, isRecruiter);
-    _worldSession->LoadGlobalAccountData();
-    _worldSession->LoadTutorialsData();
-    _worldSession->ReadAddonsInfo(recvPacket);
-    _worldSession->LoadPermissions();
+    WorldSession* worldSession = new WorldSession(id, shared_from_this(), AccountTypes(security), isPremium, authSession->Expansion,
+        authSession->MuteTime, authSession->Locale, authSession->Recruiter, isRecruiter);
+    worldSession->LoadGlobalAccountData(characterHolder->GetPreparedResult(AUTH_SESSION_QUERY_ACCOUNT_DATA));
+    worldSession->LoadTutorialsData(characterHolder->GetPreparedResult(AUTH_SESSION_QUERY_TUTORIALS));
+    worldSession->ReadAddonsInfo(authSession->Packet);
+    worldSession->LoadPermissions(authSession->Account, loginHolder->GetPreparedResult(AUTH_SESSION_QUERY_PERMISSIONS));
 
     // Initialize Warden system only if it is enabled by config
-    if (wardenActive)
-        _worldSession->InitWarden(&k, os);
+    if (sWorld->getBoolConfig(CONFIG_WARDEN_ENABLED))
+        worldSession->InitWarden(&authSession->SessionKey, authSession->OS);
+
+    {
+        std::lock_guard<std::mutex> sessionGuard(_worldSessionLock);
+        _authed = true;
+        _worldSession = worldSession;
+    }
+
+    sWorld->AddSession(worldSession);
+
+    _authSession.reset();
 
-    sWorld->AddSession(_worldSession);
+    // resume reading, packets that arrived with CMSG_AUTH_SESSION are still in the read buffer
+    ReadHandler();
 }
 
 void WorldSocket::SendAuthResponseError(uint8 code)
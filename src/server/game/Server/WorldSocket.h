@@ -27,6 +27,7 @@
 #include "WorldPacket.h"
 #include "WorldSession.h"
 #include <chrono>
+#include <memory>
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/buffer.hpp>
 
@@ -45,23 +46,36 @@ struct ClientPktHeader
 
 #pragma pack(pop)
 
+struct AuthSession;
+
 class WorldSocket : public Socket<WorldSocket>
 {
+    typedef Socket<WorldSocket> BaseSocket;
+
 public:
     WorldSocket(tcp::socket&& socket);
+    ~WorldSocket();
 
     WorldSocket(WorldSocket const& right) = delete;
     WorldSocket& operator=(WorldSocket const& right) = delete;
 
     void Start() override;
+    bool Update() override;
 
     void SendPacket(WorldPacket const& packet);
 
 protected:
+    enum class ReadDataHandlerResult
+    {
+        Ok = 0,
+        Error = 1,
+        WaitingForQuery = 2                                 // reading is paused until the query callback resumes it
+    };
+
     void OnClose() override;
     void ReadHandler() override;
     bool ReadHeaderHandler();
-    bool ReadDataHandler();
+    ReadDataHandlerResult ReadDataHandler();
 
 private:
     /// writes network.opcode log
@@ -70,7 +84,13 @@ private:
     /// sends and logs network.opcode without accessing WorldSession
     void SendPacketAndLogOpcode(WorldPacket const& packet);
     void HandleSendAuthSession();
+    /// login handshake, the queries run on the database async threads and the callbacks are resumed in Update()
     void HandleAuthSession(WorldPacket& recvPacket);
+    void HandleAuthSessionCallback(PreparedQueryResult result);
+    void HandleAuthSessionAccountCallback(SQLQueryHolder* loginHolder, SQLQueryHolder* characterHolder);
+    void ProcessQueryCallbacks();
+    /// deletes the query holders that were executed, true once none is pending anymore. wait blocks until they are executed
+    bool ReleaseQueryHolders(bool wait);
     void SendAuthResponseError(uint8 code);
 
     bool HandlePing(WorldPacket& recvPacket);
@@ -85,6 +105,11 @@ private:
     WorldSession* _worldSession;
     bool _authed;
 
+    std::unique_ptr<AuthSession> _authSession;
+    PreparedQueryResultFuture _accountInfoCallback;
+    QueryResultHolderFuture _accountLoginDataCallback;
+    QueryResultHolderFuture _accountCharacterDataCallback;
+
     MessageBuffer _headerBuffer;
     MessageBuffer _packetBuffer;
 };
@@ -22,6 +22,7 @@
 #include "SpellAuraDefines.h"
 #include "SpellInfo.h"
 #include "Unit.h"
+#include "ObjectPool.h"
 
 class SpellInfo;
 struct SpellModifier;
@@ -61,6 +62,7 @@ class AuraApplication
         void _InitFlags(Unit* caster, uint8 effMask);
         void _HandleEffect(uint8 effIndex, bool apply);
     public:
+        TRINITY_POOLED_OBJECT(AuraApplication)
 
         Unit* GetTarget() const { return _target; }
         Aura* GetBase() const { return _base; }
@@ -279,6 +281,8 @@ class UnitAura : public Aura
     protected:
         explicit UnitAura(SpellInfo const* spellproto, uint8 effMask, WorldObject* owner, Unit* caster, int32 *baseAmount, Item* castItem, ObjectGuid casterGUID);
     public:
+        TRINITY_POOLED_OBJECT(UnitAura)
+
         void _ApplyForTarget(Unit* target, Unit* caster, AuraApplication * aurApp) override;
         void _UnapplyForTarget(Unit* target, Unit* caster, AuraApplication * aurApp) override;
 
@@ -300,6 +304,8 @@ class DynObjAura : public Aura
     protected:
         explicit DynObjAura(SpellInfo const* spellproto, uint8 effMask, WorldObject* owner, Unit* caster, int32 *baseAmount, Item* castItem, ObjectGuid casterGUID);
     public:
+        TRINITY_POOLED_OBJECT(DynObjAura)
+
         void Remove(AuraRemoveMode removeMode = AURA_REMOVE_BY_DEFAULT) override;
 
         void FillTargetMap(std::map<Unit*, uint8> & targets, Unit* caster) override;
@@ -1210,10 +1210,52 @@ void Spell::SelectImplicitAreaTargets(SpellEffIndex effIndex, SpellImplicitTarge
             Trinity::Containers::RandomResizeList(targets, maxTargets);
         }
 
+        // trace the LOS of all unit targets to the center together instead of one ray per target and effect
+        bool batchLos = !IsLineOfSightIgnored();
+        for (uint32 i = 0; i < MAX_SPELL_EFFECTS && batchLos; ++i)
+            if ((effMask & (1 << i)) && m_spellInfo->Effects[i].Effect == SPELL_EFFECT_RESURRECT_NEW)
+                batchLos = false;
+
+        std::vector<VMAP::LineOfSightRay> rays;
+        std::vector<Unit*> rayTargets;
+        if (batchLos)
+        {
+            for (std::list<WorldObject*>::iterator itr = targets.begin(); itr != targets.end(); ++itr)
+            {
+                Unit* unitTarget = (*itr)->ToUnit();
+                if (!unitTarget || !unitTarget->IsInWorld())
+                    continue;
+
+                VMAP::LineOfSightRay ray;
+                ray.x1 = unitTarget->GetPositionX();
+                ray.y1 = unitTarget->GetPositionY();
+                ray.z1 = unitTarget->GetPositionZ() + 2.0f;
+                ray.x2 = center->GetPositionX();
+                ray.y2 = center->GetPositionY();
+                ray.z2 = center->GetPositionZ() + 2.0f;
+                ray.phaseMask = unitTarget->GetPhaseMask();
+                ray.inLineOfSight = true;
+                rays.push_back(ray);
+                rayTargets.push_back(unitTarget);
+            }
+
+            if (!rays.empty())
+                m_caster->GetMap()->isInLineOfSight(rays.data(), rays.size());
+        }
+
+        std::size_t ray = 0;
         for (std::list<WorldObject*>::iterator itr = targets.begin(); itr != targets.end(); ++itr)
         {
             if (Unit* unitTarget = (*itr)->ToUnit())
-                AddUnitTarget(unitTarget, effMask, false, true, center);
+            {
+                if (ray < rayTargets.size() && rayTargets[ray] == unitTarget)
+                {
+                    if (rays[ray++].inLineOfSight)
+                        AddUnitTarget(unitTarget, effMask, false, true, center, false);
+                }
+                else
+                    AddUnitTarget(unitTarget, effMask, false, true, center);
+            }
             else if (GameObject* gObjTarget = (*itr)->ToGameObject())
                 AddGOTarget(gObjTarget, effMask);
         }
@@ -2006,10 +2048,10 @@ void Spell::CleanupTargetList()
     m_delayMoment = 0;
 }
 
-void Spell::AddUnitTarget(Unit* target, uint32 effectMask, bool checkIfValid /*= true*/, bool implicit /*= true*/, Position const* losPosition /*= nullptr*/)
+void Spell::AddUnitTarget(Unit* target, uint32 effectMask, bool checkIfValid /*= true*/, bool implicit /*= true*/, Position const* losPosition /*= nullptr*/, bool checkLos /*= true*/)
 {
     for (uint32 effIndex = 0; effIndex < MAX_SPELL_EFFECTS; ++effIndex)
-        if (!m_spellInfo->Effects[effIndex].IsEffect() || !CheckEffectTarget(target, effIndex, losPosition))
+        if (!m_spellInfo->Effects[effIndex].IsEffect() || !CheckEffectTarget(target, effIndex, losPosition, checkLos))
             effectMask &= ~(1 << effIndex);
 
     // no effects left
@@ -6466,7 +6508,20 @@ CurrentSpellTypes Spell::GetCurrentContainer() const
         return(CURRENT_GENERIC_SPELL);
 }
 
-bool Spell::CheckEffectTarget(Unit const* target, uint32 eff, Position const* losPosition) const
+bool Spell::IsLineOfSightIgnored() const
+{
+    // check for ignore LOS on the effect itself
+    if (m_spellInfo->HasAttribute(SPELL_ATTR2_CAN_TARGET_NOT_IN_LOS) || DisableMgr::IsDisabledFor(DISABLE_TYPE_SPELL, m_spellInfo->Id, NULL, SPELL_DISABLE_LOS))
+        return true;
+
+    // if spell is triggered, need to check for LOS disable on the aura triggering it and inherit that behaviour
+    if (IsTriggered() && m_triggeredByAuraSpell && (m_triggeredByAuraSpell->HasAttribute(SPELL_ATTR2_CAN_TARGET_NOT_IN_LOS) || DisableMgr::IsDisabledFor(DISABLE_TYPE_SPELL, m_triggeredByAuraSpell->Id, NULL, SPELL_DISABLE_LOS)))
+        return true;
+
+    return false;
+}
+
+bool Spell::CheckEffectTarget(Unit const* target, uint32 eff, Position const* losPosition, bool checkLos /*= true*/) const
 {
     switch (m_spellInfo->Effects[eff].ApplyAuraName)
     {
@@ -6488,12 +6543,8 @@ bool Spell::CheckEffectTarget(Unit const* target, uint32 eff, Position const* lo
             break;
     }
 
-    // check for ignore LOS on the effect itself
-    if (m_spellInfo->HasAttribute(SPELL_ATTR2_CAN_TARGET_NOT_IN_LOS) || DisableMgr::IsDisabledFor(DISABLE_TYPE_SPELL, m_spellInfo->Id, NULL, SPELL_DISABLE_LOS))
-        return true;
-
-    // if spell is triggered, need to check for LOS disable on the aura triggering it and inherit that behaviour
-    if (IsTriggered() && m_triggeredByAuraSpell && (m_triggeredByAuraSpell->HasAttribute(SPELL_ATTR2_CAN_TARGET_NOT_IN_LOS) || DisableMgr::IsDisabledFor(DISABLE_TYPE_SPELL, m_triggeredByAuraSpell->Id, NULL, SPELL_DISABLE_LOS)))
+    // the caller already checked LOS, see SelectImplicitAreaTargets
+    if (!checkLos || IsLineOfSightIgnored())
         return true;
 
     /// @todo shit below shouldn't be here, but it's temporary
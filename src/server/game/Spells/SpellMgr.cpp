@@ -346,7 +346,7 @@ bool IsDiminishingReturnsGroupDurationLimited(DiminishingGroup group)
     }
 }
 
-SpellMgr::SpellMgr() { }
+SpellMgr::SpellMgr() : mSpellProcGeneration(0) { }
 
 SpellMgr::~SpellMgr()
 {
@@ -583,7 +583,7 @@ uint32 SpellMgr::GetSpellWithRank(uint32 spell_id, uint32 rank, bool strict) con
 
 SpellRequiredMapBounds SpellMgr::GetSpellsRequiredForSpellBounds(uint32 spell_id) const
 {
-    return mSpellReq.equal_range(spell_id);
+    return mSpellReqIndex.GetBounds(spell_id);
 }
 
 SpellsRequiringSpellMapBounds SpellMgr::GetSpellsRequiringSpellBounds(uint32 spell_id) const
@@ -646,12 +646,14 @@ SpellSpellGroupMapBounds SpellMgr::GetSpellSpellGroupMapBounds(uint32 spell_id)
 
 bool SpellMgr::IsSpellMemberOfSpellGroup(uint32 spellid, SpellGroup groupid) const
 {
-    SpellSpellGroupMapBounds spellGroup = GetSpellSpellGroupMapBounds(spellid);
-    for (SpellSpellGroupMap::const_iterator itr = spellGroup.first; itr != spellGroup.second; ++itr)
-    {
-        if (itr->second == groupid)
+    if (spellid + 1 >= mSpellSpellGroupIndex.Offsets.size())
+        return false;
+
+    // ranks are already resolved to their first rank when the index is built
+    for (uint32 i = mSpellSpellGroupIndex.Offsets[spellid]; i < mSpellSpellGroupIndex.Offsets[spellid + 1]; ++i)
+        if (mSpellSpellGroupIndex.Groups[i] == groupid)
             return true;
-    }
+
     return false;
 }
 
@@ -775,10 +777,21 @@ SpellGroupStackRule SpellMgr::GetSpellGroupStackRule(SpellGroup group) const
 
 SpellProcEventEntry const* SpellMgr::GetSpellProcEvent(uint32 spellId) const
 {
-    SpellProcEventMap::const_iterator itr = mSpellProcEventMap.find(spellId);
-    if (itr != mSpellProcEventMap.end())
-        return &itr->second;
-    return NULL;
+    return spellId < mSpellProcEventIndex.size() ? mSpellProcEventIndex[spellId] : NULL;
+}
+
+// Proc flags an aura of this spell reacts to in Unit::ProcDamageAndSpellFor, 0 if it can never proc there
+uint32 SpellMgr::GetSpellProcEventFlags(SpellInfo const* spellInfo) const
+{
+    // auras with a spell_proc entry are handled by the new proc system
+    if (GetSpellProcEntry(spellInfo->Id))
+        return 0;
+
+    SpellProcEventEntry const* spellProcEvent = GetSpellProcEvent(spellInfo->Id);
+    if (spellProcEvent && spellProcEvent->procFlags)
+        return spellProcEvent->procFlags;
+
+    return spellInfo->ProcFlags;
 }
 
 bool SpellMgr::IsSpellProcEventCanTriggeredBy(SpellInfo const* spellProto, SpellProcEventEntry const* spellProcEvent, uint32 EventProcFlag, SpellInfo const* procSpell, uint32 procFlags, uint32 procExtra, bool active) const
@@ -940,10 +953,7 @@ bool SpellMgr::IsSpellProcEventCanTriggeredBy(SpellInfo const* spellProto, Spell
 
 SpellProcEntry const* SpellMgr::GetSpellProcEntry(uint32 spellId) const
 {
-    SpellProcMap::const_iterator itr = mSpellProcMap.find(spellId);
-    if (itr != mSpellProcMap.end())
-        return &itr->second;
-    return NULL;
+    return spellId < mSpellProcIndex.size() ? mSpellProcIndex[spellId] : NULL;
 }
 
 bool SpellMgr::CanSpellTriggerProcOnEvent(SpellProcEntry const& procEntry, ProcEventInfo& eventInfo) const
@@ -1013,33 +1023,14 @@ bool SpellMgr::CanSpellTriggerProcOnEvent(SpellProcEntry const& procEntry, ProcE
 
 SpellBonusEntry const* SpellMgr::GetSpellBonusData(uint32 spellId) const
 {
-    // Lookup data
-    SpellBonusMap::const_iterator itr = mSpellBonusMap.find(spellId);
-    if (itr != mSpellBonusMap.end())
-        return &itr->second;
-    // Not found, try lookup for 1 spell rank if exist
-    if (uint32 rank_1 = GetFirstSpellInChain(spellId))
-    {
-        SpellBonusMap::const_iterator itr2 = mSpellBonusMap.find(rank_1);
-        if (itr2 != mSpellBonusMap.end())
-            return &itr2->second;
-    }
-    return NULL;
+    // first rank fallback is resolved when the index is built
+    return spellId < mSpellBonusIndex.size() ? mSpellBonusIndex[spellId] : NULL;
 }
 
 SpellThreatEntry const* SpellMgr::GetSpellThreatEntry(uint32 spellID) const
 {
-    SpellThreatMap::const_iterator itr = mSpellThreatMap.find(spellID);
-    if (itr != mSpellThreatMap.end())
-        return &itr->second;
-    else
-    {
-        uint32 firstSpell = GetFirstSpellInChain(spellID);
-        itr = mSpellThreatMap.find(firstSpell);
-        if (itr != mSpellThreatMap.end())
-            return &itr->second;
-    }
-    return NULL;
+    // first rank fallback is resolved when the index is built
+    return spellID < mSpellThreatIndex.size() ? mSpellThreatIndex[spellID] : NULL;
 }
 
 SkillLineAbilityMapBounds SpellMgr::GetSkillLineAbilityMapBounds(uint32 spell_id) const
@@ -1071,6 +1062,13 @@ bool SpellMgr::IsArenaAllowedEnchancment(uint32 ench_id) const
 
 const std::vector<int32>* SpellMgr::GetSpellLinked(int32 spell_id) const
 {
+    // most spells have no links at all, reject them with a single indexed load
+    uint32 absId = abs(spell_id);
+    uint8 slot = absId / SPELL_LINKED_MAX_SPELLS * 2 + (spell_id < 0 ? 1 : 0);
+    absId %= SPELL_LINKED_MAX_SPELLS;
+    if (absId >= mSpellLinkedIndex.size() || !(mSpellLinkedIndex[absId] & (1 << slot)))
+        return NULL;
+
     SpellLinkedMap::const_iterator itr = mSpellLinkedMap.find(spell_id);
     return itr != mSpellLinkedMap.end() ? &(itr->second) : NULL;
 }
@@ -1114,7 +1112,7 @@ SpellAreaForAuraMapBounds SpellMgr::GetSpellAreaForAuraMapBounds(uint32 spell_id
 
 SpellAreaForAreaMapBounds SpellMgr::GetSpellAreaForAreaMapBounds(uint32 area_id) const
 {
-    return mSpellAreaForAreaMap.equal_range(area_id);
+    return mSpellAreaForAreaIndex.GetBounds(area_id);
 }
 
 bool SpellArea::IsFitToRequirements(Player const* player, uint32 newZone, uint32 newArea) const
@@ -1219,6 +1217,86 @@ bool SpellArea::IsFitToRequirements(Player const* player, uint32 newZone, uint32
     return true;
 }
 
+template<class Store>
+void SpellMgr::BuildSpellIndex(std::vector<typename Store::mapped_type const*>& index, Store const& store, bool firstRankFallback) const
+{
+    index.assign(GetSpellInfoStoreSize(), NULL);
+    if (store.empty())
+        return;
+
+    for (typename Store::const_iterator itr = store.begin(); itr != store.end(); ++itr)
+        if (itr->first < index.size())
+            index[itr->first] = &itr->second;
+
+    if (!firstRankFallback)
+        return;
+
+    // higher ranks without own entry share the data of their first rank
+    for (uint32 spellId = 0; spellId < index.size(); ++spellId)
+        if (!index[spellId] && mSpellInfoMap[spellId])
+            if (uint32 firstRank = GetFirstSpellInChain(spellId))
+                if (firstRank != spellId)
+                    index[spellId] = index[firstRank];
+}
+
+void SpellMgr::BuildSpellSpellGroupIndex()
+{
+    uint32 const storeSize = GetSpellInfoStoreSize();
+    mSpellSpellGroupIndex.Offsets.assign(storeSize + 1, 0);
+    mSpellSpellGroupIndex.Groups.clear();
+    if (mSpellSpellGroup.empty())
+        return;
+
+    for (uint32 spellId = 0; spellId < storeSize; ++spellId)
+    {
+        mSpellSpellGroupIndex.Offsets[spellId] = mSpellSpellGroupIndex.Groups.size();
+        if (!mSpellInfoMap[spellId])
+            continue;
+
+        SpellSpellGroupMapBounds spellGroup = GetSpellSpellGroupMapBounds(spellId);
+        for (SpellSpellGroupMap::const_iterator itr = spellGroup.first; itr != spellGroup.second; ++itr)
+            mSpellSpellGroupIndex.Groups.push_back(itr->second);
+    }
+
+    mSpellSpellGroupIndex.Offsets[storeSize] = mSpellSpellGroupIndex.Groups.size();
+    mSpellSpellGroupIndex.Groups.shrink_to_fit();
+}
+
+template<class T, class Store>
+void SpellMgr::BuildSpellMultiIndex(SpellMultiIndex<T>& index, Store const& store, uint32 size)
+{
+    index.Offsets.assign(size + 1, 0);
+    index.Entries.clear();
+
+    // the store is ordered by key, count the entries of each key and turn the counts into offsets
+    for (typename Store::const_iterator itr = store.begin(); itr != store.end(); ++itr)
+    {
+        if (itr->first >= size)
+            continue;
+
+        ++index.Offsets[itr->first + 1];
+        index.Entries.push_back(std::make_pair(itr->first, itr->second));
+    }
+
+    for (uint32 key = 0; key < size; ++key)
+        index.Offsets[key + 1] += index.Offsets[key];
+
+    index.Entries.shrink_to_fit();
+}
+
+void SpellMgr::BuildSpellLinkedIndex()
+{
+    mSpellLinkedIndex.assign(GetSpellInfoStoreSize(), 0);
+    for (SpellLinkedMap::const_iterator itr = mSpellLinkedMap.begin(); itr != mSpellLinkedMap.end(); ++itr)
+    {
+        uint32 absId = abs(itr->first);
+        uint8 slot = absId / SPELL_LINKED_MAX_SPELLS * 2 + (itr->first < 0 ? 1 : 0);
+        absId %= SPELL_LINKED_MAX_SPELLS;
+        if (absId < mSpellLinkedIndex.size())
+            mSpellLinkedIndex[absId] |= 1 << slot;
+    }
+}
+
 void SpellMgr::UnloadSpellInfoChains()
 {
     for (SpellChainMap::iterator itr = mSpellChains.begin(); itr != mSpellChains.end(); ++itr)
@@ -1410,6 +1488,7 @@ void SpellMgr::LoadSpellRequired()
 
     mSpellsReqSpell.clear();                                   // need for reload case
     mSpellReq.clear();                                         // need for reload case
+    BuildSpellMultiIndex(mSpellReqIndex, mSpellReq, GetSpellInfoStoreSize());
 
     //                                                   0        1
     QueryResult result = WorldDatabase.Query("SELECT spell_id, req_spell from spell_required");
@@ -1461,6 +1540,8 @@ void SpellMgr::LoadSpellRequired()
         ++count;
     } while (result->NextRow());
 
+    BuildSpellMultiIndex(mSpellReqIndex, mSpellReq, GetSpellInfoStoreSize());
+
     TC_LOG_INFO("server.loading", ">> Loaded %u spell required records in %u ms", count, GetMSTimeDiffToNow(oldMSTime));
 
 }
@@ -1711,6 +1792,7 @@ void SpellMgr::LoadSpellGroups()
 
     mSpellSpellGroup.clear();                                  // need for reload case
     mSpellGroupSpell.clear();
+    BuildSpellSpellGroupIndex();
 
     //                                                0     1
     QueryResult result = WorldDatabase.Query("SELECT id, spell_id FROM spell_group");
@@ -1782,6 +1864,8 @@ void SpellMgr::LoadSpellGroups()
         }
     }
 
+    BuildSpellSpellGroupIndex();
+
     TC_LOG_INFO("server.loading", ">> Loaded %u spell group definitions in %u ms", count, GetMSTimeDiffToNow(oldMSTime));
 }
 
@@ -1833,6 +1917,8 @@ void SpellMgr::LoadSpellProcEvents()
     uint32 oldMSTime = getMSTime();
 
     mSpellProcEventMap.clear();                             // need for reload case
+    mSpellProcEventIndex.clear();
+    ++mSpellProcGeneration;
 
     //                                                0      1           2                3                 4                 5                 6          7       8        9             10
     QueryResult result = WorldDatabase.Query("SELECT entry, SchoolMask, SpellFamilyName, SpellFamilyMask0, SpellFamilyMask1, SpellFamilyMask2, procFlags, procEx, ppmRate, CustomChance, Cooldown FROM spell_proc_event");
@@ -1912,6 +1998,8 @@ void SpellMgr::LoadSpellProcEvents()
     }
     while (result->NextRow());
 
+    BuildSpellIndex(mSpellProcEventIndex, mSpellProcEventMap, false);
+
     TC_LOG_INFO("server.loading", ">> Loaded %u extra spell proc event conditions in %u ms", count, GetMSTimeDiffToNow(oldMSTime));
 }
 
@@ -1920,6 +2008,8 @@ void SpellMgr::LoadSpellProcs()
     uint32 oldMSTime = getMSTime();
 
     mSpellProcMap.clear();                             // need for reload case
+    mSpellProcIndex.clear();
+    ++mSpellProcGeneration;
 
     //                                                 0        1           2                3                 4                 5                 6         7              8               9        10              11             12      13        14
     QueryResult result = WorldDatabase.Query("SELECT spellId, schoolMask, spellFamilyName, spellFamilyMask0, spellFamilyMask1, spellFamilyMask2, typeMask, spellTypeMask, spellPhaseMask, hitMask, attributesMask, ratePerMinute, chance, cooldown, charges FROM spell_proc");
@@ -2053,6 +2143,8 @@ void SpellMgr::LoadSpellProcs()
     }
     while (result->NextRow());
 
+    BuildSpellIndex(mSpellProcIndex, mSpellProcMap, false);
+
     TC_LOG_INFO("server.loading", ">> Loaded %u spell proc conditions and data in %u ms", count, GetMSTimeDiffToNow(oldMSTime));
 }
 
@@ -2061,6 +2153,7 @@ void SpellMgr::LoadSpellBonusess()
     uint32 oldMSTime = getMSTime();
 
     mSpellBonusMap.clear();                             // need for reload case
+    mSpellBonusIndex.clear();
 
     //                                                0      1             2          3         4
     QueryResult result = WorldDatabase.Query("SELECT entry, direct_bonus, dot_bonus, ap_bonus, ap_dot_bonus FROM spell_bonus_data");
@@ -2092,6 +2185,8 @@ void SpellMgr::LoadSpellBonusess()
         ++count;
     } while (result->NextRow());
 
+    BuildSpellIndex(mSpellBonusIndex, mSpellBonusMap, true);
+
     TC_LOG_INFO("server.loading", ">> Loaded %u extra spell bonus data in %u ms", count, GetMSTimeDiffToNow(oldMSTime));
 }
 
@@ -2100,6 +2195,7 @@ void SpellMgr::LoadSpellThreats()
     uint32 oldMSTime = getMSTime();
 
     mSpellThreatMap.clear();                                // need for reload case
+    mSpellThreatIndex.clear();
 
     //                                                0      1        2       3
     QueryResult result = WorldDatabase.Query("SELECT entry, flatMod, pctMod, apPctMod FROM spell_threat");
@@ -2131,6 +2227,8 @@ void SpellMgr::LoadSpellThreats()
         ++count;
     } while (result->NextRow());
 
+    BuildSpellIndex(mSpellThreatIndex, mSpellThreatMap, true);
+
     TC_LOG_INFO("server.loading", ">> Loaded %u SpellThreatEntries in %u ms", count, GetMSTimeDiffToNow(oldMSTime));
 }
 
@@ -2302,6 +2400,7 @@ void SpellMgr::LoadSpellLinked()
     uint32 oldMSTime = getMSTime();
 
     mSpellLinkedMap.clear();    // need for reload case
+    mSpellLinkedIndex.clear();
 
     //                                                0              1             2
     QueryResult result = WorldDatabase.Query("SELECT spell_trigger, spell_effect, type FROM spell_linked_spell");
@@ -2353,6 +2452,8 @@ void SpellMgr::LoadSpellLinked()
         ++count;
     } while (result->NextRow());
 
+    BuildSpellLinkedIndex();
+
     TC_LOG_INFO("server.loading", ">> Loaded %u linked spells in %u ms", count, GetMSTimeDiffToNow(oldMSTime));
 }
 
@@ -2547,6 +2648,8 @@ void SpellMgr::LoadSpellAreas()
     mSpellAreaForQuestMap.clear();
     mSpellAreaForQuestEndMap.clear();
     mSpellAreaForAuraMap.clear();
+    mSpellAreaForAreaMap.clear();
+    BuildSpellMultiIndex(mSpellAreaForAreaIndex, mSpellAreaForAreaMap, 0);
 
     //                                                  0     1         2              3               4                 5          6          7       8         9
     QueryResult result = WorldDatabase.Query("SELECT spell, area, quest_start, quest_start_status, quest_end_status, quest_end, aura_spell, racemask, gender, autocast FROM spell_area");
@@ -2723,6 +2826,9 @@ void SpellMgr::LoadSpellAreas()
         ++count;
     } while (result->NextRow());
 
+    // AreaTable.dbc is indexed by area flag, size the index by the highest area id used instead
+    BuildSpellMultiIndex(mSpellAreaForAreaIndex, mSpellAreaForAreaMap, mSpellAreaForAreaMap.empty() ? 0 : mSpellAreaForAreaMap.rbegin()->first + 1);
+
     TC_LOG_INFO("server.loading", ">> Loaded %u spell area requirements in %u ms", count, GetMSTimeDiffToNow(oldMSTime));
 }
 
@@ -505,6 +505,26 @@ struct SpellArea
     bool IsFitToRequirements(Player const* player, uint32 newZone, uint32 newArea) const;
 };
 
+// key -> [Offsets[key], Offsets[key + 1]) range in the entries copied from a multimap, in the multimap's order
+template<class T>
+struct SpellMultiIndex
+{
+    typedef std::vector<std::pair<uint32, T> > EntryList;
+    typedef typename EntryList::const_iterator const_iterator;
+    typedef std::pair<const_iterator, const_iterator> Bounds;
+
+    std::vector<uint32> Offsets;
+    EntryList Entries;
+
+    Bounds GetBounds(uint32 key) const
+    {
+        if (key + 1 >= Offsets.size())
+            return Bounds(Entries.end(), Entries.end());
+
+        return Bounds(Entries.begin() + Offsets[key], Entries.begin() + Offsets[key + 1]);
+    }
+};
+
 typedef std::multimap<uint32, SpellArea> SpellAreaMap;
 typedef std::multimap<uint32, SpellArea const*> SpellAreaForQuestMap;
 typedef std::multimap<uint32, SpellArea const*> SpellAreaForAuraMap;
@@ -512,7 +532,8 @@ typedef std::multimap<uint32, SpellArea const*> SpellAreaForAreaMap;
 typedef std::pair<SpellAreaMap::const_iterator, SpellAreaMap::const_iterator> SpellAreaMapBounds;
 typedef std::pair<SpellAreaForQuestMap::const_iterator, SpellAreaForQuestMap::const_iterator> SpellAreaForQuestMapBounds;
 typedef std::pair<SpellAreaForAuraMap::const_iterator, SpellAreaForAuraMap::const_iterator>  SpellAreaForAuraMapBounds;
-typedef std::pair<SpellAreaForAreaMap::const_iterator, SpellAreaForAreaMap::const_iterator>  SpellAreaForAreaMapBounds;
+typedef SpellMultiIndex<SpellArea const*> SpellAreaForAreaIndex;     // area_id -> spell areas, built from SpellAreaForAreaMap
+typedef SpellAreaForAreaIndex::Bounds SpellAreaForAreaMapBounds;
 
 // Spell rank chain  (accessed using SpellMgr functions)
 struct SpellChainNode
@@ -528,7 +549,8 @@ typedef std::unordered_map<uint32, SpellChainNode> SpellChainMap;
 
 //                   spell_id  req_spell
 typedef std::multimap<uint32, uint32> SpellRequiredMap;
-typedef std::pair<SpellRequiredMap::const_iterator, SpellRequiredMap::const_iterator> SpellRequiredMapBounds;
+typedef SpellMultiIndex<uint32> SpellRequiredIndex;                 // spell_id -> req_spell, built from SpellRequiredMap
+typedef SpellRequiredIndex::Bounds SpellRequiredMapBounds;
 
 //                   req_spell spell_id
 typedef std::multimap<uint32, uint32> SpellsRequiringSpellMap;
@@ -578,6 +600,23 @@ typedef std::vector<SpellInfo*> SpellInfoMap;
 
 typedef std::map<int32, std::vector<int32> > SpellLinkedMap;
 
+// Dense lookup tables indexed by spell id, built once from the maps above at load
+// so per-cast lookups are a single indexed load instead of a tree/hash search
+typedef std::vector<SpellProcEventEntry const*> SpellProcEventIndex;
+typedef std::vector<SpellProcEntry const*> SpellProcIndex;
+typedef std::vector<SpellBonusEntry const*> SpellBonusIndex;
+typedef std::vector<SpellThreatEntry const*> SpellThreatIndex;
+
+// spell_id -> [offsets[spell_id], offsets[spell_id + 1]) range in the groups array
+struct SpellSpellGroupIndex
+{
+    std::vector<uint32> Offsets;
+    std::vector<SpellGroup> Groups;
+};
+
+// spell_id -> bitmask of SpellLinkedType slots present in SpellLinkedMap
+typedef std::vector<uint8> SpellLinkedIndex;
+
 bool IsPrimaryProfessionSkill(uint32 skill);
 
 inline bool IsProfessionSkill(uint32 skill)
@@ -662,6 +701,9 @@ class SpellMgr
 
         // Spell proc event table
         SpellProcEventEntry const* GetSpellProcEvent(uint32 spellId) const;
+        uint32 GetSpellProcEventFlags(SpellInfo const* spellInfo) const;
+        // changes on every (re)load of spell_proc_event and spell_proc, units rebuild their proc aura index then
+        uint32 GetSpellProcGeneration() const { return mSpellProcGeneration; }
         bool IsSpellProcEventCanTriggeredBy(SpellInfo const* spellProto, SpellProcEventEntry const* spellProcEvent, uint32 EventProcFlag, SpellInfo const* procSpell, uint32 procFlags, uint32 procExtra, bool active) const;
 
         // Spell proc table
@@ -708,6 +750,13 @@ class SpellMgr
     private:
         SpellInfo* _GetSpellInfo(uint32 spellId) { return spellId < GetSpellInfoStoreSize() ?  mSpellInfoMap[spellId] : NULL; }
 
+        template<class Store>
+        void BuildSpellIndex(std::vector<typename Store::mapped_type const*>& index, Store const& store, bool firstRankFallback) const;
+        void BuildSpellSpellGroupIndex();
+        template<class T, class Store>
+        static void BuildSpellMultiIndex(SpellMultiIndex<T>& index, Store const& store, uint32 size);
+        void BuildSpellLinkedIndex();
+
     // Modifiers
     public:
 
@@ -744,6 +793,7 @@ class SpellMgr
         SpellChainMap              mSpellChains;
         SpellsRequiringSpellMap    mSpellsReqSpell;
         SpellRequiredMap           mSpellReq;
+        SpellRequiredIndex         mSpellReqIndex;
         SpellLearnSkillMap         mSpellLearnSkills;
         SpellLearnSpellMap         mSpellLearnSpells;
         SpellTargetPositionMap     mSpellTargetPositions;
@@ -756,6 +806,13 @@ class SpellMgr
         SpellThreatMap             mSpellThreatMap;
         SpellPetAuraMap            mSpellPetAuraMap;
         SpellLinkedMap             mSpellLinkedMap;
+        SpellProcEventIndex        mSpellProcEventIndex;
+        SpellProcIndex             mSpellProcIndex;
+        uint32                     mSpellProcGeneration;
+        SpellBonusIndex            mSpellBonusIndex;
+        SpellThreatIndex           mSpellThreatIndex;
+        SpellSpellGroupIndex       mSpellSpellGroupIndex;
+        SpellLinkedIndex           mSpellLinkedIndex;
         SpellEnchantProcEventMap   mSpellEnchantProcEventMap;
         EnchantCustomAttribute     mEnchantCustomAttr;
         SpellAreaMap               mSpellAreaMap;
@@ -763,6 +820,7 @@ class SpellMgr
         SpellAreaForQuestMap       mSpellAreaForQuestEndMap;
         SpellAreaForAuraMap        mSpellAreaForAuraMap;
         SpellAreaForAreaMap        mSpellAreaForAreaMap;
+        SpellAreaForAreaIndex      mSpellAreaForAreaIndex;
         SkillLineAbilityMap        mSkillLineAbilityMap;
         PetLevelupSpellMap         mPetLevelupSpellMap;
         PetDefaultSpellsMap        mPetDefaultSpellsMap;           // only spells not listed in related mPetLevelupSpellMap entry
@@ -60,6 +60,7 @@
 #include "TicketMgr.h"
 #include "TransportMgr.h"
 #include "Unit.h"
+#include "UpdateProfiler.h"
 #include "VMapFactory.h"
 #include "WardenCheckMgr.h"
 #include "WaypointMovementGenerator.h"
@@ -93,6 +94,8 @@ World::World()
     m_maxQueuedSessionCount = 0;
     m_PlayerCount = 0;
     m_MaxPlayerCount = 0;
+    m_inWorldGameMastersValid = true;
+    m_inWorldPlayersVersion = 0;
     m_NextDailyQuestReset = 0;
     m_NextWeeklyQuestReset = 0;
     m_NextMonthlyQuestReset = 0;
@@ -1238,7 +1241,11 @@ void World::LoadConfigSettings(bool reload)
     m_bool_configs[CONFIG_SHOW_BAN_IN_WORLD] = sConfigMgr->GetBoolDefault("ShowBanInWorld", false);
     m_int_configs[CONFIG_INTERVAL_LOG_UPDATE] = sConfigMgr->GetIntDefault("RecordUpdateTimeDiffInterval", 60000);
     m_int_configs[CONFIG_MIN_LOG_UPDATE] = sConfigMgr->GetIntDefault("MinRecordUpdateTimeDiff", 100);
+    m_bool_configs[CONFIG_UPDATE_PROFILER_ENABLE] = sConfigMgr->GetBoolDefault("Profiler.Enable", false);
     m_int_configs[CONFIG_NUMTHREADS] = sConfigMgr->GetIntDefault("MapUpdate.Threads", 1);
+    m_int_configs[CONFIG_PATHFINDING_THREADS] = sConfigMgr->GetIntDefault("mmap.asyncPathFindingThreads", 0);
+    m_int_configs[CONFIG_GRID_PRELOAD_THREADS] = sConfigMgr->GetIntDefault("MapUpdate.GridPreloadThreads", 0);
+    m_int_configs[CONFIG_GRID_PRELOAD_LOOKAHEAD] = sConfigMgr->GetIntDefault("MapUpdate.GridPreloadLookAhead", 10);
     m_int_configs[CONFIG_MAX_RESULTS_LOOKUP_COMMANDS] = sConfigMgr->GetIntDefault("Command.LookupMaxResults", 0);
 
     // Warden
@@ -1435,6 +1442,25 @@ void World::SetInitialWorldSettings()
         exit(1);
     }
 
+    ///- Load the vmap models of frequently used maps up front
+    std::string preloadMaps = sConfigMgr->GetStringDefault("vmap.preloadMaps", "");
+    if (!preloadMaps.empty())
+    {
+        if (VMAP::VMapManager2* vmmgr2 = dynamic_cast<VMAP::VMapManager2*>(VMAP::VMapFactory::createOrGetVMapManager()))
+        {
+            TC_LOG_INFO("server.loading", "Preloading vmaps of maps %s...", preloadMaps.c_str());
+            uint32 oldMSTime = getMSTime();
+
+            std::vector<uint32> mapIds;
+            Tokenizer tokens(preloadMaps, ',');
+            for (Tokenizer::const_iterator itr = tokens.begin(); itr != tokens.end(); ++itr)
+                mapIds.push_back(uint32(atoi(*itr)));
+
+            vmmgr2->preloadMaps(m_dataPath + "vmaps", mapIds, sConfigMgr->GetIntDefault("vmap.preloadThreads", 4));
+            TC_LOG_INFO("server.loading", ">> Preloaded vmaps in %u ms", GetMSTimeDiffToNow(oldMSTime));
+        }
+    }
+
     ///- Initialize pool manager
     sPoolMgr->Initialize();
 
@@ -1466,6 +1492,9 @@ void World::SetInitialWorldSettings()
     LoadDBCStores(m_dataPath);
     DetectDBCLang();
 
+    sUpdateProfiler->Initialize(sMapStore.GetNumRows());
+    sUpdateProfiler->SetEnabled(getBoolConfig(CONFIG_UPDATE_PROFILER_ENABLE));
+
     TC_LOG_INFO("server.loading", "Loading SpellInfo store...");
     sSpellMgr->LoadSpellInfoStore();
 
@@ -2066,6 +2095,8 @@ void World::LoadAutobroadcasts()
 /// Update the World !
 void World::Update(uint32 diff)
 {
+    uint64 updateStart = sUpdateProfiler->Start();
+
     m_updateTime = diff;
 
     if (m_int_configs[CONFIG_INTERVAL_LOG_UPDATE] && diff > m_int_configs[CONFIG_MIN_LOG_UPDATE])
@@ -2153,7 +2184,10 @@ void World::Update(uint32 diff)
 
     /// <li> Handle session updates when the timer has passed
     ResetTimeDiffRecord();
+    uint64 phaseStart = sUpdateProfiler->Start();
     UpdateSessions(diff);
+    UpdateInWorldGameMasters();
+    sUpdateProfiler->RecordWorldPhase(PROFILE_WORLD_SESSIONS, phaseStart);
     RecordTimeDiff("UpdateSessions");
 
     /// <li> Handle weather updates when the timer has passed
@@ -2200,7 +2234,9 @@ void World::Update(uint32 diff)
     /// <li> Handle all other objects
     ///- Update objects when the timer has passed (maps, transport, creatures, ...)
     ResetTimeDiffRecord();
+    phaseStart = sUpdateProfiler->Start();
     sMapMgr->Update(diff);
+    sUpdateProfiler->RecordWorldPhase(PROFILE_WORLD_MAPS, phaseStart);
     RecordTimeDiff("UpdateMapMgr");
 
     if (sWorld->getBoolConfig(CONFIG_AUTOBROADCAST))
@@ -2212,13 +2248,19 @@ void World::Update(uint32 diff)
         }
     }
 
+    phaseStart = sUpdateProfiler->Start();
     sBattlegroundMgr->Update(diff);
+    sUpdateProfiler->RecordWorldPhase(PROFILE_WORLD_BATTLEGROUNDS, phaseStart);
     RecordTimeDiff("UpdateBattlegroundMgr");
 
+    phaseStart = sUpdateProfiler->Start();
     sOutdoorPvPMgr->Update(diff);
+    sUpdateProfiler->RecordWorldPhase(PROFILE_WORLD_OUTDOORPVP, phaseStart);
     RecordTimeDiff("UpdateOutdoorPvPMgr");
 
+    phaseStart = sUpdateProfiler->Start();
     sBattlefieldMgr->Update(diff);
+    sUpdateProfiler->RecordWorldPhase(PROFILE_WORLD_BATTLEFIELDS, phaseStart);
     RecordTimeDiff("BattlefieldMgr");
 
     ///- Delete all characters which have been deleted X days before
@@ -2228,11 +2270,15 @@ void World::Update(uint32 diff)
         Player::DeleteOldCharacters();
     }
 
+    phaseStart = sUpdateProfiler->Start();
     sLFGMgr->Update(diff);
+    sUpdateProfiler->RecordWorldPhase(PROFILE_WORLD_LFG, phaseStart);
     RecordTimeDiff("UpdateLFGMgr");
 
     // execute callbacks from sql queries that were queued recently
+    phaseStart = sUpdateProfiler->Start();
     ProcessQueryCallbacks();
+    sUpdateProfiler->RecordWorldPhase(PROFILE_WORLD_QUERY_CALLBACKS, phaseStart);
     RecordTimeDiff("ProcessQueryCallbacks");
 
     ///- Erase corpses once every 20 minutes
@@ -2268,6 +2314,8 @@ void World::Update(uint32 diff)
     ProcessCliCommands();
 
     sScriptMgr->OnWorldUpdate(diff);
+
+    sUpdateProfiler->RecordWorldPhase(PROFILE_WORLD_UPDATE, updateStart);
 }
 
 void World::ForceGameEventUpdate()
@@ -2278,19 +2326,109 @@ void World::ForceGameEventUpdate()
     m_timers[WUPDATE_EVENTS].Reset();
 }
 
+void World::AddInWorldPlayer(Player* player)
+{
+    // may load the permissions from the DB, not while holding the lock
+    bool gameMaster = player->GetSession()->HasPermission(rbac::RBAC_PERM_RECEIVE_GLOBAL_GM_TEXTMESSAGE);
+
+    std::lock_guard<std::mutex> lock(m_inWorldPlayersLock);
+    m_inWorldPlayers.push_back(player);
+    m_inWorldPlayersByZone[player->GetZoneUpdateId()].push_back(player);
+    ++m_inWorldPlayersVersion;
+
+    if (gameMaster)
+        m_inWorldGameMasters.push_back(player);
+}
+
+static void RemoveFromInWorldPlayerList(std::vector<Player*>& players, Player* player)
+{
+    // order doesn't matter, swap with the last one
+    std::vector<Player*>::iterator itr = std::find(players.begin(), players.end(), player);
+    if (itr == players.end())
+        return;
+
+    *itr = players.back();
+    players.pop_back();
+}
+
+void World::RemoveInWorldPlayer(Player* player)
+{
+    std::lock_guard<std::mutex> lock(m_inWorldPlayersLock);
+    RemoveFromInWorldPlayerList(m_inWorldPlayers, player);
+    RemoveFromInWorldPlayerList(m_inWorldGameMasters, player);
+    ++m_inWorldPlayersVersion;
+
+    std::unordered_map<uint32, InWorldPlayerList>::iterator zone = m_inWorldPlayersByZone.find(player->GetZoneUpdateId());
+    if (zone != m_inWorldPlayersByZone.end())
+    {
+        RemoveFromInWorldPlayerList(zone->second, player);
+        if (zone->second.empty())
+            m_inWorldPlayersByZone.erase(zone);
+    }
+}
+
+void World::UpdateInWorldPlayerZone(Player* player, uint32 oldZone, uint32 newZone)
+{
+    std::lock_guard<std::mutex> lock(m_inWorldPlayersLock);
+    std::unordered_map<uint32, InWorldPlayerList>::iterator zone = m_inWorldPlayersByZone.find(oldZone);
+    if (zone != m_inWorldPlayersByZone.end())
+    {
+        RemoveFromInWorldPlayerList(zone->second, player);
+        if (zone->second.empty())
+            m_inWorldPlayersByZone.erase(zone);
+    }
+
+    m_inWorldPlayersByZone[newZone].push_back(player);
+}
+
+// HasPermission may load the permissions from the DB, so they are checked on a copy without holding the lock.
+// Runs on the world thread between map updates, players can't leave the world meanwhile
+void World::UpdateInWorldGameMasters()
+{
+    if (m_inWorldGameMastersValid.exchange(true))
+        return;
+
+    InWorldPlayerList players;
+    uint32 version;
+    {
+        std::lock_guard<std::mutex> lock(m_inWorldPlayersLock);
+        players = m_inWorldPlayers;
+        version = m_inWorldPlayersVersion;
+    }
+
+    InWorldPlayerList gameMasters;
+    for (Player* player : players)
+        if (player->GetSession()->HasPermission(rbac::RBAC_PERM_RECEIVE_GLOBAL_GM_TEXTMESSAGE))
+            gameMasters.push_back(player);
+
+    std::lock_guard<std::mutex> lock(m_inWorldPlayersLock);
+    if (version != m_inWorldPlayersVersion)
+    {
+        // a player entered or left the world meanwhile, try again next update
+        m_inWorldGameMastersValid = false;
+        return;
+    }
+
+    m_inWorldGameMasters.swap(gameMasters);
+}
+
+// permissions invalidated since the GM list was collected are only loaded again by UpdateInWorldGameMasters
+static bool CanReceiveGlobalGMMessages(WorldSession* session)
+{
+    rbac::RBACData* rbac = session->GetRBACData();
+    return rbac && rbac->HasPermission(rbac::RBAC_PERM_RECEIVE_GLOBAL_GM_TEXTMESSAGE);
+}
+
 /// Send a packet to all players (except self if mentioned)
 void World::SendGlobalMessage(WorldPacket* packet, WorldSession* self, uint32 team)
 {
-    SessionMap::const_iterator itr;
-    for (itr = m_sessions.begin(); itr != m_sessions.end(); ++itr)
+    std::lock_guard<std::mutex> lock(m_inWorldPlayersLock);
+    for (Player* player : m_inWorldPlayers)
     {
-        if (itr->second &&
-            itr->second->GetPlayer() &&
-            itr->second->GetPlayer()->IsInWorld() &&
-            itr->second != self &&
-            (team == 0 || itr->second->GetPlayer()->GetTeam() == team))
+        if (player->GetSession() != self &&
+            (team == 0 || player->GetTeam() == team))
         {
-            itr->second->SendPacket(packet);
+            player->GetSession()->SendPacket(packet);
         }
     }
 }
@@ -2298,16 +2436,12 @@ void World::SendGlobalMessage(WorldPacket* packet, WorldSession* self, uint32 te
 /// Send a packet to all GMs (except self if mentioned)
 void World::SendGlobalGMMessage(WorldPacket* packet, WorldSession* self, uint32 team)
 {
-    for (SessionMap::const_iterator itr = m_sessions.begin(); itr != m_sessions.end(); ++itr)
+    std::lock_guard<std::mutex> lock(m_inWorldPlayersLock);
+    for (Player* player : m_inWorldGameMasters)
     {
-        // check if session and can receive global GM Messages and its not self
-        WorldSession* session = itr->second;
-        if (!session || session == self || !session->HasPermission(rbac::RBAC_PERM_RECEIVE_GLOBAL_GM_TEXTMESSAGE))
-            continue;
-
-        // Player should be in world
-        Player* player = session->GetPlayer();
-        if (!player || !player->IsInWorld())
+        // check if session can still receive global GM Messages and its not self
+        WorldSession* session = player->GetSession();
+        if (session == self || !CanReceiveGlobalGMMessages(session))
             continue;
 
         // Send only to same team, if team is given
@@ -2368,12 +2502,10 @@ void World::SendWorldText(uint32 string_id, ...)
 
     Trinity::WorldWorldTextBuilder wt_builder(string_id, &ap);
     Trinity::LocalizedPacketListDo<Trinity::WorldWorldTextBuilder> wt_do(wt_builder);
-    for (SessionMap::const_iterator itr = m_sessions.begin(); itr != m_sessions.end(); ++itr)
     {
-        if (!itr->second || !itr->second->GetPlayer() || !itr->second->GetPlayer()->IsInWorld())
-            continue;
-
-        wt_do(itr->second->GetPlayer());
+        std::lock_guard<std::mutex> lock(m_inWorldPlayersLock);
+        for (Player* player : m_inWorldPlayers)
+            wt_do(player);
     }
 
     va_end(ap);
@@ -2387,19 +2519,16 @@ void World::SendGMText(uint32 string_id, ...)
 
     Trinity::WorldWorldTextBuilder wt_builder(string_id, &ap);
     Trinity::LocalizedPacketListDo<Trinity::WorldWorldTextBuilder> wt_do(wt_builder);
-    for (SessionMap::const_iterator itr = m_sessions.begin(); itr != m_sessions.end(); ++itr)
     {
-        // Session should have permissions to receive global gm messages
-        WorldSession* session = itr->second;
-        if (!session || !session->HasPermission(rbac::RBAC_PERM_RECEIVE_GLOBAL_GM_TEXTMESSAGE))
-            continue;
-
-        // Player should be in world
-        Player* player = session->GetPlayer();
-        if (!player || !player->IsInWorld())
-            continue;
+        std::lock_guard<std::mutex> lock(m_inWorldPlayersLock);
+        for (Player* player : m_inWorldGameMasters)
+        {
+            // Session should still have permissions to receive global gm messages
+            if (!CanReceiveGlobalGMMessages(player->GetSession()))
+                continue;
 
-        wt_do(player);
+            wt_do(player);
+        }
     }
 
     va_end(ap);
@@ -2427,18 +2556,18 @@ void World::SendGlobalText(const char* text, WorldSession* self)
 bool World::SendZoneMessage(uint32 zone, WorldPacket* packet, WorldSession* self, uint32 team)
 {
     bool foundPlayerToSend = false;
-    SessionMap::const_iterator itr;
 
-    for (itr = m_sessions.begin(); itr != m_sessions.end(); ++itr)
+    std::lock_guard<std::mutex> lock(m_inWorldPlayersLock);
+    std::unordered_map<uint32, InWorldPlayerList>::const_iterator players = m_inWorldPlayersByZone.find(zone);
+    if (players == m_inWorldPlayersByZone.end())
+        return false;
+
+    for (Player* player : players->second)
     {
-        if (itr->second &&
-            itr->second->GetPlayer() &&
-            itr->second->GetPlayer()->IsInWorld() &&
-            itr->second->GetPlayer()->GetZoneId() == zone &&
-            itr->second != self &&
-            (team == 0 || itr->second->GetPlayer()->GetTeam() == team))
+        if (player->GetSession() != self &&
+            (team == 0 || player->GetTeam() == team))
         {
-            itr->second->SendPacket(packet);
+            player->GetSession()->SendPacket(packet);
             foundPlayerToSend = true;
         }
     }
@@ -3170,13 +3299,18 @@ void World::LoadDBVersion()
 
 void World::UpdateAreaDependentAuras()
 {
-    SessionMap::const_iterator itr;
-    for (itr = m_sessions.begin(); itr != m_sessions.end(); ++itr)
-        if (itr->second && itr->second->GetPlayer() && itr->second->GetPlayer()->IsInWorld())
-        {
-            itr->second->GetPlayer()->UpdateAreaDependentAuras(itr->second->GetPlayer()->GetAreaId());
-            itr->second->GetPlayer()->UpdateZoneDependentAuras(itr->second->GetPlayer()->GetZoneId());
-        }
+    // aura updates may add or remove players, work on a copy
+    InWorldPlayerList players;
+    {
+        std::lock_guard<std::mutex> lock(m_inWorldPlayersLock);
+        players = m_inWorldPlayers;
+    }
+
+    for (Player* player : players)
+    {
+        player->UpdateAreaDependentAuras(player->GetAreaId());
+        player->UpdateZoneDependentAuras(player->GetZoneId());
+    }
 }
 
 void World::LoadWorldStates()
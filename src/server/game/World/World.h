@@ -32,6 +32,7 @@
 
 #include <atomic>
 #include <map>
+#include <mutex>
 #include <set>
 #include <list>
 
@@ -184,6 +185,7 @@ enum WorldBoolConfigs
     CONFIG_EXTERNAL_MAIL_ENABLE,
     CONFIG_GM_BLUE_CHAT_ENABLE,
     CONFIG_SPECIAL_CODE,
+    CONFIG_UPDATE_PROFILER_ENABLE,
     BOOL_CONFIG_VALUE_COUNT
 };
 
@@ -320,6 +322,9 @@ enum WorldIntConfigs
     CONFIG_ENABLE_SINFO_LOGIN,
     CONFIG_PLAYER_ALLOW_COMMANDS,
     CONFIG_NUMTHREADS,
+    CONFIG_PATHFINDING_THREADS,
+    CONFIG_GRID_PRELOAD_THREADS,
+    CONFIG_GRID_PRELOAD_LOOKAHEAD,
     CONFIG_LOGDB_CLEARINTERVAL,
     CONFIG_LOGDB_CLEARTIME,
     CONFIG_CLIENTCACHE_VERSION,
@@ -726,6 +731,13 @@ class World
         bool SendZoneMessage(uint32 zone, WorldPacket* packet, WorldSession* self = nullptr, uint32 team = 0);
         void SendZoneText(uint32 zone, const char *text, WorldSession* self = nullptr, uint32 team = 0);
 
+        /// Broadcast indexes of the players in world, maintained by Player::AddToWorld, RemoveFromWorld and UpdateZone
+        void AddInWorldPlayer(Player* player);
+        void RemoveInWorldPlayer(Player* player);
+        void UpdateInWorldPlayerZone(Player* player, uint32 oldZone, uint32 newZone);
+        /// Permissions changed, the receivers of GM broadcasts are collected again by the next world update
+        void InvalidateInWorldGameMasters() { m_inWorldGameMastersValid = false; }
+
         uint32 pvp_ranks[HKRANKMAX];
 
         /// Are we in the middle of a shutdown?
@@ -882,6 +894,17 @@ class World
         uint32 m_currentTime;
 
         SessionMap m_sessions;
+
+        // players in world, zone is the one of Player::UpdateZone, team is not indexed as it changes in cross faction battlegrounds
+        typedef std::vector<Player*> InWorldPlayerList;
+        InWorldPlayerList m_inWorldPlayers;
+        InWorldPlayerList m_inWorldGameMasters;              // with RBAC_PERM_RECEIVE_GLOBAL_GM_TEXTMESSAGE
+        std::unordered_map<uint32, InWorldPlayerList> m_inWorldPlayersByZone;
+        std::atomic<bool> m_inWorldGameMastersValid;
+        uint32 m_inWorldPlayersVersion;                     // changed by every AddInWorldPlayer and RemoveInWorldPlayer
+        std::mutex m_inWorldPlayersLock;                    // players enter and leave from the map update threads
+
+        void UpdateInWorldGameMasters();
         typedef std::unordered_map<uint32, time_t> DisconnectMap;
         DisconnectMap m_disconnects;
         uint32 m_maxActiveSessionCount;
@@ -33,6 +33,8 @@ EndScriptData */
 #include "GossipDef.h"
 #include "Transport.h"
 #include "Language.h"
+#include "SpellAuraEffects.h"
+#include "UpdateProfiler.h"
 
 #include <fstream>
 
@@ -93,6 +95,10 @@ public:
             { "los",           rbac::RBAC_PERM_COMMAND_DEBUG_LOS,           false, &HandleDebugLoSCommand,              "", NULL },
             { "moveflags",     rbac::RBAC_PERM_COMMAND_DEBUG_MOVEFLAGS,     false, &HandleDebugMoveflagsCommand,        "", NULL },
             { "transport",     rbac::RBAC_PERM_COMMAND_DEBUG_TRANSPORT,     false, &HandleDebugTransportCommand,        "", NULL },
+            { "procstats",     rbac::RBAC_PERM_COMMAND_DEBUG_PROCSTATS,     false, &HandleDebugProcStatsCommand,        "", NULL },
+            { "aurapools",     rbac::RBAC_PERM_COMMAND_DEBUG_AURAPOOLS,     true,  &HandleDebugAuraPoolsCommand,        "", NULL },
+            { "querycache",    rbac::RBAC_PERM_COMMAND_DEBUG_QUERYCACHE,    true,  &HandleDebugQueryCacheCommand,       "", NULL },
+            { "profiler",      rbac::RBAC_PERM_COMMAND_DEBUG_PROFILER,      true,  &HandleDebugProfilerCommand,         "", NULL },
             { NULL,            0,                                     false, NULL,                                "", NULL }
         };
         static ChatCommand commandTable[] =
@@ -1391,6 +1397,158 @@ public:
         handler->PSendSysMessage("Transport %s %s", transport->GetName().c_str(), start ? "started" : "stopped");
         return true;
     }
+
+    static bool HandleDebugProcStatsCommand(ChatHandler* handler, char const* /*args*/)
+    {
+        Unit* unit = handler->getSelectedUnit();
+        if (!unit)
+            unit = handler->GetSession()->GetPlayer();
+
+        MapProcStats stats = unit->GetMap()->GetLastUpdateProcStats();
+        handler->PSendSysMessage("Map %u last update: %u proc passes, %u auras checked, %u auras skipped by the proc index",
+            unit->GetMapId(), stats.Passes, stats.CandidateAuras, stats.SkippedAuras);
+        handler->PSendSysMessage("Unit %s: %u applied auras, %u indexed for procs, proc mask 0x%08X",
+            unit->GetName().c_str(), uint32(unit->GetAppliedAuras().size()), unit->GetProcAuraCount(), unit->GetProcAuraMask());
+        return true;
+    }
+
+    static void SendObjectPoolStats(ChatHandler* handler, char const* name, ObjectPoolStats const& stats)
+    {
+        handler->PSendSysMessage("%-18s allocated: " UI64FMTD ", freed: " UI64FMTD ", live: " UI64FMTD ", slabs: " UI64FMTD " (" UI64FMTD " bytes), released: " UI64FMTD,
+            name, stats.Allocations, stats.Deallocations, stats.Allocations - stats.Deallocations, stats.Slabs, stats.Slabs * stats.SlabSize, stats.SlabReleases);
+    }
+
+    static bool HandleDebugAuraPoolsCommand(ChatHandler* handler, char const* /*args*/)
+    {
+        SendObjectPoolStats(handler, "UnitAura", ObjectPool<UnitAura>::GetStats());
+        SendObjectPoolStats(handler, "DynObjAura", ObjectPool<DynObjAura>::GetStats());
+        SendObjectPoolStats(handler, "AuraApplication", ObjectPool<AuraApplication>::GetStats());
+        SendObjectPoolStats(handler, "AuraEffect", ObjectPool<AuraEffect>::GetStats());
+        return true;
+    }
+
+    static bool HandleDebugQueryCacheCommand(ChatHandler* handler, char const* /*args*/)
+    {
+        static char const* const queryNames[MAX_MAP_QUERY_TYPES] = { "Height", "AreaInfo", "Liquid", "LineOfSight" };
+
+        MapQueryCacheStats stats = MapQueryCache::GetStats();
+        for (uint8 i = 0; i < MAX_MAP_QUERY_TYPES; ++i)
+        {
+            uint64 lookups = stats.Hits[i] + stats.Misses[i];
+            handler->PSendSysMessage("%-12s hits: " UI64FMTD ", misses: " UI64FMTD " (%.1f%% hit rate), bypassed near models: " UI64FMTD,
+                queryNames[i], stats.Hits[i], stats.Misses[i], lookups ? float(stats.Hits[i]) * 100.0f / lookups : 0.0f, stats.Bypasses[i]);
+        }
+
+        handler->PSendSysMessage("Caches cleared after vmap tile changes: " UI64FMTD, stats.Invalidations);
+        return true;
+    }
+    static void SendProfilerStats(ChatHandler* handler, std::string const& name, ProfilerStats const& stats)
+    {
+        handler->PSendSysMessage("%-32s calls: " UI64FMTD ", total: " UI64FMTD " us, avg: " UI64FMTD " us, max: " UI64FMTD " us",
+            name.c_str(), stats.Calls, stats.TotalTime / 1000, stats.Calls ? stats.TotalTime / 1000 / stats.Calls : 0, stats.MaxTime / 1000);
+    }
+
+    // sorts the ids by their total time and sends the first count non empty ones
+    static void SendTopProfilerStats(ChatHandler* handler, std::vector<std::pair<std::string, ProfilerStats>>& entries, uint32 count)
+    {
+        std::sort(entries.begin(), entries.end(), [](std::pair<std::string, ProfilerStats> const& a, std::pair<std::string, ProfilerStats> const& b)
+        {
+            return a.second.TotalTime > b.second.TotalTime;
+        });
+
+        for (uint32 i = 0; i < entries.size() && i < count && entries[i].second.Calls; ++i)
+            SendProfilerStats(handler, entries[i].first, entries[i].second);
+    }
+
+    static bool HandleDebugProfilerCommand(ChatHandler* handler, char const* args)
+    {
+        char* actionStr = strtok((char*)args, " ");
+        std::string action = actionStr ? actionStr : "show";
+
+        if (action == "on" || action == "off")
+        {
+            sUpdateProfiler->SetEnabled(action == "on");
+            handler->PSendSysMessage("Update profiler %s.", action == "on" ? "enabled" : "disabled");
+            return true;
+        }
+
+        if (action == "reset")
+        {
+            sUpdateProfiler->Reset();
+            handler->SendSysMessage("Update profiler statistics reset.");
+            return true;
+        }
+
+        if (action == "dump")
+        {
+            char* fileName = strtok(NULL, " ");
+            if (!fileName)
+                return false;
+
+            // only plain file names, the dump always goes to the logs directory
+            std::string name = fileName;
+            if (name.find_first_of("/\\:") != std::string::npos || name.find("..") != std::string::npos)
+            {
+                handler->PSendSysMessage("Invalid file name %s, directories are not allowed.", fileName);
+                handler->SetSentErrorMessage(true);
+                return false;
+            }
+
+            if (!sUpdateProfiler->Dump(name))
+            {
+                handler->PSendSysMessage("Could not write %s.", fileName);
+                handler->SetSentErrorMessage(true);
+                return false;
+            }
+
+            handler->PSendSysMessage("Update profiler statistics written to %s.", fileName);
+            return true;
+        }
+
+        if (action != "show")
+            return false;
+
+        char* categoryStr = strtok(NULL, " ");
+        std::string category = categoryStr ? categoryStr : "world";
+        char* countStr = strtok(NULL, " ");
+        uint32 count = countStr ? uint32(atoi(countStr)) : 10;
+
+        handler->PSendSysMessage("Update profiler is %s.", sUpdateProfiler->IsEnabled() ? "enabled" : "disabled");
+
+        if (category == "world")
+        {
+            for (uint32 i = 0; i < MAX_PROFILED_WORLD_PHASES; ++i)
+                SendProfilerStats(handler, UpdateProfiler::GetWorldPhaseName(ProfiledWorldPhase(i)), sUpdateProfiler->GetWorldPhaseStats(ProfiledWorldPhase(i)));
+            for (uint32 i = 0; i < MAX_PACKET_PROCESSING_MODES; ++i)
+                SendProfilerStats(handler, UpdateProfiler::GetProcessingName(PacketProcessing(i)), sUpdateProfiler->GetProcessingStats(PacketProcessing(i)));
+        }
+        else if (category == "opcodes")
+        {
+            std::vector<std::pair<std::string, ProfilerStats>> entries;
+            for (uint32 i = 0; i < NUM_MSG_TYPES; ++i)
+                entries.push_back(std::make_pair(GetOpcodeNameForLogging(uint16(i)), sUpdateProfiler->GetOpcodeStats(uint16(i))));
+
+            SendTopProfilerStats(handler, entries, count);
+        }
+        else if (category == "maps")
+        {
+            std::vector<std::pair<std::string, ProfilerStats>> entries;
+            for (uint32 i = 0; i < sUpdateProfiler->GetMapCount(); ++i)
+            {
+                std::string name = std::to_string(i);
+                if (MapEntry const* mapEntry = sMapStore.LookupEntry(i))
+                    name += std::string(" ") + mapEntry->name[handler->GetSessionDbcLocale()];
+
+                entries.push_back(std::make_pair(name, sUpdateProfiler->GetMapStats(i)));
+            }
+
+            SendTopProfilerStats(handler, entries, count);
+        }
+        else
+            return false;
+
+        return true;
+    }
 };
 
 void AddSC_debug_commandscript()
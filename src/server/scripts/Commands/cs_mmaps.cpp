@@ -49,6 +49,7 @@ public:
             { "loadedtiles", rbac::RBAC_PERM_COMMAND_MMAP_LOADEDTILES, false, &HandleMmapLoadedTilesCommand, "", NULL },
             { "loc",         rbac::RBAC_PERM_COMMAND_MMAP_LOC,         false, &HandleMmapLocCommand,         "", NULL },
             { "path",        rbac::RBAC_PERM_COMMAND_MMAP_PATH,        false, &HandleMmapPathCommand,        "", NULL },
+            { "pathcache",   rbac::RBAC_PERM_COMMAND_MMAP_PATHCACHE,   true,  &HandleMmapPathCacheCommand,   "", NULL },
             { "stats",       rbac::RBAC_PERM_COMMAND_MMAP_STATS,       false, &HandleMmapStatsCommand,       "", NULL },
             { "testarea",    rbac::RBAC_PERM_COMMAND_MMAP_TESTAREA,    false, &HandleMmapTestArea,           "", NULL },
             { NULL,          0,                                  false, NULL,                          "", NULL }
@@ -133,7 +134,7 @@ public:
 
         // calculate navmesh tile location
         dtNavMesh const* navmesh = MMAP::MMapFactory::createOrGetMMapManager()->GetNavMesh(handler->GetSession()->GetPlayer()->GetMapId());
-        dtNavMeshQuery const* navmeshquery = MMAP::MMapFactory::createOrGetMMapManager()->GetNavMeshQuery(handler->GetSession()->GetPlayer()->GetMapId(), player->GetInstanceId());
+        dtNavMeshQuery const* navmeshquery = MMAP::MMapFactory::createOrGetMMapManager()->GetNavMeshQuery(handler->GetSession()->GetPlayer()->GetMapId());
         if (!navmesh || !navmeshquery)
         {
             handler->PSendSysMessage("NavMesh not loaded for current map.");
@@ -185,7 +186,7 @@ public:
     {
         uint32 mapid = handler->GetSession()->GetPlayer()->GetMapId();
         dtNavMesh const* navmesh = MMAP::MMapFactory::createOrGetMMapManager()->GetNavMesh(mapid);
-        dtNavMeshQuery const* navmeshquery = MMAP::MMapFactory::createOrGetMMapManager()->GetNavMeshQuery(mapid, handler->GetSession()->GetPlayer()->GetInstanceId());
+        dtNavMeshQuery const* navmeshquery = MMAP::MMapFactory::createOrGetMMapManager()->GetNavMeshQuery(mapid);
         if (!navmesh || !navmeshquery)
         {
             handler->PSendSysMessage("NavMesh not loaded for current map.");
@@ -206,6 +207,19 @@ public:
         return true;
     }
 
+    static bool HandleMmapPathCacheCommand(ChatHandler* handler, char const* /*args*/)
+    {
+        MMAP::MMapPathCacheStats stats = MMAP::MMapFactory::createOrGetMMapManager()->GetPathCacheStats();
+        uint64 lookups = stats.Hits + stats.Misses;
+
+        handler->PSendSysMessage("mmap path cache:");
+        handler->PSendSysMessage(" " UI64FMTD " hits, " UI64FMTD " misses, %.1f%% hit rate",
+            stats.Hits, stats.Misses, lookups ? 100.0f * stats.Hits / lookups : 0.0f);
+        handler->PSendSysMessage(" %u corridors cached, at most %u per map", stats.Entries, uint32(MMAP::MMAP_PATH_CACHE_SIZE));
+        handler->PSendSysMessage(" " UI64FMTD " evictions, " UI64FMTD " invalidations by tile changes", stats.Evictions, stats.Invalidations);
+        return true;
+    }
+
     static bool HandleMmapStatsCommand(ChatHandler* handler, char const* /*args*/)
     {
         uint32 mapId = handler->GetSession()->GetPlayer()->GetMapId();
@@ -215,6 +229,14 @@ public:
         MMAP::MMapManager* manager = MMAP::MMapFactory::createOrGetMMapManager();
         handler->PSendSysMessage(" %u maps loaded with %u tiles overall", manager->getLoadedMapsCount(), manager->getLoadedTilesCount());
 
+        MMAP::MMapQueryStats queryStats = manager->GetQueryStats();
+        handler->PSendSysMessage("Pathfinding stats:");
+        handler->PSendSysMessage(" " UI64FMTD " paths calculated, " UI64FMTD " findPath calls", queryStats.Paths, queryStats.FindPathCalls);
+        handler->PSendSysMessage(" %.1f nodes expanded and %.1f us spent per path",
+            queryStats.Paths ? float(queryStats.NodesExpanded) / queryStats.Paths : 0.0f,
+            queryStats.Paths ? float(queryStats.PathTime) / queryStats.Paths : 0.0f);
+        handler->PSendSysMessage(" " UI64FMTD " query objects, " UI64FMTD " node pool growths", queryStats.Queries, queryStats.NodePoolGrowths);
+
         dtNavMesh const* navmesh = manager->GetNavMesh(handler->GetSession()->GetPlayer()->GetMapId());
         if (!navmesh)
         {
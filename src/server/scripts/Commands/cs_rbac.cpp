@@ -28,6 +28,7 @@ EndScriptData */
 #include "Language.h"
 #include "Player.h"
 #include "ScriptMgr.h"
+#include "World.h"
 
 struct RBACCommandData
 {
@@ -198,6 +199,7 @@ public:
             case rbac::RBAC_OK:
                 handler->PSendSysMessage(LANG_RBAC_PERM_GRANTED, command->id, permission->GetName().c_str(),
                     command->realmId, command->rbac->GetId(), command->rbac->GetName().c_str());
+                sWorld->InvalidateInWorldGameMasters();
                 break;
             case rbac::RBAC_ID_DOES_NOT_EXISTS:
                 handler->PSendSysMessage(LANG_RBAC_WRONG_PARAMETER_ID, command->id);
@@ -237,6 +239,7 @@ public:
             case rbac::RBAC_OK:
                 handler->PSendSysMessage(LANG_RBAC_PERM_DENIED, command->id, permission->GetName().c_str(),
                     command->realmId, command->rbac->GetId(), command->rbac->GetName().c_str());
+                sWorld->InvalidateInWorldGameMasters();
                 break;
             case rbac::RBAC_ID_DOES_NOT_EXISTS:
                 handler->PSendSysMessage(LANG_RBAC_WRONG_PARAMETER_ID, command->id);
@@ -272,6 +275,7 @@ public:
             case rbac::RBAC_OK:
                 handler->PSendSysMessage(LANG_RBAC_PERM_REVOKED, command->id, permission->GetName().c_str(),
                     command->realmId, command->rbac->GetId(), command->rbac->GetName().c_str());
+                sWorld->InvalidateInWorldGameMasters();
                 break;
             case rbac::RBAC_ID_DOES_NOT_EXISTS:
                 handler->PSendSysMessage(LANG_RBAC_WRONG_PARAMETER_ID, command->id);
@@ -109,8 +109,8 @@ class boss_blackheart_the_inciter : public CreatureScript
                         {
                             DoCast(me, SPELL_INCITE_CHAOS);
 
-                            std::list<HostileReference*> t_list = me->getThreatManager().getThreatList();
-                            for (std::list<HostileReference*>::const_iterator itr = t_list.begin(); itr!= t_list.end(); ++itr)
+                            ThreatContainer::StorageType t_list = me->getThreatManager().getThreatList();
+                            for (ThreatContainer::StorageType::const_iterator itr = t_list.begin(); itr!= t_list.end(); ++itr)
                             {
                                 if (Unit* target = ObjectAccessor::GetUnit(*me, (*itr)->getUnitGuid()))
                                     if (target->GetTypeId() == TYPEID_PLAYER)
@@ -87,6 +87,12 @@
 #  define ATTR_DEPRECATED
 #endif //COMPILER == COMPILER_GNU
 
+#if COMPILER == COMPILER_MICROSOFT
+#  define TRINITY_THREAD_LOCAL __declspec(thread)
+#else
+#  define TRINITY_THREAD_LOCAL __thread
+#endif
+
 #define UI64FMTD "%" PRIu64
 #define UI64LIT(N) UINT64_C(N)
 
@@ -0,0 +1,308 @@
+/*
+ * Copyright (C) 2008-2015 TrinityCore <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRINITY_OBJECTPOOL_H
+#define TRINITY_OBJECTPOOL_H
+
+#include "Define.h"
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+struct ObjectPoolStats
+{
+    uint64 Allocations;                                     // blocks handed out by the pool
+    uint64 Deallocations;                                   // blocks given back to the pool
+    uint64 Slabs;                                           // slabs currently held
+    uint64 SlabReleases;                                    // empty slabs given back to the heap
+    uint64 SlabSize;                                        // bytes per slab
+};
+
+/**
+ * @brief Fixed size block allocator for objects of type T
+ *
+ * Blocks are carved from slabs of ObjectsPerSlab objects. Every thread keeps a
+ * small cache of free blocks, so most allocations and deallocations don't take
+ * a lock. A cache that runs empty takes ObjectsPerSlab blocks from the shared
+ * pool, a cache that grows past MaxCachedBlocks gives ObjectsPerSlab blocks
+ * back to the slabs they were carved from, whichever thread freed them. Slabs
+ * whose blocks are all back are returned to the heap, except for a spare one.
+ * The blocks cached by a thread when it exits are lost, at most MaxCachedBlocks.
+ */
+template<class T, size_t ObjectsPerSlab = 128>
+class ObjectPool
+{
+    struct Slab;
+
+    struct Block
+    {
+        union
+        {
+            Block* Next;
+            typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type Storage;
+        };
+
+        Slab* Owner;
+    };
+
+    struct Slab
+    {
+        Block Blocks[ObjectsPerSlab];
+        Block* FreeList;                                    // blocks of this slab in the shared pool
+        size_t FreeCount;
+        Slab* Prev;                                         // neighbours in the list of slabs with free blocks
+        Slab* Next;
+    };
+
+public:
+    static size_t const MaxCachedBlocks = 2 * ObjectsPerSlab;
+
+    static void* Allocate()
+    {
+        if (!_cache)
+            Refill();
+
+        Block* block = _cache;
+        _cache = block->Next;
+        --_cacheSize;
+        _allocations.fetch_add(1, std::memory_order_relaxed);
+        return block;
+    }
+
+    static void Deallocate(void* ptr)
+    {
+        if (!ptr)
+            return;
+
+        Block* block = static_cast<Block*>(ptr);
+        block->Next = _cache;
+        _cache = block;
+        if (++_cacheSize >= MaxCachedBlocks)
+            Flush();
+
+        _deallocations.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static ObjectPoolStats GetStats()
+    {
+        ObjectPoolStats stats;
+        stats.Allocations = _allocations.load(std::memory_order_relaxed);
+        stats.Deallocations = _deallocations.load(std::memory_order_relaxed);
+        stats.Slabs = _slabs.load(std::memory_order_relaxed);
+        stats.SlabReleases = _slabReleases.load(std::memory_order_relaxed);
+        stats.SlabSize = sizeof(Slab);
+        return stats;
+    }
+
+private:
+    // moves up to ObjectsPerSlab blocks from the shared pool into the cache of the calling thread
+    static void Refill()
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+
+        if (!_freeSlabs)
+            AllocateSlab();
+
+        for (size_t i = 0; i < ObjectsPerSlab && _freeSlabs; ++i)
+        {
+            Slab* slab = _freeSlabs;
+            Block* block = slab->FreeList;
+            slab->FreeList = block->Next;
+            if (!--slab->FreeCount)
+                Unlink(slab);
+
+            block->Next = _cache;
+            _cache = block;
+            ++_cacheSize;
+        }
+    }
+
+    // gives ObjectsPerSlab blocks of the calling thread's cache back to their slabs
+    static void Flush()
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+
+        for (size_t i = 0; i < ObjectsPerSlab; ++i)
+        {
+            Block* block = _cache;
+            _cache = block->Next;
+            --_cacheSize;
+
+            Slab* slab = block->Owner;
+            block->Next = slab->FreeList;
+            slab->FreeList = block;
+            if (++slab->FreeCount == 1)
+                Link(slab);
+            else if (slab->FreeCount == ObjectsPerSlab && (slab->Prev || slab->Next))
+                ReleaseSlab(slab);
+        }
+    }
+
+    static void AllocateSlab()
+    {
+        Slab* slab = new Slab();
+        for (size_t i = 0; i < ObjectsPerSlab; ++i)
+        {
+            slab->Blocks[i].Owner = slab;
+            slab->Blocks[i].Next = i + 1 < ObjectsPerSlab ? &slab->Blocks[i + 1] : NULL;
+        }
+
+        slab->FreeList = &slab->Blocks[0];
+        slab->FreeCount = ObjectsPerSlab;
+        Link(slab);
+        _slabs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static void ReleaseSlab(Slab* slab)
+    {
+        Unlink(slab);
+        delete slab;
+        _slabs.fetch_sub(1, std::memory_order_relaxed);
+        _slabReleases.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static void Link(Slab* slab)
+    {
+        slab->Prev = NULL;
+        slab->Next = _freeSlabs;
+        if (_freeSlabs)
+            _freeSlabs->Prev = slab;
+        _freeSlabs = slab;
+    }
+
+    static void Unlink(Slab* slab)
+    {
+        if (slab->Prev)
+            slab->Prev->Next = slab->Next;
+        else
+            _freeSlabs = slab->Next;
+
+        if (slab->Next)
+            slab->Next->Prev = slab->Prev;
+
+        slab->Prev = NULL;
+        slab->Next = NULL;
+    }
+
+    static TRINITY_THREAD_LOCAL Block* _cache;
+    static TRINITY_THREAD_LOCAL size_t _cacheSize;
+
+    static std::mutex _lock;
+    static Slab* _freeSlabs;                                // slabs with blocks in the shared pool, guarded by _lock
+
+    static std::atomic<uint64> _allocations;
+    static std::atomic<uint64> _deallocations;
+    static std::atomic<uint64> _slabs;
+    static std::atomic<uint64> _slabReleases;
+};
+
+template<class T, size_t ObjectsPerSlab>
+TRINITY_THREAD_LOCAL typename ObjectPool<T, ObjectsPerSlab>::Block* ObjectPool<T, ObjectsPerSlab>::_cache = NULL;
+
+template<class T, size_t ObjectsPerSlab>
+TRINITY_THREAD_LOCAL size_t ObjectPool<T, ObjectsPerSlab>::_cacheSize = 0;
+
+template<class T, size_t ObjectsPerSlab>
+std::mutex ObjectPool<T, ObjectsPerSlab>::_lock;
+
+template<class T, size_t ObjectsPerSlab>
+typename ObjectPool<T, ObjectsPerSlab>::Slab* ObjectPool<T, ObjectsPerSlab>::_freeSlabs = NULL;
+
+template<class T, size_t ObjectsPerSlab>
+std::atomic<uint64> ObjectPool<T, ObjectsPerSlab>::_allocations(0);
+
+template<class T, size_t ObjectsPerSlab>
+std::atomic<uint64> ObjectPool<T, ObjectsPerSlab>::_deallocations(0);
+
+template<class T, size_t ObjectsPerSlab>
+std::atomic<uint64> ObjectPool<T, ObjectsPerSlab>::_slabs(0);
+
+template<class T, size_t ObjectsPerSlab>
+std::atomic<uint64> ObjectPool<T, ObjectsPerSlab>::_slabReleases(0);
+
+/**
+ * @brief STL allocator drawing single element allocations (tree and list nodes) from ObjectPool
+ */
+template<class T>
+class PoolAllocator
+{
+public:
+    typedef T value_type;
+    typedef T* pointer;
+    typedef T const* const_pointer;
+    typedef T& reference;
+    typedef T const& const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    template<class U>
+    struct rebind { typedef PoolAllocator<U> other; };
+
+    PoolAllocator() { }
+    template<class U>
+    PoolAllocator(PoolAllocator<U> const& /*other*/) { }
+
+    T* allocate(size_t count)
+    {
+        if (count == 1)
+            return static_cast<T*>(ObjectPool<T>::Allocate());
+
+        return static_cast<T*>(::operator new(count * sizeof(T)));
+    }
+
+    void deallocate(T* ptr, size_t count)
+    {
+        if (count == 1)
+            ObjectPool<T>::Deallocate(ptr);
+        else
+            ::operator delete(ptr);
+    }
+
+    size_t max_size() const { return size_t(-1) / sizeof(T); }
+
+    template<class U, class... Args>
+    void construct(U* ptr, Args&&... args) { ::new((void*)ptr) U(std::forward<Args>(args)...); }
+
+    template<class U>
+    void destroy(U* ptr) { ptr->~U(); }
+
+    template<class U>
+    bool operator==(PoolAllocator<U> const& /*other*/) const { return true; }
+    template<class U>
+    bool operator!=(PoolAllocator<U> const& /*other*/) const { return false; }
+};
+
+/// Routes new/delete of a class (but not of classes derived from it) through ObjectPool
+#define TRINITY_POOLED_OBJECT(T) \
+    static void* operator new(size_t size) \
+    { \
+        if (size != sizeof(T)) \
+            return ::operator new(size); \
+        return ObjectPool<T>::Allocate(); \
+    } \
+    static void operator delete(void* ptr, size_t size) \
+    { \
+        if (size != sizeof(T)) \
+            ::operator delete(ptr); \
+        else \
+            ObjectPool<T>::Deallocate(ptr); \
+    }
+
+#endif // TRINITY_OBJECTPOOL_H
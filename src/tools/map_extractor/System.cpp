@@ -19,12 +19,19 @@
 #define _CRT_SECURE_NO_DEPRECATE
 
 #include <stdio.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <deque>
 #include <set>
+#include <string>
+#include <thread>
+#include <vector>
 #include <cstdlib>
 
 #ifdef _WIN32
 #include "direct.h"
+#include <sys/stat.h>
 #else
 #include <sys/stat.h>
 #include <unistd.h>
@@ -36,6 +43,7 @@
 #include "adt.h"
 #include "wdt.h"
 #include <fcntl.h>
+#include <zlib.h>
 
 #if defined( __GNUC__ )
     #define _open   open
@@ -52,7 +60,7 @@
 #else
     #define OPEN_FLAGS (O_RDONLY | O_BINARY)
 #endif
-extern ArchiveSet gOpenArchives;
+extern thread_local ArchiveSet gOpenArchives;
 
 typedef struct
 {
@@ -90,6 +98,13 @@ float CONF_float_to_int16_limit = 2048.0f;   // Max accuracy = val/65536
 float CONF_flat_height_delta_limit = 0.005f; // If max - min less this value - surface is flat
 float CONF_flat_liquid_delta_limit = 0.001f; // If max - min less this value - liquid surface is flat
 
+// Threads converting map tiles, each one opens its own MPQ archives
+int   CONF_threads = std::max(int(std::thread::hardware_concurrency()), 1);
+// Compress the map file sections with zlib, they are inflated once when the server loads the grid
+bool  CONF_compress = true;
+// Skip map tiles whose output was written by the same extractor version and build after the last MPQ change
+bool  CONF_incremental = false;
+
 // List MPQ for extract from
 const char *CONF_mpq_list[]={
     "common.MPQ",
@@ -127,6 +142,20 @@ void CreateDir( const std::string& Path )
     }
 }
 
+uint32 GetMSTimeSince(std::chrono::steady_clock::time_point const& start)
+{
+    return uint32(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+time_t GetFileTime(char const* fileName)
+{
+    struct stat status;
+    if (stat(fileName, &status))
+        return 0;
+
+    return status.st_mtime;
+}
+
 bool FileExists( const char* FileName )
 {
     int fp = _open(FileName, OPEN_FLAGS);
@@ -148,6 +177,9 @@ void Usage(char* prg)
         "-o set output path (max %d characters)\n"\
         "-e extract only MAP(1)/DBC(2) - standard: both(3)\n"\
         "-f height stored as int (less map size but lost some accuracy) 1 by default\n"\
+        "-z compress map files 1 by default\n"\
+        "-t number of threads converting map tiles - standard: number of cores\n"\
+        "-u skip map tiles already extracted from unchanged MPQs (rerun without it after changing -f or -z)\n"\
         "Example: %s -f 0 -i \"c:\\games\\game\"", prg, MAX_PATH_LENGTH - 1, MAX_PATH_LENGTH - 1, prg);
     exit(1);
 }
@@ -160,7 +192,10 @@ void HandleArgs(int argc, char * arg[])
         // o - output path
         // e - extract only MAP(1)/DBC(2) - standard both(3)
         // f - use float to int conversion
+        // z - compress map files
         // h - limit minimum height
+        // t - map tile threads
+        // u - incremental update
         if(arg[c][0] != '-')
             Usage(arg[0]);
 
@@ -190,6 +225,25 @@ void HandleArgs(int argc, char * arg[])
                 else
                     Usage(arg[0]);
                 break;
+            case 'z':
+                if(c + 1 < argc)                            // all ok
+                    CONF_compress=atoi(arg[(c++) + 1])!=0;
+                else
+                    Usage(arg[0]);
+                break;
+            case 't':
+                if(c + 1 < argc)                            // all ok
+                {
+                    CONF_threads=atoi(arg[(c++) + 1]);
+                    if(CONF_threads < 1)
+                        Usage(arg[0]);
+                }
+                else
+                    Usage(arg[0]);
+                break;
+            case 'u':
+                CONF_incremental = true;
+                break;
             case 'e':
                 if(c + 1 < argc)                            // all ok
                 {
@@ -324,7 +378,7 @@ void ReadLiquidTypeTableDBC()
 
 // Map file format data
 static char const* MAP_MAGIC         = "MAPS";
-static char const* MAP_VERSION_MAGIC = "v1.3";
+static char const* MAP_VERSION_MAGIC = "v1.4";
 static char const* MAP_AREA_MAGIC    = "AREA";
 static char const* MAP_HEIGHT_MAGIC  = "MHGT";
 static char const* MAP_LIQUID_MAGIC  = "MLIQ";
@@ -345,6 +399,7 @@ struct map_fileheader
 };
 
 #define MAP_AREA_NO_AREA      0x0001
+#define MAP_AREA_COMPRESSED   0x0002
 
 struct map_areaHeader
 {
@@ -356,6 +411,8 @@ struct map_areaHeader
 #define MAP_HEIGHT_NO_HEIGHT  0x0001
 #define MAP_HEIGHT_AS_INT16   0x0002
 #define MAP_HEIGHT_AS_INT8    0x0004
+#define MAP_HEIGHT_DELTA      0x0008                        // integer heights stored as difference to the previous one
+#define MAP_HEIGHT_COMPRESSED 0x0010
 
 struct map_heightHeader
 {
@@ -377,6 +434,8 @@ struct map_heightHeader
 
 #define MAP_LIQUID_NO_TYPE    0x0001
 #define MAP_LIQUID_NO_HEIGHT  0x0002
+#define MAP_LIQUID_AS_INT16   0x0004                        // heights stored as uint16 after their float min and max
+#define MAP_LIQUID_COMPRESSED 0x0008
 
 struct map_liquidHeader
 {
@@ -399,20 +458,65 @@ float selectUInt16StepStore(float maxDiff)
 {
     return 65535 / maxDiff;
 }
-// Temporary grid data store
-uint16 area_flags[ADT_CELLS_PER_GRID][ADT_CELLS_PER_GRID];
 
-float V8[ADT_GRID_SIZE][ADT_GRID_SIZE];
-float V9[ADT_GRID_SIZE+1][ADT_GRID_SIZE+1];
-uint16 uint16_V8[ADT_GRID_SIZE][ADT_GRID_SIZE];
-uint16 uint16_V9[ADT_GRID_SIZE+1][ADT_GRID_SIZE+1];
-uint8  uint8_V8[ADT_GRID_SIZE][ADT_GRID_SIZE];
-uint8  uint8_V9[ADT_GRID_SIZE+1][ADT_GRID_SIZE+1];
+template<class T>
+void AppendMapData(std::vector<uint8>& data, T const* values, size_t count)
+{
+    uint8 const* bytes = reinterpret_cast<uint8 const*>(values);
+    data.insert(data.end(), bytes, bytes + count * sizeof(T));
+}
+
+// Neighbouring heights differ little, their differences compress a lot better than the heights
+template<class T>
+void AppendMapDeltas(std::vector<uint8>& data, T const* values, size_t count)
+{
+    std::vector<T> deltas(count);
+    T previous = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        deltas[i] = T(values[i] - previous);
+        previous = values[i];
+    }
+
+    AppendMapData(data, deltas.data(), count);
+}
+
+// A compressed section holds the uncompressed size of its data followed by the zlib stream
+template<class F>
+void CompressMapSection(std::vector<uint8>& data, F& flags, F compressedFlag)
+{
+    if (!CONF_compress || data.empty())
+        return;
+
+    uLongf packedSize = compressBound(uLong(data.size()));
+    std::vector<uint8> packed(sizeof(uint32) + packedSize);
+    uint32 size = uint32(data.size());
+    memcpy(packed.data(), &size, sizeof(size));
+    if (compress2(&packed[sizeof(uint32)], &packedSize, data.data(), uLong(data.size()), Z_BEST_COMPRESSION) != Z_OK)
+        return;
+
+    // tiny sections don't get smaller
+    if (sizeof(uint32) + packedSize >= data.size())
+        return;
+
+    packed.resize(sizeof(uint32) + packedSize);
+    data.swap(packed);
+    flags |= compressedFlag;
+}
+// Temporary grid data store, one per tile converting thread
+thread_local uint16 area_flags[ADT_CELLS_PER_GRID][ADT_CELLS_PER_GRID];
+
+thread_local float V8[ADT_GRID_SIZE][ADT_GRID_SIZE];
+thread_local float V9[ADT_GRID_SIZE+1][ADT_GRID_SIZE+1];
+thread_local uint16 uint16_V8[ADT_GRID_SIZE][ADT_GRID_SIZE];
+thread_local uint16 uint16_V9[ADT_GRID_SIZE+1][ADT_GRID_SIZE+1];
+thread_local uint8  uint8_V8[ADT_GRID_SIZE][ADT_GRID_SIZE];
+thread_local uint8  uint8_V9[ADT_GRID_SIZE+1][ADT_GRID_SIZE+1];
 
-uint16 liquid_entry[ADT_CELLS_PER_GRID][ADT_CELLS_PER_GRID];
-uint8 liquid_flags[ADT_CELLS_PER_GRID][ADT_CELLS_PER_GRID];
-bool  liquid_show[ADT_GRID_SIZE][ADT_GRID_SIZE];
-float liquid_height[ADT_GRID_SIZE+1][ADT_GRID_SIZE+1];
+thread_local uint16 liquid_entry[ADT_CELLS_PER_GRID][ADT_CELLS_PER_GRID];
+thread_local uint8 liquid_flags[ADT_CELLS_PER_GRID][ADT_CELLS_PER_GRID];
+thread_local bool  liquid_show[ADT_GRID_SIZE][ADT_GRID_SIZE];
+thread_local float liquid_height[ADT_GRID_SIZE+1][ADT_GRID_SIZE+1];
 
 bool ConvertADT(char *filename, char *filename2, int /*cell_y*/, int /*cell_x*/, uint32 build)
 {
@@ -474,16 +578,12 @@ bool ConvertADT(char *filename, char *filename2, int /*cell_y*/, int /*cell_x*/,
         }
     }
 
-    map.areaMapOffset = sizeof(map);
-    map.areaMapSize   = sizeof(map_areaHeader);
-
     map_areaHeader areaHeader;
     areaHeader.fourcc = *(uint32 const*)MAP_AREA_MAGIC;
     areaHeader.flags = 0;
     if (fullAreaData)
     {
         areaHeader.gridArea = 0;
-        map.areaMapSize+=sizeof(area_flags);
     }
     else
     {
@@ -603,9 +703,6 @@ bool ConvertADT(char *filename, char *filename2, int /*cell_y*/, int /*cell_x*/,
             maxHeight = CONF_use_minHeight;
     }
 
-    map.heightMapOffset = map.areaMapOffset + map.areaMapSize;
-    map.heightMapSize = sizeof(map_heightHeader);
-
     map_heightHeader heightHeader;
     heightHeader.fourcc = *(uint32 const*)MAP_HEIGHT_MAGIC;
     heightHeader.flags = 0;
@@ -648,7 +745,6 @@ bool ConvertADT(char *filename, char *filename2, int /*cell_y*/, int /*cell_x*/,
             for (int y=0; y<=ADT_GRID_SIZE; y++)
                 for(int x=0;x<=ADT_GRID_SIZE;x++)
                     uint8_V9[y][x] = uint8((V9[y][x] - minHeight) * step + 0.5f);
-            map.heightMapSize+= sizeof(uint8_V9) + sizeof(uint8_V8);
         }
         else if (heightHeader.flags&MAP_HEIGHT_AS_INT16)
         {
@@ -658,10 +754,7 @@ bool ConvertADT(char *filename, char *filename2, int /*cell_y*/, int /*cell_x*/,
             for (int y=0; y<=ADT_GRID_SIZE; y++)
                 for(int x=0;x<=ADT_GRID_SIZE;x++)
                     uint16_V9[y][x] = uint16((V9[y][x] - minHeight) * step + 0.5f);
-            map.heightMapSize+= sizeof(uint16_V9) + sizeof(uint16_V8);
         }
-        else
-            map.heightMapSize+= sizeof(V9) + sizeof(V8);
     }
 
     // Get from MCLQ chunk (old)
@@ -814,15 +907,12 @@ bool ConvertADT(char *filename, char *filename2, int /*cell_y*/, int /*cell_x*/,
     }
 
     map_liquidHeader liquidHeader;
+    float liquidMinHeight = 0.0f;
+    float liquidMaxHeight = 0.0f;
 
     // no water data (if all grid have 0 liquid type)
-    if (type == 0 && !fullType)
-    {
-        // No liquid data
-        map.liquidMapOffset = 0;
-        map.liquidMapSize   = 0;
-    }
-    else
+    bool hasLiquid = type != 0 || fullType;
+    if (hasLiquid)
     {
         int minX = 255, minY = 255;
         int maxX = 0, maxY = 0;
@@ -846,8 +936,6 @@ bool ConvertADT(char *filename, char *filename2, int /*cell_y*/, int /*cell_x*/,
                     liquid_height[y][x] = CONF_use_minHeight;
             }
         }
-        map.liquidMapOffset = map.heightMapOffset + map.heightMapSize;
-        map.liquidMapSize = sizeof(map_liquidHeader);
         liquidHeader.fourcc = *(uint32 const*)MAP_LIQUID_MAGIC;
         liquidHeader.flags = 0;
         liquidHeader.liquidType = 0;
@@ -869,21 +957,30 @@ bool ConvertADT(char *filename, char *filename2, int /*cell_y*/, int /*cell_x*/,
 
         if (liquidHeader.flags & MAP_LIQUID_NO_TYPE)
             liquidHeader.liquidType = type;
-        else
-            map.liquidMapSize += sizeof(liquid_entry) + sizeof(liquid_flags);
 
-        if (!(liquidHeader.flags & MAP_LIQUID_NO_HEIGHT))
-            map.liquidMapSize += sizeof(float)*liquidHeader.width*liquidHeader.height;
+        // Try store as uint16 values, the stored area includes the unused cells at CONF_use_minHeight
+        if (CONF_allow_float_to_int && !(liquidHeader.flags & MAP_LIQUID_NO_HEIGHT))
+        {
+            liquidMinHeight = 20000;
+            liquidMaxHeight = -20000;
+            for (int y = liquidHeader.offsetY; y < liquidHeader.offsetY + liquidHeader.height; y++)
+            {
+                for (int x = liquidHeader.offsetX; x < liquidHeader.offsetX + liquidHeader.width; x++)
+                {
+                    float h = liquid_height[y][x];
+                    if (liquidMaxHeight < h) liquidMaxHeight = h;
+                    if (liquidMinHeight > h) liquidMinHeight = h;
+                }
+            }
+
+            if (liquidMaxHeight - liquidMinHeight < CONF_float_to_int16_limit)
+                liquidHeader.flags |= MAP_LIQUID_AS_INT16;
+        }
     }
 
     // map hole info
     uint16 holes[ADT_CELLS_PER_GRID][ADT_CELLS_PER_GRID];
 
-    if (map.liquidMapOffset)
-        map.holesOffset = map.liquidMapOffset + map.liquidMapSize;
-    else
-        map.holesOffset = map.heightMapOffset + map.heightMapSize;
-
     memset(holes, 0, sizeof(holes));
     bool hasHoles = false;
 
@@ -905,54 +1002,114 @@ bool ConvertADT(char *filename, char *filename2, int /*cell_y*/, int /*cell_x*/,
     else
         map.holesSize = 0;
 
-    // Ok all data prepared - store it
-    FILE* output = fopen(filename2, "wb");
-    if (!output)
-    {
-        printf("Can't create the output file '%s'\n", filename2);
-        return false;
-    }
-    fwrite(&map, sizeof(map), 1, output);
-    // Store area data
-    fwrite(&areaHeader, sizeof(areaHeader), 1, output);
+    //============================================
+    // Pack the sections
+    //============================================
+    std::vector<uint8> areaData;
     if (!(areaHeader.flags&MAP_AREA_NO_AREA))
-        fwrite(area_flags, sizeof(area_flags), 1, output);
+        AppendMapData(areaData, &area_flags[0][0], ADT_CELLS_PER_GRID * ADT_CELLS_PER_GRID);
+    CompressMapSection(areaData, areaHeader.flags, uint16(MAP_AREA_COMPRESSED));
 
-    // Store height data
-    fwrite(&heightHeader, sizeof(heightHeader), 1, output);
+    std::vector<uint8> heightData;
     if (!(heightHeader.flags & MAP_HEIGHT_NO_HEIGHT))
     {
+        if ((heightHeader.flags & (MAP_HEIGHT_AS_INT16 | MAP_HEIGHT_AS_INT8)) && CONF_compress)
+            heightHeader.flags |= MAP_HEIGHT_DELTA;
+
         if (heightHeader.flags & MAP_HEIGHT_AS_INT16)
         {
-            fwrite(uint16_V9, sizeof(uint16_V9), 1, output);
-            fwrite(uint16_V8, sizeof(uint16_V8), 1, output);
+            if (heightHeader.flags & MAP_HEIGHT_DELTA)
+            {
+                AppendMapDeltas(heightData, &uint16_V9[0][0], (ADT_GRID_SIZE+1) * (ADT_GRID_SIZE+1));
+                AppendMapDeltas(heightData, &uint16_V8[0][0], ADT_GRID_SIZE * ADT_GRID_SIZE);
+            }
+            else
+            {
+                AppendMapData(heightData, &uint16_V9[0][0], (ADT_GRID_SIZE+1) * (ADT_GRID_SIZE+1));
+                AppendMapData(heightData, &uint16_V8[0][0], ADT_GRID_SIZE * ADT_GRID_SIZE);
+            }
         }
         else if (heightHeader.flags & MAP_HEIGHT_AS_INT8)
         {
-            fwrite(uint8_V9, sizeof(uint8_V9), 1, output);
-            fwrite(uint8_V8, sizeof(uint8_V8), 1, output);
+            if (heightHeader.flags & MAP_HEIGHT_DELTA)
+            {
+                AppendMapDeltas(heightData, &uint8_V9[0][0], (ADT_GRID_SIZE+1) * (ADT_GRID_SIZE+1));
+                AppendMapDeltas(heightData, &uint8_V8[0][0], ADT_GRID_SIZE * ADT_GRID_SIZE);
+            }
+            else
+            {
+                AppendMapData(heightData, &uint8_V9[0][0], (ADT_GRID_SIZE+1) * (ADT_GRID_SIZE+1));
+                AppendMapData(heightData, &uint8_V8[0][0], ADT_GRID_SIZE * ADT_GRID_SIZE);
+            }
         }
         else
         {
-            fwrite(V9, sizeof(V9), 1, output);
-            fwrite(V8, sizeof(V8), 1, output);
+            AppendMapData(heightData, &V9[0][0], (ADT_GRID_SIZE+1) * (ADT_GRID_SIZE+1));
+            AppendMapData(heightData, &V8[0][0], ADT_GRID_SIZE * ADT_GRID_SIZE);
         }
     }
+    CompressMapSection(heightData, heightHeader.flags, uint32(MAP_HEIGHT_COMPRESSED));
 
-    // Store liquid data if need
-    if (map.liquidMapOffset)
+    std::vector<uint8> liquidData;
+    if (hasLiquid)
     {
-        fwrite(&liquidHeader, sizeof(liquidHeader), 1, output);
         if (!(liquidHeader.flags&MAP_LIQUID_NO_TYPE))
         {
-            fwrite(liquid_entry, sizeof(liquid_entry), 1, output);
-            fwrite(liquid_flags, sizeof(liquid_flags), 1, output);
+            AppendMapData(liquidData, &liquid_entry[0][0], ADT_CELLS_PER_GRID * ADT_CELLS_PER_GRID);
+            AppendMapData(liquidData, &liquid_flags[0][0], ADT_CELLS_PER_GRID * ADT_CELLS_PER_GRID);
         }
-        if (!(liquidHeader.flags&MAP_LIQUID_NO_HEIGHT))
+        if (liquidHeader.flags&MAP_LIQUID_AS_INT16)
         {
+            AppendMapData(liquidData, &liquidMinHeight, 1);
+            AppendMapData(liquidData, &liquidMaxHeight, 1);
+
+            float step = liquidMaxHeight > liquidMinHeight ? selectUInt16StepStore(liquidMaxHeight - liquidMinHeight) : 0.0f;
+            std::vector<uint16> heights;
             for (int y=0; y<liquidHeader.height;y++)
-                fwrite(&liquid_height[y+liquidHeader.offsetY][liquidHeader.offsetX], sizeof(float), liquidHeader.width, output);
+                for (int x=0; x<liquidHeader.width;x++)
+                    heights.push_back(uint16((liquid_height[y+liquidHeader.offsetY][x+liquidHeader.offsetX] - liquidMinHeight) * step + 0.5f));
+            AppendMapData(liquidData, heights.data(), heights.size());
         }
+        else if (!(liquidHeader.flags&MAP_LIQUID_NO_HEIGHT))
+        {
+            for (int y=0; y<liquidHeader.height;y++)
+                AppendMapData(liquidData, &liquid_height[y+liquidHeader.offsetY][liquidHeader.offsetX], liquidHeader.width);
+        }
+        CompressMapSection(liquidData, liquidHeader.flags, uint16(MAP_LIQUID_COMPRESSED));
+    }
+
+    map.areaMapOffset = sizeof(map);
+    map.areaMapSize = uint32(sizeof(areaHeader) + areaData.size());
+    map.heightMapOffset = map.areaMapOffset + map.areaMapSize;
+    map.heightMapSize = uint32(sizeof(heightHeader) + heightData.size());
+    map.liquidMapOffset = hasLiquid ? map.heightMapOffset + map.heightMapSize : 0;
+    map.liquidMapSize = hasLiquid ? uint32(sizeof(liquidHeader) + liquidData.size()) : 0;
+    map.holesOffset = map.heightMapOffset + map.heightMapSize + map.liquidMapSize;
+
+    // Ok all data prepared - store it
+    FILE* output = fopen(filename2, "wb");
+    if (!output)
+    {
+        printf("Can't create the output file '%s'\n", filename2);
+        return false;
+    }
+    fwrite(&map, sizeof(map), 1, output);
+    // Store area data
+    fwrite(&areaHeader, sizeof(areaHeader), 1, output);
+    if (!areaData.empty())
+        fwrite(areaData.data(), areaData.size(), 1, output);
+
+    // Store height data
+    fwrite(&heightHeader, sizeof(heightHeader), 1, output);
+    if (!heightData.empty())
+        fwrite(heightData.data(), heightData.size(), 1, output);
+
+    // Store liquid data if need
+    if (hasLiquid)
+    {
+        fwrite(&liquidHeader, sizeof(liquidHeader), 1, output);
+        if (!liquidData.empty())
+            fwrite(liquidData.data(), liquidData.size(), 1, output);
     }
 
     // store hole data
@@ -964,27 +1121,96 @@ bool ConvertADT(char *filename, char *filename2, int /*cell_y*/, int /*cell_x*/,
     return true;
 }
 
-void ExtractMapsFromMpq(uint32 build)
+struct MapTile
+{
+    char MpqName[256];
+    char OutputName[256];
+    uint32 X;
+    uint32 Y;
+};
+
+// Incremental mode: the output was written after the newest MPQ was modified, by this extractor version for this build
+bool IsMapTileUpToDate(MapTile const& tile, time_t inputTime, uint32 build)
+{
+    if (GetFileTime(tile.OutputName) < inputTime)
+        return false;
+
+    FILE* output = fopen(tile.OutputName, "rb");
+    if (!output)
+        return false;
+
+    map_fileheader header;
+    bool upToDate = fread(&header, sizeof(header), 1, output) == 1 &&
+        header.mapMagic == *(uint32 const*)MAP_MAGIC &&
+        header.versionMagic == *(uint32 const*)MAP_VERSION_MAGIC &&
+        header.buildMagic == build;
+
+    fclose(output);
+    return upToDate;
+}
+
+void OpenMPQFiles(std::vector<std::string> const& mpqFiles)
+{
+    for (std::vector<std::string>::const_iterator itr = mpqFiles.begin(); itr != mpqFiles.end(); ++itr)
+        new MPQArchive(itr->c_str());
+}
+
+inline void CloseMPQFiles()
+{
+    for(ArchiveSet::iterator j = gOpenArchives.begin(); j != gOpenArchives.end();++j) (*j)->close();
+        gOpenArchives.clear();
+}
+
+void ConvertMapTiles(std::vector<MapTile> const& tiles, std::vector<std::string> const& mpqFiles, uint32 build,
+    std::atomic<uint32>* nextTile, std::atomic<uint32>* doneTiles, std::atomic<uint32>* failedTiles)
+{
+    OpenMPQFiles(mpqFiles);
+
+    uint32 total = uint32(tiles.size());
+    for (uint32 i = (*nextTile)++; i < total; i = (*nextTile)++)
+    {
+        MapTile tile = tiles[i];
+        if (!ConvertADT(tile.MpqName, tile.OutputName, tile.Y, tile.X, build))
+            ++(*failedTiles);
+
+        // draw progress bar, whichever thread crosses a percent draws it
+        uint32 done = ++(*doneTiles);
+        if (done * 100 / total != (done - 1) * 100 / total)
+            printf("Processing........................%u%%\r", done * 100 / total);
+    }
+
+    CloseMPQFiles();
+}
+
+void ExtractMapsFromMpq(uint32 build, std::vector<std::string> const& mpqFiles)
 {
-    char mpq_filename[1024];
-    char output_filename[1024];
     char mpq_map_name[1024];
 
     printf("Extracting maps...\n");
 
+    std::chrono::steady_clock::time_point phaseStart = std::chrono::steady_clock::now();
+
     uint32 map_count = ReadMapDBC();
 
     ReadAreaTableDBC();
     ReadLiquidTypeTableDBC();
 
+    printf("Read DBC data in %u ms\n", GetMSTimeSince(phaseStart));
+
     std::string path = output_path;
     path += "/maps/";
     CreateDir(path);
 
-    printf("Convert map files\n");
+    time_t inputTime = 0;
+    for (std::vector<std::string>::const_iterator itr = mpqFiles.begin(); itr != mpqFiles.end(); ++itr)
+        inputTime = std::max(inputTime, GetFileTime(itr->c_str()));
+
+    // collect the tiles of all maps first, they are converted in any order but each one only writes its own file
+    phaseStart = std::chrono::steady_clock::now();
+    std::vector<MapTile> tiles;
+    uint32 skipped = 0;
     for(uint32 z = 0; z < map_count; ++z)
     {
-        printf("Extract %s (%d/%u)                  \n", map_ids[z].name, z+1, map_count);
         // Loadup map grid data
         sprintf(mpq_map_name, "World\\Maps\\%s\\%s.wdt", map_ids[z].name, map_ids[z].name);
         WDT_file wdt;
@@ -1000,15 +1226,42 @@ void ExtractMapsFromMpq(uint32 build)
             {
                 if (!wdt.main->adt_list[y][x].exist)
                     continue;
-                sprintf(mpq_filename, "World\\Maps\\%s\\%s_%u_%u.adt", map_ids[z].name, map_ids[z].name, x, y);
-                sprintf(output_filename, "%s/maps/%03u%02u%02u.map", output_path, map_ids[z].id, y, x);
-                ConvertADT(mpq_filename, output_filename, y, x, build);
+                MapTile tile;
+                sprintf(tile.MpqName, "World\\Maps\\%s\\%s_%u_%u.adt", map_ids[z].name, map_ids[z].name, x, y);
+                sprintf(tile.OutputName, "%s/maps/%03u%02u%02u.map", output_path, map_ids[z].id, y, x);
+                tile.X = x;
+                tile.Y = y;
+
+                if (CONF_incremental && IsMapTileUpToDate(tile, inputTime, build))
+                {
+                    ++skipped;
+                    continue;
+                }
+
+                tiles.push_back(tile);
             }
-            // draw progress bar
-            printf("Processing........................%d%%\r", (100 * (y+1)) / WDT_MAP_SIZE);
         }
     }
-    printf("\n");
+
+    printf("Found %u map tiles to convert (%u up to date) in %u ms\n", uint32(tiles.size()), skipped, GetMSTimeSince(phaseStart));
+
+    printf("Convert map files using %d threads\n", CONF_threads);
+    phaseStart = std::chrono::steady_clock::now();
+
+    std::atomic<uint32> nextTile(0);
+    std::atomic<uint32> doneTiles(0);
+    std::atomic<uint32> failedTiles(0);
+    if (!tiles.empty())
+    {
+        std::vector<std::thread> workerThreads;
+        for (int i = 0; i < std::min(CONF_threads, int(tiles.size())); ++i)
+            workerThreads.push_back(std::thread(ConvertMapTiles, std::cref(tiles), std::cref(mpqFiles), build, &nextTile, &doneTiles, &failedTiles));
+
+        for (std::thread& thread : workerThreads)
+            thread.join();
+    }
+
+    printf("\nConverted %u map tiles (%u failed) in %u ms\n", uint32(tiles.size()) - failedTiles, uint32(failedTiles), GetMSTimeSince(phaseStart));
     delete [] areas;
     delete [] map_ids;
 }
@@ -1033,6 +1286,8 @@ void ExtractDBCFiles(int locale, bool basicLocale)
 {
     printf("Extracting dbc files...\n");
 
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
     std::set<std::string> dbcfiles;
 
     // get DBC file list
@@ -1076,15 +1331,17 @@ void ExtractDBCFiles(int locale, bool basicLocale)
         if (ExtractFile(iter->c_str(), filename))
             ++count;
     }
-    printf("Extracted %u DBC files\n\n", count);
+    printf("Extracted %u DBC files in %u ms\n\n", count, GetMSTimeSince(start));
 }
 
-void LoadLocaleMPQFiles(int const locale)
+// the opened files are appended to mpqFiles, for the tile converting threads to open them too
+void LoadLocaleMPQFiles(int const locale, std::vector<std::string>& mpqFiles)
 {
     char filename[512];
 
     sprintf(filename,"%s/Data/%s/locale-%s.MPQ", input_path, langs[locale], langs[locale]);
     new MPQArchive(filename);
+    mpqFiles.push_back(filename);
 
     for(int i = 1; i < 5; ++i)
     {
@@ -1094,11 +1351,14 @@ void LoadLocaleMPQFiles(int const locale)
 
         sprintf(filename,"%s/Data/%s/patch-%s%s.MPQ", input_path, langs[locale], langs[locale], ext);
         if(FileExists(filename))
+        {
             new MPQArchive(filename);
+            mpqFiles.push_back(filename);
+        }
     }
 }
 
-void LoadCommonMPQFiles()
+void LoadCommonMPQFiles(std::vector<std::string>& mpqFiles)
 {
     char filename[512];
     int count = sizeof(CONF_mpq_list)/sizeof(char*);
@@ -1106,16 +1366,13 @@ void LoadCommonMPQFiles()
     {
         sprintf(filename, "%s/Data/%s", input_path, CONF_mpq_list[i]);
         if(FileExists(filename))
+        {
             new MPQArchive(filename);
+            mpqFiles.push_back(filename);
+        }
     }
 }
 
-inline void CloseMPQFiles()
-{
-    for(ArchiveSet::iterator j = gOpenArchives.begin(); j != gOpenArchives.end();++j) (*j)->close();
-        gOpenArchives.clear();
-}
-
 int main(int argc, char * arg[])
 {
     printf("Map & DBC Extractor\n");
@@ -1135,7 +1392,8 @@ int main(int argc, char * arg[])
             printf("Detected locale: %s\n", langs[i]);
 
             //Open MPQs
-            LoadLocaleMPQFiles(i);
+            std::vector<std::string> mpqFiles;
+            LoadLocaleMPQFiles(i, mpqFiles);
 
             if((CONF_extract & EXTRACT_DBC) == 0)
             {
@@ -1172,11 +1430,14 @@ int main(int argc, char * arg[])
         printf("Using locale: %s\n", langs[FirstLocale]);
 
         // Open MPQs
-        LoadLocaleMPQFiles(FirstLocale);
-        LoadCommonMPQFiles();
+        std::vector<std::string> mpqFiles;
+        LoadLocaleMPQFiles(FirstLocale, mpqFiles);
+        LoadCommonMPQFiles(mpqFiles);
 
         // Extract maps
-        ExtractMapsFromMpq(build);
+        std::chrono::steady_clock::time_point mapStart = std::chrono::steady_clock::now();
+        ExtractMapsFromMpq(build, mpqFiles);
+        printf("Extracted maps in %u ms\n", GetMSTimeSince(mapStart));
 
         // Close MPQs
         CloseMPQFiles();
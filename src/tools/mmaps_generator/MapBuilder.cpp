@@ -27,9 +27,17 @@
 #include "DetourNavMesh.h"
 #include "DetourCommon.h"
 
+#include "Timer.h"
+
 #define MMAP_MAGIC 0x4d4d4150   // 'MMAP'
 #define MMAP_VERSION 5
 
+#define MMAP_CHECKSUM_MAGIC 0x4d4d5355  // 'MMSU'
+#define MMAP_CHECKSUM_VERSION 1
+
+// tasks handed to a worker at once, consecutive tiles of a map share most of their models
+#define TILE_TASK_CHUNK 4
+
 struct MmapTileHeader
 {
     uint32 mmapMagic;
@@ -42,6 +50,47 @@ struct MmapTileHeader
         mmapVersion(MMAP_VERSION), size(0), usesLiquids(true) {}
 };
 
+// written next to each .mmtile, also for tiles without output so empty tiles are not rebuilt either
+struct MmapTileChecksum
+{
+    uint32 magic;
+    uint32 version;
+    uint64 checksum;
+    uint8 hasTile;
+
+    MmapTileChecksum() : magic(MMAP_CHECKSUM_MAGIC), version(MMAP_CHECKSUM_VERSION), checksum(0), hasTile(0) {}
+};
+
+// FNV-1a
+static void hashData(uint64& hash, void const* data, size_t size)
+{
+    unsigned char const* bytes = static_cast<unsigned char const*>(data);
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+}
+
+static void hashFile(uint64& hash, char const* fileName)
+{
+    FILE* file = fopen(fileName, "rb");
+    if (!file)
+    {
+        // missing inputs are part of the state, a tile must be rebuilt when they appear
+        uint8 missing = 0xFF;
+        hashData(hash, &missing, sizeof(missing));
+        return;
+    }
+
+    unsigned char buffer[64 * 1024];
+    size_t count;
+    while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        hashData(hash, buffer, count);
+
+    fclose(file);
+}
+
 namespace MMAP
 {
     MapBuilder::MapBuilder(float maxWalkableAngle, bool skipLiquid,
@@ -55,13 +104,25 @@ namespace MMAP
         m_skipBattlegrounds  (skipBattlegrounds),
         m_maxWalkableAngle   (maxWalkableAngle),
         m_bigBaseUnit        (bigBaseUnit),
+        m_settingsChecksum   (14695981039346656037ULL),
         m_rcContext          (NULL),
-        _cancelationToken    (false)
+        m_totalTiles         (0),
+        m_finishedTiles      (0)
     {
         m_terrainBuilder = new TerrainBuilder(skipLiquid);
 
+        // rcContext with logging and timers disabled keeps no state, workers share it
         m_rcContext = new rcContext(false);
 
+        uint32 const versions[3] = { MMAP_VERSION, uint32(DT_NAVMESH_VERSION), MMAP_CHECKSUM_VERSION };
+        bool usesLiquids = m_terrainBuilder->usesLiquids();
+        hashData(m_settingsChecksum, versions, sizeof(versions));
+        hashData(m_settingsChecksum, &m_maxWalkableAngle, sizeof(m_maxWalkableAngle));
+        hashData(m_settingsChecksum, &m_bigBaseUnit, sizeof(m_bigBaseUnit));
+        hashData(m_settingsChecksum, &usesLiquids, sizeof(usesLiquids));
+        if (m_offMeshFilePath)
+            hashFile(m_settingsChecksum, m_offMeshFilePath);
+
         discoverTiles();
     }
 
@@ -160,58 +221,244 @@ namespace MMAP
 
     /**************************************************************************/
 
-    void MapBuilder::WorkerThread()
+    void MapBuilder::buildAllMaps(int threads)
+    {
+        m_tiles.sort([](MapTiles a, MapTiles b)
+        {
+            return a.m_tiles->size() > b.m_tiles->size();
+        });
+
+        std::vector<uint32> mapIds;
+        for (TileList::iterator it = m_tiles.begin(); it != m_tiles.end(); ++it)
+            if (!shouldSkipMap(it->m_mapId))
+                mapIds.push_back(it->m_mapId);
+
+        buildMaps(mapIds, threads);
+    }
+
+    /**************************************************************************/
+    void MapBuilder::buildMaps(std::vector<uint32> const& mapIds, int threads)
     {
-        while (1)
+        uint32 start = getMSTime();
+
+        std::vector<TileBuildTask> tasks;
+        for (uint32 mapID : mapIds)
         {
-            uint32 mapId;
+            std::set<uint32>* tiles = getTileList(mapID);
+
+            // make sure we process maps which don't have tiles
+            if (!tiles->size())
+            {
+                // convert coord bounds to grid bounds
+                uint32 minX, minY, maxX, maxY;
+                getGridBounds(mapID, minX, minY, maxX, maxY);
+
+                // add all tiles within bounds to tile list.
+                for (uint32 i = minX; i <= maxX; ++i)
+                    for (uint32 j = minY; j <= maxY; ++j)
+                        tiles->insert(StaticMapTree::packTileID(i, j));
+            }
+
+            if (tiles->empty())
+            {
+                printf("[Map %03i] Complete!\n", mapID);
+                continue;
+            }
+
+            // build navMesh
+            dtNavMesh* navMesh = NULL;
+            buildNavMesh(mapID, navMesh);
+            if (!navMesh)
+            {
+                printf("[Map %03i] Failed creating navmesh!\n", mapID);
+                continue;
+            }
+
+            printf("[Map %03i] We have %u tiles.                          \n", mapID, (unsigned int)tiles->size());
+
+            MapBuildState* state = new MapBuildState(mapID, navMesh, tiles->size());
+            m_buildStates.push_back(state);
 
-            _queue.WaitAndPop(mapId);
+            for (std::set<uint32>::iterator it = tiles->begin(); it != tiles->end(); ++it)
+            {
+                TileBuildTask task;
+                task.m_map = state;
+
+                // unpack tile coords
+                StaticMapTree::unpackTileID((*it), task.m_tileX, task.m_tileY);
+                tasks.push_back(task);
+            }
+        }
+
+        m_totalTiles = tasks.size();
+        m_finishedTiles = 0;
 
-            if (_cancelationToken)
-                return;
+        // maps come biggest first, deal their tiles out in chunks so every worker starts on the large continents
+        uint32 workerCount = std::max(threads, 1);
+        for (uint32 i = 0; i < workerCount; ++i)
+            m_workQueues.push_back(new TileWorkQueue());
 
-            buildMap(mapId);
+        for (size_t i = 0; i < tasks.size(); ++i)
+            m_workQueues[(i / TILE_TASK_CHUNK) % workerCount]->m_tasks.push_back(tasks[i]);
+
+        if (threads > 0)
+        {
+            std::vector<std::thread> workerThreads;
+            for (uint32 i = 0; i < workerCount; ++i)
+                workerThreads.push_back(std::thread(&MapBuilder::workerThread, this, i));
+
+            for (auto& thread : workerThreads)
+                thread.join();
         }
+        else
+            workerThread(0);
+
+        printReport(GetMSTimeDiffToNow(start));
+
+        for (TileWorkQueue* queue : m_workQueues)
+            delete queue;
+        m_workQueues.clear();
+
+        for (MapBuildState* state : m_buildStates)
+            delete state;
+        m_buildStates.clear();
     }
 
-    void MapBuilder::buildAllMaps(int threads)
+    /**************************************************************************/
+    void MapBuilder::workerThread(uint32 workerId)
+    {
+        TileBuildTask task;
+        while (getNextTask(workerId, task))
+            buildTask(task);
+    }
+
+    /**************************************************************************/
+    bool MapBuilder::getNextTask(uint32 workerId, TileBuildTask& task)
     {
-        for (int i = 0; i < threads; ++i)
         {
-            _workerThreads.push_back(std::thread(&MapBuilder::WorkerThread, this));
+            TileWorkQueue* queue = m_workQueues[workerId];
+            std::lock_guard<std::mutex> lock(queue->m_lock);
+            if (!queue->m_tasks.empty())
+            {
+                task = queue->m_tasks.front();
+                queue->m_tasks.pop_front();
+                return true;
+            }
         }
 
-        m_tiles.sort([](MapTiles a, MapTiles b)
+        // steal from the back, the owner keeps working through the front of its queue
+        // no tasks are added once building started, so all queues being empty means we are done
+        for (size_t i = 1; i < m_workQueues.size(); ++i)
         {
-            return a.m_tiles->size() > b.m_tiles->size();
-        });
+            TileWorkQueue* victim = m_workQueues[(workerId + i) % m_workQueues.size()];
+            std::lock_guard<std::mutex> lock(victim->m_lock);
+            if (!victim->m_tasks.empty())
+            {
+                task = victim->m_tasks.back();
+                victim->m_tasks.pop_back();
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /**************************************************************************/
+    void MapBuilder::buildTask(TileBuildTask const& task)
+    {
+        MapBuildState& map = *task.m_map;
+        uint32 mapID = map.m_mapId;
+        uint32 tileStart = getMSTime();
 
-        for (TileList::iterator it = m_tiles.begin(); it != m_tiles.end(); ++it)
         {
-            uint32 mapId = it->m_mapId;
-            if (!shouldSkipMap(mapId))
+            std::lock_guard<std::mutex> lock(map.m_lock);
+            if (!map.m_started)
             {
-                if (threads > 0)
-                    _queue.Push(mapId);
-                else
-                    buildMap(mapId);
+                map.m_started = true;
+                map.m_startTime = tileStart;
             }
         }
 
-        while (!_queue.Empty())
+        char const* result;
+        uint64 checksum = getTileChecksum(mapID, task.m_tileX, task.m_tileY, map.m_navMesh);
+        if (isTileUpToDate(mapID, task.m_tileX, task.m_tileY, checksum))
         {
-            std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+            ++map.m_skippedTiles;
+            result = "up to date";
         }
+        else
+        {
+            {
+                // the first tile built loads the models of the whole map, the others wait for it and share them
+                std::lock_guard<std::mutex> lock(map.m_lock);
+                if (!map.m_modelsLoaded)
+                {
+                    m_terrainBuilder->loadMapModels(mapID);
+                    map.m_modelsLoaded = true;
+                }
+            }
+
+            // don't leave an outdated tile behind if the tile turns out empty now
+            char fileName[255];
+            sprintf(fileName, "mmaps/%03u%02i%02i.mmtile", mapID, task.m_tileY, task.m_tileX);
+            remove(fileName);
 
-        _cancelationToken = true;
+            if (buildTile(mapID, task.m_tileX, task.m_tileY, map.m_navMesh, &map.m_lock))
+            {
+                writeTileChecksum(mapID, task.m_tileX, task.m_tileY, checksum);
+                ++map.m_builtTiles;
+                result = "built";
+            }
+            else
+            {
+                ++map.m_failedTiles;
+                result = "failed";
+            }
+        }
 
-        _queue.Cancel();
+        uint32 tileTime = GetMSTimeDiffToNow(tileStart);
+        map.m_buildTime += tileTime;
 
-        for (auto& thread : _workerThreads)
+        uint32 finished = ++m_finishedTiles;
+        printf("[%3u%%] [Map %03i] [%02u,%02u] %s in %u ms (%u/%u tiles)\n", finished * 100 / m_totalTiles, mapID,
+            task.m_tileX, task.m_tileY, result, tileTime, finished, uint32(m_totalTiles));
+
+        if (--map.m_remainingTiles)
+            return;
+
+        std::lock_guard<std::mutex> lock(map.m_lock);
+        if (map.m_modelsLoaded)
+            m_terrainBuilder->unloadMapModels(mapID);
+
+        dtFreeNavMesh(map.m_navMesh);
+        map.m_navMesh = NULL;
+        map.m_endTime = getMSTime();
+
+        printf("[Map %03i] Complete!\n", mapID);
+    }
+
+    /**************************************************************************/
+    void MapBuilder::printReport(uint32 totalTime)
+    {
+        if (m_buildStates.empty())
+            return;
+
+        uint32 built = 0, skipped = 0, failed = 0;
+
+        printf("\n Map  Tiles  Built  Up to date  Failed  Build time (ms)  Wall time (ms)\n");
+        for (MapBuildState* state : m_buildStates)
         {
-            thread.join();
+            printf(" %03u  %5u  %5u  %10u  %6u  %15u  %14u\n", state->m_mapId, state->m_tileCount,
+                uint32(state->m_builtTiles), uint32(state->m_skippedTiles), uint32(state->m_failedTiles),
+                uint32(state->m_buildTime), getMSTimeDiff(state->m_startTime, state->m_endTime));
+
+            built += state->m_builtTiles;
+            skipped += state->m_skippedTiles;
+            failed += state->m_failedTiles;
         }
+
+        printf("\n%u maps, %u tiles: %u built, %u up to date, %u failed in %u ms on %u worker(s)\n\n",
+            uint32(m_buildStates.size()), uint32(m_totalTiles), built, skipped, failed, totalTime, uint32(m_workQueues.size()));
     }
 
     /**************************************************************************/
@@ -358,61 +605,13 @@ namespace MMAP
     }
 
     /**************************************************************************/
-    void MapBuilder::buildMap(uint32 mapID)
+    void MapBuilder::buildMap(uint32 mapID, int threads)
     {
-#ifndef __APPLE__
-        //printf("[Thread %u] Building map %03u:\n", uint32(ACE_Thread::self()), mapID);
-#endif
-
-        std::set<uint32>* tiles = getTileList(mapID);
-
-        // make sure we process maps which don't have tiles
-        if (!tiles->size())
-        {
-            // convert coord bounds to grid bounds
-            uint32 minX, minY, maxX, maxY;
-            getGridBounds(mapID, minX, minY, maxX, maxY);
-
-            // add all tiles within bounds to tile list.
-            for (uint32 i = minX; i <= maxX; ++i)
-                for (uint32 j = minY; j <= maxY; ++j)
-                    tiles->insert(StaticMapTree::packTileID(i, j));
-        }
-
-        if (!tiles->empty())
-        {
-            // build navMesh
-            dtNavMesh* navMesh = NULL;
-            buildNavMesh(mapID, navMesh);
-            if (!navMesh)
-            {
-                printf("[Map %03i] Failed creating navmesh!\n", mapID);
-                return;
-            }
-
-            // now start building mmtiles for each tile
-            printf("[Map %03i] We have %u tiles.                          \n", mapID, (unsigned int)tiles->size());
-            for (std::set<uint32>::iterator it = tiles->begin(); it != tiles->end(); ++it)
-            {
-                uint32 tileX, tileY;
-
-                // unpack tile coords
-                StaticMapTree::unpackTileID((*it), tileX, tileY);
-
-                if (shouldSkipTile(mapID, tileX, tileY))
-                    continue;
-
-                buildTile(mapID, tileX, tileY, navMesh);
-            }
-
-            dtFreeNavMesh(navMesh);
-        }
-
-        printf("[Map %03i] Complete!\n", mapID);
+        buildMaps(std::vector<uint32>(1, mapID), threads);
     }
 
     /**************************************************************************/
-    void MapBuilder::buildTile(uint32 mapID, uint32 tileX, uint32 tileY, dtNavMesh* navMesh)
+    bool MapBuilder::buildTile(uint32 mapID, uint32 tileX, uint32 tileY, dtNavMesh* navMesh, std::mutex* navMeshLock)
     {
         printf("[Map %03i] Building tile [%02u,%02u]\n", mapID, tileX, tileY);
 
@@ -426,7 +625,7 @@ namespace MMAP
 
         // if there is no data, give up now
         if (!meshData.solidVerts.size() && !meshData.liquidVerts.size())
-            return;
+            return true;
 
         // remove unused vertices
         TerrainBuilder::cleanVertices(meshData.solidVerts, meshData.solidTris);
@@ -438,7 +637,7 @@ namespace MMAP
         allVerts.append(meshData.solidVerts);
 
         if (!allVerts.size())
-            return;
+            return true;
 
         // get bounds of current tile
         float bmin[3], bmax[3];
@@ -447,7 +646,7 @@ namespace MMAP
         m_terrainBuilder->loadOffMeshConnections(mapID, tileX, tileY, meshData, m_offMeshFilePath);
 
         // build navmesh tile
-        buildMoveMapTile(mapID, tileX, tileY, meshData, bmin, bmax, navMesh);
+        return buildMoveMapTile(mapID, tileX, tileY, meshData, bmin, bmax, navMesh, navMeshLock);
     }
 
     /**************************************************************************/
@@ -526,9 +725,9 @@ namespace MMAP
     }
 
     /**************************************************************************/
-    void MapBuilder::buildMoveMapTile(uint32 mapID, uint32 tileX, uint32 tileY,
+    bool MapBuilder::buildMoveMapTile(uint32 mapID, uint32 tileX, uint32 tileY,
         MeshData &meshData, float bmin[3], float bmax[3],
-        dtNavMesh* navMesh)
+        dtNavMesh* navMesh, std::mutex* navMeshLock)
     {
         // console output
         char tileString[20];
@@ -703,7 +902,7 @@ namespace MMAP
             delete[] pmmerge;
             delete[] dmmerge;
             delete[] tiles;
-            return;
+            return false;
         }
         rcMergePolyMeshes(m_rcContext, pmmerge, nmerge, *iv.polyMesh);
 
@@ -714,7 +913,7 @@ namespace MMAP
             delete[] pmmerge;
             delete[] dmmerge;
             delete[] tiles;
-            return;
+            return false;
         }
         rcMergePolyMeshDetails(m_rcContext, dmmerge, nmerge, *iv.polyMeshDetail);
 
@@ -768,6 +967,9 @@ namespace MMAP
         unsigned char* navData = NULL;
         int navDataSize = 0;
 
+        // false on errors, tiles without geometry are not errors
+        bool success = false;
+
         do
         {
             // these values are checked within dtCreateNavMeshData - handle them here
@@ -789,6 +991,7 @@ namespace MMAP
 
                 // message is an annoyance
                 //printf("%sNo vertices to build tile!              \n", tileString);
+                success = true;
                 break;
             }
             if (!params.polyCount || !params.polys ||
@@ -798,6 +1001,7 @@ namespace MMAP
                 // keep in mind that we do output those into debug info
                 // drop tiles with only exact count - some tiles may have geometry while having less tiles
                 printf("%s No polygons to build on tile!              \n", tileString);
+                success = true;
                 break;
             }
             if (!params.detailMeshes || !params.detailVerts || !params.detailTris)
@@ -815,12 +1019,23 @@ namespace MMAP
 
             dtTileRef tileRef = 0;
             printf("%s Adding tile to navmesh...\n", tileString);
-            // DT_TILE_FREE_DATA tells detour to unallocate memory when the tile
-            // is removed via removeTile()
-            dtStatus dtResult = navMesh->addTile(navData, navDataSize, DT_TILE_FREE_DATA, 0, &tileRef);
+            dtStatus dtResult;
+            {
+                // navmesh is shared by all tiles of the map and only used to validate them,
+                // the tile is removed right away and navData stays ours to write and free
+                std::unique_lock<std::mutex> lock;
+                if (navMeshLock)
+                    lock = std::unique_lock<std::mutex>(*navMeshLock);
+
+                dtResult = navMesh->addTile(navData, navDataSize, 0, 0, &tileRef);
+                if (tileRef)
+                    navMesh->removeTile(tileRef, NULL, NULL);
+            }
+
             if (!tileRef || dtResult != DT_SUCCESS)
             {
                 printf("%s Failed adding tile to navmesh!           \n", tileString);
+                dtFree(navData);
                 break;
             }
 
@@ -833,7 +1048,7 @@ namespace MMAP
                 char message[1024];
                 sprintf(message, "[Map %03i] Failed to open %s for writing!\n", mapID, fileName);
                 perror(message);
-                navMesh->removeTile(tileRef, NULL, NULL);
+                dtFree(navData);
                 break;
             }
 
@@ -849,8 +1064,8 @@ namespace MMAP
             fwrite(navData, sizeof(unsigned char), navDataSize, file);
             fclose(file);
 
-            // now that tile is written to disk, we can unload it
-            navMesh->removeTile(tileRef, NULL, NULL);
+            dtFree(navData);
+            success = true;
         }
         while (0);
 
@@ -867,6 +1082,8 @@ namespace MMAP
             iv.generateObjFile(mapID, tileX, tileY, meshData);
             iv.writeIV(mapID, tileX, tileY);
         }
+
+        return success;
     }
 
     /**************************************************************************/
@@ -1005,4 +1222,74 @@ namespace MMAP
         return true;
     }
 
+    /**************************************************************************/
+    uint64 MapBuilder::getTileChecksum(uint32 mapID, uint32 tileX, uint32 tileY, dtNavMesh const* navMesh)
+    {
+        uint64 checksum = m_settingsChecksum;
+        char fileName[255];
+
+        // terrain of the tile and the borders loaded from its neighbours, see TerrainBuilder::loadMap
+        uint32 const neighbours[5][2] = { { tileX, tileY }, { tileX + 1, tileY }, { tileX - 1, tileY }, { tileX, tileY + 1 }, { tileX, tileY - 1 } };
+        for (uint32 i = 0; i < 5; ++i)
+        {
+            sprintf(fileName, "maps/%03u%02u%02u.map", mapID, neighbours[i][1], neighbours[i][0]);
+            hashFile(checksum, fileName);
+        }
+
+        // model spawns, the .vmo files themselves are not hashed - re-extracting vmaps rewrites the tile files too
+        sprintf(fileName, "vmaps/%03u.vmtree", mapID);
+        hashFile(checksum, fileName);
+        hashFile(checksum, ("vmaps/" + StaticMapTree::getTileFileName(mapID, tileX, tileY)).c_str());
+
+        // tile coords in the navmesh depend on the bounds of all tiles of the map
+        hashData(checksum, navMesh->getParams()->orig, sizeof(navMesh->getParams()->orig));
+        return checksum;
+    }
+
+    /**************************************************************************/
+    bool MapBuilder::isTileUpToDate(uint32 mapID, uint32 tileX, uint32 tileY, uint64 checksum)
+    {
+        char fileName[255];
+        sprintf(fileName, "mmaps/%03u%02i%02i.mmsum", mapID, tileY, tileX);
+        FILE* file = fopen(fileName, "rb");
+        if (!file)
+            return false;
+
+        MmapTileChecksum tileChecksum;
+        int count = fread(&tileChecksum, sizeof(MmapTileChecksum), 1, file);
+        fclose(file);
+        if (count != 1)
+            return false;
+
+        if (tileChecksum.magic != MMAP_CHECKSUM_MAGIC || tileChecksum.version != MMAP_CHECKSUM_VERSION)
+            return false;
+
+        if (tileChecksum.checksum != checksum)
+            return false;
+
+        // tiles without geometry have no .mmtile
+        return !tileChecksum.hasTile || shouldSkipTile(mapID, tileX, tileY);
+    }
+
+    /**************************************************************************/
+    void MapBuilder::writeTileChecksum(uint32 mapID, uint32 tileX, uint32 tileY, uint64 checksum)
+    {
+        char fileName[255];
+        sprintf(fileName, "mmaps/%03u%02i%02i.mmsum", mapID, tileY, tileX);
+        FILE* file = fopen(fileName, "wb");
+        if (!file)
+        {
+            char message[1024];
+            sprintf(message, "[Map %03i] Failed to open %s for writing!\n", mapID, fileName);
+            perror(message);
+            return;
+        }
+
+        MmapTileChecksum tileChecksum;
+        tileChecksum.checksum = checksum;
+        tileChecksum.hasTile = shouldSkipTile(mapID, tileX, tileY) ? 1 : 0;
+        fwrite(&tileChecksum, sizeof(MmapTileChecksum), 1, file);
+        fclose(file);
+    }
+
 }
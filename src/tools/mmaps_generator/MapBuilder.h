@@ -23,7 +23,9 @@
 #include <set>
 #include <map>
 #include <list>
+#include <deque>
 #include <atomic>
+#include <mutex>
 #include <thread>
 
 #include "TerrainBuilder.h"
@@ -31,7 +33,6 @@
 
 #include "Recast.h"
 #include "DetourNavMesh.h"
-#include "ProducerConsumerQueue.h"
 
 using namespace VMAP;
 
@@ -73,6 +74,43 @@ namespace MMAP
         rcPolyMeshDetail* dmesh;
     };
 
+    // build state of one map, shared by all workers building its tiles
+    struct MapBuildState
+    {
+        MapBuildState(uint32 mapId, dtNavMesh* navMesh, uint32 tileCount) : m_mapId(mapId), m_navMesh(navMesh),
+            m_tileCount(tileCount), m_remainingTiles(tileCount), m_builtTiles(0), m_skippedTiles(0), m_failedTiles(0),
+            m_buildTime(0), m_started(false), m_modelsLoaded(false), m_startTime(0), m_endTime(0) {}
+
+        uint32 m_mapId;
+        dtNavMesh* m_navMesh;                   // only used to validate tiles, guarded by m_lock
+        uint32 m_tileCount;
+        std::atomic<uint32> m_remainingTiles;
+        std::atomic<uint32> m_builtTiles;
+        std::atomic<uint32> m_skippedTiles;     // up to date, see isTileUpToDate
+        std::atomic<uint32> m_failedTiles;
+        std::atomic<uint32> m_buildTime;        // ms spent in tile workers
+
+        std::mutex m_lock;
+        bool m_started;
+        bool m_modelsLoaded;
+        uint32 m_startTime;
+        uint32 m_endTime;
+    };
+
+    struct TileBuildTask
+    {
+        MapBuildState* m_map;
+        uint32 m_tileX;
+        uint32 m_tileY;
+    };
+
+    // tasks handed to one worker, other workers steal from the back when they run dry
+    struct TileWorkQueue
+    {
+        std::mutex m_lock;
+        std::deque<TileBuildTask> m_tasks;
+    };
+
     class MapBuilder
     {
         public:
@@ -88,7 +126,7 @@ namespace MMAP
             ~MapBuilder();
 
             // builds all mmap tiles for the specified map id (ignores skip settings)
-            void buildMap(uint32 mapID);
+            void buildMap(uint32 mapID, int threads = 0);
             void buildMeshFromFile(char* name);
 
             // builds an mmap tile for the specified map and its mesh
@@ -97,25 +135,32 @@ namespace MMAP
             // builds list of maps, then builds all of mmap tiles (based on the skip settings)
             void buildAllMaps(int threads);
 
-            void WorkerThread();
-
         private:
             // detect maps and tiles
             void discoverTiles();
             std::set<uint32>* getTileList(uint32 mapID);
 
+            // builds the tiles of all maps on a shared pool, threads == 0 builds on the calling thread
+            void buildMaps(std::vector<uint32> const& mapIds, int threads);
+            void workerThread(uint32 workerId);
+            bool getNextTask(uint32 workerId, TileBuildTask& task);
+            void buildTask(TileBuildTask const& task);
+            void printReport(uint32 totalTime);
+
             void buildNavMesh(uint32 mapID, dtNavMesh* &navMesh);
 
-            void buildTile(uint32 mapID, uint32 tileX, uint32 tileY, dtNavMesh* navMesh);
+            // returns false if the tile could not be built, not if it is empty
+            bool buildTile(uint32 mapID, uint32 tileX, uint32 tileY, dtNavMesh* navMesh, std::mutex* navMeshLock = NULL);
 
             // move map building
-            void buildMoveMapTile(uint32 mapID,
+            bool buildMoveMapTile(uint32 mapID,
                 uint32 tileX,
                 uint32 tileY,
                 MeshData &meshData,
                 float bmin[3],
                 float bmax[3],
-                dtNavMesh* navMesh);
+                dtNavMesh* navMesh,
+                std::mutex* navMeshLock = NULL);
 
             void getTileBounds(uint32 tileX, uint32 tileY,
                 float* verts, int vertCount,
@@ -126,6 +171,11 @@ namespace MMAP
             bool isTransportMap(uint32 mapID);
             bool shouldSkipTile(uint32 mapID, uint32 tileX, uint32 tileY);
 
+            // resumable builds, a tile is up to date when its inputs and the build settings did not change since it was written
+            uint64 getTileChecksum(uint32 mapID, uint32 tileX, uint32 tileY, dtNavMesh const* navMesh);
+            bool isTileUpToDate(uint32 mapID, uint32 tileX, uint32 tileY, uint64 checksum);
+            void writeTileChecksum(uint32 mapID, uint32 tileX, uint32 tileY, uint64 checksum);
+
             TerrainBuilder* m_terrainBuilder;
             TileList m_tiles;
 
@@ -138,13 +188,15 @@ namespace MMAP
 
             float m_maxWalkableAngle;
             bool m_bigBaseUnit;
+            uint64 m_settingsChecksum;          // build settings and offmesh input, part of every tile checksum
 
             // build performance - not really used for now
             rcContext* m_rcContext;
 
-            std::vector<std::thread> _workerThreads;
-            ProducerConsumerQueue<uint32> _queue;
-            std::atomic<bool> _cancelationToken;
+            std::vector<MapBuildState*> m_buildStates;
+            std::vector<TileWorkQueue*> m_workQueues;
+            std::atomic<uint32> m_totalTiles;
+            std::atomic<uint32> m_finishedTiles;
     };
 }
 
@@ -24,6 +24,8 @@
 #include "MapTree.h"
 #include "ModelInstance.h"
 
+#include <zlib.h>
+
 // ******************************************
 // Map file format defines
 // ******************************************
@@ -45,6 +47,8 @@ struct map_fileheader
 #define MAP_HEIGHT_NO_HEIGHT  0x0001
 #define MAP_HEIGHT_AS_INT16   0x0002
 #define MAP_HEIGHT_AS_INT8    0x0004
+#define MAP_HEIGHT_DELTA      0x0008
+#define MAP_HEIGHT_COMPRESSED 0x0010
 
 struct map_heightHeader
 {
@@ -56,6 +60,8 @@ struct map_heightHeader
 
 #define MAP_LIQUID_NO_TYPE    0x0001
 #define MAP_LIQUID_NO_HEIGHT  0x0002
+#define MAP_LIQUID_AS_INT16   0x0004
+#define MAP_LIQUID_COMPRESSED 0x0008
 
 struct map_liquidHeader
 {
@@ -80,10 +86,71 @@ struct map_liquidHeader
 namespace MMAP
 {
 
-    char const* MAP_VERSION_MAGIC = "v1.3";
+    char const* MAP_VERSION_MAGIC = "v1.4";
+    char const* MAP_VERSION_MAGIC_UNCOMPRESSED = "v1.3";
+
+    // Data following a map file section header, compressed sections hold their size and a zlib stream
+    class MapSection
+    {
+    public:
+        MapSection() : m_pos(0) { }
+
+        bool load(FILE* mapFile, uint32 sectionSize, uint32 headerSize, bool compressed)
+        {
+            if (sectionSize < headerSize)
+                return false;
+
+            std::vector<uint8> packed(sectionSize - headerSize);
+            if (!packed.empty() && fread(packed.data(), 1, packed.size(), mapFile) != packed.size())
+                return false;
+
+            if (!compressed)
+            {
+                m_data.swap(packed);
+                return true;
+            }
+
+            uint32 size;
+            if (packed.size() <= sizeof(size))
+                return false;
+
+            memcpy(&size, packed.data(), sizeof(size));
+            m_data.resize(size);
+            uLongf inflatedSize = size;
+            return uncompress(m_data.data(), &inflatedSize, &packed[sizeof(size)], uLong(packed.size() - sizeof(size))) == Z_OK &&
+                inflatedSize == size;
+        }
+
+        // same as fread
+        size_t read(void* dest, size_t size, size_t count)
+        {
+            count = std::min(count, (m_data.size() - m_pos) / size);
+            memcpy(dest, m_data.data() + m_pos, size * count);
+            m_pos += size * count;
+            return count;
+        }
 
-    TerrainBuilder::TerrainBuilder(bool skipLiquid) : m_skipLiquid (skipLiquid){ }
-    TerrainBuilder::~TerrainBuilder() { }
+    private:
+        std::vector<uint8> m_data;
+        size_t m_pos;
+    };
+
+    template<class T>
+    static void decodeHeightDeltas(T* heights, int count)
+    {
+        for (int i = 1; i < count; ++i)
+            heights[i] = T(heights[i] + heights[i - 1]);
+    }
+
+    TerrainBuilder::TerrainBuilder(bool skipLiquid) : m_skipLiquid (skipLiquid), m_vmapManager(new VMapManager2()) { }
+    TerrainBuilder::~TerrainBuilder()
+    {
+        for (auto& mapModels : m_mapModels)
+            for (std::string const& name : mapModels.second)
+                m_vmapManager->releaseModelInstance(name);
+
+        delete m_vmapManager;
+    }
 
     /**************************************************************************/
     void TerrainBuilder::getLoopVars(Spot portion, int &loopStart, int &loopEnd, int &loopInc)
@@ -142,7 +209,7 @@ namespace MMAP
 
         map_fileheader fheader;
         if (fread(&fheader, sizeof(map_fileheader), 1, mapFile) != 1 ||
-            fheader.versionMagic != *((uint32 const*)(MAP_VERSION_MAGIC)))
+            (fheader.versionMagic != *((uint32 const*)(MAP_VERSION_MAGIC)) && fheader.versionMagic != *((uint32 const*)(MAP_VERSION_MAGIC_UNCOMPRESSED))))
         {
             fclose(mapFile);
             printf("%s is the wrong version, please extract new .map files\n", mapFileName);
@@ -154,9 +221,11 @@ namespace MMAP
 
         bool haveTerrain = false;
         bool haveLiquid = false;
+        MapSection heightSection;
         if (fread(&hheader, sizeof(map_heightHeader), 1, mapFile) == 1)
         {
-            haveTerrain = !(hheader.flags & MAP_HEIGHT_NO_HEIGHT);
+            haveTerrain = !(hheader.flags & MAP_HEIGHT_NO_HEIGHT) &&
+                heightSection.load(mapFile, fheader.heightMapSize, sizeof(map_heightHeader), (hheader.flags & MAP_HEIGHT_COMPRESSED) != 0);
             haveLiquid = fheader.liquidMapOffset && !m_skipLiquid;
         }
 
@@ -187,11 +256,17 @@ namespace MMAP
                 uint8 v9[V9_SIZE_SQ];
                 uint8 v8[V8_SIZE_SQ];
                 int count = 0;
-                count += fread(v9, sizeof(uint8), V9_SIZE_SQ, mapFile);
-                count += fread(v8, sizeof(uint8), V8_SIZE_SQ, mapFile);
+                count += heightSection.read(v9, sizeof(uint8), V9_SIZE_SQ);
+                count += heightSection.read(v8, sizeof(uint8), V8_SIZE_SQ);
                 if (count != expected)
                     printf("TerrainBuilder::loadMap: Failed to read some data expected %d, read %d\n", expected, count);
 
+                if (hheader.flags & MAP_HEIGHT_DELTA)
+                {
+                    decodeHeightDeltas(v9, V9_SIZE_SQ);
+                    decodeHeightDeltas(v8, V8_SIZE_SQ);
+                }
+
                 heightMultiplier = (hheader.gridMaxHeight - hheader.gridHeight) / 255;
 
                 for (int i = 0; i < V9_SIZE_SQ; ++i)
@@ -205,11 +280,17 @@ namespace MMAP
                 uint16 v9[V9_SIZE_SQ];
                 uint16 v8[V8_SIZE_SQ];
                 int count = 0;
-                count += fread(v9, sizeof(uint16), V9_SIZE_SQ, mapFile);
-                count += fread(v8, sizeof(uint16), V8_SIZE_SQ, mapFile);
+                count += heightSection.read(v9, sizeof(uint16), V9_SIZE_SQ);
+                count += heightSection.read(v8, sizeof(uint16), V8_SIZE_SQ);
                 if (count != expected)
                     printf("TerrainBuilder::loadMap: Failed to read some data expected %d, read %d\n", expected, count);
 
+                if (hheader.flags & MAP_HEIGHT_DELTA)
+                {
+                    decodeHeightDeltas(v9, V9_SIZE_SQ);
+                    decodeHeightDeltas(v8, V8_SIZE_SQ);
+                }
+
                 heightMultiplier = (hheader.gridMaxHeight - hheader.gridHeight) / 65535;
 
                 for (int i = 0; i < V9_SIZE_SQ; ++i)
@@ -221,8 +302,8 @@ namespace MMAP
             else
             {
                 int count = 0;
-                count += fread(V9, sizeof(float), V9_SIZE_SQ, mapFile);
-                count += fread(V8, sizeof(float), V8_SIZE_SQ, mapFile);
+                count += heightSection.read(V9, sizeof(float), V9_SIZE_SQ);
+                count += heightSection.read(V8, sizeof(float), V8_SIZE_SQ);
                 if (count != expected)
                     printf("TerrainBuilder::loadMap: Failed to read some data expected %d, read %d\n", expected, count);
             }
@@ -275,22 +356,43 @@ namespace MMAP
         if (haveLiquid)
         {
             map_liquidHeader lheader;
+            MapSection liquidSection;
             fseek(mapFile, fheader.liquidMapOffset, SEEK_SET);
-            if (fread(&lheader, sizeof(map_liquidHeader), 1, mapFile) != 1)
+            if (fread(&lheader, sizeof(map_liquidHeader), 1, mapFile) != 1 ||
+                !liquidSection.load(mapFile, fheader.liquidMapSize, sizeof(map_liquidHeader), (lheader.flags & MAP_LIQUID_COMPRESSED) != 0))
                 printf("TerrainBuilder::loadMap: Failed to read some data expected 1, read 0\n");
 
 
             float* liquid_map = NULL;
 
+            // the liquid entries precede the liquid type flags
             if (!(lheader.flags & MAP_LIQUID_NO_TYPE))
-                if (fread(liquid_type, sizeof(liquid_type), 1, mapFile) != 1)
+            {
+                uint16 liquid_entry[16][16];
+                if (liquidSection.read(liquid_entry, sizeof(liquid_entry), 1) != 1 ||
+                    liquidSection.read(liquid_type, sizeof(liquid_type), 1) != 1)
                     printf("TerrainBuilder::loadMap: Failed to read some data expected 1, read 0\n");
+            }
 
-            if (!(lheader.flags & MAP_LIQUID_NO_HEIGHT))
+            if (lheader.flags & MAP_LIQUID_AS_INT16)
             {
+                float minHeight = 0.0f, maxHeight = 0.0f;
                 uint32 toRead = lheader.width * lheader.height;
+                std::vector<uint16> heights(toRead);
+                if (liquidSection.read(&minHeight, sizeof(float), 1) != 1 || liquidSection.read(&maxHeight, sizeof(float), 1) != 1 ||
+                    liquidSection.read(heights.data(), sizeof(uint16), toRead) != toRead)
+                    printf("TerrainBuilder::loadMap: Failed to read some data expected 1, read 0\n");
+
+                float multiplier = (maxHeight - minHeight) / 65535;
                 liquid_map = new float [toRead];
-                if (fread(liquid_map, sizeof(float), toRead, mapFile) != toRead)
+                for (uint32 i = 0; i < toRead; ++i)
+                    liquid_map[i] = minHeight + heights[i] * multiplier;
+            }
+            else if (!(lheader.flags & MAP_LIQUID_NO_HEIGHT))
+            {
+                uint32 toRead = lheader.width * lheader.height;
+                liquid_map = new float [toRead];
+                if (liquidSection.read(liquid_map, sizeof(float), toRead) != toRead)
                     printf("TerrainBuilder::loadMap: Failed to read some data expected 1, read 0\n");
             }
 
@@ -631,24 +733,21 @@ namespace MMAP
     /**************************************************************************/
     bool TerrainBuilder::loadVMap(uint32 mapID, uint32 tileX, uint32 tileY, MeshData &meshData)
     {
-        IVMapManager* vmapManager = new VMapManager2();
-        int result = vmapManager->loadMap("vmaps", mapID, tileX, tileY);
+        // the tree is private to this tile, only the models are shared with the other workers
+        StaticMapTree mapTree(mapID, "vmaps/");
         bool retval = false;
 
         do
         {
-            if (result == VMAP_LOAD_RESULT_ERROR)
+            if (!mapTree.InitMap(VMapManager2::getMapFileName(mapID), m_vmapManager))
                 break;
 
-            InstanceTreeMap instanceTrees;
-            ((VMapManager2*)vmapManager)->getInstanceMapTree(instanceTrees);
-
-            if (!instanceTrees[mapID])
+            if (!mapTree.LoadMapTile(tileX, tileY, m_vmapManager))
                 break;
 
             ModelInstance* models = NULL;
             uint32 count = 0;
-            instanceTrees[mapID]->getModelInstances(models, count);
+            mapTree.getModelInstances(models, count);
 
             if (!models)
                 break;
@@ -778,12 +877,47 @@ namespace MMAP
         }
         while (false);
 
-        vmapManager->unloadMap(mapID, tileX, tileY);
-        delete vmapManager;
+        mapTree.UnloadMap(m_vmapManager);
 
         return retval;
     }
 
+    /**************************************************************************/
+    void TerrainBuilder::loadMapModels(uint32 mapID)
+    {
+        std::set<std::string> names;
+        uint32 tileCount = 0;
+        if (!StaticMapTree::getModelNames("vmaps/", mapID, names, tileCount))
+            return;
+
+        std::vector<std::string> loaded;
+        for (std::string const& name : names)
+            if (m_vmapManager->acquireModelInstance("vmaps/", name))
+                loaded.push_back(name);
+
+        std::lock_guard<std::mutex> lock(m_mapModelsLock);
+        std::vector<std::string>& mapModels = m_mapModels[mapID];
+        mapModels.insert(mapModels.end(), loaded.begin(), loaded.end());
+    }
+
+    /**************************************************************************/
+    void TerrainBuilder::unloadMapModels(uint32 mapID)
+    {
+        std::vector<std::string> names;
+        {
+            std::lock_guard<std::mutex> lock(m_mapModelsLock);
+            auto itr = m_mapModels.find(mapID);
+            if (itr == m_mapModels.end())
+                return;
+
+            names.swap(itr->second);
+            m_mapModels.erase(itr);
+        }
+
+        for (std::string const& name : names)
+            m_vmapManager->releaseModelInstance(name);
+    }
+
     /**************************************************************************/
     void TerrainBuilder::transform(std::vector<G3D::Vector3> &source, std::vector<G3D::Vector3> &transformedVertices, float scale, G3D::Matrix3 &rotation, G3D::Vector3 &position)
     {
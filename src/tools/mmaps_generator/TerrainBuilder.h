@@ -26,6 +26,14 @@
 #include "G3D/Vector3.h"
 #include "G3D/Matrix3.h"
 
+#include <mutex>
+#include <unordered_map>
+
+namespace VMAP
+{
+    class VMapManager2;
+}
+
 namespace MMAP
 {
     enum Spot
@@ -85,6 +93,10 @@ namespace MMAP
             bool loadVMap(uint32 mapID, uint32 tileX, uint32 tileY, MeshData &meshData);
             void loadOffMeshConnections(uint32 mapID, uint32 tileX, uint32 tileY, MeshData &meshData, const char* offMeshFilePath);
 
+            /// Keeps all models of the map loaded until unloadMapModels, tiles built in between share them
+            void loadMapModels(uint32 mapID);
+            void unloadMapModels(uint32 mapID);
+
             bool usesLiquids() { return !m_skipLiquid; }
 
             // vert and triangle methods
@@ -104,6 +116,13 @@ namespace MMAP
             /// Controls whether liquids are loaded
             bool m_skipLiquid;
 
+            /// Model cache shared by all tile workers, thread safe
+            VMAP::VMapManager2* m_vmapManager;
+
+            /// Models pinned by loadMapModels
+            std::mutex m_mapModelsLock;
+            std::unordered_map<uint32, std::vector<std::string>> m_mapModels;
+
             /// Load the map terrain from file
             bool loadHeightMap(uint32 mapID, uint32 tileX, uint32 tileY, G3D::Array<float> &vertices, G3D::Array<int> &triangles, Spot portion);
 
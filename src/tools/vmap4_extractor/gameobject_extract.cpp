@@ -43,7 +43,7 @@ bool ExtractSingleModel(std::string& fname)
     output += "/";
     output += name;
 
-    if (FileExists(output.c_str()))
+    if (ExtractedFileUpToDate(output.c_str()))
         return true;
 
     Model mdl(fname);
@@ -21,6 +21,11 @@
 #include <iostream>
 #include <vector>
 #include <list>
+#include <set>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
 #include <errno.h>
 
 #ifdef WIN32
@@ -56,7 +61,7 @@
 
 //-----------------------------------------------------------------------------
 
-extern ArchiveSet gOpenArchives;
+extern thread_local ArchiveSet gOpenArchives;
 
 typedef struct
 {
@@ -71,6 +76,9 @@ char output_path[128]=".";
 char input_path[1024]=".";
 bool hasInputPathParam = false;
 bool preciseVectorData = false;
+int extractThreads = std::max(int(std::thread::hardware_concurrency()), 1);
+bool incrementalUpdate = false;
+time_t archivesTime = 0;                                    // newest modification of the opened archives
 
 // Constants
 
@@ -90,6 +98,30 @@ bool FileExists(const char* file)
     return false;
 }
 
+uint32 GetMSTimeSince(std::chrono::steady_clock::time_point const& start)
+{
+    return uint32(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+time_t GetFileTime(const char* file)
+{
+    struct stat status;
+    if (stat(file, &status))
+        return 0;
+
+    return status.st_mtime;
+}
+
+// Incremental update extracts the files again if an archive changed since, otherwise they are never overwritten
+bool ExtractedFileUpToDate(const char* file)
+{
+    if (!incrementalUpdate)
+        return FileExists(file);
+
+    time_t fileTime = GetFileTime(file);
+    return fileTime && fileTime >= archivesTime;
+}
+
 void strToLower(char* str)
 {
     while(*str)
@@ -121,24 +153,68 @@ void ReadLiquidTypeTableDBC()
     printf("Done! (%u LiqTypes loaded)\n", (unsigned int)LiqType_count);
 }
 
-bool ExtractWmo()
+void OpenArchives(std::vector<std::string> const& archiveNames)
+{
+    for (size_t i=0; i < archiveNames.size(); ++i)
+    {
+        MPQArchive *archive = new MPQArchive(archiveNames[i].c_str());
+        if (gOpenArchives.empty() || gOpenArchives.front() != archive)
+            delete archive;
+    }
+}
+
+void ExtractWmoFiles(std::vector<std::string> const& wmoFiles, std::vector<std::string> const& archiveNames,
+    std::atomic<size_t>* nextWmo, std::atomic<bool>* success)
 {
-    bool success = true;
+    OpenArchives(archiveNames);
+
+    for (size_t i = (*nextWmo)++; i < wmoFiles.size() && *success; i = (*nextWmo)++)
+    {
+        std::string fname = wmoFiles[i];
+        if (!ExtractSingleWmo(fname))
+            *success = false;
+    }
+
+    for (ArchiveSet::iterator itr = gOpenArchives.begin(); itr != gOpenArchives.end(); ++itr)
+        delete *itr;
+    gOpenArchives.clear();
+}
 
+bool ExtractWmo(std::vector<std::string> const& archiveNames)
+{
     //const char* ParsArchiveNames[] = {"patch-2.MPQ", "patch.MPQ", "common.MPQ", "expansion.MPQ"};
 
-    for (ArchiveSet::const_iterator ar_itr = gOpenArchives.begin(); ar_itr != gOpenArchives.end() && success; ++ar_itr)
+    // every output file is written by one thread only, the first archive listing it names it like before
+    std::vector<std::string> wmoFiles;
+    std::set<std::string> localFiles;
+    for (ArchiveSet::const_iterator ar_itr = gOpenArchives.begin(); ar_itr != gOpenArchives.end(); ++ar_itr)
     {
         vector<string> filelist;
 
         (*ar_itr)->GetFileListTo(filelist);
-        for (vector<string>::iterator fname = filelist.begin(); fname != filelist.end() && success; ++fname)
+        for (vector<string>::iterator fname = filelist.begin(); fname != filelist.end(); ++fname)
         {
-            if (fname->find(".wmo") != string::npos)
-                success = ExtractSingleWmo(*fname);
+            if (fname->find(".wmo") == string::npos)
+                continue;
+
+            std::string localFile = GetPlainName(fname->c_str());
+            fixnamen(&localFile[0], localFile.length());
+            if (localFiles.insert(localFile).second)
+                wmoFiles.push_back(*fname);
         }
     }
 
+    printf("Extracting %u wmo files using %d threads\n", uint32(wmoFiles.size()), extractThreads);
+
+    std::atomic<size_t> nextWmo(0);
+    std::atomic<bool> success(true);
+    std::vector<std::thread> workerThreads;
+    for (int i = 0; i < extractThreads; ++i)
+        workerThreads.push_back(std::thread(ExtractWmoFiles, std::cref(wmoFiles), std::cref(archiveNames), &nextWmo, &success));
+
+    for (std::thread& thread : workerThreads)
+        thread.join();
+
     if (success)
         printf("\nExtract wmo complete (No (fatal) errors)\n");
 
@@ -154,7 +230,7 @@ bool ExtractSingleWmo(std::string& fname)
     sprintf(szLocalFile, "%s/%s", szWorkDirWmo, plain_name);
     fixnamen(szLocalFile,strlen(szLocalFile));
 
-    if (FileExists(szLocalFile))
+    if (ExtractedFileUpToDate(szLocalFile))
         return true;
 
     int p = 0;
@@ -176,7 +252,7 @@ bool ExtractSingleWmo(std::string& fname)
         return true;
 
     bool file_ok = true;
-    std::cout << "Extracting " << fname << std::endl;
+    printf("Extracting %s\n", fname.c_str());
     WMORoot froot(fname);
     if(!froot.open())
     {
@@ -415,6 +491,22 @@ bool processArgv(int argc, char ** argv, const char *versionString)
         {
             preciseVectorData = true;
         }
+        else if(strcmp("-t",argv[i]) == 0)
+        {
+            if((i+1)<argc && atoi(argv[i + 1]) > 0)
+            {
+                extractThreads = atoi(argv[i + 1]);
+                ++i;
+            }
+            else
+            {
+                result = false;
+            }
+        }
+        else if(strcmp("-u",argv[i]) == 0)
+        {
+            incrementalUpdate = true;
+        }
         else
         {
             result = false;
@@ -424,10 +516,12 @@ bool processArgv(int argc, char ** argv, const char *versionString)
     if(!result)
     {
         printf("Extract %s.\n",versionString);
-        printf("%s [-?][-s][-l][-d <path>]\n", argv[0]);
+        printf("%s [-?][-s][-l][-d <path>][-t <threads>][-u]\n", argv[0]);
         printf("   -s : (default) small size (data size optimization), ~500MB less vmap data.\n");
         printf("   -l : large size, ~500MB more vmap data. (might contain more details)\n");
         printf("   -d <path>: Path to the vector data source folder.\n");
+        printf("   -t <threads>: Number of threads extracting wmo files, (default) number of cores.\n");
+        printf("   -u : Update a previous extraction, only files older than the archives are extracted again.\n");
         printf("   -? : This message.\n");
     }
     return result;
@@ -458,7 +552,10 @@ int main(int argc, char ** argv)
         std::string sdir = std::string(szWorkDirWmo) + "/dir";
         std::string sdir_bin = std::string(szWorkDirWmo) + "/dir_bin";
         struct stat status;
-        if (!stat(sdir.c_str(), &status) || !stat(sdir_bin.c_str(), &status))
+        // the map instances are always written again, only the model files are kept by an update
+        if (incrementalUpdate)
+            remove(sdir_bin.c_str());
+        else if (!stat(sdir.c_str(), &status) || !stat(sdir_bin.c_str(), &status))
         {
             printf("Your output directory seems to be polluted, please use an empty directory!\n");
             printf("<press return to exit>");
@@ -480,12 +577,9 @@ int main(int argc, char ** argv)
     // prepare archive name list
     std::vector<std::string> archiveNames;
     fillArchiveNameVector(archiveNames);
+    OpenArchives(archiveNames);
     for (size_t i=0; i < archiveNames.size(); ++i)
-    {
-        MPQArchive *archive = new MPQArchive(archiveNames[i].c_str());
-        if (gOpenArchives.empty() || gOpenArchives.front() != archive)
-            delete archive;
-    }
+        archivesTime = std::max(archivesTime, GetFileTime(archiveNames[i].c_str()));
 
     if (gOpenArchives.empty())
     {
@@ -495,8 +589,12 @@ int main(int argc, char ** argv)
     ReadLiquidTypeTableDBC();
 
     // extract data
+    std::chrono::steady_clock::time_point phaseStart = std::chrono::steady_clock::now();
     if (success)
-        success = ExtractWmo();
+    {
+        success = ExtractWmo(archiveNames);
+        printf("Extracted wmo files in %u ms\n", GetMSTimeSince(phaseStart));
+    }
 
     //xxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
     //map.dbc
@@ -531,11 +629,15 @@ int main(int argc, char ** argv)
         }
 
         delete dbc;
+        phaseStart = std::chrono::steady_clock::now();
         ParsMapFiles();
+        printf("Processed maps in %u ms\n", GetMSTimeSince(phaseStart));
         delete [] map_ids;
         //nError = ERROR_SUCCESS;
         // Extract models, listed in DameObjectDisplayInfo.dbc
+        phaseStart = std::chrono::steady_clock::now();
         ExtractGameobjectModels();
+        printf("Extracted gameobject models in %u ms\n", GetMSTimeSince(phaseStart));
     }
 
     printf("\n");
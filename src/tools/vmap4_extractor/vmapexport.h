@@ -32,6 +32,7 @@ extern const char * szWorkDirWmo;
 extern const char * szRawVMAPMagic;                         // vmap magic string for extracted raw vmap data
 
 bool FileExists(const char * file);
+bool ExtractedFileUpToDate(const char * file);
 void strToLower(char* str);
 
 bool ExtractSingleWmo(std::string& fname);